@@ -1,4 +1,8 @@
 ..\..\..\VulkanSDK\1.3.261.1\Bin\glslc.exe shader.vert -o vert.spv
 ..\..\..\VulkanSDK\1.3.261.1\Bin\glslc.exe shader.frag -o frag.spv
 ..\..\..\VulkanSDK\1.3.261.1\Bin\glslc.exe shader.comp -o comp.spv
+..\..\..\VulkanSDK\1.3.261.1\Bin\glslc.exe saxpy.comp -o saxpy.spv
+..\..\..\VulkanSDK\1.3.261.1\Bin\glslc.exe --target-env=vulkan1.2 reduce.comp -o reduce.spv
+..\..\..\VulkanSDK\1.3.261.1\Bin\glslc.exe --target-env=vulkan1.2 scan.comp -o scan.spv
+..\..\..\VulkanSDK\1.3.261.1\Bin\glslc.exe cull.comp -o cull.spv
 pause
@@ -9,6 +9,33 @@
 #include <array>
 #include <chrono>
 #include <random>
+#include <map>
+#include <bit>
+#include <algorithm>
+#include <future>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <iomanip>
+#include <thread>
+#include <limits>
+#include <deque>
+#include <functional>
+#include <condition_variable>
+
+// Compute results are verified in simd registers where available.
+#if defined( __AVX2__ )
+#include <immintrin.h>
+#elif defined( __ARM_NEON ) && defined( __aarch64__ )
+#include <arm_neon.h>
+#endif
+
+// The trace clock counts performance counter ticks on windows.
+#if defined( _WIN32 )
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
 
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
@@ -27,9 +54,60 @@
 constexpr bool EnableBestPracticesValidation = false;
 #endif
 
-constexpr uint64_t Kilobyte          = 1024;
-constexpr uint64_t Megabyte          = 1024 * Kilobyte;
-constexpr uint32_t MaxFramesInFlight = 2;
+constexpr uint64_t Kilobyte              = 1024;
+constexpr uint64_t Megabyte              = 1024 * Kilobyte;
+constexpr uint64_t MinGpuMemoryBlockSize = 64 * Megabyte;
+constexpr uint64_t MaxGpuMemoryBlockSize = 256 * Megabyte;
+constexpr uint32_t MaxFramesInFlight     = 4;
+constexpr uint32_t MaxUniformsPerFrame   = 1024;
+
+constexpr bool     EnableComputeVerification = true;
+constexpr uint32_t ComputeElementCount       = 1000000; // Not a multiple of the workgroup size, so the last workgroup is partial.
+constexpr uint32_t MinComputeWorkgroupSize   = 64;
+constexpr uint32_t MaxComputeWorkgroupSize   = 256;
+constexpr uint32_t MaxComputeJobsInFlight    = 64;    // Descriptor sets of the compute job pool.
+constexpr uint32_t MaxComputeKernelBindings  = 8;     // Storage buffers of a compute kernel.
+constexpr uint32_t MinCpuReferenceRangeSize  = 65536; // Elements per worker thread of cpu references.
+constexpr uint32_t MinComputeStreamSlotCount = 2;     // Double buffered, upload and dispatch overlap the readback.
+constexpr uint32_t MaxComputeStreamSlotCount = 3;     // Triple buffered, the cpu also produces while the gpu works.
+
+constexpr uint32_t ComputeVerificationBlockSize   = 4096;    // Elements of a verification block, sampled verification checks whole blocks.
+constexpr uint32_t DefaultComputeMismatchReports  = 8;       // Mismatches printed when a verification fails.
+constexpr float    DefaultComputeVerificationUlps = 2.0f;    // Tolerance of ulp verification.
+constexpr float    DefaultComputeRelativeError    = 1e-6f;   // Tolerance of relative verification.
+constexpr float    MaxComputeVerificationUlps     = 1 << 20; // Ulp distances of the simd comparison wrap from 2^24.
+
+constexpr uint32_t     CullingClusterTriangleCount = 64; // Triangles of a mesh cluster, clusters are culled and drawn one draw each.
+constexpr VkDeviceSize CullingDrawCommandOffset    = 16; // Draw commands follow the draw count, padded as in the culling shader.
+
+constexpr uint32_t HeadlessFrameCount = 100; // Frames rendered in headless mode when no count is given.
+constexpr float    HeadlessFrameRate  = 60.0f; // Animation steps by a fixed time per frame, so captures are reproducible.
+
+constexpr uint32_t BenchmarkFrameCount       = 1000; // Measured frames when neither frames nor seconds are given.
+constexpr uint32_t BenchmarkWarmupFrameCount = 60;   // Frames rendered before measuring when no count is given.
+
+constexpr uint32_t GpuProfilerQueryCount   = 64;   // Timestamp queries of each command buffer, two per scope.
+constexpr double   RollingAverageWeight    = 0.05; // Weight of the newest frame in rolling averages.
+constexpr double   LogIntervalSeconds      = 1.0;  // Rolling averages are printed at this interval.
+constexpr uint32_t PipelineStatisticCount  = 7;
+constexpr uint32_t ComputeOverlapFrameCount = 8; // Recent frames a dispatch is compared with to measure async compute overlap.
+
+constexpr uint32_t TraceEventsPerThread         = 65536; // Older events of a thread are overwritten.
+constexpr uint32_t TraceGraphicsQueueTrack      = 1000;  // Trace tracks of gpu scopes, cpu threads use tracks from one.
+constexpr uint32_t TraceComputeQueueTrack       = 1001;
+constexpr uint32_t GpuTimestampCalibrationCount = 8; // The calibration with the shortest round trip or the smallest deviation is used.
+
+// Time domain of the trace clock, which calibrated timestamps sample together with the gpu clock.
+#if defined( _WIN32 )
+constexpr VkTimeDomainEXT TraceTimeDomain = VK_TIME_DOMAIN_QUERY_PERFORMANCE_COUNTER_EXT;
+#else
+constexpr VkTimeDomainEXT TraceTimeDomain = VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT;
+#endif
+
+using FrameClock = std::chrono::steady_clock;
+
+constexpr uint64_t DefragmentationBytesPerFrame = 16 * Megabyte;
+constexpr uint64_t StagingRingBufferSize        = 64 * Megabyte;
 
 ////////////////////////////////////////////////////////////
 /// GetBindingDescription.
@@ -159,6 +237,47 @@ void vkDestroyDebugUtilsMessengerExtension(
     }
 }
 
+////////////////////////////////////////////////////////////
+/// vkGetPhysicalDeviceCalibrateableTimeDomainsExtension.
+////////////////////////////////////////////////////////////
+VkResult vkGetPhysicalDeviceCalibrateableTimeDomainsExtension(
+    VkInstance       instance,
+    VkPhysicalDevice physicalDevice,
+    uint32_t*        timeDomainCount,
+    VkTimeDomainEXT* timeDomains )
+{
+    const auto function = (PFN_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT) vkGetInstanceProcAddr( instance, "vkGetPhysicalDeviceCalibrateableTimeDomainsEXT" );
+    if( function != nullptr )
+    {
+        return function( physicalDevice, timeDomainCount, timeDomains );
+    }
+    else
+    {
+        return VK_ERROR_EXTENSION_NOT_PRESENT;
+    }
+}
+
+////////////////////////////////////////////////////////////
+/// vkGetCalibratedTimestampsExtension.
+////////////////////////////////////////////////////////////
+VkResult vkGetCalibratedTimestampsExtension(
+    VkDevice                            device,
+    uint32_t                            timestampCount,
+    const VkCalibratedTimestampInfoEXT* timestampInfos,
+    uint64_t*                           timestamps,
+    uint64_t*                           maxDeviation )
+{
+    const auto function = (PFN_vkGetCalibratedTimestampsEXT) vkGetDeviceProcAddr( device, "vkGetCalibratedTimestampsEXT" );
+    if( function != nullptr )
+    {
+        return function( device, timestampCount, timestampInfos, timestamps, maxDeviation );
+    }
+    else
+    {
+        return VK_ERROR_EXTENSION_NOT_PRESENT;
+    }
+}
+
 ////////////////////////////////////////////////////////////
 /// Status code enumeration.
 ////////////////////////////////////////////////////////////
@@ -173,7 +292,84 @@ enum class StatusCode : uint32_t
 ////////////////////////////////////////////////////////////
 enum class QueryType : uint32_t
 {
-    PipelineStatistics = 0
+    PipelineStatistics = 0,
+    Count
+};
+
+////////////////////////////////////////////////////////////
+/// Benchmark metric enumeration.
+////////////////////////////////////////////////////////////
+enum class BenchmarkMetric : uint32_t
+{
+    CpuFrameTime = 0, // Between the starts of consecutive frames.
+    GpuFrameTime,     // Graphics command buffer on the gpu.
+    ComputeTime,      // Dispatch on the gpu.
+    AcquireTime,
+    SubmitTime,       // Compute and graphics submits.
+    PresentTime,
+    FrameLatency,     // From input sampling to the end of the frame on the gpu.
+    ComputeOverlap,   // Dispatch time on the gpu overlapping graphics frames.
+    Count
+};
+
+////////////////////////////////////////////////////////////
+/// Pipeline statistics export enumeration.
+////////////////////////////////////////////////////////////
+enum class PipelineStatisticsExport : uint32_t
+{
+    None = 0,
+    Stdout,     // Rolling averages are printed while running.
+    Csv,        // All frames are written at exit.
+    ChromeTrace // All frames are written at exit as counter events.
+};
+
+////////////////////////////////////////////////////////////
+/// Compute buffer memory mode enumeration.
+////////////////////////////////////////////////////////////
+enum class ComputeBufferMode : uint32_t
+{
+    Auto = 0,    // Host visible if all device local memory is host visible (UMA or resizable BAR), device local otherwise.
+    HostVisible, // The shader accesses host visible memory, inputs are written directly.
+    DeviceLocal  // Inputs are uploaded through staging on the copy queue.
+};
+
+////////////////////////////////////////////////////////////
+/// Compute verification mode enumeration.
+////////////////////////////////////////////////////////////
+enum class ComputeVerificationMode : uint32_t
+{
+    Exact = 0, // Results must be equal to the cpu results.
+    Ulp,       // Results may differ by a number of units in the last place.
+    Relative   // Results may differ by a fraction of the larger magnitude.
+};
+
+////////////////////////////////////////////////////////////
+/// Benchmark output format enumeration.
+////////////////////////////////////////////////////////////
+enum class BenchmarkFormat : uint32_t
+{
+    Json = 0,
+    Csv
+};
+
+////////////////////////////////////////////////////////////
+/// Latency mode enumeration.
+////////////////////////////////////////////////////////////
+enum class LatencyMode : uint32_t
+{
+    Balanced = 0, // Two frames in flight, mailbox.
+    LowLatency,   // One frame in flight, immediate or relaxed fifo.
+    Throughput    // Three frames in flight and more swap chain images.
+};
+
+////////////////////////////////////////////////////////////
+/// Queue which owns a movable gpu resource.
+////////////////////////////////////////////////////////////
+enum class GpuResourceOwner : uint32_t
+{
+    Graphics = 0,
+    Compute,
+    Count
 };
 
 ////////////////////////////////////////////////////////////
@@ -185,6 +381,7 @@ struct QueueFamilyIndices
     bool m_HasComputeFamily;
     bool m_HasCopyFamily;
     bool m_HasPresentFamily;
+    bool m_IsGraphicsFamilyCompute; // Graphics command buffers can record dispatches.
 
     uint32_t m_GraphicsFamily;
     uint32_t m_ComputeFamily;
@@ -208,3430 +405,10746 @@ struct SwapChainSupportDetails
 };
 
 ////////////////////////////////////////////////////////////
-/// Application object.
+/// Gpu memory type preferences.
 ////////////////////////////////////////////////////////////
-class Application
+struct GpuMemoryPreferences
 {
-private:
-    ////////////////////////////////////////////////////////////
-    /// Private glfw members.
-    ////////////////////////////////////////////////////////////
-    uint32_t    m_Width;
-    uint32_t    m_Height;
-    GLFWwindow* m_Window;
-    std::string m_WindowName;
-
-    ////////////////////////////////////////////////////////////
-    /// Private Vulkan members.
-    ////////////////////////////////////////////////////////////
-    VkInstance                                     m_Instance;
-    VkSurfaceKHR                                   m_Surface;
-    VkPhysicalDevice                               m_PhysicalDevice;
-    VkPhysicalDeviceFeatures                       m_PhysicalDeviceFeatures;
-    VkDevice                                       m_Device;
-    VkQueue                                        m_GraphicsQueue;
-    VkQueue                                        m_ComputeQueue;
-    VkQueue                                        m_CopyQueue;
-    VkQueue                                        m_PresentQueue;
-    VkSwapchainKHR                                 m_SwapChain;
-    std::vector<VkImage>                           m_SwapChainImages;
-    VkFormat                                       m_SwapChainImageFormat;
-    VkExtent2D                                     m_SwapChainExtent;
-    std::vector<VkImageView>                       m_SwapChainImageViews;
-    VkRenderPass                                   m_RenderPass;
-    VkDescriptorSetLayout                          m_DescriptorSetLayout;
-    VkDescriptorPool                               m_DescriptorPool;
-    std::vector<VkDescriptorSet>                   m_DescriptorSets;
-    VkPipelineLayout                               m_GraphicsPipelineLayout;
-    VkPipeline                                     m_GraphicsPipeline;
-    std::vector<VkFramebuffer>                     m_SwapChainFramebuffers;
-    VkCommandPool                                  m_CommandPoolGraphics;
-    VkCommandPool                                  m_CommandPoolCopy;
-    VkImage                                        m_TextureImage;
-    std::pair<uint32_t, VkDeviceSize>              m_TextureImageGpuMemoryOffset;
-    VkImageView                                    m_TextureImageView;
-    VkSampler                                      m_TextureSampler;
-    VkBuffer                                       m_VertexBuffer;
-    std::pair<uint32_t, VkDeviceSize>              m_VertexBufferGpuMemoryOffset;
-    VkBuffer                                       m_IndexBuffer;
-    std::pair<uint32_t, VkDeviceSize>              m_IndexBufferGpuMemoryOffset;
-    VkImage                                        m_DepthImage;
-    std::pair<uint32_t, VkDeviceSize>              m_DepthImageGpuMemoryOffset;
-    VkImageView                                    m_DepthImageView;
-    std::vector<VkDeviceMemory>                    m_BufferGpuMemoryLocal;
-    std::vector<VkDeviceSize>                      m_BufferGpuMemoryLocalSize;
-    std::vector<VkDeviceSize>                      m_BufferGpuMemoryLocalUsage;
-    std::vector<VkDeviceMemory>                    m_BufferGpuMemoryCpuVisible;
-    std::vector<VkDeviceSize>                      m_BufferGpuMemoryCpuVisibleSize;
-    std::vector<VkDeviceSize>                      m_BufferGpuMemoryCpuVisibleUsage;
-    std::vector<VkBuffer>                          m_UniformBuffers;
-    std::vector<std::pair<uint32_t, VkDeviceSize>> m_UniformBuffersGpuMemoryOffsets;
-    std::vector<VkCommandBuffer>                   m_GraphicsCommandBuffers;
-    std::vector<VkSemaphore>                       m_ImageAvailableSemaphores;
-    std::vector<VkSemaphore>                       m_RenderFinishedSemaphores;
-    std::vector<VkFence>                           m_InFlightFences;
-    std::vector<VkFence>                           m_ImagesInFlight;
-    std::vector<VkQueryPool>                       m_QueryPools;
-    QueueFamilyIndices                             m_QueueFamilyIndices;
-    uint32_t                                       m_CurrentFrame;
-    bool                                           m_IsFrameBufferResized;
-    bool                                           m_IsPipelineStatisticsQuerySupported;
-    float                                          m_MaxSamplerAnisotropy;
-    // Compute only members.
-    VkCommandPool                                  m_CommandPoolCompute;
-    VkCommandBuffer                                m_ComputeCommandBuffer;
-    VkDescriptorSetLayout                          m_ComputeDescriptorSetLayout;
-    VkDescriptorPool                               m_ComputeDescriptorPool;
-    VkDescriptorSet                                m_ComputeDescriptorSet;
-    VkPipelineLayout                               m_ComputePipelineLayout;
-    VkPipeline                                     m_ComputePipeline;
-    std::vector<VkBuffer>                          m_ComputeBuffers;
-    std::vector<std::pair<uint32_t, VkDeviceSize>> m_ComputeBuffersGpuMemoryOffsets;
-    VkDeviceMemory                                 m_ComputeMemory;
-    uint32_t                                       m_VectorElementCount;
-    float*                                         m_NumbersA;
-    float*                                         m_NumbersB;
-    float*                                         m_Results;
-
-    ////////////////////////////////////////////////////////////
-    /// Private Vulkan extensions members.
-    ////////////////////////////////////////////////////////////
-    std::vector<const char*> m_PhysicalDeviceExtensions;
-
-    ////////////////////////////////////////////////////////////
-    /// Private debugging and validation layer members.
-    ////////////////////////////////////////////////////////////
-#ifdef _DEBUG
-    std::vector<const char*> m_ValidationLayers;
-    VkDebugUtilsMessengerEXT m_DebugMessenger;
-#endif
+    VkMemoryPropertyFlags m_Required;  // Memory type must have all of these flags.
+    VkMemoryPropertyFlags m_Preferred; // Memory type with more of these flags wins.
+    VkMemoryPropertyFlags m_Avoided;   // Memory type with more of these flags loses.
 
-public:
     ////////////////////////////////////////////////////////////
-    /// Default constructor of the object.
+    /// Constructs the object with given flags.
     ////////////////////////////////////////////////////////////
-    Application()
-        : Application( 800, 600, "Vulkan Application" )
+    GpuMemoryPreferences(
+        const VkMemoryPropertyFlags required,
+        const VkMemoryPropertyFlags preferred = 0,
+        const VkMemoryPropertyFlags avoided   = 0 )
+        : m_Required( required )
+        , m_Preferred( preferred )
+        , m_Avoided( avoided )
     {
     }
+};
 
-    ////////////////////////////////////////////////////////////
-    /// Constructs the object with given parameters.
-    ////////////////////////////////////////////////////////////
-    Application(
-        const uint32_t     width,
-        const uint32_t     height,
-        const std::string& windowName )
-        : m_Width( width )
-        , m_Height( height )
-        , m_Window( nullptr )
-        , m_WindowName( windowName )
-        , m_Instance( VK_NULL_HANDLE )
-        , m_Surface( VK_NULL_HANDLE )
-        , m_PhysicalDevice( VK_NULL_HANDLE )
-        , m_PhysicalDeviceFeatures{}
-        , m_Device( VK_NULL_HANDLE )
-        , m_GraphicsQueue( VK_NULL_HANDLE )
-        , m_ComputeQueue( VK_NULL_HANDLE )
-        , m_CopyQueue( VK_NULL_HANDLE )
-        , m_PresentQueue( VK_NULL_HANDLE )
-        , m_SwapChain( VK_NULL_HANDLE )
-        , m_SwapChainImages{}
-        , m_SwapChainImageFormat( VK_FORMAT_UNDEFINED )
-        , m_SwapChainExtent{}
-        , m_SwapChainImageViews{}
-        , m_RenderPass( VK_NULL_HANDLE )
-        , m_DescriptorSetLayout( VK_NULL_HANDLE )
-        , m_DescriptorPool( VK_NULL_HANDLE )
-        , m_DescriptorSets{}
-        , m_GraphicsPipelineLayout( VK_NULL_HANDLE )
-        , m_GraphicsPipeline( VK_NULL_HANDLE )
-        , m_SwapChainFramebuffers{}
-        , m_CommandPoolGraphics( VK_NULL_HANDLE )
-        , m_CommandPoolCopy( VK_NULL_HANDLE )
-        , m_TextureImage( VK_NULL_HANDLE )
-        , m_TextureImageGpuMemoryOffset{}
-        , m_TextureImageView( VK_NULL_HANDLE )
-        , m_TextureSampler( VK_NULL_HANDLE )
-        , m_VertexBuffer( VK_NULL_HANDLE )
-        , m_VertexBufferGpuMemoryOffset{}
-        , m_IndexBuffer( VK_NULL_HANDLE )
-        , m_IndexBufferGpuMemoryOffset{}
-        , m_BufferGpuMemoryLocal{}
-        , m_BufferGpuMemoryLocalSize{}
-        , m_BufferGpuMemoryLocalUsage{}
-        , m_BufferGpuMemoryCpuVisible{}
-        , m_BufferGpuMemoryCpuVisibleSize{}
-        , m_BufferGpuMemoryCpuVisibleUsage{}
-        , m_UniformBuffers{}
-        , m_UniformBuffersGpuMemoryOffsets{}
-        , m_GraphicsCommandBuffers{}
-        , m_ImageAvailableSemaphores{}
-        , m_RenderFinishedSemaphores{}
-        , m_InFlightFences{}
-        , m_ImagesInFlight{}
-        , m_QueryPools{}
-        , m_QueueFamilyIndices{}
-        , m_CurrentFrame( 0 )
-        , m_IsFrameBufferResized( false )
-        , m_IsPipelineStatisticsQuerySupported( false )
-        , m_MaxSamplerAnisotropy( 1.0f )
-        , m_PhysicalDeviceExtensions{}
-        , m_CommandPoolCompute( VK_NULL_HANDLE )
-        , m_ComputeCommandBuffer( VK_NULL_HANDLE )
-        , m_ComputeDescriptorSetLayout( VK_NULL_HANDLE )
-        , m_ComputeDescriptorPool( VK_NULL_HANDLE )
-        , m_ComputeDescriptorSet( VK_NULL_HANDLE )
-        , m_ComputePipelineLayout( VK_NULL_HANDLE )
-        , m_ComputePipeline( VK_NULL_HANDLE )
-        , m_ComputeBuffers{}
-        , m_ComputeBuffersGpuMemoryOffsets{}
-        , m_ComputeMemory( VK_NULL_HANDLE )
-        , m_VectorElementCount( 0 )
-        , m_NumbersA( nullptr )
-        , m_NumbersB( nullptr )
-        , m_Results( nullptr )
-    {
-        m_PhysicalDeviceExtensions.emplace_back( VK_KHR_SWAPCHAIN_EXTENSION_NAME );
-
-#ifdef _DEBUG
-        m_ValidationLayers.emplace_back( "VK_LAYER_KHRONOS_validation" );
-        m_DebugMessenger = VK_NULL_HANDLE;
-#endif
+////////////////////////////////////////////////////////////
+/// Gpu memory statistics of a heap.
+////////////////////////////////////////////////////////////
+struct GpuMemoryHeapStats
+{
+    VkDeviceSize m_Budget;           // Bytes the process can allocate without degrading performance.
+    VkDeviceSize m_Usage;            // Bytes allocated by the process (reported by the driver if possible).
+    VkDeviceSize m_AllocatedBytes;   // Bytes of allocated gpu memory blocks.
+    VkDeviceSize m_UsedBytes;        // Bytes of sub-allocations.
+    uint32_t     m_BlockCount;       // Allocated gpu memory blocks.
+    uint32_t     m_AllocationCount;  // Sub-allocations.
+    float        m_Fragmentation;    // One minus the largest free range divided by all free bytes.
+    VkDeviceSize m_LargestFreeRange; // Used to compute fragmentation.
+};
 
-        m_BufferGpuMemoryLocal.emplace_back( VK_NULL_HANDLE );
-        m_BufferGpuMemoryLocalSize.emplace_back( 0 );
-        m_BufferGpuMemoryLocalUsage.emplace_back( 0 );
-        m_BufferGpuMemoryCpuVisible.emplace_back( VK_NULL_HANDLE );
-        m_BufferGpuMemoryCpuVisibleSize.emplace_back( 0 );
-        m_BufferGpuMemoryCpuVisibleUsage.emplace_back( 0 );
-    }
+////////////////////////////////////////////////////////////
+/// Gpu memory resource types, linear and optimal resources must not
+/// share a bufferImageGranularity page.
+////////////////////////////////////////////////////////////
+enum class GpuMemoryResourceType
+{
+    Linear,
+    Optimal
+};
 
-    ////////////////////////////////////////////////////////////
-    /// Initializes the application.
-    ////////////////////////////////////////////////////////////
-    StatusCode Initialize()
+////////////////////////////////////////////////////////////
+/// Gpu memory block sub-allocated with segregated free lists.
+////////////////////////////////////////////////////////////
+struct GpuMemoryBlock
+{
+    // Free ranges are bucketed by the power of two of their size (like the first level of TLSF),
+    // a set bit in the mask means that the bucket is not empty.
+    static constexpr uint32_t FreeListCount = 64;
+
+    VkDeviceMemory                                                             m_Memory;
+    uint32_t                                                                   m_MemoryTypeIndex;
+    VkDeviceSize                                                               m_Size;
+    VkDeviceSize                                                               m_Usage;
+    VkDeviceSize                                                               m_Granularity;        // Buffer image granularity.
+    bool                                                                       m_IsDedicated;        // Owned by a single resource.
+    void*                                                                      m_MappedData;         // Persistently mapped host pointer.
+    std::map<VkDeviceSize, VkDeviceSize>                                       m_Allocations;        // Offset and size.
+    std::set<VkDeviceSize>                                                     m_OptimalAllocations; // Offsets.
+    std::map<VkDeviceSize, VkDeviceSize>                                       m_FreeRanges;         // Offset and size.
+    std::array<std::set<std::pair<VkDeviceSize, VkDeviceSize>>, FreeListCount> m_FreeLists;          // Size and offset.
+    uint64_t                                                                   m_FreeListMask;
+
+    ////////////////////////////////////////////////////////////
+    /// Resets the block to one free range covering the whole memory.
+    ////////////////////////////////////////////////////////////
+    void Reset(
+        VkDeviceMemory     memory,
+        const uint32_t     memoryTypeIndex,
+        const VkDeviceSize size,
+        const VkDeviceSize granularity = 1,
+        const bool         isDedicated = false )
     {
-        StatusCode result = StatusCode::Success;
+        m_Memory          = memory;
+        m_MemoryTypeIndex = memoryTypeIndex;
+        m_Size            = size;
+        m_Usage           = 0;
+        m_Granularity     = std::max<VkDeviceSize>( granularity, 1 );
+        m_IsDedicated     = isDedicated;
+        m_MappedData      = nullptr;
+        m_FreeListMask    = 0;
 
-        // Create a window.
-        result = InitializeWindow();
-        if( result != StatusCode::Success )
+        m_Allocations.clear();
+        m_OptimalAllocations.clear();
+        m_FreeRanges.clear();
+
+        for( auto& freeList : m_FreeLists )
         {
-            return result;
+            freeList.clear();
         }
 
-        // Initialize Vulkan api.
-        result = InitializeVulkan();
-        if( result != StatusCode::Success )
+        if( size > 0 )
         {
-            return result;
+            InsertFreeRange( 0, size );
         }
-
-        return result;
     }
 
     ////////////////////////////////////////////////////////////
-    /// Executes the main loop of the application.
+    /// Sub-allocates an aligned range, returns false if nothing fits.
     ////////////////////////////////////////////////////////////
-    StatusCode Run()
+    bool Allocate(
+        const VkDeviceSize          size,
+        const VkDeviceSize          alignment,
+        const GpuMemoryResourceType resourceType,
+        VkDeviceSize&               offset )
     {
-        StatusCode result = StatusCode::Success;
+        const bool isOptimal = resourceType == GpuMemoryResourceType::Optimal;
 
-        result = MainLoop();
-        if( result != StatusCode::Success )
+        for( uint32_t listIndex = GetFreeListIndex( size ); listIndex < FreeListCount; ++listIndex )
         {
-            return result;
-        }
+            // Jump to the next not empty free list.
+            const uint64_t mask = m_FreeListMask & ( ~0ULL << listIndex );
 
-        return result;
-    }
+            if( mask == 0 )
+            {
+                return false;
+            }
+
+            listIndex = static_cast<uint32_t>( std::countr_zero( mask ) );
+
+            // Ranges are sorted by size, so the first range that fits is the best one in this list.
+            const auto& freeList = m_FreeLists[listIndex];
+
+            for( auto range = freeList.lower_bound( { size, 0 } ); range != freeList.end(); ++range )
+            {
+                const auto [rangeSize, rangeOffset] = *range;
+
+                VkDeviceSize       alignedOffset = AlignUp( rangeOffset, alignment );
+                const VkDeviceSize rangeEnd      = rangeOffset + rangeSize;
+
+                // Move away from the page of a previous allocation of the other resource type.
+                if( m_Granularity > 1 )
+                {
+                    auto previous = m_Allocations.lower_bound( rangeOffset );
+
+                    if( previous != m_Allocations.begin() )
+                    {
+                        --previous;
+
+                        if( IsOptimalAllocation( previous->first ) != isOptimal &&
+                            IsOnSamePage( previous->first + previous->second, alignedOffset ) )
+                        {
+                            alignedOffset = AlignUp( alignedOffset, m_Granularity );
+                        }
+                    }
+                }
+
+                if( alignedOffset + size > rangeEnd )
+                {
+                    continue;
+                }
+
+                // Skip the range if it ends on the page of a next allocation of the other resource type.
+                if( m_Granularity > 1 )
+                {
+                    const auto next = m_Allocations.lower_bound( rangeEnd );
+
+                    if( next != m_Allocations.end() &&
+                        IsOptimalAllocation( next->first ) != isOptimal &&
+                        IsOnSamePage( alignedOffset + size, next->first ) )
+                    {
+                        continue;
+                    }
+                }
+
+                RemoveFreeRange( rangeOffset );
+
+                // Return the alignment padding and the tail back to the free lists.
+                if( alignedOffset > rangeOffset )
+                {
+                    InsertFreeRange( rangeOffset, alignedOffset - rangeOffset );
+                }
+
+                if( rangeEnd > alignedOffset + size )
+                {
+                    InsertFreeRange( alignedOffset + size, rangeEnd - alignedOffset - size );
+                }
+
+                m_Allocations[alignedOffset] = size;
+                m_Usage += size;
+
+                if( isOptimal )
+                {
+                    m_OptimalAllocations.insert( alignedOffset );
+                }
+
+                offset = alignedOffset;
+
+                return true;
+            }
+        }
+
+        return false;
+    }
 
     ////////////////////////////////////////////////////////////
-    /// Destroys the application.
+    /// Frees a sub-allocation and merges it with neighbouring free ranges.
     ////////////////////////////////////////////////////////////
-    StatusCode Destroy()
+    void Free( const VkDeviceSize offset )
     {
-        StatusCode result = StatusCode::Success;
+        const auto allocation = m_Allocations.find( offset );
 
-        // Cleanups Vulkan api.
-        result = CleanupVulkan();
-        if( result != StatusCode::Success )
+        if( allocation == m_Allocations.end() )
         {
-            return result;
+            std::cerr << "Cannot find gpu memory allocation to free!" << std::endl;
+            return;
         }
 
-        // Cleanups the window and glfw library.
-        result = CleanupWindow();
-        if( result != StatusCode::Success )
+        VkDeviceSize freeOffset = allocation->first;
+        VkDeviceSize freeSize   = allocation->second;
+
+        m_Usage -= freeSize;
+        m_Allocations.erase( allocation );
+        m_OptimalAllocations.erase( freeOffset );
+
+        // Merge with the next free range.
+        const auto next = m_FreeRanges.find( freeOffset + freeSize );
+
+        if( next != m_FreeRanges.end() )
         {
-            return result;
+            freeSize += next->second;
+            RemoveFreeRange( next->first );
         }
 
-        return result;
+        // Merge with the previous free range.
+        auto previous = m_FreeRanges.lower_bound( freeOffset );
+
+        if( previous != m_FreeRanges.begin() )
+        {
+            --previous;
+
+            if( previous->first + previous->second == freeOffset )
+            {
+                freeOffset = previous->first;
+                freeSize += previous->second;
+                RemoveFreeRange( previous->first );
+            }
+        }
+
+        InsertFreeRange( freeOffset, freeSize );
     }
 
-private:
     ////////////////////////////////////////////////////////////
-    /// Initialize the window using glfw.
+    /// Returns the size of the largest free range.
     ////////////////////////////////////////////////////////////
-    StatusCode InitializeWindow()
+    VkDeviceSize GetLargestFreeRange() const
     {
-        // Initialize glfw library.
-        if( glfwInit() != GLFW_TRUE )
+        if( m_FreeListMask == 0 )
         {
-            std::cerr << "Cannot initialize glfw library!" << std::endl;
-            return StatusCode::Fail;
+            return 0;
         }
 
-        // Tell explicitly not to create an OpenGL context.
-        glfwWindowHint( GLFW_CLIENT_API, GLFW_NO_API );
+        const uint32_t listIndex = static_cast<uint32_t>( std::bit_width( m_FreeListMask ) - 1 );
 
-        // Initialize the window.
-        m_Window = glfwCreateWindow( m_Width, m_Height, m_WindowName.c_str(), nullptr, nullptr );
-        if( m_Window == nullptr )
-        {
-            std::cerr << "Cannot create window!" << std::endl;
-            return StatusCode::Fail;
-        }
+        return m_FreeLists[listIndex].rbegin()->first;
+    }
 
-        // Set a callback for window resizing.
-        glfwSetWindowUserPointer( m_Window, this );
-        glfwSetFramebufferSizeCallback( m_Window, static_cast<GLFWframebuffersizefun>( FrameBufferResizeCallback ) );
+    ////////////////////////////////////////////////////////////
+    /// Checks if the block has no sub-allocations.
+    ////////////////////////////////////////////////////////////
+    bool IsEmpty() const
+    {
+        return m_Allocations.empty();
+    }
 
-        return StatusCode::Success;
+    ////////////////////////////////////////////////////////////
+    /// Aligns a value up to the given alignment.
+    ////////////////////////////////////////////////////////////
+    static VkDeviceSize AlignUp( const VkDeviceSize value, const VkDeviceSize alignment )
+    {
+        return alignment > 1
+            ? ( ( value + alignment - 1 ) / alignment ) * alignment
+            : value;
     }
 
+private:
     ////////////////////////////////////////////////////////////
-    /// Initializes Vulkan api.
+    /// Checks if the allocation at the given offset is an optimal resource.
     ////////////////////////////////////////////////////////////
-    StatusCode InitializeVulkan()
+    bool IsOptimalAllocation( const VkDeviceSize offset ) const
     {
-        StatusCode result = StatusCode::Success;
+        return m_OptimalAllocations.contains( offset );
+    }
 
-        result = LoadModel();
-        if( result != StatusCode::Success )
-        {
-            std::cerr << "Loading model creation failed!" << std::endl;
-            return result;
-        }
+    ////////////////////////////////////////////////////////////
+    /// Checks if the end of one range and the start of the next range
+    /// lie on the same bufferImageGranularity page.
+    ////////////////////////////////////////////////////////////
+    bool IsOnSamePage( const VkDeviceSize endOffset, const VkDeviceSize startOffset ) const
+    {
+        return ( endOffset - 1 ) / m_Granularity == startOffset / m_Granularity;
+    }
 
-        result = CreateInstance();
-        if( result != StatusCode::Success )
-        {
-            std::cerr << "Vulkan instance creation failed!" << std::endl;
-            return result;
-        }
+    ////////////////////////////////////////////////////////////
+    /// Returns the free list index (floor of log2) for a given size.
+    ////////////////////////////////////////////////////////////
+    static uint32_t GetFreeListIndex( const VkDeviceSize size )
+    {
+        return size > 0
+            ? static_cast<uint32_t>( std::bit_width( size ) - 1 )
+            : 0;
+    }
 
-#ifdef _DEBUG
-        result = SetupDebugMessenger();
-        if( result != StatusCode::Success )
-        {
-            std::cerr << "Setup debug messenger failed!" << std::endl;
-            return result;
-        }
-#endif
-        result = CreateSurface();
-        if( result != StatusCode::Success )
-        {
-            std::cerr << "Surface creation failed!" << std::endl;
-            return result;
-        }
+    ////////////////////////////////////////////////////////////
+    /// Inserts a free range.
+    ////////////////////////////////////////////////////////////
+    void InsertFreeRange( const VkDeviceSize offset, const VkDeviceSize size )
+    {
+        const uint32_t listIndex = GetFreeListIndex( size );
 
-        result = PickPhysicalDevice();
-        if( result != StatusCode::Success )
-        {
-            std::cerr << "Physical device picking failed!" << std::endl;
-            return result;
-        }
+        m_FreeRanges[offset] = size;
+        m_FreeLists[listIndex].insert( { size, offset } );
+        m_FreeListMask |= 1ULL << listIndex;
+    }
 
-        result = CreateLogicalDevice();
-        if( result != StatusCode::Success )
-        {
-            std::cerr << "Logical device creation failed!" << std::endl;
-            return result;
-        }
+    ////////////////////////////////////////////////////////////
+    /// Removes a free range.
+    ////////////////////////////////////////////////////////////
+    void RemoveFreeRange( const VkDeviceSize offset )
+    {
+        const auto     range     = m_FreeRanges.find( offset );
+        const uint32_t listIndex = GetFreeListIndex( range->second );
 
-        result = CreateSwapChain();
-        if( result != StatusCode::Success )
-        {
-            std::cerr << "Swap chain creation failed!" << std::endl;
-            return result;
-        }
+        m_FreeLists[listIndex].erase( { range->second, offset } );
+        m_FreeRanges.erase( range );
 
-        result = CreateImageViews();
-        if( result != StatusCode::Success )
+        if( m_FreeLists[listIndex].empty() )
         {
-            std::cerr << "Image views creation failed!" << std::endl;
-            return result;
+            m_FreeListMask &= ~( 1ULL << listIndex );
         }
+    }
+};
 
-        result = CreateRenderPass();
-        if( result != StatusCode::Success )
-        {
-            std::cerr << "Render pass creation failed!" << std::endl;
-            return result;
-        }
+////////////////////////////////////////////////////////////
+/// Persistently mapped uniform ring buffer, split into one region per frame.
+/// Sub-allocations are bound with dynamic descriptor offsets.
+////////////////////////////////////////////////////////////
+struct GpuRingBuffer
+{
+    VkBuffer                          m_Buffer;
+    std::pair<uint32_t, VkDeviceSize> m_GpuMemoryOffsets;
+    uint8_t*                          m_MappedData;
+    VkDeviceSize                      m_Alignment;    // Min uniform buffer offset alignment.
+    VkDeviceSize                      m_RegionSize;   // Bytes per frame.
+    VkDeviceSize                      m_RegionOffset; // Start of the current frame region.
+    VkDeviceSize                      m_Head;         // Next free byte in the current frame region.
 
-        result = CreateDescriptorSetLayout();
-        if( result != StatusCode::Success )
-        {
-            std::cerr << "Descriptor set layout creation failed!" << std::endl;
-            return result;
-        }
+    ////////////////////////////////////////////////////////////
+    /// Starts writing to the region of the given frame.
+    ////////////////////////////////////////////////////////////
+    void BeginRegion( const uint32_t regionIndex )
+    {
+        m_RegionOffset = GetRegionOffset( regionIndex );
+        m_Head         = 0;
+    }
 
-        result = CreateGraphicsPipeline();
-        if( result != StatusCode::Success )
-        {
-            std::cerr << "Graphics pipeline creation failed!" << std::endl;
-            return result;
-        }
+    ////////////////////////////////////////////////////////////
+    /// Returns the offset of the region of the given frame.
+    ////////////////////////////////////////////////////////////
+    VkDeviceSize GetRegionOffset( const uint32_t regionIndex ) const
+    {
+        return regionIndex * m_RegionSize;
+    }
 
-        result = CreateComputePipeline();
-        if( result != StatusCode::Success )
-        {
-            std::cerr << "Compute pipeline creation failed!" << std::endl;
-            return result;
-        }
+    ////////////////////////////////////////////////////////////
+    /// Copies data to the current region, returns false if the region is full.
+    ////////////////////////////////////////////////////////////
+    bool Push( const void* data, const VkDeviceSize size, uint32_t& dynamicOffset )
+    {
+        const VkDeviceSize alignedSize = GpuMemoryBlock::AlignUp( size, m_Alignment );
 
-        result = CreateCommandPools();
-        if( result != StatusCode::Success )
+        if( m_Head + alignedSize > m_RegionSize )
         {
-            std::cerr << "Command pool creation failed!" << std::endl;
-            return result;
+            return false;
         }
 
-        result = CreateDepthResources();
-        if( result != StatusCode::Success )
-        {
-            std::cerr << "Depth resources creation failed!" << std::endl;
-            return result;
-        }
+        dynamicOffset = static_cast<uint32_t>( m_RegionOffset + m_Head );
+        m_Head += alignedSize;
 
-        result = CreateFramebuffers();
-        if( result != StatusCode::Success )
-        {
-            std::cerr << "Frame buffers creation failed!" << std::endl;
-            return result;
-        }
+        memcpy( m_MappedData + dynamicOffset, data, static_cast<size_t>( size ) );
 
-        result = CreateTextureImage();
-        if( result != StatusCode::Success )
-        {
-            std::cerr << "Texture image creation failed!" << std::endl;
-            return result;
-        }
+        return true;
+    }
+};
 
-        result = CreateTextureImageView();
-        if( result != StatusCode::Success )
-        {
-            std::cerr << "Texture image view creation failed!" << std::endl;
-            return result;
-        }
+////////////////////////////////////////////////////////////
+/// Persistently mapped staging ring buffer, uploads are streamed through it in chunks.
+/// Head and tail only grow, bytes between them are still read by the gpu.
+////////////////////////////////////////////////////////////
+struct GpuStagingRingBuffer
+{
+    VkBuffer                          m_Buffer;
+    std::pair<uint32_t, VkDeviceSize> m_GpuMemoryOffsets;
+    uint8_t*                          m_MappedData;
+    VkDeviceSize                      m_Size;
+    VkDeviceSize                      m_Alignment; // Alignment of the chunk offsets.
+    VkDeviceSize                      m_Head;      // End of the reserved bytes, only grows and wraps by the ring size.
+    VkDeviceSize                      m_Tail;      // Start of the bytes the gpu can still read, never past the head.
 
-        result = CreateTextureSampler();
-        if( result != StatusCode::Success )
-        {
-            std::cerr << "Texture sampler creation failed!" << std::endl;
-            return result;
-        }
+    ////////////////////////////////////////////////////////////
+    /// Reserves up to size contiguous bytes but at least minSize,
+    /// returns the reserved byte count or zero if the ring is full.
+    ////////////////////////////////////////////////////////////
+    VkDeviceSize Reserve( const VkDeviceSize size, const VkDeviceSize minSize, VkDeviceSize& offset )
+    {
+        // Submitted batches keep the head they were submitted with, so the head is never reset.
+        VkDeviceSize head = GpuMemoryBlock::AlignUp( m_Head, m_Alignment );
 
-        result = CreateVertexBuffer();
-        if( result != StatusCode::Success )
+        // Skip the end of the ring if the chunk does not fit there.
+        if( m_Size - head % m_Size < minSize )
         {
-            std::cerr << "Vertex buffers creation failed!" << std::endl;
-            return result;
+            head = GpuMemoryBlock::AlignUp( head, m_Size );
         }
 
-        result = CreateIndexBuffer();
-        if( result != StatusCode::Success )
+        if( head - m_Tail >= m_Size )
         {
-            std::cerr << "Index buffers creation failed!" << std::endl;
-            return result;
+            return 0;
         }
 
-        result = CreateUniformBuffers();
-        if( result != StatusCode::Success )
-        {
-            std::cerr << "Uniform buffers creation failed!" << std::endl;
-            return result;
-        }
+        const VkDeviceSize reservedSize = std::min( { size, m_Size - ( head - m_Tail ), m_Size - head % m_Size } );
 
-        result = CreateComputeBuffers();
-        if( result != StatusCode::Success )
+        if( reservedSize < minSize )
         {
-            std::cerr << "Compute buffers creation failed!" << std::endl;
-            return result;
+            return 0;
         }
 
-        result = CreateDescriptorPool();
-        if( result != StatusCode::Success )
-        {
-            std::cerr << "Descriptor pool creation failed!" << std::endl;
-            return result;
-        }
+        offset = head % m_Size;
+        m_Head = head + reservedSize;
 
-        result = CreateDescriptorSets();
-        if( result != StatusCode::Success )
-        {
-            std::cerr << "Descriptor sets creation failed!" << std::endl;
-            return result;
-        }
+        return reservedSize;
+    }
 
-        result = CreateCommandBuffers();
-        if( result != StatusCode::Success )
-        {
-            std::cerr << "Command buffers creation failed!" << std::endl;
-            return result;
-        }
+    ////////////////////////////////////////////////////////////
+    /// Releases the bytes reserved before the given head.
+    ////////////////////////////////////////////////////////////
+    void Release( const VkDeviceSize head )
+    {
+        m_Tail = std::max( m_Tail, std::min( head, m_Head ) );
+    }
+};
 
-        result = CreateQueries();
-        if( result != StatusCode::Success )
-        {
-            std::cerr << "Queries creation failed!" << std::endl;
-            return result;
-        }
+////////////////////////////////////////////////////////////
+/// Gpu resource which defragmentation can move to another block.
+////////////////////////////////////////////////////////////
+struct GpuMovableResource
+{
+    VkBuffer*                          m_Buffer;      // Buffer to move or null.
+    VkImage*                           m_Image;       // Image to move or null.
+    VkImageView*                       m_ImageView;   // Image view to recreate or null.
+    std::pair<uint32_t, VkDeviceSize>* m_GpuMemoryOffsets;
+    VkBufferCreateInfo                 m_BufferInfo;
+    VkImageCreateInfo                  m_ImageInfo;
+    VkImageAspectFlags                 m_ImageAspect;
+    VkImageLayout                      m_ImageLayout; // Layout of the image between frames.
+    GpuResourceOwner                   m_Owner;
+    bool                               m_IsMoveFailed; // The resource did not fit, so its block is not defragmented until memory is freed.
+};
 
-        result = RecordCommandBuffers();
-        if( result != StatusCode::Success )
-        {
-            std::cerr << "Command buffers recording failed!" << std::endl;
-            return result;
-        }
+////////////////////////////////////////////////////////////
+/// Gpu resource move, holds the new resource until the swap and the old one after it.
+////////////////////////////////////////////////////////////
+struct GpuMemoryMove
+{
+    uint32_t                          m_ResourceIndex;
+    VkBuffer                          m_Buffer;
+    VkImage                           m_Image;
+    VkImageView                       m_ImageView;
+    std::pair<uint32_t, VkDeviceSize> m_GpuMemoryOffsets;
+};
 
-        result = CreateSemaphores();
-        if( result != StatusCode::Success )
-        {
-            std::cerr << "Semaphores creation failed!" << std::endl;
-            return result;
-        }
+////////////////////////////////////////////////////////////
+/// Timed event of the trace.
+////////////////////////////////////////////////////////////
+struct TraceEvent
+{
+    const char* m_Name;  // Static string, events are written long after they are added.
+    int64_t     m_Begin; // Nanoseconds since the trace was enabled.
+    int64_t     m_End;
+    uint32_t    m_Track;
+};
 
-        result = CreateFences();
-        if( result != StatusCode::Success )
+////////////////////////////////////////////////////////////
+/// Ring buffer of trace events written by a single thread.
+/// An event is published by incrementing the count, so neither the writer nor readers lock.
+////////////////////////////////////////////////////////////
+struct TraceThreadBuffer
+{
+    std::array<TraceEvent, TraceEventsPerThread> m_Events;
+    std::atomic<uint64_t>                        m_Count;   // Events ever written.
+    std::atomic<bool>                            m_IsInUse; // Owned by a running thread.
+    uint32_t                                     m_Track;
+};
+
+////////////////////////////////////////////////////////////
+/// Trace buffer of the current thread, released for reuse when the thread exits.
+////////////////////////////////////////////////////////////
+struct TraceThreadRegistration
+{
+    TraceThreadBuffer* m_Buffer;
+
+    ~TraceThreadRegistration()
+    {
+        if( m_Buffer != nullptr )
         {
-            std::cerr << "Fences creation failed!" << std::endl;
-            return result;
+            m_Buffer->m_IsInUse.store( false, std::memory_order_release );
         }
-
-        return result;
     }
+};
+
+////////////////////////////////////////////////////////////
+/// Collects trace events of all threads and writes them in the chrome trace format.
+////////////////////////////////////////////////////////////
+struct Tracer
+{
+    std::mutex                                      m_Mutex; // Guards registration of thread buffers and writing.
+    std::vector<std::unique_ptr<TraceThreadBuffer>> m_Buffers;
+    FrameClock::time_point                          m_StartTime;
+    std::atomic<bool>                               m_IsEnabled;
 
     ////////////////////////////////////////////////////////////
-    /// Main loop of the application.
+    /// Returns the tracer of the process.
     ////////////////////////////////////////////////////////////
-    StatusCode MainLoop()
+    static Tracer& Get()
     {
-        StatusCode result = StatusCode::Success;
-
-        // Check for events.
-        while( !glfwWindowShouldClose( m_Window ) && result == StatusCode::Success )
-        {
-            glfwPollEvents();
-            result = DrawFrameAndMultiplyVector();
-        }
+        static Tracer tracer;
 
-        if( vkDeviceWaitIdle( m_Device ) != VK_SUCCESS )
-        {
-            std::cerr << "Failed to waiting for device!" << std::endl;
-            return StatusCode::Fail;
-        }
-
-        return result;
+        return tracer;
     }
 
     ////////////////////////////////////////////////////////////
-    /// Cleanups the window.
+    /// Starts the trace clock and enables recording of events.
     ////////////////////////////////////////////////////////////
-    StatusCode CleanupWindow()
+    void Enable()
     {
-        // Destroy the windows.
-        glfwDestroyWindow( m_Window );
-
-        // Destroy glfw library.
-        glfwTerminate();
-
-        return StatusCode::Success;
+        m_StartTime = FrameClock::now();
+        m_IsEnabled.store( true, std::memory_order_release );
     }
 
     ////////////////////////////////////////////////////////////
-    /// Loads a model.
+    /// Checks if events are recorded.
     ////////////////////////////////////////////////////////////
-    StatusCode LoadModel()
+    bool IsEnabled() const
     {
-        return TinyObjLoader::loadModel( "Models/viking_room.obj", Vertices, Indices )
-            ? StatusCode::Success
-            : StatusCode::Fail;
+        return m_IsEnabled.load( std::memory_order_acquire );
     }
 
     ////////////////////////////////////////////////////////////
-    /// Creates Vulkan instance.
+    /// Returns nanoseconds since the trace was enabled.
     ////////////////////////////////////////////////////////////
-    StatusCode CreateInstance()
+    int64_t GetTime() const
     {
-        // Information about the application.
-        VkApplicationInfo applicationInfo  = {};
-        applicationInfo.sType              = VK_STRUCTURE_TYPE_APPLICATION_INFO;
-        applicationInfo.pApplicationName   = m_WindowName.c_str();
-        applicationInfo.applicationVersion = VK_MAKE_VERSION( 1, 0, 0 );
-        applicationInfo.pEngineName        = "No Engine";
-        applicationInfo.engineVersion      = VK_MAKE_VERSION( 1, 0, 0 );
-        applicationInfo.apiVersion         = VK_API_VERSION_1_0;
+        return std::chrono::duration_cast<std::chrono::nanoseconds>( FrameClock::now() - m_StartTime ).count();
+    }
 
-        // Obtain required extensions.
-        uint32_t                 glfwExtensionCount = 0;
-        const char**             glfwExtensions     = glfwGetRequiredInstanceExtensions( &glfwExtensionCount );
-        std::vector<const char*> extensions( glfwExtensions, glfwExtensions + glfwExtensionCount );
+    ////////////////////////////////////////////////////////////
+    /// Converts a timestamp of the trace time domain to nanoseconds since the trace was enabled.
+    /// The trace clock counts from the same origin as the performance counter or the monotonic clock.
+    ////////////////////////////////////////////////////////////
+    int64_t GetTime( const uint64_t hostTimestamp ) const
+    {
+#if defined( _WIN32 )
+        LARGE_INTEGER counterFrequency = {};
+        QueryPerformanceFrequency( &counterFrequency );
 
-#ifdef _DEBUG
-        // Add debug messenger extension.
-        extensions.push_back( VK_EXT_DEBUG_UTILS_EXTENSION_NAME );
+        const uint64_t frequency   = static_cast<uint64_t>( counterFrequency.QuadPart );
+        const uint64_t nanoseconds = hostTimestamp / frequency * 1000000000 + hostTimestamp % frequency * 1000000000 / frequency;
+#else
+        const uint64_t nanoseconds = hostTimestamp;
 #endif
 
-        // Enumarate supported extensions.
-        uint32_t extensionCount = 0;
-        vkEnumerateInstanceExtensionProperties( nullptr, &extensionCount, nullptr );
+        return static_cast<int64_t>( nanoseconds ) - std::chrono::duration_cast<std::chrono::nanoseconds>( m_StartTime.time_since_epoch() ).count();
+    }
 
-        std::vector<VkExtensionProperties> availableExtensions( extensionCount );
-        vkEnumerateInstanceExtensionProperties( nullptr, &extensionCount, availableExtensions.data() );
+    ////////////////////////////////////////////////////////////
+    /// Adds an event to the buffer of the calling thread.
+    /// Zero track selects the track of the calling thread.
+    ////////////////////////////////////////////////////////////
+    void AddEvent( const char* name, const int64_t begin, const int64_t end, const uint32_t track = 0 )
+    {
+        TraceThreadBuffer& buffer = GetThreadBuffer();
+        const uint64_t     count  = buffer.m_Count.load( std::memory_order_relaxed );
 
-        // Check if required extensions are supported.
-        std::set<std::string> requiredRequiredExtensions( extensions.begin(), extensions.end() );
+        buffer.m_Events[count % TraceEventsPerThread] = { name, begin, end, track != 0 ? track : buffer.m_Track };
+        buffer.m_Count.store( count + 1, std::memory_order_release );
+    }
 
-        for( const auto& extension : availableExtensions )
+    ////////////////////////////////////////////////////////////
+    /// Returns the buffer of the calling thread, registers it on first use.
+    ////////////////////////////////////////////////////////////
+    TraceThreadBuffer& GetThreadBuffer()
+    {
+        thread_local TraceThreadRegistration registration = {};
+
+        if( registration.m_Buffer != nullptr )
         {
-            requiredRequiredExtensions.erase( extension.extensionName );
+            return *registration.m_Buffer;
         }
 
-        if( !requiredRequiredExtensions.empty() )
+        const std::lock_guard<std::mutex> lock( m_Mutex );
+
+        // Buffers of exited threads are reused, worker threads may be created for each task.
+        for( const auto& buffer : m_Buffers )
         {
-            std::cerr << "Cannot find required extensions!" << std::endl;
-            return StatusCode::Fail;
+            if( !buffer->m_IsInUse.load( std::memory_order_acquire ) )
+            {
+                buffer->m_IsInUse.store( true, std::memory_order_relaxed );
+                registration.m_Buffer = buffer.get();
+                return *registration.m_Buffer;
+            }
         }
 
-#ifdef _DEBUG
-        // Enumarate supported validation layers.
-        uint32_t layerCount;
-        vkEnumerateInstanceLayerProperties( &layerCount, nullptr );
+        m_Buffers.emplace_back( std::make_unique<TraceThreadBuffer>() );
 
-        std::vector<VkLayerProperties> availableLayers( layerCount );
-        vkEnumerateInstanceLayerProperties( &layerCount, availableLayers.data() );
+        registration.m_Buffer          = m_Buffers.back().get();
+        registration.m_Buffer->m_Track = static_cast<uint32_t>( m_Buffers.size() );
+        registration.m_Buffer->m_IsInUse.store( true, std::memory_order_relaxed );
 
-        // Check if required validation layers are supported.
-        std::set<std::string> requiredValidationLayers( m_ValidationLayers.begin(), m_ValidationLayers.end() );
+        return *registration.m_Buffer;
+    }
 
-        for( const auto& layer : availableLayers )
-        {
-            requiredValidationLayers.erase( layer.layerName );
-        }
+    ////////////////////////////////////////////////////////////
+    /// Writes events of all threads as a json file for chrome://tracing and Perfetto.
+    /// Threads keep adding events meanwhile, events overwritten during the copy are dropped.
+    ////////////////////////////////////////////////////////////
+    StatusCode Write( const std::string& fileName )
+    {
+        const std::lock_guard<std::mutex> lock( m_Mutex );
 
-        if( !requiredValidationLayers.empty() )
+        std::ofstream file( fileName );
+
+        if( !file.is_open() )
         {
-            std::cerr << "Cannot find required validation layers!" << std::endl;
+            std::cerr << "Cannot open " << fileName << " file!" << std::endl;
             return StatusCode::Fail;
         }
-#endif
-
-        // Sufficient information for creating an instance.
-        VkInstanceCreateInfo createInfo    = {};
-        createInfo.sType                   = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
-        createInfo.pApplicationInfo        = &applicationInfo;
-        createInfo.enabledExtensionCount   = static_cast<uint32_t>( extensions.size() );
-        createInfo.ppEnabledExtensionNames = extensions.data();
-#ifdef _DEBUG
-        createInfo.enabledLayerCount   = static_cast<uint32_t>( m_ValidationLayers.size() );
-        createInfo.ppEnabledLayerNames = m_ValidationLayers.data();
 
-        VkDebugUtilsMessengerCreateInfoEXT debugCreateInfo = {};
-        PopulateDebugMessengerCreateInfo( debugCreateInfo );
+        // Timestamps are in microseconds, nanoseconds are kept as decimals.
+        file << std::fixed << std::setprecision( 3 );
+        file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n"
+             << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << TraceGraphicsQueueTrack << ", \"args\": {\"name\": \"gpu graphics queue\"}},\n"
+             << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << TraceComputeQueueTrack << ", \"args\": {\"name\": \"gpu compute queue\"}}";
 
-        if constexpr( EnableBestPracticesValidation )
+        for( const auto& buffer : m_Buffers )
         {
-            const VkValidationFeatureEnableEXT enables  = VK_VALIDATION_FEATURE_ENABLE_BEST_PRACTICES_EXT;
-            VkValidationFeaturesEXT            features = {};
+            file << ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer->m_Track
+                 << ", \"args\": {\"name\": \"cpu thread " << buffer->m_Track << "\"}}";
 
-            features.sType                         = VK_STRUCTURE_TYPE_VALIDATION_FEATURES_EXT;
-            features.enabledValidationFeatureCount = 1;
-            features.pEnabledValidationFeatures    = &enables;
+            const uint64_t          count  = buffer->m_Count.load( std::memory_order_acquire );
+            const uint64_t          first  = count > TraceEventsPerThread ? count - TraceEventsPerThread : 0;
+            std::vector<TraceEvent> events = {};
 
-            createInfo.pNext = &features;
-        }
-        else
-        {
-            createInfo.pNext = &debugCreateInfo;
-        }
-#else
-        createInfo.enabledLayerCount       = 0;
-#endif
+            for( uint64_t i = first; i < count; ++i )
+            {
+                events.emplace_back( buffer->m_Events[i % TraceEventsPerThread] );
+            }
 
-        if( vkCreateInstance( &createInfo, nullptr, &m_Instance ) != VK_SUCCESS )
-        {
-            std::cerr << "Cannot create Vulkan instance!" << std::endl;
-            return StatusCode::Fail;
+            // The writer may be overwriting the slot of the event after the last published one.
+            std::atomic_thread_fence( std::memory_order_acquire );
+
+            const uint64_t newCount   = buffer->m_Count.load( std::memory_order_relaxed );
+            const uint64_t validFirst = newCount + 1 > TraceEventsPerThread ? newCount + 1 - TraceEventsPerThread : 0;
+
+            for( uint64_t i = std::max( first, validFirst ); i < count; ++i )
+            {
+                const TraceEvent& event = events[i - first];
+
+                file << ",\n{\"name\": \"" << event.m_Name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << event.m_Track
+                     << ", \"ts\": " << event.m_Begin / 1000.0 << ", \"dur\": " << ( event.m_End - event.m_Begin ) / 1000.0 << "}";
+            }
         }
 
-        return StatusCode::Success;
+        file << "\n]}\n";
+
+        return file.good() ? StatusCode::Success : StatusCode::Fail;
     }
+};
 
-    ////////////////////////////////////////////////////////////
-    /// Creates Vulkan surface.
-    ////////////////////////////////////////////////////////////
-    StatusCode CreateSurface()
+////////////////////////////////////////////////////////////
+/// Traces the lifetime of a scope on the calling thread, does nothing if tracing is disabled.
+////////////////////////////////////////////////////////////
+struct TraceZone
+{
+    const char* m_Name;
+    int64_t     m_Begin; // Negative if tracing is disabled.
+
+    explicit TraceZone( const char* name )
+        : m_Name( name )
+        , m_Begin( Tracer::Get().IsEnabled() ? Tracer::Get().GetTime() : -1 )
     {
-        if( glfwCreateWindowSurface( m_Instance, m_Window, nullptr, &m_Surface ) != VK_SUCCESS )
+    }
+
+    ~TraceZone()
+    {
+        if( m_Begin >= 0 )
         {
-            std::cerr << "Cannot create Vulkan surface using glfw library!" << std::endl;
-            return StatusCode::Fail;
+            Tracer::Get().AddEvent( m_Name, m_Begin, Tracer::Get().GetTime() );
         }
-
-        return StatusCode::Success;
     }
 
+    TraceZone( const TraceZone& )            = delete;
+    TraceZone& operator=( const TraceZone& ) = delete;
+};
+
+////////////////////////////////////////////////////////////
+/// Worker threads of cpu verification and references.
+/// Tasks must not wait for other tasks, ranges are waited for on threads outside of the pool.
+////////////////////////////////////////////////////////////
+struct ThreadPool
+{
+    std::vector<std::thread>          m_Threads;
+    std::deque<std::function<void()>> m_Tasks;
+    std::mutex                        m_Mutex;
+    std::condition_variable           m_Condition;
+    bool                              m_IsStopping; // Guarded by the mutex, set at process exit.
+
     ////////////////////////////////////////////////////////////
-    /// Picks a suitable graphics card.
+    /// Returns the thread pool of the process, one thread per hardware thread.
     ////////////////////////////////////////////////////////////
-    StatusCode PickPhysicalDevice()
+    static ThreadPool& Get()
     {
-        // Enumerate for available graphics cards.
-        uint32_t physicalDeviceCount = 0;
-        vkEnumeratePhysicalDevices( m_Instance, &physicalDeviceCount, nullptr );
-
-        if( physicalDeviceCount == 0 )
-        {
-            std::cerr << "Cannot find a physical device!" << std::endl;
-            StatusCode::Fail;
-        }
+        static ThreadPool threadPool;
 
-        std::vector<VkPhysicalDevice> physicalDevices( physicalDeviceCount );
-        vkEnumeratePhysicalDevices( m_Instance, &physicalDeviceCount, physicalDevices.data() );
+        return threadPool;
+    }
 
-        // Choose a suitibale graphics card.
-        uint32_t bestScore = 0;
+    ThreadPool()
+        : m_Threads{}
+        , m_Tasks{}
+        , m_Mutex{}
+        , m_Condition{}
+        , m_IsStopping( false )
+    {
+        const uint32_t threadCount = std::max( std::thread::hardware_concurrency(), 1u );
 
-        for( const auto& physicalDevice : physicalDevices )
+        for( uint32_t i = 0; i < threadCount; ++i )
         {
-            if( IsPhysicalDeviceSuitable( physicalDevice ) )
-            {
-                uint32_t currentScore = RatePhysicalDeviceSuitability( physicalDevice );
-                if( currentScore > bestScore )
-                {
-                    m_PhysicalDevice = physicalDevice;
-                    bestScore        = currentScore;
-                }
-            }
+            m_Threads.emplace_back( [this]() { Work(); } );
         }
+    }
 
-        if( m_PhysicalDevice == VK_NULL_HANDLE )
+    ~ThreadPool()
+    {
         {
-            std::cerr << "Cannot find a suitable physical device!" << std::endl;
-            StatusCode::Fail;
+            std::lock_guard<std::mutex> lock( m_Mutex );
+            m_IsStopping = true;
         }
 
-        return StatusCode::Success;
+        m_Condition.notify_all();
+
+        for( std::thread& thread : m_Threads )
+        {
+            thread.join();
+        }
     }
 
+    ThreadPool( const ThreadPool& )            = delete;
+    ThreadPool& operator=( const ThreadPool& ) = delete;
+
     ////////////////////////////////////////////////////////////
-    /// Rates graphics card suitability.
+    /// Returns the number of worker threads.
     ////////////////////////////////////////////////////////////
-    uint32_t RatePhysicalDeviceSuitability( VkPhysicalDevice physicalDevice )
+    uint32_t GetThreadCount() const
     {
-        // Get the physical device properties.
-        VkPhysicalDeviceProperties physicalDeviceProperties = {};
-        vkGetPhysicalDeviceProperties( physicalDevice, &physicalDeviceProperties );
-
-        // Get the physical device features.
-        vkGetPhysicalDeviceFeatures( physicalDevice, &m_PhysicalDeviceFeatures );
-
-        // Do not choose a physical device without tessellation shader support.
-        if( !m_PhysicalDeviceFeatures.tessellationShader )
-        {
-            return 0;
-        }
+        return static_cast<uint32_t>( m_Threads.size() );
+    }
 
-        uint32_t score = 0;
+    ////////////////////////////////////////////////////////////
+    /// Calls the function with contiguous ranges of elements on worker threads and waits for them.
+    ////////////////////////////////////////////////////////////
+    template<typename Function>
+    void ForEachRange( const uint32_t elementCount, const uint32_t rangeCount, const Function& function )
+    {
+        std::vector<std::future<void>> ranges( rangeCount );
 
-        switch( physicalDeviceProperties.deviceType )
+        for( uint32_t r = 0; r < rangeCount; ++r )
         {
-            case VK_PHYSICAL_DEVICE_TYPE_OTHER:
-                score += 2;
-                break;
-
-            case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
-                score += 100;
-                break;
-
-            case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
-                score += 1000;
-                break;
+            const uint32_t begin = static_cast<uint32_t>( static_cast<uint64_t>( elementCount ) * r / rangeCount );
+            const uint32_t end   = static_cast<uint32_t>( static_cast<uint64_t>( elementCount ) * ( r + 1 ) / rangeCount );
 
-            case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
-                score += 10;
-                break;
+            auto task = std::make_shared<std::packaged_task<void()>>( [&function, r, begin, end]() { function( r, begin, end ); } );
+            ranges[r] = task->get_future();
 
-            case VK_PHYSICAL_DEVICE_TYPE_CPU:
-                score += 5;
-                break;
+            {
+                std::lock_guard<std::mutex> lock( m_Mutex );
+                m_Tasks.emplace_back( [task]() { ( *task )(); } );
+            }
 
-            default:
-                score += 1;
+            m_Condition.notify_one();
         }
 
-        score += physicalDeviceProperties.limits.maxImageDimension2D;
-
-        // Get max sampler anisotropy.
-        if( m_PhysicalDeviceFeatures.samplerAnisotropy )
+        for( auto& range : ranges )
         {
-            m_MaxSamplerAnisotropy = physicalDeviceProperties.limits.maxSamplerAnisotropy;
+            range.get();
         }
-
-        // Get pipeline statistics query.
-        m_IsPipelineStatisticsQuerySupported = m_PhysicalDeviceFeatures.pipelineStatisticsQuery;
-
-        // Get max compute work group x.
-        m_VectorElementCount = physicalDeviceProperties.limits.maxComputeWorkGroupCount[0];
-
-        return score;
     }
 
     ////////////////////////////////////////////////////////////
-    /// Checks if the physical device is suitable.
+    /// Runs tasks until the pool stops.
     ////////////////////////////////////////////////////////////
-    bool IsPhysicalDeviceSuitable( VkPhysicalDevice physicalDevice )
+    void Work()
     {
-        const QueueFamilyIndices      indices = FindQueueFamilies( physicalDevice );
-        const SwapChainSupportDetails details = QuerySwapChainSupport( physicalDevice );
+        while( true )
+        {
+            std::function<void()> task;
 
-        const bool areQueueFamiliesSupported =
-            indices.m_HasGraphicsFamily &&
-            indices.m_HasPresentFamily;
+            {
+                std::unique_lock<std::mutex> lock( m_Mutex );
+                m_Condition.wait( lock, [this]() { return m_IsStopping || !m_Tasks.empty(); } );
 
-        const bool areExtensionsSupported =
-            areQueueFamiliesSupported &&
-            CheckPhysicalDeviceExtensionSupport( physicalDevice );
+                if( m_Tasks.empty() )
+                {
+                    return;
+                }
 
-        const bool areSwapChainDetailsSupported =
-            areExtensionsSupported &&
-            !details.m_Formats.empty() &&
-            !details.m_PresentModes.empty();
+                task = std::move( m_Tasks.front() );
+                m_Tasks.pop_front();
+            }
 
-        return areSwapChainDetailsSupported;
+            task();
+        }
     }
+};
+
+////////////////////////////////////////////////////////////
+/// Mismatch of a compute result.
+////////////////////////////////////////////////////////////
+struct ComputeMismatch
+{
+    uint32_t m_Index;
+    float    m_Value;
+    float    m_Expected;
+};
+
+////////////////////////////////////////////////////////////
+/// Result of a compute verification.
+////////////////////////////////////////////////////////////
+struct ComputeVerificationReport
+{
+    uint64_t                     m_VerifiedCount;
+    uint64_t                     m_MismatchCount;
+    float                        m_MaxError;   // Absolute, in ulps or relative by the verification mode.
+    std::vector<ComputeMismatch> m_Mismatches; // First mismatches by index.
+};
+
+////////////////////////////////////////////////////////////
+/// Timeline semaphore of a queue, each submission signals the next value.
+////////////////////////////////////////////////////////////
+struct GpuTimeline
+{
+    VkSemaphore m_Semaphore;
+    uint64_t    m_Value; // Value signaled by the last submission.
+};
+
+////////////////////////////////////////////////////////////
+/// Semaphore wait of a submission.
+////////////////////////////////////////////////////////////
+struct GpuSemaphoreWait
+{
+    VkSemaphore          m_Semaphore;
+    uint64_t             m_Value; // Ignored for binary semaphores.
+    VkPipelineStageFlags m_Stage;
+};
+
+////////////////////////////////////////////////////////////
+/// Named gpu profiler scope recorded in a command buffer.
+////////////////////////////////////////////////////////////
+struct GpuProfilerScope
+{
+    const char* m_Name;
+    uint32_t    m_Depth; // Number of enclosing scopes.
+};
+
+////////////////////////////////////////////////////////////
+/// Resolved duration of a gpu profiler scope.
+////////////////////////////////////////////////////////////
+struct GpuProfilerResult
+{
+    const char* m_Name;
+    uint32_t    m_Depth;
+    double      m_Milliseconds;
+    uint64_t    m_BeginTimestamp; // Gpu ticks, used to place the scope on the trace timeline.
+    uint64_t    m_EndTimestamp;
+};
+
+////////////////////////////////////////////////////////////
+/// Correlation of the timestamps of a queue with the trace clock.
+/// Queues may have separate time domains, so each queue is calibrated on its own.
+////////////////////////////////////////////////////////////
+struct GpuTimestampCalibration
+{
+    uint64_t m_Timestamp;       // Gpu ticks of the calibration.
+    int64_t  m_Time;            // Trace nanoseconds of the calibration.
+    double   m_TimestampPeriod; // Nanoseconds per timestamp tick.
+    uint64_t m_TimestampMask;   // Valid bits of the timestamps of the queue family.
+    bool     m_IsCalibrated;
 
     ////////////////////////////////////////////////////////////
-    /// Checks for needed physical device extensions support.
+    /// Converts gpu ticks of the queue to trace nanoseconds.
+    /// Ticks are taken relative to the calibration, so large counter values keep their precision.
     ////////////////////////////////////////////////////////////
-    bool CheckPhysicalDeviceExtensionSupport( VkPhysicalDevice physicalDevice )
+    int64_t GetTime( const uint64_t timestamp ) const
     {
-        uint32_t extensionCount;
-        vkEnumerateDeviceExtensionProperties( physicalDevice, nullptr, &extensionCount, nullptr );
+        // Counters with less than 64 valid bits wrap, so the difference is taken in the valid bits and sign extended.
+        const uint64_t difference = ( timestamp - m_Timestamp ) & m_TimestampMask;
+        const uint64_t signBit    = ( m_TimestampMask >> 1 ) + 1;
+        const int64_t  ticks      = static_cast<int64_t>( ( difference ^ signBit ) - signBit );
 
-        std::vector<VkExtensionProperties> availableExtensions( extensionCount );
-        vkEnumerateDeviceExtensionProperties( physicalDevice, nullptr, &extensionCount, availableExtensions.data() );
+        return m_Time + static_cast<int64_t>( ticks * m_TimestampPeriod );
+    }
+};
 
-        std::set<std::string> requiredExtensions( m_PhysicalDeviceExtensions.begin(), m_PhysicalDeviceExtensions.end() );
+////////////////////////////////////////////////////////////
+/// Gpu profiler writing timestamps of nested scopes to a query pool per command buffer slot.
+/// Scope k of a slot owns queries 2k and 2k + 1.
+////////////////////////////////////////////////////////////
+struct GpuProfiler
+{
+    std::vector<VkQueryPool>                   m_QueryPools;      // One per slot, empty if timestamps are not supported.
+    std::vector<std::vector<GpuProfilerScope>> m_Scopes;          // Scopes recorded in each slot.
+    std::vector<uint32_t>                      m_OpenScopes;      // Scopes of the recorded slot which are not ended yet.
+    double                                     m_TimestampPeriod; // Nanoseconds per timestamp tick.
+    uint64_t                                   m_TimestampMask;   // Valid bits of the timestamps of the queue family.
 
-        for( const auto& extension : availableExtensions )
+    ////////////////////////////////////////////////////////////
+    /// Starts recording scopes of the slot, resets its queries.
+    ////////////////////////////////////////////////////////////
+    void BeginSlot( const VkCommandBuffer commandBuffer, const uint32_t slot )
+    {
+        if( slot >= m_QueryPools.size() )
         {
-            requiredExtensions.erase( extension.extensionName );
+            return;
         }
 
-        return requiredExtensions.empty();
+        vkCmdResetQueryPool( commandBuffer, m_QueryPools[slot], 0, GpuProfilerQueryCount );
+
+        m_Scopes[slot].clear();
+        m_OpenScopes.clear();
     }
 
     ////////////////////////////////////////////////////////////
-    /// Creates a logical device.
+    /// Begins a scope nested in the open scopes of the slot.
     ////////////////////////////////////////////////////////////
-    StatusCode CreateLogicalDevice()
+    void BeginScope(
+        const VkCommandBuffer         commandBuffer,
+        const uint32_t                slot,
+        const char*                   name,
+        const VkPipelineStageFlagBits stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT )
     {
-        // Get graphics queue family index.
-        m_QueueFamilyIndices = FindQueueFamilies( m_PhysicalDevice );
-
-        // Graphics, compute, copy and present queues create information.
-        std::vector<VkDeviceQueueCreateInfo>    queueCreateInfos    = {};
-        std::vector<std::vector<float>>         queuesPriorities    = {};
-        std::set<std::pair<uint32_t, uint32_t>> uniqueQueueFamilies = {
-            { m_QueueFamilyIndices.m_GraphicsFamily, m_QueueFamilyIndices.m_GraphicsCount },
-            { m_QueueFamilyIndices.m_ComputeFamily, m_QueueFamilyIndices.m_ComputeCount },
-            { m_QueueFamilyIndices.m_CopyFamily, m_QueueFamilyIndices.m_CopyCount },
-            { m_QueueFamilyIndices.m_PresentFamily, m_QueueFamilyIndices.m_PresentCount }
-        };
-
-        for( const auto& queueFamily : uniqueQueueFamilies )
+        if( slot >= m_QueryPools.size() )
         {
-            if( queueFamily.second == 0 )
-            {
-                // Queue count is equal 0, continuing.
-                continue;
-            }
-
-            // Set the queue priority.
-            std::vector<float> queuePriorities( queueFamily.second );
-
-            for( auto& queuePriority : queuePriorities )
-            {
-                queuePriority = 1.0f;
-            }
-
-            queuesPriorities.emplace_back( queuePriorities );
-
-            // Populate queue create information.
-            VkDeviceQueueCreateInfo queueCreateInfo = {};
-            queueCreateInfo.sType                   = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-            queueCreateInfo.queueFamilyIndex        = queueFamily.first;
-            queueCreateInfo.queueCount              = queueFamily.second;
-            queueCreateInfo.pQueuePriorities        = queuesPriorities.back().data();
-
-            queueCreateInfos.emplace_back( queueCreateInfo );
+            return;
         }
 
-        // Populate logical device create information.
-        VkDeviceCreateInfo deviceCreateInfo      = {};
-        deviceCreateInfo.sType                   = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-        deviceCreateInfo.queueCreateInfoCount    = static_cast<uint32_t>( queueCreateInfos.size() );
-        deviceCreateInfo.pQueueCreateInfos       = queueCreateInfos.data();
-        deviceCreateInfo.pEnabledFeatures        = &m_PhysicalDeviceFeatures;
-        deviceCreateInfo.enabledExtensionCount   = static_cast<uint32_t>( m_PhysicalDeviceExtensions.size() );
-        deviceCreateInfo.ppEnabledExtensionNames = m_PhysicalDeviceExtensions.data();
-#ifdef _DEBUG
-        deviceCreateInfo.enabledLayerCount   = static_cast<uint32_t>( m_ValidationLayers.size() );
-        deviceCreateInfo.ppEnabledLayerNames = m_ValidationLayers.data();
-#else
-        deviceCreateInfo.enabledLayerCount = 0;
-#endif
+        std::vector<GpuProfilerScope>& scopes     = m_Scopes[slot];
+        const uint32_t                 scopeIndex = static_cast<uint32_t>( scopes.size() );
 
-        // Create a logical device.
-        if( vkCreateDevice( m_PhysicalDevice, &deviceCreateInfo, nullptr, &m_Device ) != VK_SUCCESS )
+        // Scopes which do not fit the query pool are not profiled, but still nest.
+        if( 2 * scopeIndex + 2 > GpuProfilerQueryCount )
         {
-            std::cerr << "Cannot create a logical device!" << std::endl;
-            return StatusCode::Fail;
+            m_OpenScopes.emplace_back( UINT32_MAX );
+            return;
         }
 
-        // Get graphics queue.
-        const uint32_t graphicsQueueIndex = m_QueueFamilyIndices.m_GraphicsCount - 1;
+        scopes.push_back( { name, static_cast<uint32_t>( m_OpenScopes.size() ) } );
+        m_OpenScopes.emplace_back( scopeIndex );
 
-        vkGetDeviceQueue( m_Device, m_QueueFamilyIndices.m_GraphicsFamily, graphicsQueueIndex, &m_GraphicsQueue );
-        if( m_GraphicsQueue == nullptr )
+        vkCmdWriteTimestamp( commandBuffer, stage, m_QueryPools[slot], 2 * scopeIndex );
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Ends the innermost open scope of the slot.
+    ////////////////////////////////////////////////////////////
+    void EndScope(
+        const VkCommandBuffer         commandBuffer,
+        const uint32_t                slot,
+        const VkPipelineStageFlagBits stage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT )
+    {
+        if( slot >= m_QueryPools.size() || m_OpenScopes.empty() )
         {
-            std::cerr << "Cannot obtain graphics queue!" << std::endl;
-            return StatusCode::Fail;
+            return;
         }
 
-        // Get compute queue.
-        if( m_QueueFamilyIndices.m_HasComputeFamily &&
-            m_QueueFamilyIndices.m_GraphicsFamily != m_QueueFamilyIndices.m_ComputeFamily )
-        {
-            const uint32_t computeQueueIndex = m_QueueFamilyIndices.m_ComputeCount - 1;
+        const uint32_t scopeIndex = m_OpenScopes.back();
+        m_OpenScopes.pop_back();
 
-            vkGetDeviceQueue( m_Device, m_QueueFamilyIndices.m_ComputeFamily, computeQueueIndex, &m_ComputeQueue );
-            if( m_ComputeQueue == nullptr )
-            {
-                std::cerr << "Cannot obtain compute queue!" << std::endl;
-                return StatusCode::Fail;
-            }
-        }
-        else
+        if( scopeIndex != UINT32_MAX )
         {
-            m_ComputeQueue = m_GraphicsQueue;
+            vkCmdWriteTimestamp( commandBuffer, stage, m_QueryPools[slot], 2 * scopeIndex + 1 );
         }
+    }
 
-        // Get copy family.
-        if( m_QueueFamilyIndices.m_HasCopyFamily &&
-            m_QueueFamilyIndices.m_GraphicsFamily != m_QueueFamilyIndices.m_CopyFamily )
+    ////////////////////////////////////////////////////////////
+    /// Resolves the scopes of the slot without waiting, returns false if they are not available.
+    ////////////////////////////////////////////////////////////
+    bool Resolve( const VkDevice device, const uint32_t slot, std::vector<GpuProfilerResult>& results ) const
+    {
+        if( slot >= m_QueryPools.size() || m_Scopes[slot].empty() )
         {
-            const uint32_t copyQueueIndex = m_QueueFamilyIndices.m_CopyCount - 1;
-
-            vkGetDeviceQueue( m_Device, m_QueueFamilyIndices.m_CopyFamily, copyQueueIndex, &m_CopyQueue );
-            if( m_CopyQueue == nullptr )
-            {
-                std::cerr << "Cannot obtain copy queue!" << std::endl;
-                return StatusCode::Fail;
-            }
+            return false;
         }
-        else
+
+        const std::vector<GpuProfilerScope>& scopes     = m_Scopes[slot];
+        const uint32_t                       queryCount = static_cast<uint32_t>( 2 * scopes.size() );
+        std::vector<uint64_t>                timestamps( queryCount );
+
+        if( vkGetQueryPoolResults( device, m_QueryPools[slot], 0, queryCount, timestamps.size() * sizeof( uint64_t ), timestamps.data(), sizeof( uint64_t ), VK_QUERY_RESULT_64_BIT ) != VK_SUCCESS )
         {
-            m_CopyQueue = m_GraphicsQueue;
+            return false;
         }
 
-        // Get present family.
-        if( m_QueueFamilyIndices.m_HasPresentFamily &&
-            m_QueueFamilyIndices.m_GraphicsFamily != m_QueueFamilyIndices.m_PresentFamily )
-        {
-            const uint32_t presentQueueIndex = m_QueueFamilyIndices.m_PresentCount - 1;
+        results.clear();
 
-            vkGetDeviceQueue( m_Device, m_QueueFamilyIndices.m_PresentFamily, presentQueueIndex, &m_PresentQueue );
-            if( m_PresentQueue == nullptr )
-            {
-                std::cerr << "Cannot obtain present queue!" << std::endl;
-                return StatusCode::Fail;
-            }
-        }
-        else
+        for( size_t i = 0; i < scopes.size(); ++i )
         {
-            m_PresentQueue = m_GraphicsQueue;
+            // The end may have wrapped around the valid bits.
+            const double milliseconds = ( ( timestamps[2 * i + 1] - timestamps[2 * i] ) & m_TimestampMask ) * m_TimestampPeriod / 1000000.0;
+
+            results.push_back( { scopes[i].m_Name, scopes[i].m_Depth, milliseconds, timestamps[2 * i], timestamps[2 * i + 1] } );
         }
 
-        return StatusCode::Success;
+        return true;
     }
+};
 
-    ////////////////////////////////////////////////////////////
-    /// Finds different queue families.
-    ////////////////////////////////////////////////////////////
-    QueueFamilyIndices FindQueueFamilies( VkPhysicalDevice physicalDevice )
-    {
-        QueueFamilyIndices indices = {};
-
-        // Get physical device queue family properties.
-        uint32_t queueFamilyCount = 0;
-        vkGetPhysicalDeviceQueueFamilyProperties( physicalDevice, &queueFamilyCount, nullptr );
+////////////////////////////////////////////////////////////
+/// Pipeline statistics of a frame with derived ratios.
+////////////////////////////////////////////////////////////
+struct PipelineStatisticsSample
+{
+    uint64_t                                   m_FrameIndex;
+    double                                     m_Milliseconds;          // Time the results were read since the first sample.
+    std::array<double, PipelineStatisticCount> m_Counters;              // In the order of the query statistic bits.
+    double                                     m_Overdraw;              // Fragment shader invocations per pixel.
+    double                                     m_VertexCacheEfficiency; // Vertex shader invocations per index, lower is better.
+    double                                     m_ClipRejectionRate;     // Primitives rejected by clipping per clipped primitive, clamped to zero.
+};
 
-        std::vector<VkQueueFamilyProperties> queueFamilies( queueFamilyCount );
-        vkGetPhysicalDeviceQueueFamilyProperties( physicalDevice, &queueFamilyCount, queueFamilies.data() );
+////////////////////////////////////////////////////////////
+/// Uploads recorded into one copy and one graphics command buffer.
+/// The copy queue releases ownership of the resources and the graphics queue acquires them.
+////////////////////////////////////////////////////////////
+struct GpuUploadBatch
+{
+    uint64_t                                       m_Ticket;
+    VkCommandBuffer                                m_CopyCommandBuffer;
+    VkCommandBuffer                                m_GraphicsCommandBuffer;
+    uint64_t                                       m_TimelineValue;         // Graphics timeline value of the batch.
+    VkDeviceSize                                   m_StagingRingBufferHead; // Staging bytes released when the batch completes.
+};
+
+////////////////////////////////////////////////////////////
+/// Decoded texture waiting for its upload.
+////////////////////////////////////////////////////////////
+struct LoadedTexture
+{
+    Pixels* m_Pixels;
+    int32_t m_Width;
+    int32_t m_Height;
+    int32_t m_Channels;
+};
+
+////////////////////////////////////////////////////////////
+/// Compute kernel registered by the application.
+/// Kernels bind storage buffers to set 0, bindings 0 to n - 1, and specialize their workgroup size as
+/// local_size_x_id = 0. Workgroups are numbered in x, y, z order, because large dispatches are split.
+////////////////////////////////////////////////////////////
+struct ComputeKernel
+{
+    VkDescriptorSetLayout m_DescriptorSetLayout;
+    VkPipelineLayout      m_PipelineLayout;
+    VkPipeline            m_Pipeline;
+    uint32_t              m_BindingCount;
+    uint32_t              m_PushConstantSize; // Bytes, zero if the kernel has no push constants.
+};
+
+////////////////////////////////////////////////////////////
+/// Storage buffer of compute jobs.
+////////////////////////////////////////////////////////////
+struct ComputeJobBuffer
+{
+    VkBuffer                          m_Buffer; // Null if the buffer is destroyed.
+    std::pair<uint32_t, VkDeviceSize> m_GpuMemoryOffsets;
+    VkDeviceSize                      m_Size;
+    bool                              m_IsDeviceLocal; // Read back through a copy, host visible buffers are read directly.
+};
+
+////////////////////////////////////////////////////////////
+/// Typed handle of a compute job buffer.
+////////////////////////////////////////////////////////////
+template<typename T>
+struct ComputeBufferHandle
+{
+    uint32_t m_Index;
+};
+
+////////////////////////////////////////////////////////////
+/// Compute job, a kernel dispatched over its buffers.
+////////////////////////////////////////////////////////////
+struct ComputeJob
+{
+    uint32_t              m_Kernel;
+    std::vector<uint32_t> m_Buffers; // Buffer index of each binding.
+    std::vector<uint8_t>  m_PushConstants;
+    uint32_t              m_InvocationCount; // Rounded up to whole workgroups, kernels check the bounds.
+
+    ////////////////////////////////////////////////////////////
+    /// Binds the buffer to the next binding.
+    ////////////////////////////////////////////////////////////
+    template<typename T>
+    void AddBuffer( const ComputeBufferHandle<T> buffer )
+    {
+        m_Buffers.emplace_back( buffer.m_Index );
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Sets push constants from a trivially copyable struct.
+    ////////////////////////////////////////////////////////////
+    template<typename T>
+    void SetPushConstants( const T& pushConstants )
+    {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>( &pushConstants );
+
+        m_PushConstants.assign( bytes, bytes + sizeof( T ) );
+    }
+};
+
+////////////////////////////////////////////////////////////
+/// Submitted compute job, its resources are released once it completes.
+////////////////////////////////////////////////////////////
+struct ComputeJobSubmission
+{
+    VkCommandBuffer                m_CommandBuffer;
+    VkDescriptorSet                m_DescriptorSet;
+    uint64_t                       m_TimelineValue; // Compute timeline value of the job.
+    std::shared_future<StatusCode> m_Completion;
+};
+
+////////////////////////////////////////////////////////////
+/// Submitted frame, its latency is measured once the gpu finishes it.
+////////////////////////////////////////////////////////////
+struct PendingFrameLatency
+{
+    uint64_t               m_TimelineValue; // Graphics timeline value of the frame.
+    FrameClock::time_point m_StartTime;     // Input sampling time of the frame.
+};
+
+////////////////////////////////////////////////////////////
+/// Reduction of a compute buffer, values match the reduction kernel.
+////////////////////////////////////////////////////////////
+enum class ComputeReduction
+{
+    Sum,
+    Min,
+    Max,
+    Dot // Sum of products of two buffers.
+};
+
+////////////////////////////////////////////////////////////
+/// Prefix scan of a compute buffer.
+////////////////////////////////////////////////////////////
+enum class ComputeScan
+{
+    Inclusive,
+    Exclusive
+};
+
+////////////////////////////////////////////////////////////
+/// Push constants of the reduction and scan kernels.
+////////////////////////////////////////////////////////////
+struct ParallelPrimitiveConstants
+{
+    uint32_t m_ElementCount;
+    uint32_t m_Operation; // Reduction, or one for exclusive scans.
+};
+
+////////////////////////////////////////////////////////////
+/// Mesh cluster culled against the frustum, matches the culling shader.
+////////////////////////////////////////////////////////////
+struct CullingCluster
+{
+    alignas( 16 ) glm::vec4 m_BoundingSphere; // Center and radius in model space.
+    uint32_t                m_FirstIndex;
+    uint32_t                m_IndexCount;
+    uint32_t                m_Padding[2]; // Std430 rounds the struct up to the alignment of the vec4.
+};
+
+////////////////////////////////////////////////////////////
+/// Push constants of the culling kernel.
+////////////////////////////////////////////////////////////
+struct CullingConstants
+{
+    uint32_t m_ClusterCount;
+};
+
+////////////////////////////////////////////////////////////
+/// Buffers and command buffers of a chunk in flight in the compute stream.
+////////////////////////////////////////////////////////////
+struct ComputeStreamSlot
+{
+    std::array<VkBuffer, 2>                          m_StagingBuffers; // Inputs written by the cpu.
+    std::array<std::pair<uint32_t, VkDeviceSize>, 2> m_StagingBuffersGpuMemoryOffsets;
+    std::array<VkBuffer, 3>                          m_Buffers; // Device local inputs and result.
+    std::array<std::pair<uint32_t, VkDeviceSize>, 3> m_BuffersGpuMemoryOffsets;
+    VkBuffer                                         m_ReadbackBuffer;
+    std::pair<uint32_t, VkDeviceSize>                m_ReadbackBufferGpuMemoryOffsets;
+    std::vector<float>                               m_Results; // Cpu results of the chunk.
+    VkDescriptorSet                                  m_DescriptorSet;
+    VkCommandBuffer                                  m_UploadCommandBuffer;   // Copy queue.
+    VkCommandBuffer                                  m_DispatchCommandBuffer; // Compute queue.
+    VkCommandBuffer                                  m_ReadbackCommandBuffer; // Copy queue.
+    uint64_t                                         m_UploadTimelineValue;
+    uint64_t                                         m_DispatchTimelineValue;
+    uint64_t                                         m_ReadbackTimelineValue;
+    uint32_t                                         m_Chunk;
+    bool                                             m_IsInFlight;
+};
+
+////////////////////////////////////////////////////////////
+/// Application settings from the command line.
+////////////////////////////////////////////////////////////
+struct ApplicationSettings
+{
+    LatencyMode m_LatencyMode;
+    uint32_t    m_FramesInFlight;   // Zero selects the count of the latency mode.
+    uint32_t    m_FrameCount;       // Zero renders until the window is closed.
+    bool        m_IsHeadless;       // Renders to offscreen images without a window and a surface.
+    std::string m_CaptureDirectory; // Headless frames are written there if not empty.
+
+    bool            m_IsBenchmark;
+    uint32_t        m_WarmupFrameCount;
+    float           m_BenchmarkSeconds; // Zero measures the frame count instead.
+    BenchmarkFormat m_BenchmarkFormat;
+    std::string     m_BenchmarkOutput; // Results are printed to the standard output if empty.
+
+    bool m_IsGpuProfileLogged; // Prints rolling averages of gpu profiler scopes.
+
+    PipelineStatisticsExport m_PipelineStatisticsExport;
+    std::string              m_PipelineStatisticsOutput; // File of csv and chrome trace exports.
+
+    std::string m_TraceOutput; // Cpu zones and gpu scopes are traced to this file at exit and on F12 if not empty.
+
+    ComputeBufferMode m_ComputeBufferMode;
+    uint32_t          m_ComputeReadbackInterval; // Results of every n-th dispatch are read back and verified, zero selects one.
+
+    ComputeVerificationMode m_ComputeVerificationMode;
+    float                   m_ComputeVerificationTolerance; // Ulps or relative error, zero selects the default of the mode.
+    uint32_t                m_ComputeVerificationSampling;  // One of every n blocks is verified, rotating each readback. Zero verifies all.
+    uint32_t                m_ComputeMismatchReports;       // Zero selects the default.
+
+    uint32_t m_ComputeStreamChunkCount; // Chunks streamed through the compute queue before rendering, zero disables streaming.
+    uint32_t m_ComputeStreamSlotCount;  // Double or triple buffering, zero selects triple.
+
+    bool m_IsComputeSerialized; // Graphics waits for the dispatch of its frame, the baseline of async compute.
+
+    bool m_IsGpuCullingDisabled; // Draws all indices with one direct draw, the baseline of gpu culling.
+};
+
+////////////////////////////////////////////////////////////
+/// Application object.
+////////////////////////////////////////////////////////////
+class Application
+{
+private:
+    ////////////////////////////////////////////////////////////
+    /// Private glfw members.
+    ////////////////////////////////////////////////////////////
+    uint32_t    m_Width;
+    uint32_t    m_Height;
+    GLFWwindow* m_Window;
+    std::string m_WindowName;
+
+    ////////////////////////////////////////////////////////////
+    /// Private settings members.
+    ////////////////////////////////////////////////////////////
+    ApplicationSettings m_Settings;
+    uint32_t            m_FramesInFlight;
+    uint32_t            m_ComputeReadbackCount; // Results are verified while later frames run.
+    uint32_t            m_FrameCount;
+    uint64_t            m_FrameIndex;
+
+    ////////////////////////////////////////////////////////////
+    /// Private Vulkan members.
+    ////////////////////////////////////////////////////////////
+    VkInstance                                     m_Instance;
+    VkSurfaceKHR                                   m_Surface;
+    VkPhysicalDevice                               m_PhysicalDevice;
+    VkPhysicalDeviceFeatures                       m_PhysicalDeviceFeatures;
+    VkPhysicalDeviceProperties                     m_PhysicalDeviceProperties;
+    VkPhysicalDeviceMemoryProperties               m_GpuMemoryProperties;
+    VkDevice                                       m_Device;
+    VkQueue                                        m_GraphicsQueue;
+    VkQueue                                        m_ComputeQueue;
+    VkQueue                                        m_CopyQueue;
+    VkQueue                                        m_PresentQueue;
+    VkSwapchainKHR                                 m_SwapChain;
+    std::vector<VkImage>                           m_SwapChainImages;
+    std::vector<std::pair<uint32_t, VkDeviceSize>> m_OffscreenImagesGpuMemoryOffsets; // Headless images in place of the swap chain.
+    std::vector<VkBuffer>                          m_CaptureBuffers;
+    std::vector<std::pair<uint32_t, VkDeviceSize>> m_CaptureBuffersGpuMemoryOffsets;
+    std::vector<uint64_t>                          m_CapturedFrameIndices; // Frame index copied to the capture buffer, zero if none.
+    VkFormat                                       m_SwapChainImageFormat;
+    VkExtent2D                                     m_SwapChainExtent;
+    std::vector<VkImageView>                       m_SwapChainImageViews;
+    VkRenderPass                                   m_RenderPass;
+    VkDescriptorSetLayout                          m_DescriptorSetLayout;
+    VkDescriptorPool                               m_DescriptorPool;
+    std::vector<VkDescriptorSet>                   m_DescriptorSets;
+    VkPipelineLayout                               m_GraphicsPipelineLayout;
+    VkPipeline                                     m_GraphicsPipeline;
+    std::vector<VkFramebuffer>                     m_SwapChainFramebuffers;
+    VkCommandPool                                  m_CommandPoolGraphics;
+    VkCommandPool                                  m_CommandPoolCopy;
+    VkImage                                        m_TextureImage;
+    std::pair<uint32_t, VkDeviceSize>              m_TextureImageGpuMemoryOffset;
+    VkImageView                                    m_TextureImageView;
+    VkSampler                                      m_TextureSampler;
+    VkBuffer                                       m_VertexBuffer;
+    std::pair<uint32_t, VkDeviceSize>              m_VertexBufferGpuMemoryOffset;
+    VkBuffer                                       m_IndexBuffer;
+    std::pair<uint32_t, VkDeviceSize>              m_IndexBufferGpuMemoryOffset;
+    VkImage                                        m_DepthImage;
+    std::pair<uint32_t, VkDeviceSize>              m_DepthImageGpuMemoryOffset;
+    VkImageView                                    m_DepthImageView;
+    std::vector<GpuMemoryBlock>                    m_GpuMemoryBlocks;
+    GpuRingBuffer                                  m_UniformRingBuffer;
+    std::vector<uint32_t>                          m_UniformDynamicOffsets; // Ring buffer offset of the uniforms each image is recorded with.
+    std::vector<GpuMovableResource>                m_GpuMovableResources;
+    std::vector<GpuMemoryMove>                     m_GpuMemoryMoves;
+    VkCommandBuffer                                m_DefragmentationCommandBuffer;
+    uint64_t                                       m_DefragmentationTimelineValue;         // Copy timeline value of the moves.
+    std::array<std::array<VkCommandBuffer, 2>, 2>  m_DefragmentationOwnerCommandBuffers;   // Release and acquire of each owner.
+    std::array<uint64_t, 2>                        m_DefragmentationReleaseTimelineValues; // Owner timeline values of the releases.
+    std::array<uint64_t, 2>                        m_DefragmentationAcquireTimelineValues; // Owner timeline values of the acquires.
+    std::vector<bool>                              m_IsImageUsingMovedGpuMemory;           // Command buffer of the image still uses the old resources.
+    std::vector<bool>                              m_IsReadbackUsingMovedGpuMemory;        // Compute command buffers of the readback buffer still use the old resources.
+    GpuStagingRingBuffer                           m_StagingRingBuffer;
+    GpuUploadBatch                                 m_UploadBatch; // Batch being recorded.
+    std::vector<GpuUploadBatch>                    m_SubmittedUploadBatches;
+    uint64_t                                       m_UploadTicket; // Ticket of the last submitted batch.
+    std::vector<VkCommandBuffer>                   m_GraphicsCommandBuffers;
+    std::vector<VkSemaphore>                       m_ImageAvailableSemaphores;
+    std::vector<VkSemaphore>                       m_RenderFinishedSemaphores;
+    GpuTimeline                                    m_GraphicsTimeline;
+    GpuTimeline                                    m_ComputeTimeline;
+    GpuTimeline                                    m_CopyTimeline;
+    std::vector<uint64_t>                          m_FrameTimelineValues; // Graphics timeline value of each frame in flight.
+    std::vector<uint64_t>                          m_ImageTimelineValues; // Graphics timeline value of the last frame of each image.
+    std::vector<uint64_t>                          m_ImageFrameIndices;   // Frame index of the last frame of each image.
+    std::vector<VkQueryPool>                       m_QueryPools;
+    GpuProfiler                                    m_GraphicsProfiler;   // Slot per graphics command buffer.
+    GpuProfiler                                    m_ComputeProfiler;    // Slot per compute command buffer.
+    std::vector<uint64_t>                          m_PipelineStatistics; // Latest available query results.
+    QueueFamilyIndices                             m_QueueFamilyIndices;
+    uint32_t                                       m_CurrentFrame;
+    std::vector<FrameClock::time_point>            m_FrameStartTimes;        // Input sampling time of each frame in flight.
+    std::vector<double>                            m_FrameLatencies;         // Milliseconds from input sampling to the end of the frame on the gpu.
+    std::thread                                    m_FrameLatencyWaiter;     // Measures latencies as the frames finish.
+    std::deque<PendingFrameLatency>                m_PendingFrameLatencies;  // Guarded by the mutex, oldest frame first.
+    std::vector<double>                            m_MeasuredFrameLatencies; // Guarded by the mutex, moved to the frame latencies by the main thread.
+    std::mutex                                     m_FrameLatencyMutex;
+    std::condition_variable                        m_FrameLatencyCondition;
+    bool                                           m_IsFrameLatencyWaiterStopping; // Guarded by the mutex.
+    bool                                           m_IsFrameBufferResized;
+    bool                                           m_IsPipelineStatisticsQuerySupported;
+    bool                                           m_IsTimestampQuerySupported;
+    bool                                           m_IsDeviceLocalMemoryHostVisible;
+    bool                                           m_IsMemoryBudgetSupported;
+    bool                                           m_IsCalibratedTimestampSupported; // The gpu clock can be sampled together with the trace clock.
+    float                                          m_MaxSamplerAnisotropy;
+    // Compute only members.
+    VkCommandPool                                  m_CommandPoolCompute;
+    std::vector<VkCommandBuffer>                   m_ComputeCommandBuffers; // Two per readback buffer, with and without the readback.
+    std::vector<uint64_t>                          m_ComputeTimelineValues; // Compute timeline value of each readback buffer.
+    VkDescriptorSetLayout                          m_ComputeDescriptorSetLayout;
+    VkDescriptorPool                               m_ComputeDescriptorPool;
+    std::vector<VkDescriptorSet>                   m_ComputeDescriptorSets; // One per readback buffer, updated once its dispatches are done.
+    VkPipelineLayout                               m_ComputePipelineLayout;
+    VkPipeline                                     m_ComputePipeline;
+    std::vector<VkBuffer>                          m_ComputeBuffers;
+    std::vector<std::pair<uint32_t, VkDeviceSize>> m_ComputeBuffersGpuMemoryOffsets;
+    std::vector<VkBuffer>                          m_ComputeReadbackBuffers;
+    std::vector<std::pair<uint32_t, VkDeviceSize>> m_ComputeReadbackBuffersGpuMemoryOffsets;
+    std::vector<bool>                              m_IsComputeResultPending;     // Dispatch submitted, verification not started.
+    std::vector<bool>                              m_IsComputeReadbackSubmitted; // Last dispatch copied its results to the readback buffer.
+    bool                                           m_IsComputeBufferDeviceLocal;
+    std::vector<std::future<StatusCode>>           m_ComputeVerifications;
+    uint32_t                                       m_ComputeVerificationIndex; // Rotates the blocks of sampled verification.
+    uint32_t                                       m_ComputeReadbackIndex;
+    VkDeviceMemory                                 m_ComputeMemory;
+    uint32_t                                       m_VectorElementCount;
+    uint32_t                                       m_ComputeWorkgroupSize; // Specialized into the compute shader.
+    std::array<uint32_t, 3>                        m_ComputeDispatchSize;  // Workgroups are split to y and z beyond the x limit.
+    float*                                         m_NumbersA;
+    float*                                         m_NumbersB;
+    float*                                         m_Results;
+
+    ////////////////////////////////////////////////////////////
+    /// Private asset loading members, filled by worker threads.
+    ////////////////////////////////////////////////////////////
+    std::future<StatusCode> m_ModelLoading;
+    std::future<StatusCode> m_TextureLoading;
+    std::future<StatusCode> m_ShaderLoading;
+    LoadedTexture           m_LoadedTexture;
+    std::vector<char>       m_VertexShaderCode;
+    std::vector<char>       m_FragmentShaderCode;
+    std::vector<char>       m_ComputeShaderCode;
+
+    ////////////////////////////////////////////////////////////
+    /// Private benchmark members.
+    ////////////////////////////////////////////////////////////
+    FrameClock::time_point                                                            m_PreviousFrameStartTime;
+    FrameClock::time_point                                                            m_BenchmarkStartTime;
+    FrameClock::time_point                                                            m_BenchmarkEndTime;
+    std::array<std::vector<double>, static_cast<uint32_t>( BenchmarkMetric::Count )> m_BenchmarkSamples; // Milliseconds.
+
+    ////////////////////////////////////////////////////////////
+    /// Private gpu profiler members.
+    ////////////////////////////////////////////////////////////
+    std::vector<GpuProfilerResult> m_GraphicsGpuProfile; // Latest resolved frame.
+    std::vector<GpuProfilerResult> m_ComputeGpuProfile;  // Latest resolved dispatch.
+    std::map<std::string, double>  m_GpuProfileAverages; // Rolling averages in milliseconds by scope name.
+    FrameClock::time_point         m_GpuProfileLogTime;
+
+    ////////////////////////////////////////////////////////////
+    /// Private async compute members.
+    ////////////////////////////////////////////////////////////
+    std::vector<GpuSemaphoreWait>             m_GraphicsComputeWaits;    // Dispatches whose output the next graphics submission consumes.
+    std::deque<std::pair<int64_t, int64_t>>   m_GraphicsFrameIntervals;  // Trace nanoseconds of recent frames.
+    std::deque<std::pair<int64_t, int64_t>>   m_PendingComputeIntervals; // Dispatches waiting for the frames that may overlap them.
+
+    ////////////////////////////////////////////////////////////
+    /// Private pipeline statistics members.
+    ////////////////////////////////////////////////////////////
+    PipelineStatisticsSample              m_PipelineStatisticsSample;  // Latest frame.
+    PipelineStatisticsSample              m_PipelineStatisticsAverage; // Rolling averages.
+    std::vector<PipelineStatisticsSample> m_PipelineStatisticsSamples; // All frames, kept only for file exports.
+    FrameClock::time_point                m_PipelineStatisticsStartTime;
+    FrameClock::time_point                m_PipelineStatisticsLogTime;
+
+    ////////////////////////////////////////////////////////////
+    /// Private trace members.
+    ////////////////////////////////////////////////////////////
+    GpuTimestampCalibration m_GraphicsTimestampCalibration;
+    GpuTimestampCalibration m_ComputeTimestampCalibration;
+    bool                    m_IsTraceRequested; // Set by the key callback, the trace is written by the main loop.
+
+    ////////////////////////////////////////////////////////////
+    /// Private compute job members.
+    ////////////////////////////////////////////////////////////
+    std::vector<ComputeKernel>                                m_ComputeKernels;
+    std::vector<ComputeJobBuffer>                             m_ComputeJobBuffers;     // Destroyed buffers keep their index, so handles stay unique.
+    std::vector<ComputeJobSubmission>                         m_ComputeJobSubmissions; // Jobs whose resources are not released yet.
+    std::thread                                               m_ComputeJobWaiter;      // Completes jobs in timeline order.
+    std::deque<std::pair<uint64_t, std::promise<StatusCode>>> m_ComputeJobCompletions; // Guarded by the mutex, oldest job first.
+    std::mutex                                                m_ComputeJobMutex;
+    std::condition_variable                                   m_ComputeJobCondition;
+    bool                                                      m_IsComputeJobWaiterStopping; // Guarded by the mutex.
+    VkDescriptorPool                                          m_ComputeJobDescriptorPool;
+    bool                                                      m_IsSubgroupArithmeticSupported; // Required by the reduction and scan kernels.
+    uint32_t                                                  m_ReductionKernel;
+    uint32_t                                                  m_ScanKernel;
+
+    ////////////////////////////////////////////////////////////
+    /// Private compute stream members.
+    ////////////////////////////////////////////////////////////
+    std::vector<ComputeStreamSlot> m_ComputeStreamSlots;
+
+    ////////////////////////////////////////////////////////////
+    /// Private gpu culling members.
+    ////////////////////////////////////////////////////////////
+    bool                                           m_IsGpuCullingSupported; // Draw indirect count and multi draw indirect, false if disabled by the settings.
+    uint32_t                                       m_CullingKernel;
+    uint32_t                                       m_CullingClusterCount;
+    std::array<uint32_t, 3>                        m_CullingDispatchSize;
+    VkBuffer                                       m_CullingClusterBuffer;
+    std::pair<uint32_t, VkDeviceSize>              m_CullingClusterBufferGpuMemoryOffset;
+    std::vector<VkBuffer>                          m_CullingDrawBuffers; // Draw count and draw commands of each image.
+    std::vector<std::pair<uint32_t, VkDeviceSize>> m_CullingDrawBuffersGpuMemoryOffsets;
+    std::vector<VkDescriptorSet>                   m_CullingDescriptorSets;
+
+    ////////////////////////////////////////////////////////////
+    /// Private Vulkan extensions members.
+    ////////////////////////////////////////////////////////////
+    std::vector<const char*> m_PhysicalDeviceExtensions;
+
+    ////////////////////////////////////////////////////////////
+    /// Private debugging and validation layer members.
+    ////////////////////////////////////////////////////////////
+#ifdef _DEBUG
+    std::vector<const char*> m_ValidationLayers;
+    VkDebugUtilsMessengerEXT m_DebugMessenger;
+#endif
+
+public:
+    ////////////////////////////////////////////////////////////
+    /// Default constructor of the object.
+    ////////////////////////////////////////////////////////////
+    Application()
+        : Application( 800, 600, "Vulkan Application", {} )
+    {
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Constructs the object with given parameters.
+    ////////////////////////////////////////////////////////////
+    Application(
+        const uint32_t             width,
+        const uint32_t             height,
+        const std::string&         windowName,
+        const ApplicationSettings& settings )
+        : m_Width( width )
+        , m_Height( height )
+        , m_Window( nullptr )
+        , m_WindowName( windowName )
+        , m_Settings( settings )
+        , m_FramesInFlight( GetFramesInFlight( settings ) )
+        , m_ComputeReadbackCount( 2 * m_FramesInFlight )
+        , m_FrameCount( GetFrameCount( settings ) )
+        , m_FrameIndex( 0 )
+        , m_Instance( VK_NULL_HANDLE )
+        , m_Surface( VK_NULL_HANDLE )
+        , m_PhysicalDevice( VK_NULL_HANDLE )
+        , m_PhysicalDeviceFeatures{}
+        , m_PhysicalDeviceProperties{}
+        , m_GpuMemoryProperties{}
+        , m_Device( VK_NULL_HANDLE )
+        , m_GraphicsQueue( VK_NULL_HANDLE )
+        , m_ComputeQueue( VK_NULL_HANDLE )
+        , m_CopyQueue( VK_NULL_HANDLE )
+        , m_PresentQueue( VK_NULL_HANDLE )
+        , m_SwapChain( VK_NULL_HANDLE )
+        , m_SwapChainImages{}
+        , m_OffscreenImagesGpuMemoryOffsets{}
+        , m_CaptureBuffers{}
+        , m_CaptureBuffersGpuMemoryOffsets{}
+        , m_CapturedFrameIndices{}
+        , m_SwapChainImageFormat( VK_FORMAT_UNDEFINED )
+        , m_SwapChainExtent{}
+        , m_SwapChainImageViews{}
+        , m_RenderPass( VK_NULL_HANDLE )
+        , m_DescriptorSetLayout( VK_NULL_HANDLE )
+        , m_DescriptorPool( VK_NULL_HANDLE )
+        , m_DescriptorSets{}
+        , m_GraphicsPipelineLayout( VK_NULL_HANDLE )
+        , m_GraphicsPipeline( VK_NULL_HANDLE )
+        , m_SwapChainFramebuffers{}
+        , m_CommandPoolGraphics( VK_NULL_HANDLE )
+        , m_CommandPoolCopy( VK_NULL_HANDLE )
+        , m_TextureImage( VK_NULL_HANDLE )
+        , m_TextureImageGpuMemoryOffset{}
+        , m_TextureImageView( VK_NULL_HANDLE )
+        , m_TextureSampler( VK_NULL_HANDLE )
+        , m_VertexBuffer( VK_NULL_HANDLE )
+        , m_VertexBufferGpuMemoryOffset{}
+        , m_IndexBuffer( VK_NULL_HANDLE )
+        , m_IndexBufferGpuMemoryOffset{}
+        , m_GpuMemoryBlocks{}
+        , m_UniformRingBuffer{}
+        , m_UniformDynamicOffsets{}
+        , m_GpuMovableResources{}
+        , m_GpuMemoryMoves{}
+        , m_DefragmentationCommandBuffer( VK_NULL_HANDLE )
+        , m_DefragmentationTimelineValue( 0 )
+        , m_DefragmentationOwnerCommandBuffers{}
+        , m_DefragmentationReleaseTimelineValues{}
+        , m_DefragmentationAcquireTimelineValues{}
+        , m_IsImageUsingMovedGpuMemory{}
+        , m_IsReadbackUsingMovedGpuMemory{}
+        , m_StagingRingBuffer{}
+        , m_UploadBatch{}
+        , m_SubmittedUploadBatches{}
+        , m_UploadTicket( 0 )
+        , m_GraphicsCommandBuffers{}
+        , m_ImageAvailableSemaphores{}
+        , m_RenderFinishedSemaphores{}
+        , m_GraphicsTimeline{}
+        , m_ComputeTimeline{}
+        , m_CopyTimeline{}
+        , m_FrameTimelineValues{}
+        , m_ImageTimelineValues{}
+        , m_ImageFrameIndices{}
+        , m_QueryPools{}
+        , m_GraphicsProfiler{}
+        , m_ComputeProfiler{}
+        , m_PipelineStatistics{}
+        , m_QueueFamilyIndices{}
+        , m_CurrentFrame( 0 )
+        , m_FrameStartTimes{}
+        , m_FrameLatencies{}
+        , m_FrameLatencyWaiter{}
+        , m_PendingFrameLatencies{}
+        , m_MeasuredFrameLatencies{}
+        , m_FrameLatencyMutex{}
+        , m_FrameLatencyCondition{}
+        , m_IsFrameLatencyWaiterStopping( false )
+        , m_IsFrameBufferResized( false )
+        , m_IsPipelineStatisticsQuerySupported( false )
+        , m_IsTimestampQuerySupported( false )
+        , m_IsDeviceLocalMemoryHostVisible( false )
+        , m_IsMemoryBudgetSupported( false )
+        , m_IsCalibratedTimestampSupported( false )
+        , m_MaxSamplerAnisotropy( 1.0f )
+        , m_PhysicalDeviceExtensions{}
+        , m_CommandPoolCompute( VK_NULL_HANDLE )
+        , m_ComputeCommandBuffers{}
+        , m_ComputeTimelineValues{}
+        , m_ComputeDescriptorSetLayout( VK_NULL_HANDLE )
+        , m_ComputeDescriptorPool( VK_NULL_HANDLE )
+        , m_ComputeDescriptorSets{}
+        , m_ComputePipelineLayout( VK_NULL_HANDLE )
+        , m_ComputePipeline( VK_NULL_HANDLE )
+        , m_ComputeBuffers{}
+        , m_ComputeBuffersGpuMemoryOffsets{}
+        , m_ComputeReadbackBuffers{}
+        , m_ComputeReadbackBuffersGpuMemoryOffsets{}
+        , m_IsComputeResultPending{}
+        , m_IsComputeReadbackSubmitted{}
+        , m_IsComputeBufferDeviceLocal( false )
+        , m_ComputeVerifications{}
+        , m_ComputeVerificationIndex( 0 )
+        , m_ComputeReadbackIndex( 0 )
+        , m_ComputeMemory( VK_NULL_HANDLE )
+        , m_VectorElementCount( ComputeElementCount )
+        , m_ComputeWorkgroupSize( MinComputeWorkgroupSize )
+        , m_ComputeDispatchSize{}
+        , m_NumbersA( nullptr )
+        , m_NumbersB( nullptr )
+        , m_Results( nullptr )
+        , m_ModelLoading{}
+        , m_TextureLoading{}
+        , m_ShaderLoading{}
+        , m_LoadedTexture{}
+        , m_VertexShaderCode{}
+        , m_FragmentShaderCode{}
+        , m_ComputeShaderCode{}
+        , m_PreviousFrameStartTime{}
+        , m_BenchmarkStartTime{}
+        , m_BenchmarkEndTime{}
+        , m_BenchmarkSamples{}
+        , m_GraphicsGpuProfile{}
+        , m_ComputeGpuProfile{}
+        , m_GpuProfileAverages{}
+        , m_GpuProfileLogTime{}
+        , m_GraphicsComputeWaits{}
+        , m_GraphicsFrameIntervals{}
+        , m_PendingComputeIntervals{}
+        , m_PipelineStatisticsSample{}
+        , m_PipelineStatisticsAverage{}
+        , m_PipelineStatisticsSamples{}
+        , m_PipelineStatisticsStartTime{}
+        , m_PipelineStatisticsLogTime{}
+        , m_GraphicsTimestampCalibration{}
+        , m_ComputeTimestampCalibration{}
+        , m_IsTraceRequested( false )
+        , m_ComputeKernels{}
+        , m_ComputeJobBuffers{}
+        , m_ComputeJobSubmissions{}
+        , m_ComputeJobWaiter{}
+        , m_ComputeJobCompletions{}
+        , m_ComputeJobMutex{}
+        , m_ComputeJobCondition{}
+        , m_IsComputeJobWaiterStopping( false )
+        , m_ComputeJobDescriptorPool( VK_NULL_HANDLE )
+        , m_IsSubgroupArithmeticSupported( false )
+        , m_ReductionKernel( 0 )
+        , m_ScanKernel( 0 )
+        , m_ComputeStreamSlots{}
+        , m_IsGpuCullingSupported( false )
+        , m_CullingKernel( 0 )
+        , m_CullingClusterCount( 0 )
+        , m_CullingDispatchSize{}
+        , m_CullingClusterBuffer( VK_NULL_HANDLE )
+        , m_CullingClusterBufferGpuMemoryOffset{}
+        , m_CullingDrawBuffers{}
+        , m_CullingDrawBuffersGpuMemoryOffsets{}
+        , m_CullingDescriptorSets{}
+    {
+        if( !m_Settings.m_IsHeadless )
+        {
+            m_PhysicalDeviceExtensions.emplace_back( VK_KHR_SWAPCHAIN_EXTENSION_NAME );
+        }
+
+        if( !m_Settings.m_TraceOutput.empty() )
+        {
+            Tracer::Get().Enable();
+        }
+
+#ifdef _DEBUG
+        m_ValidationLayers.emplace_back( "VK_LAYER_KHRONOS_validation" );
+        m_DebugMessenger = VK_NULL_HANDLE;
+#endif
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Returns the frames in flight of the settings.
+    ////////////////////////////////////////////////////////////
+    static uint32_t GetFramesInFlight( const ApplicationSettings& settings )
+    {
+        if( settings.m_FramesInFlight != 0 )
+        {
+            return std::clamp( settings.m_FramesInFlight, 1u, MaxFramesInFlight );
+        }
+
+        switch( settings.m_LatencyMode )
+        {
+            case LatencyMode::LowLatency:
+                return 1;
+
+            case LatencyMode::Throughput:
+                return 3;
+
+            default:
+                return 2;
+        }
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Returns the number of frames to render, zero renders until the window is closed.
+    ////////////////////////////////////////////////////////////
+    static uint32_t GetFrameCount( const ApplicationSettings& settings )
+    {
+        uint32_t frameCount = settings.m_FrameCount;
+
+        if( settings.m_IsBenchmark )
+        {
+            // A benchmark of given seconds ends by time.
+            if( frameCount == 0 && settings.m_BenchmarkSeconds == 0.0f )
+            {
+                frameCount = BenchmarkFrameCount;
+            }
+
+            return frameCount != 0 ? settings.m_WarmupFrameCount + frameCount : 0;
+        }
+
+        if( settings.m_IsHeadless && frameCount == 0 )
+        {
+            frameCount = HeadlessFrameCount;
+        }
+
+        return frameCount;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Returns the name of the latency mode.
+    ////////////////////////////////////////////////////////////
+    static const char* GetLatencyModeName( const LatencyMode latencyMode )
+    {
+        switch( latencyMode )
+        {
+            case LatencyMode::LowLatency:
+                return "low-latency";
+
+            case LatencyMode::Throughput:
+                return "throughput";
+
+            default:
+                return "balanced";
+        }
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Initializes the application.
+    ////////////////////////////////////////////////////////////
+    StatusCode Initialize()
+    {
+        StatusCode result = StatusCode::Success;
+
+        // Create a window, headless mode renders without it.
+        if( !m_Settings.m_IsHeadless )
+        {
+            result = InitializeWindow();
+            if( result != StatusCode::Success )
+            {
+                return result;
+            }
+        }
+
+        // Initialize Vulkan api.
+        result = InitializeVulkan();
+        if( result != StatusCode::Success )
+        {
+            return result;
+        }
+
+        // Verify compute jobs.
+        if constexpr( EnableComputeVerification )
+        {
+            result = VerifyComputeKernels();
+            if( result != StatusCode::Success )
+            {
+                std::cerr << "Compute kernel verification failed!" << std::endl;
+                return result;
+            }
+        }
+
+        return result;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Executes the main loop of the application.
+    ////////////////////////////////////////////////////////////
+    StatusCode Run()
+    {
+        StatusCode result = StatusCode::Success;
+
+        // Stream compute chunks before rendering.
+        if( m_Settings.m_ComputeStreamChunkCount != 0 )
+        {
+            result = RunComputeStream();
+            if( result != StatusCode::Success )
+            {
+                return result;
+            }
+        }
+
+        result = MainLoop();
+        if( result != StatusCode::Success )
+        {
+            return result;
+        }
+
+        return result;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Destroys the application.
+    ////////////////////////////////////////////////////////////
+    StatusCode Destroy()
+    {
+        StatusCode result = StatusCode::Success;
+
+        // Cleanups Vulkan api.
+        result = CleanupVulkan();
+        if( result != StatusCode::Success )
+        {
+            return result;
+        }
+
+        // Cleanups the window and glfw library.
+        if( !m_Settings.m_IsHeadless )
+        {
+            result = CleanupWindow();
+            if( result != StatusCode::Success )
+            {
+                return result;
+            }
+        }
+
+        return result;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Returns gpu profiler scopes of the latest resolved frame.
+    ////////////////////////////////////////////////////////////
+    const std::vector<GpuProfilerResult>& GetGraphicsGpuProfile() const
+    {
+        return m_GraphicsGpuProfile;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Returns gpu profiler scopes of the latest resolved dispatch.
+    ////////////////////////////////////////////////////////////
+    const std::vector<GpuProfilerResult>& GetComputeGpuProfile() const
+    {
+        return m_ComputeGpuProfile;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Returns the rolling average of the gpu profiler scope in milliseconds, zero if not profiled.
+    ////////////////////////////////////////////////////////////
+    double GetGpuProfileAverage( const std::string& name ) const
+    {
+        const auto average = m_GpuProfileAverages.find( name );
+
+        return average != m_GpuProfileAverages.end() ? average->second : 0.0;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Returns pipeline statistics of the latest resolved frame.
+    ////////////////////////////////////////////////////////////
+    const PipelineStatisticsSample& GetPipelineStatistics() const
+    {
+        return m_PipelineStatisticsSample;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Returns rolling averages of pipeline statistics.
+    ////////////////////////////////////////////////////////////
+    const PipelineStatisticsSample& GetPipelineStatisticsAverage() const
+    {
+        return m_PipelineStatisticsAverage;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Registers a compute kernel from a spir-v file.
+    /// Zero binding count reflects the storage buffer bindings from the spir-v.
+    ////////////////////////////////////////////////////////////
+    StatusCode RegisterComputeKernel(
+        const std::string& fileName,
+        const uint32_t     bindingCount,
+        const uint32_t     pushConstantSize,
+        uint32_t&          kernel )
+    {
+        const std::vector<char> code = ReadBinaryFile( fileName );
+
+        if( code.empty() )
+        {
+            return StatusCode::Fail;
+        }
+
+        ComputeKernel computeKernel      = {};
+        computeKernel.m_BindingCount     = bindingCount != 0 ? bindingCount : GetSpirvBindingCount( code );
+        computeKernel.m_PushConstantSize = pushConstantSize;
+
+        if( computeKernel.m_BindingCount == 0 || computeKernel.m_BindingCount > MaxComputeKernelBindings ||
+            pushConstantSize > m_PhysicalDeviceProperties.limits.maxPushConstantsSize )
+        {
+            std::cerr << "Unsupported layout of compute kernel " << fileName << "!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        if( CreateComputeKernelPipeline( code, computeKernel ) != StatusCode::Success )
+        {
+            std::cerr << "Cannot create compute kernel " << fileName << "!" << std::endl;
+            DestroyComputeKernel( computeKernel );
+            return StatusCode::Fail;
+        }
+
+        kernel = static_cast<uint32_t>( m_ComputeKernels.size() );
+        m_ComputeKernels.emplace_back( computeKernel );
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Creates a compute job buffer, optionally filled with the elements.
+    ////////////////////////////////////////////////////////////
+    template<typename T>
+    StatusCode CreateComputeJobBuffer( const uint32_t elementCount, const T* elements, ComputeBufferHandle<T>& buffer )
+    {
+        return CreateComputeJobBuffer( static_cast<VkDeviceSize>( elementCount ) * sizeof( T ), elements, buffer.m_Index );
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Reads elements of a compute job buffer, the jobs writing it must be complete.
+    ////////////////////////////////////////////////////////////
+    template<typename T>
+    StatusCode ReadComputeJobBuffer( const ComputeBufferHandle<T> buffer, std::vector<T>& elements )
+    {
+        if( buffer.m_Index >= m_ComputeJobBuffers.size() )
+        {
+            return StatusCode::Fail;
+        }
+
+        elements.resize( static_cast<size_t>( m_ComputeJobBuffers[buffer.m_Index].m_Size / sizeof( T ) ) );
+
+        return ReadComputeJobBuffer( buffer.m_Index, elements.data(), elements.size() * sizeof( T ) );
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Destroys a compute job buffer, the jobs using it must be complete.
+    ////////////////////////////////////////////////////////////
+    template<typename T>
+    void DestroyComputeJobBuffer( const ComputeBufferHandle<T> buffer )
+    {
+        if( buffer.m_Index < m_ComputeJobBuffers.size() )
+        {
+            ComputeJobBuffer& jobBuffer = m_ComputeJobBuffers[buffer.m_Index];
+
+            DestroyBuffer( jobBuffer.m_Buffer, jobBuffer.m_GpuMemoryOffsets );
+
+            jobBuffer.m_Buffer = VK_NULL_HANDLE;
+        }
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Submits a compute job to the compute queue, the future is ready once the gpu finishes it.
+    /// Jobs run in submission order, each one sees the writes of the previous ones.
+    ////////////////////////////////////////////////////////////
+    StatusCode SubmitComputeJob( const ComputeJob& job, std::shared_future<StatusCode>& completion )
+    {
+        const TraceZone zone( "SubmitComputeJob" );
+
+        if( ValidateComputeJob( job ) != StatusCode::Success )
+        {
+            return StatusCode::Fail;
+        }
+
+        const ComputeKernel&    kernel       = m_ComputeKernels[job.m_Kernel];
+        std::array<uint32_t, 3> dispatchSize = {};
+
+        if( GetComputeDispatchSize( m_PhysicalDeviceProperties.limits, job.m_InvocationCount, m_ComputeWorkgroupSize, dispatchSize ) != StatusCode::Success )
+        {
+            std::cerr << "Compute job of " << job.m_InvocationCount << " invocations exceeds the workgroup count limits!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        ComputeJobSubmission submission = {};
+
+        if( AllocateComputeJobDescriptorSet( kernel, submission.m_DescriptorSet ) != StatusCode::Success )
+        {
+            return StatusCode::Fail;
+        }
+
+        // Bind the buffers.
+        std::vector<VkDescriptorBufferInfo> bufferInfos( job.m_Buffers.size() );
+        std::vector<VkWriteDescriptorSet>   writeDescriptorSets( job.m_Buffers.size() );
+
+        for( uint32_t i = 0; i < job.m_Buffers.size(); ++i )
+        {
+            bufferInfos[i].buffer = m_ComputeJobBuffers[job.m_Buffers[i]].m_Buffer;
+            bufferInfos[i].offset = 0;
+            bufferInfos[i].range  = VK_WHOLE_SIZE;
+
+            writeDescriptorSets[i].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writeDescriptorSets[i].dstSet          = submission.m_DescriptorSet;
+            writeDescriptorSets[i].dstBinding      = i;
+            writeDescriptorSets[i].descriptorCount = 1;
+            writeDescriptorSets[i].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            writeDescriptorSets[i].pBufferInfo     = &bufferInfos[i];
+        }
+
+        vkUpdateDescriptorSets( m_Device, static_cast<uint32_t>( writeDescriptorSets.size() ), writeDescriptorSets.data(), 0, nullptr );
+
+        // Record the dispatch.
+        if( BeginOneTimeCommandBuffer( m_CommandPoolCompute, submission.m_CommandBuffer ) != StatusCode::Success )
+        {
+            vkFreeDescriptorSets( m_Device, m_ComputeJobDescriptorPool, 1, &submission.m_DescriptorSet );
+            return StatusCode::Fail;
+        }
+
+        // Earlier jobs, copies and host writes are visible to the job.
+        VkMemoryBarrier barrier = {};
+        barrier.sType           = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask   = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask   = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+        vkCmdPipelineBarrier( submission.m_CommandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr );
+
+        vkCmdBindPipeline( submission.m_CommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, kernel.m_Pipeline );
+        vkCmdBindDescriptorSets( submission.m_CommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, kernel.m_PipelineLayout, 0, 1, &submission.m_DescriptorSet, 0, nullptr );
+
+        if( kernel.m_PushConstantSize != 0 )
+        {
+            vkCmdPushConstants( submission.m_CommandBuffer, kernel.m_PipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, kernel.m_PushConstantSize, job.m_PushConstants.data() );
+        }
+
+        vkCmdDispatch( submission.m_CommandBuffer, dispatchSize[0], dispatchSize[1], dispatchSize[2] );
+
+        // Results of host visible buffers are read directly.
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+        vkCmdPipelineBarrier( submission.m_CommandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr );
+
+        vkEndCommandBuffer( submission.m_CommandBuffer );
+
+        if( SubmitCommandBuffer( m_ComputeQueue, submission.m_CommandBuffer, {}, m_ComputeTimeline, VK_NULL_HANDLE, submission.m_TimelineValue ) != StatusCode::Success )
+        {
+            std::cerr << "Failed to submit compute job!" << std::endl;
+            vkFreeCommandBuffers( m_Device, m_CommandPoolCompute, 1, &submission.m_CommandBuffer );
+            vkFreeDescriptorSets( m_Device, m_ComputeJobDescriptorPool, 1, &submission.m_DescriptorSet );
+            return StatusCode::Fail;
+        }
+
+        // The waiter thread touches only the timeline semaphore, resources are released by the main loop.
+        std::promise<StatusCode> promise;
+        submission.m_Completion = promise.get_future().share();
+        completion              = submission.m_Completion;
+
+        {
+            std::lock_guard<std::mutex> lock( m_ComputeJobMutex );
+            m_ComputeJobCompletions.emplace_back( submission.m_TimelineValue, std::move( promise ) );
+        }
+
+        m_ComputeJobCondition.notify_one();
+
+        m_ComputeJobSubmissions.emplace_back( submission );
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Reduces a compute buffer on the gpu and waits for the result.
+    /// Buffer b is read by dot products only, other reductions may pass a again.
+    ////////////////////////////////////////////////////////////
+    StatusCode ReduceComputeBuffer(
+        const ComputeBufferHandle<float> a,
+        const ComputeBufferHandle<float> b,
+        const uint32_t                   elementCount,
+        const ComputeReduction           reduction,
+        float&                           result )
+    {
+        const TraceZone zone( "ReduceComputeBuffer" );
+
+        if( !m_IsSubgroupArithmeticSupported || elementCount == 0 )
+        {
+            std::cerr << "Compute reduction is not supported!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        std::vector<ComputeBufferHandle<float>> partials;
+        std::shared_future<StatusCode>          completion;
+        ComputeBufferHandle<float>              inputA    = a;
+        ComputeBufferHandle<float>              inputB    = b;
+        ParallelPrimitiveConstants              constants = { elementCount, static_cast<uint32_t>( reduction ) };
+        StatusCode                              status    = StatusCode::Success;
+
+        // Each pass reduces workgroups to one value each, until a single value is left.
+        while( status == StatusCode::Success )
+        {
+            const uint32_t workgroupCount = ( constants.m_ElementCount + m_ComputeWorkgroupSize - 1 ) / m_ComputeWorkgroupSize;
+
+            ComputeBufferHandle<float> partial = {};
+
+            status = CreateComputeJobBuffer<float>( workgroupCount, nullptr, partial );
+            if( status != StatusCode::Success )
+            {
+                break;
+            }
+
+            partials.emplace_back( partial );
+
+            ComputeJob job        = {};
+            job.m_Kernel          = m_ReductionKernel;
+            job.m_InvocationCount = constants.m_ElementCount;
+            job.AddBuffer( inputA );
+            job.AddBuffer( inputB );
+            job.AddBuffer( partial );
+            job.SetPushConstants( constants );
+
+            status = SubmitComputeJob( job, completion );
+
+            if( workgroupCount == 1 )
+            {
+                break;
+            }
+
+            // Partial dot products are summed.
+            inputA    = partial;
+            inputB    = partial;
+            constants = { workgroupCount, static_cast<uint32_t>( reduction == ComputeReduction::Dot ? ComputeReduction::Sum : reduction ) };
+        }
+
+        std::vector<float> values;
+
+        if( status == StatusCode::Success )
+        {
+            status = completion.get();
+        }
+
+        if( status == StatusCode::Success )
+        {
+            status = ReadComputeJobBuffer( partials.back(), values );
+        }
+
+        if( status == StatusCode::Success )
+        {
+            result = values[0];
+        }
+
+        // Passes submitted before a failure may still run.
+        WaitForTimelineValue( m_ComputeTimeline, m_ComputeTimeline.m_Value );
+
+        for( const ComputeBufferHandle<float> partial : partials )
+        {
+            DestroyComputeJobBuffer( partial );
+        }
+
+        return status;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Computes prefix sums of a compute buffer on the gpu in a single pass and waits for them.
+    ////////////////////////////////////////////////////////////
+    StatusCode ScanComputeBuffer(
+        const ComputeBufferHandle<float> values,
+        const ComputeBufferHandle<float> sums,
+        const uint32_t                   elementCount,
+        const ComputeScan                scan )
+    {
+        const TraceZone zone( "ScanComputeBuffer" );
+
+        if( !m_IsSubgroupArithmeticSupported || elementCount == 0 )
+        {
+            std::cerr << "Compute scan is not supported!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        // Partition counter, then flag, aggregate and inclusive prefix of each partition.
+        const uint32_t              partitionCount = ( elementCount + m_ComputeWorkgroupSize - 1 ) / m_ComputeWorkgroupSize;
+        const std::vector<uint32_t> partitionStates( 1 + 3 * static_cast<size_t>( partitionCount ), 0 );
+
+        ComputeBufferHandle<uint32_t> states = {};
+
+        if( CreateComputeJobBuffer( static_cast<uint32_t>( partitionStates.size() ), partitionStates.data(), states ) != StatusCode::Success )
+        {
+            return StatusCode::Fail;
+        }
+
+        const ParallelPrimitiveConstants constants = { elementCount, scan == ComputeScan::Exclusive ? 1u : 0u };
+
+        ComputeJob job        = {};
+        job.m_Kernel          = m_ScanKernel;
+        job.m_InvocationCount = elementCount;
+        job.AddBuffer( values );
+        job.AddBuffer( sums );
+        job.AddBuffer( states );
+        job.SetPushConstants( constants );
+
+        std::shared_future<StatusCode> completion;
+        StatusCode                     result = SubmitComputeJob( job, completion );
+
+        if( result == StatusCode::Success )
+        {
+            result = completion.get();
+        }
+
+        DestroyComputeJobBuffer( states );
+
+        return result;
+    }
+
+private:
+    ////////////////////////////////////////////////////////////
+    /// Initialize the window using glfw.
+    ////////////////////////////////////////////////////////////
+    StatusCode InitializeWindow()
+    {
+        // Initialize glfw library.
+        if( glfwInit() != GLFW_TRUE )
+        {
+            std::cerr << "Cannot initialize glfw library!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        // Tell explicitly not to create an OpenGL context.
+        glfwWindowHint( GLFW_CLIENT_API, GLFW_NO_API );
+
+        // Initialize the window.
+        m_Window = glfwCreateWindow( m_Width, m_Height, m_WindowName.c_str(), nullptr, nullptr );
+        if( m_Window == nullptr )
+        {
+            std::cerr << "Cannot create window!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        // Set a callback for window resizing.
+        glfwSetWindowUserPointer( m_Window, this );
+        glfwSetFramebufferSizeCallback( m_Window, static_cast<GLFWframebuffersizefun>( FrameBufferResizeCallback ) );
+
+        // Set a callback for writing the trace on demand.
+        if( !m_Settings.m_TraceOutput.empty() )
+        {
+            glfwSetKeyCallback( m_Window, static_cast<GLFWkeyfun>( KeyCallback ) );
+        }
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Initializes Vulkan api.
+    ////////////////////////////////////////////////////////////
+    StatusCode InitializeVulkan()
+    {
+        StatusCode result = StatusCode::Success;
+
+        // Assets are loaded on worker threads while the device is created.
+        LoadAssets();
+
+        result = CreateInstance();
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Vulkan instance creation failed!" << std::endl;
+            return result;
+        }
+
+#ifdef _DEBUG
+        result = SetupDebugMessenger();
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Setup debug messenger failed!" << std::endl;
+            return result;
+        }
+#endif
+        if( !m_Settings.m_IsHeadless )
+        {
+            result = CreateSurface();
+            if( result != StatusCode::Success )
+            {
+                std::cerr << "Surface creation failed!" << std::endl;
+                return result;
+            }
+        }
+
+        result = PickPhysicalDevice();
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Physical device picking failed!" << std::endl;
+            return result;
+        }
+
+        result = CreateLogicalDevice();
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Logical device creation failed!" << std::endl;
+            return result;
+        }
+
+        if( m_Settings.m_IsHeadless )
+        {
+            result = CreateOffscreenImages();
+            if( result != StatusCode::Success )
+            {
+                std::cerr << "Offscreen images creation failed!" << std::endl;
+                return result;
+            }
+        }
+        else
+        {
+            result = CreateSwapChain();
+            if( result != StatusCode::Success )
+            {
+                std::cerr << "Swap chain creation failed!" << std::endl;
+                return result;
+            }
+        }
+
+        result = CreateImageViews();
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Image views creation failed!" << std::endl;
+            return result;
+        }
+
+        result = CreateRenderPass();
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Render pass creation failed!" << std::endl;
+            return result;
+        }
+
+        result = CreateDescriptorSetLayout();
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Descriptor set layout creation failed!" << std::endl;
+            return result;
+        }
+
+        result = CreateGraphicsPipeline();
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Graphics pipeline creation failed!" << std::endl;
+            return result;
+        }
+
+        result = CreateComputePipeline();
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Compute pipeline creation failed!" << std::endl;
+            return result;
+        }
+
+        result = CreateCommandPools();
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Command pool creation failed!" << std::endl;
+            return result;
+        }
+
+        // Uploads signal timelines, so they are created before the first upload batch.
+        result = CreateTimelines();
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Timelines creation failed!" << std::endl;
+            return result;
+        }
+
+        StartComputeJobWaiter();
+        StartFrameLatencyWaiter();
+
+        result = CreateStagingRingBuffer();
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Staging ring buffer creation failed!" << std::endl;
+            return result;
+        }
+
+        result = CreateDepthResources();
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Depth resources creation failed!" << std::endl;
+            return result;
+        }
+
+        result = CreateFramebuffers();
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Frame buffers creation failed!" << std::endl;
+            return result;
+        }
+
+        result = CreateTextureImage();
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Texture image creation failed!" << std::endl;
+            return result;
+        }
+
+        result = CreateTextureImageView();
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Texture image view creation failed!" << std::endl;
+            return result;
+        }
+
+        result = CreateTextureSampler();
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Texture sampler creation failed!" << std::endl;
+            return result;
+        }
+
+        result = CreateVertexBuffer();
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Vertex buffers creation failed!" << std::endl;
+            return result;
+        }
+
+        result = CreateIndexBuffer();
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Index buffers creation failed!" << std::endl;
+            return result;
+        }
+
+        if( m_IsGpuCullingSupported )
+        {
+            result = CreateCullingClusters();
+            if( result != StatusCode::Success )
+            {
+                std::cerr << "Culling clusters creation failed!" << std::endl;
+                return result;
+            }
+        }
+
+        // Uploads overlap the rest of initialization, staging memory is released once they complete.
+        result = SubmitUploadBatch();
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Upload batch submission failed!" << std::endl;
+            return result;
+        }
+
+        result = CreateUniformBuffers();
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Uniform buffers creation failed!" << std::endl;
+            return result;
+        }
+
+        result = CreateCullingDrawBuffers();
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Culling draw buffers creation failed!" << std::endl;
+            return result;
+        }
+
+        result = CreateComputeBuffers();
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Compute buffers creation failed!" << std::endl;
+            return result;
+        }
+
+        result = CreateDescriptorPool();
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Descriptor pool creation failed!" << std::endl;
+            return result;
+        }
+
+        result = CreateDescriptorSets();
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Descriptor sets creation failed!" << std::endl;
+            return result;
+        }
+
+        result = CreateCommandBuffers();
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Command buffers creation failed!" << std::endl;
+            return result;
+        }
+
+        result = CreateQueries();
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Queries creation failed!" << std::endl;
+            return result;
+        }
+
+        result = CreateComputeJobDescriptorPool();
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Compute job descriptor pool creation failed!" << std::endl;
+            return result;
+        }
+
+        if( m_IsSubgroupArithmeticSupported )
+        {
+            result = RegisterComputeKernel( "Shaders/reduce.spv", 0, sizeof( ParallelPrimitiveConstants ), m_ReductionKernel );
+            if( result == StatusCode::Success )
+            {
+                result = RegisterComputeKernel( "Shaders/scan.spv", 0, sizeof( ParallelPrimitiveConstants ), m_ScanKernel );
+            }
+            if( result != StatusCode::Success )
+            {
+                std::cerr << "Reduction and scan kernels creation failed!" << std::endl;
+                return result;
+            }
+        }
+
+        result = RecordCommandBuffers();
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Command buffers recording failed!" << std::endl;
+            return result;
+        }
+
+        result = CreateSemaphores();
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Semaphores creation failed!" << std::endl;
+            return result;
+        }
+
+        // Traces and the compute overlap place the timestamps of both queues on the trace clock.
+        if( m_IsTimestampQuerySupported )
+        {
+            result = CalibrateGpuTimestamps( m_GraphicsQueue, m_QueueFamilyIndices.m_GraphicsFamily, m_CommandPoolGraphics, m_GraphicsTimeline, m_GraphicsTimestampCalibration );
+
+            if( result == StatusCode::Success )
+            {
+                result = CalibrateGpuTimestamps( m_ComputeQueue, m_QueueFamilyIndices.m_ComputeFamily, m_CommandPoolCompute, m_ComputeTimeline, m_ComputeTimestampCalibration );
+            }
+
+            if( result != StatusCode::Success )
+            {
+                std::cerr << "Gpu timestamps calibration failed!" << std::endl;
+                return result;
+            }
+        }
+
+        return result;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Main loop of the application.
+    ////////////////////////////////////////////////////////////
+    StatusCode MainLoop()
+    {
+        StatusCode result = StatusCode::Success;
+
+        // Check for events.
+        while( IsRunning() && result == StatusCode::Success )
+        {
+            const TraceZone zone( "Frame" );
+
+            // Wait for the frame slot before sampling input, so the frame uses the newest input.
+            BeginFrame();
+
+            if( !m_Settings.m_IsHeadless )
+            {
+                const TraceZone pollZone( "PollEvents" );
+
+                glfwPollEvents();
+            }
+
+            // The file is overwritten at exit again.
+            if( m_IsTraceRequested )
+            {
+                m_IsTraceRequested = false;
+
+                if( Tracer::Get().Write( m_Settings.m_TraceOutput ) == StatusCode::Success )
+                {
+                    std::cout << "Trace written to " << m_Settings.m_TraceOutput << std::endl;
+                }
+            }
+
+            result = DrawFrameAndMultiplyVector();
+
+            ReleaseCompletedUploadBatches();
+            ReleaseCompletedComputeJobs();
+            PrintGpuProfile();
+            PrintPipelineStatistics();
+
+            if( result == StatusCode::Success )
+            {
+                result = DefragmentGpuMemory();
+            }
+        }
+
+        PrintGpuMemoryStats();
+
+        if( vkDeviceWaitIdle( m_Device ) != VK_SUCCESS )
+        {
+            std::cerr << "Failed to waiting for device!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        m_BenchmarkEndTime = FrameClock::now();
+
+        StopFrameLatencyWaiter();
+        CollectFrameLatencies();
+        PrintFrameLatencyStats();
+
+        if( m_Settings.m_IsBenchmark && WriteBenchmarkResults() != StatusCode::Success )
+        {
+            std::cerr << "Failed to write benchmark results!" << std::endl;
+            result = StatusCode::Fail;
+        }
+
+        if( WritePipelineStatistics() != StatusCode::Success )
+        {
+            std::cerr << "Failed to write pipeline statistics!" << std::endl;
+            result = StatusCode::Fail;
+        }
+
+        if( !m_Settings.m_TraceOutput.empty() && Tracer::Get().Write( m_Settings.m_TraceOutput ) != StatusCode::Success )
+        {
+            std::cerr << "Failed to write trace!" << std::endl;
+            result = StatusCode::Fail;
+        }
+
+        // Write the frames captured after the last reuse of their images.
+        for( uint32_t i = 0; i < m_CapturedFrameIndices.size(); ++i )
+        {
+            if( WriteCapturedFrame( i ) != StatusCode::Success && result == StatusCode::Success )
+            {
+                result = StatusCode::Fail;
+            }
+        }
+
+        // Verify the results of the last frames.
+        if( FinishComputeVerification() != StatusCode::Success && result == StatusCode::Success )
+        {
+            std::cerr << "Failed to verify compute workload!" << std::endl;
+            result = StatusCode::Fail;
+        }
+
+        return result;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Checks if the main loop should render another frame.
+    ////////////////////////////////////////////////////////////
+    bool IsRunning() const
+    {
+        if( m_FrameCount != 0 && m_FrameIndex >= m_FrameCount )
+        {
+            return false;
+        }
+
+        // The benchmark clock starts with the first measured frame.
+        if( IsBenchmarkMeasuring() && m_FrameIndex > m_Settings.m_WarmupFrameCount && m_Settings.m_BenchmarkSeconds > 0.0f &&
+            std::chrono::duration<float>( FrameClock::now() - m_BenchmarkStartTime ).count() >= m_Settings.m_BenchmarkSeconds )
+        {
+            return false;
+        }
+
+        return m_Settings.m_IsHeadless || !glfwWindowShouldClose( m_Window );
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Cleanups the window.
+    ////////////////////////////////////////////////////////////
+    StatusCode CleanupWindow()
+    {
+        // Destroy the windows.
+        glfwDestroyWindow( m_Window );
+
+        // Destroy glfw library.
+        glfwTerminate();
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Starts loading the model, the texture and the shaders on worker threads.
+    ////////////////////////////////////////////////////////////
+    void LoadAssets()
+    {
+        m_ModelLoading   = std::async( std::launch::async, [this]() { return LoadModel(); } );
+        m_TextureLoading = std::async( std::launch::async, [this]() { return LoadTexture(); } );
+        m_ShaderLoading  = std::async( std::launch::async, [this]() { return LoadShaders(); } );
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Waits for an asset loaded on a worker thread.
+    ////////////////////////////////////////////////////////////
+    static StatusCode WaitForAsset( std::future<StatusCode>& loading )
+    {
+        // Already joined.
+        if( !loading.valid() )
+        {
+            return StatusCode::Success;
+        }
+
+        return loading.get();
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Loads a model.
+    ////////////////////////////////////////////////////////////
+    StatusCode LoadModel()
+    {
+        return TinyObjLoader::loadModel( "Models/viking_room.obj", Vertices, Indices )
+            ? StatusCode::Success
+            : StatusCode::Fail;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Decodes a texture.
+    ////////////////////////////////////////////////////////////
+    StatusCode LoadTexture()
+    {
+        // std::string textureFileName = "Textures/texture.jpg";
+        std::string textureFileName = "Textures/viking_room.png";
+
+        m_LoadedTexture.m_Pixels = StbImage::loadRgba(
+            textureFileName,
+            m_LoadedTexture.m_Width,
+            m_LoadedTexture.m_Height,
+            m_LoadedTexture.m_Channels );
+
+        return m_LoadedTexture.m_Pixels != nullptr
+            ? StatusCode::Success
+            : StatusCode::Fail;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Reads the bytecode of shaders, kept for swap chain recreation.
+    ////////////////////////////////////////////////////////////
+    StatusCode LoadShaders()
+    {
+        m_VertexShaderCode   = ReadBinaryFile( "Shaders/vert.spv" );
+        m_FragmentShaderCode = ReadBinaryFile( "Shaders/frag.spv" );
+        m_ComputeShaderCode  = ReadBinaryFile( "Shaders/comp.spv" );
+
+        return m_VertexShaderCode.empty() || m_FragmentShaderCode.empty() || m_ComputeShaderCode.empty()
+            ? StatusCode::Fail
+            : StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Creates Vulkan instance.
+    ////////////////////////////////////////////////////////////
+    StatusCode CreateInstance()
+    {
+        // Information about the application.
+        VkApplicationInfo applicationInfo  = {};
+        applicationInfo.sType              = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+        applicationInfo.pApplicationName   = m_WindowName.c_str();
+        applicationInfo.applicationVersion = VK_MAKE_VERSION( 1, 0, 0 );
+        applicationInfo.pEngineName        = "No Engine";
+        applicationInfo.engineVersion      = VK_MAKE_VERSION( 1, 0, 0 );
+        applicationInfo.apiVersion         = VK_API_VERSION_1_2;
+
+        // Obtain required extensions, headless mode does not need surface extensions.
+        uint32_t                 glfwExtensionCount = 0;
+        const char**             glfwExtensions     = m_Settings.m_IsHeadless ? nullptr : glfwGetRequiredInstanceExtensions( &glfwExtensionCount );
+        std::vector<const char*> extensions( glfwExtensions, glfwExtensions + glfwExtensionCount );
+
+#ifdef _DEBUG
+        // Add debug messenger extension.
+        extensions.push_back( VK_EXT_DEBUG_UTILS_EXTENSION_NAME );
+#endif
+
+        // Enumarate supported extensions.
+        uint32_t extensionCount = 0;
+        vkEnumerateInstanceExtensionProperties( nullptr, &extensionCount, nullptr );
+
+        std::vector<VkExtensionProperties> availableExtensions( extensionCount );
+        vkEnumerateInstanceExtensionProperties( nullptr, &extensionCount, availableExtensions.data() );
+
+        // Check if required extensions are supported.
+        std::set<std::string> requiredRequiredExtensions( extensions.begin(), extensions.end() );
+
+        for( const auto& extension : availableExtensions )
+        {
+            requiredRequiredExtensions.erase( extension.extensionName );
+        }
+
+        if( !requiredRequiredExtensions.empty() )
+        {
+            std::cerr << "Cannot find required extensions!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+#ifdef _DEBUG
+        // Enumarate supported validation layers.
+        uint32_t layerCount;
+        vkEnumerateInstanceLayerProperties( &layerCount, nullptr );
+
+        std::vector<VkLayerProperties> availableLayers( layerCount );
+        vkEnumerateInstanceLayerProperties( &layerCount, availableLayers.data() );
+
+        // Check if required validation layers are supported.
+        std::set<std::string> requiredValidationLayers( m_ValidationLayers.begin(), m_ValidationLayers.end() );
+
+        for( const auto& layer : availableLayers )
+        {
+            requiredValidationLayers.erase( layer.layerName );
+        }
+
+        if( !requiredValidationLayers.empty() )
+        {
+            std::cerr << "Cannot find required validation layers!" << std::endl;
+            return StatusCode::Fail;
+        }
+#endif
+
+        // Sufficient information for creating an instance.
+        VkInstanceCreateInfo createInfo    = {};
+        createInfo.sType                   = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+        createInfo.pApplicationInfo        = &applicationInfo;
+        createInfo.enabledExtensionCount   = static_cast<uint32_t>( extensions.size() );
+        createInfo.ppEnabledExtensionNames = extensions.data();
+#ifdef _DEBUG
+        createInfo.enabledLayerCount   = static_cast<uint32_t>( m_ValidationLayers.size() );
+        createInfo.ppEnabledLayerNames = m_ValidationLayers.data();
+
+        VkDebugUtilsMessengerCreateInfoEXT debugCreateInfo = {};
+        PopulateDebugMessengerCreateInfo( debugCreateInfo );
+
+        if constexpr( EnableBestPracticesValidation )
+        {
+            const VkValidationFeatureEnableEXT enables  = VK_VALIDATION_FEATURE_ENABLE_BEST_PRACTICES_EXT;
+            VkValidationFeaturesEXT            features = {};
+
+            features.sType                         = VK_STRUCTURE_TYPE_VALIDATION_FEATURES_EXT;
+            features.enabledValidationFeatureCount = 1;
+            features.pEnabledValidationFeatures    = &enables;
+
+            createInfo.pNext = &features;
+        }
+        else
+        {
+            createInfo.pNext = &debugCreateInfo;
+        }
+#else
+        createInfo.enabledLayerCount       = 0;
+#endif
+
+        if( vkCreateInstance( &createInfo, nullptr, &m_Instance ) != VK_SUCCESS )
+        {
+            std::cerr << "Cannot create Vulkan instance!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Creates Vulkan surface.
+    ////////////////////////////////////////////////////////////
+    StatusCode CreateSurface()
+    {
+        if( glfwCreateWindowSurface( m_Instance, m_Window, nullptr, &m_Surface ) != VK_SUCCESS )
+        {
+            std::cerr << "Cannot create Vulkan surface using glfw library!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Picks a suitable graphics card.
+    ////////////////////////////////////////////////////////////
+    StatusCode PickPhysicalDevice()
+    {
+        // Enumerate for available graphics cards.
+        uint32_t physicalDeviceCount = 0;
+        vkEnumeratePhysicalDevices( m_Instance, &physicalDeviceCount, nullptr );
+
+        if( physicalDeviceCount == 0 )
+        {
+            std::cerr << "Cannot find a physical device!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        std::vector<VkPhysicalDevice> physicalDevices( physicalDeviceCount );
+        vkEnumeratePhysicalDevices( m_Instance, &physicalDeviceCount, physicalDevices.data() );
+
+        // Choose a suitibale graphics card.
+        uint32_t bestScore = 0;
+
+        for( const auto& physicalDevice : physicalDevices )
+        {
+            if( IsPhysicalDeviceSuitable( physicalDevice ) )
+            {
+                uint32_t currentScore = RatePhysicalDeviceSuitability( physicalDevice );
+                if( currentScore > bestScore )
+                {
+                    m_PhysicalDevice = physicalDevice;
+                    bestScore        = currentScore;
+                }
+            }
+        }
+
+        if( m_PhysicalDevice == VK_NULL_HANDLE )
+        {
+            std::cerr << "Cannot find a suitable physical device!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        // Get properties and gpu memory properties of the chosen physical device.
+        vkGetPhysicalDeviceProperties( m_PhysicalDevice, &m_PhysicalDeviceProperties );
+        vkGetPhysicalDeviceMemoryProperties( m_PhysicalDevice, &m_GpuMemoryProperties );
+
+        // Check if the whole device local memory is host visible (UMA or resizable BAR),
+        // then uploads can write directly to device local memory without staging.
+        VkDeviceSize deviceLocalHeapSize            = 0;
+        VkDeviceSize hostVisibleDeviceLocalHeapSize = 0;
+
+        for( uint32_t i = 0; i < m_GpuMemoryProperties.memoryTypeCount; ++i )
+        {
+            const VkMemoryType& memoryType = m_GpuMemoryProperties.memoryTypes[i];
+            const VkDeviceSize  heapSize   = m_GpuMemoryProperties.memoryHeaps[memoryType.heapIndex].size;
+
+            if( memoryType.propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT )
+            {
+                deviceLocalHeapSize = std::max( deviceLocalHeapSize, heapSize );
+
+                if( ( memoryType.propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT ) &&
+                    ( memoryType.propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT ) )
+                {
+                    hostVisibleDeviceLocalHeapSize = std::max( hostVisibleDeviceLocalHeapSize, heapSize );
+                }
+            }
+        }
+
+        m_IsDeviceLocalMemoryHostVisible = deviceLocalHeapSize > 0 && hostVisibleDeviceLocalHeapSize == deviceLocalHeapSize;
+
+        // Timestamps are written on graphics and compute queues.
+        m_IsTimestampQuerySupported =
+            m_PhysicalDeviceProperties.limits.timestampComputeAndGraphics &&
+            m_PhysicalDeviceProperties.limits.timestampPeriod > 0.0f;
+
+        // Choose the compute workgroup size from the subgroup size and split the dispatch to fit the limits.
+        VkPhysicalDeviceSubgroupProperties subgroupProperties = {};
+        subgroupProperties.sType                              = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES;
+
+        VkPhysicalDeviceProperties2 physicalDeviceProperties = {};
+        physicalDeviceProperties.sType                       = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        physicalDeviceProperties.pNext                       = &subgroupProperties;
+
+        vkGetPhysicalDeviceProperties2( m_PhysicalDevice, &physicalDeviceProperties );
+
+        m_ComputeWorkgroupSize = GetComputeWorkgroupSize( m_PhysicalDeviceProperties.limits, subgroupProperties.subgroupSize );
+
+        // Reductions and scans combine subgroups in registers.
+        constexpr VkSubgroupFeatureFlags subgroupFeatures = VK_SUBGROUP_FEATURE_BASIC_BIT | VK_SUBGROUP_FEATURE_ARITHMETIC_BIT;
+
+        m_IsSubgroupArithmeticSupported =
+            ( subgroupProperties.supportedStages & VK_SHADER_STAGE_COMPUTE_BIT ) &&
+            ( subgroupProperties.supportedOperations & subgroupFeatures ) == subgroupFeatures;
+
+        // Gpu culling writes a variable count of draws for a single indirect draw call,
+        // multi draw indirect is enabled with the other core features of the device.
+        VkPhysicalDeviceVulkan12Features vulkan12Features = {};
+        vulkan12Features.sType                            = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+        VkPhysicalDeviceFeatures2 physicalDeviceFeatures = {};
+        physicalDeviceFeatures.sType                     = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        physicalDeviceFeatures.pNext                     = &vulkan12Features;
+
+        vkGetPhysicalDeviceFeatures2( m_PhysicalDevice, &physicalDeviceFeatures );
+
+        // The culling dispatch is recorded into the graphics command buffers.
+        m_IsGpuCullingSupported =
+            !m_Settings.m_IsGpuCullingDisabled &&
+            vulkan12Features.drawIndirectCount &&
+            m_PhysicalDeviceFeatures.multiDrawIndirect &&
+            FindQueueFamilies( m_PhysicalDevice ).m_IsGraphicsFamilyCompute;
+
+        if( GetComputeDispatchSize( m_PhysicalDeviceProperties.limits, m_VectorElementCount, m_ComputeWorkgroupSize, m_ComputeDispatchSize ) != StatusCode::Success )
+        {
+            std::cerr << "Compute dispatch of " << m_VectorElementCount << " elements exceeds the workgroup count limits!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        // Enable heap budget queries if available, otherwise estimate the budget from heap sizes.
+        m_IsMemoryBudgetSupported = CheckPhysicalDeviceExtensionSupport( m_PhysicalDevice, { VK_EXT_MEMORY_BUDGET_EXTENSION_NAME } );
+
+        if( m_IsMemoryBudgetSupported )
+        {
+            m_PhysicalDeviceExtensions.emplace_back( VK_EXT_MEMORY_BUDGET_EXTENSION_NAME );
+        }
+
+        // Enable calibrated timestamps if available, otherwise gpu timestamps are calibrated by a submission round trip.
+        m_IsCalibratedTimestampSupported =
+            CheckPhysicalDeviceExtensionSupport( m_PhysicalDevice, { VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME } ) &&
+            IsTimeDomainCalibrateable( VK_TIME_DOMAIN_DEVICE_EXT ) &&
+            IsTimeDomainCalibrateable( TraceTimeDomain );
+
+        if( m_IsCalibratedTimestampSupported )
+        {
+            m_PhysicalDeviceExtensions.emplace_back( VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME );
+        }
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Checks if calibrated timestamps can sample the time domain.
+    ////////////////////////////////////////////////////////////
+    bool IsTimeDomainCalibrateable( const VkTimeDomainEXT timeDomain ) const
+    {
+        uint32_t timeDomainCount = 0;
+
+        if( vkGetPhysicalDeviceCalibrateableTimeDomainsExtension( m_Instance, m_PhysicalDevice, &timeDomainCount, nullptr ) != VK_SUCCESS )
+        {
+            return false;
+        }
+
+        std::vector<VkTimeDomainEXT> timeDomains( timeDomainCount );
+
+        if( vkGetPhysicalDeviceCalibrateableTimeDomainsExtension( m_Instance, m_PhysicalDevice, &timeDomainCount, timeDomains.data() ) != VK_SUCCESS )
+        {
+            return false;
+        }
+
+        return std::find( timeDomains.begin(), timeDomains.end(), timeDomain ) != timeDomains.end();
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Returns the compute workgroup size of four subgroups, clamped to 64 - 256 invocations and the device limits.
+    ////////////////////////////////////////////////////////////
+    static uint32_t GetComputeWorkgroupSize( const VkPhysicalDeviceLimits& limits, const uint32_t subgroupSize )
+    {
+        // Several subgroups per workgroup hide memory latency, subgroup sizes are powers of two.
+        uint32_t workgroupSize = std::clamp( 4 * std::max( subgroupSize, 1u ), MinComputeWorkgroupSize, MaxComputeWorkgroupSize );
+
+        while( workgroupSize > 1 &&
+               ( workgroupSize > limits.maxComputeWorkGroupSize[0] || workgroupSize > limits.maxComputeWorkGroupInvocations ) )
+        {
+            workgroupSize /= 2;
+        }
+
+        return workgroupSize;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Returns workgroup counts covering the elements, the x count is split to y and z if it exceeds the limit.
+    ////////////////////////////////////////////////////////////
+    static StatusCode GetComputeDispatchSize(
+        const VkPhysicalDeviceLimits& limits,
+        const uint32_t                elementCount,
+        const uint32_t                workgroupSize,
+        std::array<uint32_t, 3>&      dispatchSize )
+    {
+        const uint64_t workgroupCount = ( static_cast<uint64_t>( elementCount ) + workgroupSize - 1 ) / workgroupSize;
+        const uint64_t countX         = std::max<uint64_t>( std::min<uint64_t>( workgroupCount, limits.maxComputeWorkGroupCount[0] ), 1 );
+        const uint64_t countY         = std::min<uint64_t>( ( workgroupCount + countX - 1 ) / countX, limits.maxComputeWorkGroupCount[1] );
+        const uint64_t countZ         = ( workgroupCount + countX * countY - 1 ) / ( countX * countY );
+
+        if( countZ > limits.maxComputeWorkGroupCount[2] )
+        {
+            return StatusCode::Fail;
+        }
+
+        // Workgroups past the element count return early in the shader.
+        dispatchSize = { static_cast<uint32_t>( countX ), static_cast<uint32_t>( std::max<uint64_t>( countY, 1 ) ), static_cast<uint32_t>( std::max<uint64_t>( countZ, 1 ) ) };
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Rates graphics card suitability.
+    ////////////////////////////////////////////////////////////
+    uint32_t RatePhysicalDeviceSuitability( VkPhysicalDevice physicalDevice )
+    {
+        // Get the physical device properties.
+        VkPhysicalDeviceProperties physicalDeviceProperties = {};
+        vkGetPhysicalDeviceProperties( physicalDevice, &physicalDeviceProperties );
+
+        // Get the physical device features.
+        vkGetPhysicalDeviceFeatures( physicalDevice, &m_PhysicalDeviceFeatures );
+
+        // Do not choose a physical device without tessellation shader support.
+        if( !m_PhysicalDeviceFeatures.tessellationShader )
+        {
+            return 0;
+        }
+
+        // Do not choose a physical device without Vulkan 1.2 (timeline semaphores).
+        if( physicalDeviceProperties.apiVersion < VK_API_VERSION_1_2 )
+        {
+            return 0;
+        }
+
+        VkPhysicalDeviceVulkan12Features vulkan12Features = {};
+        vulkan12Features.sType                            = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+        VkPhysicalDeviceFeatures2 features = {};
+        features.sType                     = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features.pNext                     = &vulkan12Features;
+
+        vkGetPhysicalDeviceFeatures2( physicalDevice, &features );
+
+        if( !vulkan12Features.timelineSemaphore )
+        {
+            return 0;
+        }
+
+        uint32_t score = 0;
+
+        switch( physicalDeviceProperties.deviceType )
+        {
+            case VK_PHYSICAL_DEVICE_TYPE_OTHER:
+                score += 2;
+                break;
+
+            case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+                score += 100;
+                break;
+
+            case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+                score += 1000;
+                break;
+
+            case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+                score += 10;
+                break;
+
+            case VK_PHYSICAL_DEVICE_TYPE_CPU:
+                score += 5;
+                break;
+
+            default:
+                score += 1;
+        }
+
+        score += physicalDeviceProperties.limits.maxImageDimension2D;
+
+        // Get max sampler anisotropy.
+        if( m_PhysicalDeviceFeatures.samplerAnisotropy )
+        {
+            m_MaxSamplerAnisotropy = physicalDeviceProperties.limits.maxSamplerAnisotropy;
+        }
+
+        // Get pipeline statistics query.
+        m_IsPipelineStatisticsQuerySupported = m_PhysicalDeviceFeatures.pipelineStatisticsQuery;
+
+        return score;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Checks if the physical device is suitable.
+    ////////////////////////////////////////////////////////////
+    bool IsPhysicalDeviceSuitable( VkPhysicalDevice physicalDevice )
+    {
+        const QueueFamilyIndices indices = FindQueueFamilies( physicalDevice );
+
+        const bool areQueueFamiliesSupported =
+            indices.m_HasGraphicsFamily &&
+            ( indices.m_HasPresentFamily || m_Settings.m_IsHeadless );
+
+        const bool areExtensionsSupported =
+            areQueueFamiliesSupported &&
+            CheckPhysicalDeviceExtensionSupport( physicalDevice, m_PhysicalDeviceExtensions );
+
+        // Headless mode renders to offscreen images, so a swap chain is not needed.
+        if( m_Settings.m_IsHeadless )
+        {
+            return areExtensionsSupported;
+        }
+
+        const SwapChainSupportDetails details = QuerySwapChainSupport( physicalDevice );
+
+        const bool areSwapChainDetailsSupported =
+            areExtensionsSupported &&
+            !details.m_Formats.empty() &&
+            !details.m_PresentModes.empty();
+
+        return areSwapChainDetailsSupported;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Checks for needed physical device extensions support.
+    ////////////////////////////////////////////////////////////
+    bool CheckPhysicalDeviceExtensionSupport( VkPhysicalDevice physicalDevice, const std::vector<const char*>& extensions )
+    {
+        uint32_t extensionCount;
+        vkEnumerateDeviceExtensionProperties( physicalDevice, nullptr, &extensionCount, nullptr );
+
+        std::vector<VkExtensionProperties> availableExtensions( extensionCount );
+        vkEnumerateDeviceExtensionProperties( physicalDevice, nullptr, &extensionCount, availableExtensions.data() );
+
+        std::set<std::string> requiredExtensions( extensions.begin(), extensions.end() );
+
+        for( const auto& extension : availableExtensions )
+        {
+            requiredExtensions.erase( extension.extensionName );
+        }
+
+        return requiredExtensions.empty();
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Creates a logical device.
+    ////////////////////////////////////////////////////////////
+    StatusCode CreateLogicalDevice()
+    {
+        // Get graphics queue family index.
+        m_QueueFamilyIndices = FindQueueFamilies( m_PhysicalDevice );
+
+        // Graphics, compute, copy and present queues create information.
+        std::vector<VkDeviceQueueCreateInfo>    queueCreateInfos    = {};
+        std::vector<std::vector<float>>         queuesPriorities    = {};
+        std::set<std::pair<uint32_t, uint32_t>> uniqueQueueFamilies = {
+            { m_QueueFamilyIndices.m_GraphicsFamily, m_QueueFamilyIndices.m_GraphicsCount },
+            { m_QueueFamilyIndices.m_ComputeFamily, m_QueueFamilyIndices.m_ComputeCount },
+            { m_QueueFamilyIndices.m_CopyFamily, m_QueueFamilyIndices.m_CopyCount },
+            { m_QueueFamilyIndices.m_PresentFamily, m_QueueFamilyIndices.m_PresentCount }
+        };
+
+        for( const auto& queueFamily : uniqueQueueFamilies )
+        {
+            if( queueFamily.second == 0 )
+            {
+                // Queue count is equal 0, continuing.
+                continue;
+            }
+
+            // Set the queue priority.
+            std::vector<float> queuePriorities( queueFamily.second );
+
+            for( auto& queuePriority : queuePriorities )
+            {
+                queuePriority = 1.0f;
+            }
+
+            queuesPriorities.emplace_back( queuePriorities );
+
+            // Populate queue create information.
+            VkDeviceQueueCreateInfo queueCreateInfo = {};
+            queueCreateInfo.sType                   = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+            queueCreateInfo.queueFamilyIndex        = queueFamily.first;
+            queueCreateInfo.queueCount              = queueFamily.second;
+            queueCreateInfo.pQueuePriorities        = queuesPriorities.back().data();
+
+            queueCreateInfos.emplace_back( queueCreateInfo );
+        }
+
+        // Enable timeline semaphores and the indirect draws of gpu culling.
+        VkPhysicalDeviceVulkan12Features vulkan12Features = {};
+        vulkan12Features.sType                            = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        vulkan12Features.timelineSemaphore                = VK_TRUE;
+        vulkan12Features.drawIndirectCount                = m_IsGpuCullingSupported ? VK_TRUE : VK_FALSE;
+
+        // Populate logical device create information.
+        VkDeviceCreateInfo deviceCreateInfo      = {};
+        deviceCreateInfo.sType                   = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+        deviceCreateInfo.pNext                   = &vulkan12Features;
+        deviceCreateInfo.queueCreateInfoCount    = static_cast<uint32_t>( queueCreateInfos.size() );
+        deviceCreateInfo.pQueueCreateInfos       = queueCreateInfos.data();
+        deviceCreateInfo.pEnabledFeatures        = &m_PhysicalDeviceFeatures;
+        deviceCreateInfo.enabledExtensionCount   = static_cast<uint32_t>( m_PhysicalDeviceExtensions.size() );
+        deviceCreateInfo.ppEnabledExtensionNames = m_PhysicalDeviceExtensions.data();
+#ifdef _DEBUG
+        deviceCreateInfo.enabledLayerCount   = static_cast<uint32_t>( m_ValidationLayers.size() );
+        deviceCreateInfo.ppEnabledLayerNames = m_ValidationLayers.data();
+#else
+        deviceCreateInfo.enabledLayerCount = 0;
+#endif
+
+        // Create a logical device.
+        if( vkCreateDevice( m_PhysicalDevice, &deviceCreateInfo, nullptr, &m_Device ) != VK_SUCCESS )
+        {
+            std::cerr << "Cannot create a logical device!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        // Get graphics queue.
+        const uint32_t graphicsQueueIndex = m_QueueFamilyIndices.m_GraphicsCount - 1;
+
+        vkGetDeviceQueue( m_Device, m_QueueFamilyIndices.m_GraphicsFamily, graphicsQueueIndex, &m_GraphicsQueue );
+        if( m_GraphicsQueue == nullptr )
+        {
+            std::cerr << "Cannot obtain graphics queue!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        // Get compute queue.
+        if( m_QueueFamilyIndices.m_HasComputeFamily &&
+            m_QueueFamilyIndices.m_GraphicsFamily != m_QueueFamilyIndices.m_ComputeFamily )
+        {
+            const uint32_t computeQueueIndex = m_QueueFamilyIndices.m_ComputeCount - 1;
+
+            vkGetDeviceQueue( m_Device, m_QueueFamilyIndices.m_ComputeFamily, computeQueueIndex, &m_ComputeQueue );
+            if( m_ComputeQueue == nullptr )
+            {
+                std::cerr << "Cannot obtain compute queue!" << std::endl;
+                return StatusCode::Fail;
+            }
+        }
+        else
+        {
+            m_ComputeQueue = m_GraphicsQueue;
+        }
+
+        // Get copy family.
+        if( m_QueueFamilyIndices.m_HasCopyFamily &&
+            m_QueueFamilyIndices.m_GraphicsFamily != m_QueueFamilyIndices.m_CopyFamily )
+        {
+            const uint32_t copyQueueIndex = m_QueueFamilyIndices.m_CopyCount - 1;
+
+            vkGetDeviceQueue( m_Device, m_QueueFamilyIndices.m_CopyFamily, copyQueueIndex, &m_CopyQueue );
+            if( m_CopyQueue == nullptr )
+            {
+                std::cerr << "Cannot obtain copy queue!" << std::endl;
+                return StatusCode::Fail;
+            }
+        }
+        else
+        {
+            m_CopyQueue = m_GraphicsQueue;
+        }
+
+        // Get present family.
+        if( m_QueueFamilyIndices.m_HasPresentFamily &&
+            m_QueueFamilyIndices.m_GraphicsFamily != m_QueueFamilyIndices.m_PresentFamily )
+        {
+            const uint32_t presentQueueIndex = m_QueueFamilyIndices.m_PresentCount - 1;
+
+            vkGetDeviceQueue( m_Device, m_QueueFamilyIndices.m_PresentFamily, presentQueueIndex, &m_PresentQueue );
+            if( m_PresentQueue == nullptr )
+            {
+                std::cerr << "Cannot obtain present queue!" << std::endl;
+                return StatusCode::Fail;
+            }
+        }
+        else
+        {
+            m_PresentQueue = m_GraphicsQueue;
+        }
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Finds different queue families.
+    ////////////////////////////////////////////////////////////
+    QueueFamilyIndices FindQueueFamilies( VkPhysicalDevice physicalDevice )
+    {
+        QueueFamilyIndices indices = {};
+
+        // Get physical device queue family properties.
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties( physicalDevice, &queueFamilyCount, nullptr );
+
+        std::vector<VkQueueFamilyProperties> queueFamilies( queueFamilyCount );
+        vkGetPhysicalDeviceQueueFamilyProperties( physicalDevice, &queueFamilyCount, queueFamilies.data() );
+
+        // Find all needed queue families.
+        uint32_t index = 0;
+        for( const auto& queueFamily : queueFamilies )
+        {
+            // Graphics queue family.
+            if( queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT &&
+                !indices.m_HasGraphicsFamily )
+            {
+                indices.m_GraphicsFamily          = index;
+                indices.m_HasGraphicsFamily       = true;
+                indices.m_IsGraphicsFamilyCompute = ( queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT ) != 0;
+                indices.m_GraphicsCount           = queueFamily.queueCount;
+            }
+
+            // Compute queue family (explicitly).
+            if( queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT &&
+                !( queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT ) &&
+                !indices.m_HasComputeFamily )
+            {
+                indices.m_ComputeFamily    = index;
+                indices.m_HasComputeFamily = true;
+                indices.m_ComputeCount     = queueFamily.queueCount;
+            }
+
+            // Memory transfer queue family (explicitly).
+            if( queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT &&
+                !( queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT ) &&
+                !( queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT ) &&
+                !indices.m_HasCopyFamily )
+            {
+                indices.m_CopyFamily    = index;
+                indices.m_HasCopyFamily = true;
+                indices.m_CopyCount     = queueFamily.queueCount;
+            }
+
+            // Present queue family, there is none without a surface.
+            if( !indices.m_HasPresentFamily && m_Surface != VK_NULL_HANDLE )
+            {
+                VkBool32 presentSupported = false;
+                vkGetPhysicalDeviceSurfaceSupportKHR( physicalDevice, index, m_Surface, &presentSupported );
+                if( presentSupported )
+                {
+                    indices.m_PresentFamily    = index;
+                    indices.m_HasPresentFamily = true;
+                    indices.m_PresentCount     = queueFamily.queueCount;
+                }
+            }
+
+            ++index;
+        }
+
+        // Without dedicated families, copies and dispatches run on the graphics queue,
+        // so ownership transfers and timestamps use the graphics family.
+        if( !indices.m_HasComputeFamily )
+        {
+            indices.m_ComputeFamily = indices.m_GraphicsFamily;
+        }
+
+        if( !indices.m_HasCopyFamily )
+        {
+            indices.m_CopyFamily = indices.m_GraphicsFamily;
+        }
+
+        return indices;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Finds a given supported format.
+    ////////////////////////////////////////////////////////////
+    VkFormat FindSupportedFormat(
+        const std::vector<VkFormat>& candidates,
+        const VkImageTiling          tiling,
+        const VkFormatFeatureFlags   features )
+    {
+        // List of candidate formats in order from most desirable to least desirable.
+        for( VkFormat format : candidates )
+        {
+            VkFormatProperties props = {};
+            vkGetPhysicalDeviceFormatProperties( m_PhysicalDevice, format, &props );
+
+            if( tiling == VK_IMAGE_TILING_LINEAR && ( props.linearTilingFeatures & features ) == features )
+            {
+                return format;
+            }
+            else if( tiling == VK_IMAGE_TILING_OPTIMAL && ( props.optimalTilingFeatures & features ) == features )
+            {
+                return format;
+            }
+        }
+
+        return VK_FORMAT_UNDEFINED;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Finds a supported depth format.
+    ////////////////////////////////////////////////////////////
+    VkFormat FindDepthFormat()
+    {
+        return FindSupportedFormat(
+            { VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT },
+            VK_IMAGE_TILING_OPTIMAL,
+            VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT );
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Checks if a given format has stencil component.
+    ////////////////////////////////////////////////////////////
+    bool HasStencilComponent( const VkFormat format )
+    {
+        return ( format == VK_FORMAT_D32_SFLOAT_S8_UINT ) ||
+            ( format == VK_FORMAT_D24_UNORM_S8_UINT );
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Creates swap chain.
+    ////////////////////////////////////////////////////////////
+    StatusCode CreateSwapChain()
+    {
+        // Get swap chain support details
+        SwapChainSupportDetails details = QuerySwapChainSupport( m_PhysicalDevice );
+
+        // Set swap chain settings.
+        VkSurfaceFormatKHR surfaceFormat = ChooseSwapSurfaceFormat( details.m_Formats );
+        VkPresentModeKHR   presentMode   = ChooseSwapPresentMode( details.m_PresentModes );
+        VkExtent2D         extent        = ChooseSwapExtent( details.m_Capabilities );
+
+        // Swap chain count, low latency queues as few images as possible.
+        uint32_t imageCount = details.m_Capabilities.minImageCount + 1;
+
+        if( m_Settings.m_LatencyMode == LatencyMode::LowLatency )
+        {
+            imageCount = details.m_Capabilities.minImageCount;
+        }
+        else if( m_Settings.m_LatencyMode == LatencyMode::Throughput )
+        {
+            imageCount = std::max( imageCount, m_FramesInFlight + 1 );
+        }
+
+        if( details.m_Capabilities.maxImageCount > 0 &&
+            details.m_Capabilities.maxImageCount < imageCount )
+        {
+            // Limit swap chain count to the maximum.
+            imageCount = details.m_Capabilities.maxImageCount;
+        }
+
+        // Populate swap chain create information.
+        VkSwapchainCreateInfoKHR createInfo = {};
+        createInfo.sType                    = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+        createInfo.surface                  = m_Surface;
+        createInfo.minImageCount            = imageCount;
+        createInfo.imageFormat              = surfaceFormat.format;
+        createInfo.imageColorSpace          = surfaceFormat.colorSpace;
+        createInfo.imageExtent              = extent;
+        createInfo.imageArrayLayers         = 1; // More than one for stereoscopic 3d applications.
+        createInfo.imageUsage               = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+
+        std::vector<uint32_t> queueFamilyIndices = {};
+
+        if( m_QueueFamilyIndices.m_PresentFamily != m_QueueFamilyIndices.m_GraphicsFamily )
+        {
+            // Add both queues if they are in different queue families.
+            queueFamilyIndices.emplace_back( m_QueueFamilyIndices.m_GraphicsFamily );
+            queueFamilyIndices.emplace_back( m_QueueFamilyIndices.m_PresentFamily );
+        }
+        else
+        {
+            // Add one queue if graphics and present queues are in the same queue family.
+            queueFamilyIndices.emplace_back( m_QueueFamilyIndices.m_GraphicsFamily );
+        }
+
+        if( m_QueueFamilyIndices.m_ComputeFamily != m_QueueFamilyIndices.m_GraphicsFamily )
+        {
+            // Add compute queue family if it is in different queue family then graphics one.
+            queueFamilyIndices.emplace_back( m_QueueFamilyIndices.m_ComputeFamily );
+        }
+
+        if( m_QueueFamilyIndices.m_CopyFamily != m_QueueFamilyIndices.m_GraphicsFamily &&
+            m_QueueFamilyIndices.m_CopyFamily != m_QueueFamilyIndices.m_ComputeFamily )
+        {
+            // Add copy queue family if it is in different queue family then graphics and compute ones.
+            queueFamilyIndices.emplace_back( m_QueueFamilyIndices.m_CopyFamily );
+        }
+
+        if( queueFamilyIndices.size() > 1 )
+        {
+            // Graphics, compute, copy and present queues are in different queue families.
+            createInfo.imageSharingMode      = VK_SHARING_MODE_CONCURRENT;
+            createInfo.queueFamilyIndexCount = static_cast<uint32_t>( queueFamilyIndices.size() );
+            createInfo.pQueueFamilyIndices   = queueFamilyIndices.data();
+        }
+        else
+        {
+            // Graphics, compute, copy and present queues are in the same queue family.
+            createInfo.imageSharingMode      = VK_SHARING_MODE_EXCLUSIVE;
+            createInfo.queueFamilyIndexCount = 0;       // Optional.
+            createInfo.pQueueFamilyIndices   = nullptr; // Optional.
+        }
+
+        // Check supported formats.
+        VkImageFormatProperties imageFormatProperties = {};
+        if( vkGetPhysicalDeviceImageFormatProperties(
+                m_PhysicalDevice,
+                createInfo.imageFormat,
+                VK_IMAGE_TYPE_2D,
+                VK_IMAGE_TILING_OPTIMAL,
+                createInfo.imageUsage,
+                0,
+                &imageFormatProperties ) != VK_SUCCESS )
+        {
+            std::cerr << "Cannot get physical device image format properties!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        if( imageFormatProperties.maxExtent.height < extent.height || imageFormatProperties.maxExtent.width < extent.width )
+        {
+            std::cerr << "Image extent is bigger than max extent!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        createInfo.preTransform   = details.m_Capabilities.currentTransform;
+        createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+        createInfo.presentMode    = presentMode;
+        createInfo.clipped        = VK_TRUE;
+        createInfo.oldSwapchain   = VK_NULL_HANDLE;
+
+        // Create swap chain.
+        if( vkCreateSwapchainKHR( m_Device, &createInfo, nullptr, &m_SwapChain ) != VK_SUCCESS )
+        {
+            std::cerr << "Cannot create swap chain!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        // Get swap chain images.
+        vkGetSwapchainImagesKHR( m_Device, m_SwapChain, &imageCount, nullptr );
+        m_SwapChainImages.resize( imageCount );
+        vkGetSwapchainImagesKHR( m_Device, m_SwapChain, &imageCount, m_SwapChainImages.data() );
+
+        // Store swap chain format and extent.
+        m_SwapChainImageFormat = surfaceFormat.format;
+        m_SwapChainExtent      = extent;
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Creates offscreen images which replace the swap chain in headless mode.
+    ////////////////////////////////////////////////////////////
+    StatusCode CreateOffscreenImages()
+    {
+        // Images are copied to capture buffers after rendering.
+        const VkFormat format = FindSupportedFormat(
+            { VK_FORMAT_B8G8R8A8_SRGB, VK_FORMAT_R8G8B8A8_SRGB },
+            VK_IMAGE_TILING_OPTIMAL,
+            VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT | VK_FORMAT_FEATURE_TRANSFER_SRC_BIT );
+
+        if( format == VK_FORMAT_UNDEFINED )
+        {
+            std::cerr << "Cannot find a format for offscreen images!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        m_SwapChainImageFormat = format;
+        m_SwapChainExtent      = { m_Width, m_Height };
+
+        // One image for each frame in flight, so rendering never waits for an image.
+        m_SwapChainImages.resize( m_FramesInFlight );
+        m_OffscreenImagesGpuMemoryOffsets.resize( m_FramesInFlight );
+
+        for( uint32_t i = 0; i < m_FramesInFlight; ++i )
+        {
+            const StatusCode result = CreateImage(
+                m_SwapChainExtent.width,
+                m_SwapChainExtent.height,
+                m_SwapChainImageFormat,
+                VK_IMAGE_TILING_OPTIMAL,
+                VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+                { VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT },
+                m_SwapChainImages[i],
+                m_OffscreenImagesGpuMemoryOffsets[i] );
+
+            if( result != StatusCode::Success )
+            {
+                std::cerr << "Cannot create offscreen image!" << std::endl;
+                return StatusCode::Fail;
+            }
+        }
+
+        if( m_Settings.m_CaptureDirectory.empty() )
+        {
+            return StatusCode::Success;
+        }
+
+        // Rendered images are read back a few frames later, when their images are reused.
+        const VkDeviceSize captureSize = static_cast<VkDeviceSize>( m_SwapChainExtent.width ) * m_SwapChainExtent.height * 4;
+
+        m_CaptureBuffers.resize( m_FramesInFlight );
+        m_CaptureBuffersGpuMemoryOffsets.resize( m_FramesInFlight );
+        m_CapturedFrameIndices.resize( m_FramesInFlight, 0 );
+
+        for( uint32_t i = 0; i < m_FramesInFlight; ++i )
+        {
+            const StatusCode result = CreateBuffer(
+                captureSize,
+                VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                { VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_MEMORY_PROPERTY_HOST_CACHED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT },
+                1,
+                &m_QueueFamilyIndices.m_GraphicsFamily,
+                m_CaptureBuffers[i],
+                m_CaptureBuffersGpuMemoryOffsets[i] );
+
+            if( result != StatusCode::Success )
+            {
+                std::cerr << "Cannot create buffer for frame capture!" << std::endl;
+                return StatusCode::Fail;
+            }
+        }
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Writes the frame captured from the offscreen image to a ppm file.
+    ////////////////////////////////////////////////////////////
+    StatusCode WriteCapturedFrame( const uint32_t imageIndex )
+    {
+        const uint64_t frameIndex = m_CapturedFrameIndices[imageIndex];
+
+        if( frameIndex == 0 )
+        {
+            return StatusCode::Success;
+        }
+
+        m_CapturedFrameIndices[imageIndex] = 0;
+
+        // Frame files are numbered from zero.
+        std::string frameNumber = std::to_string( frameIndex - 1 );
+        frameNumber.insert( 0, frameNumber.size() < 6 ? 6 - frameNumber.size() : 0, '0' );
+
+        const std::string filename = m_Settings.m_CaptureDirectory + "/frame_" + frameNumber + ".ppm";
+        std::ofstream     file( filename, std::ios::binary );
+
+        if( !file.is_open() )
+        {
+            std::cerr << "Cannot open " << filename << " file!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        const uint32_t width  = m_SwapChainExtent.width;
+        const uint32_t height = m_SwapChainExtent.height;
+        const auto*    pixels = static_cast<const uint8_t*>( GetMappedGpuMemory( m_CaptureBuffersGpuMemoryOffsets[imageIndex] ) );
+        const bool     isBgra = m_SwapChainImageFormat == VK_FORMAT_B8G8R8A8_SRGB;
+
+        // Binary ppm stores rgb without alpha.
+        std::vector<uint8_t> rgb( static_cast<size_t>( width ) * height * 3 );
+
+        for( size_t i = 0; i < static_cast<size_t>( width ) * height; ++i )
+        {
+            rgb[i * 3 + 0] = pixels[i * 4 + ( isBgra ? 2 : 0 )];
+            rgb[i * 3 + 1] = pixels[i * 4 + 1];
+            rgb[i * 3 + 2] = pixels[i * 4 + ( isBgra ? 0 : 2 )];
+        }
+
+        file << "P6\n"
+             << width << " " << height << "\n"
+             << "255\n";
+        file.write( reinterpret_cast<const char*>( rgb.data() ), rgb.size() );
+
+        if( !file.good() )
+        {
+            std::cerr << "Cannot write " << filename << " file!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Queries swap chain support.
+    ////////////////////////////////////////////////////////////
+    SwapChainSupportDetails QuerySwapChainSupport( VkPhysicalDevice physicalDevice )
+    {
+        SwapChainSupportDetails details = {};
+
+        // Get swap chain capabilities.
+        vkGetPhysicalDeviceSurfaceCapabilitiesKHR( physicalDevice, m_Surface, &details.m_Capabilities );
+
+        // Get swap chain formats.
+        uint32_t formatCount;
+        vkGetPhysicalDeviceSurfaceFormatsKHR( physicalDevice, m_Surface, &formatCount, nullptr );
+
+        if( formatCount != 0 )
+        {
+            details.m_Formats.resize( formatCount );
+            vkGetPhysicalDeviceSurfaceFormatsKHR( physicalDevice, m_Surface, &formatCount, details.m_Formats.data() );
+        }
+
+        // Get swap chain present modes.
+        uint32_t presentModeCount;
+        vkGetPhysicalDeviceSurfacePresentModesKHR( physicalDevice, m_Surface, &presentModeCount, nullptr );
+
+        if( presentModeCount != 0 )
+        {
+            details.m_PresentModes.resize( presentModeCount );
+            vkGetPhysicalDeviceSurfacePresentModesKHR( physicalDevice, m_Surface, &presentModeCount, details.m_PresentModes.data() );
+        }
+
+        return details;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Chooses swap chain surface format.
+    ////////////////////////////////////////////////////////////
+    VkSurfaceFormatKHR ChooseSwapSurfaceFormat( const std::vector<VkSurfaceFormatKHR>& availableFormats )
+    {
+        for( const auto& availableFormat : availableFormats )
+        {
+            // Use 32 bits per pixel (blue, green, red, alpha with 8 bit)/
+            if( availableFormat.format == VK_FORMAT_B8G8R8A8_SRGB &&
+                availableFormat.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR )
+            {
+                return availableFormat;
+            }
+        }
+
+        std::cerr << "Cannot choose a desire swap chain surface format! Used the first format!" << std::endl;
+        return availableFormats[0];
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Chooses swap chain present mode.
+    ////////////////////////////////////////////////////////////
+    VkPresentModeKHR ChooseSwapPresentMode( const std::vector<VkPresentModeKHR>& availablePresentModes )
+    {
+        // Low latency does not wait for vertical blank, or only when the frame is on time.
+        if( m_Settings.m_LatencyMode == LatencyMode::LowLatency )
+        {
+            for( const VkPresentModeKHR presentMode : { VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_FIFO_RELAXED_KHR } )
+            {
+                if( std::find( availablePresentModes.begin(), availablePresentModes.end(), presentMode ) != availablePresentModes.end() )
+                {
+                    return presentMode;
+                }
+            }
+
+            return VK_PRESENT_MODE_FIFO_KHR;
+        }
+
+        for( const auto& availablePresentMode : availablePresentModes )
+        {
+            // Triple buffering is much better than double buffering.
+            if( availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR )
+            {
+                return availablePresentMode;
+            }
+        }
+
+        // Choose double buffering if triple buffering is not available.
+        return VK_PRESENT_MODE_FIFO_KHR;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Chooses swap chain extent.
+    ////////////////////////////////////////////////////////////
+    VkExtent2D ChooseSwapExtent( const VkSurfaceCapabilitiesKHR& capabilities )
+    {
+        if( capabilities.currentExtent.width != UINT32_MAX )
+        {
+            return capabilities.currentExtent;
+        }
+        else
+        {
+            VkExtent2D actualExtent = { m_Width, m_Height };
+
+            actualExtent.width  = std::max( capabilities.minImageExtent.width, std::min( capabilities.maxImageExtent.width, actualExtent.width ) );
+            actualExtent.height = std::max( capabilities.minImageExtent.height, std::min( capabilities.maxImageExtent.height, actualExtent.height ) );
+
+            return actualExtent;
+        }
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Creates image views.
+    ////////////////////////////////////////////////////////////
+    StatusCode CreateImageViews()
+    {
+        const uint32_t swapChainImageCount = static_cast<uint32_t>( m_SwapChainImages.size() );
+
+        // Match swap chain image views to swap chain images.
+        m_SwapChainImageViews.resize( swapChainImageCount );
+
+        for( uint32_t i = 0; i < swapChainImageCount; ++i )
+        {
+            // For stereographics 3d applications a swap chain with multiple layers is required and
+            // with multiple image views as well.
+            const StatusCode result = CreateImageView(
+                m_SwapChainImages[i],
+                m_SwapChainImageFormat,
+                VK_IMAGE_ASPECT_COLOR_BIT,
+                m_SwapChainImageViews[i] );
+
+            if( result != StatusCode::Success )
+            {
+                std::cerr << "Cannot create swap chain image view!" << std::endl;
+                return StatusCode::Fail;
+            }
+        }
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Creates render pass.
+    ////////////////////////////////////////////////////////////
+    StatusCode CreateRenderPass()
+    {
+        // Populate color attachment description information.
+        VkAttachmentDescription colorAttachment = {};
+        colorAttachment.format                  = m_SwapChainImageFormat;
+        colorAttachment.samples                 = VK_SAMPLE_COUNT_1_BIT;
+        colorAttachment.loadOp                  = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        colorAttachment.storeOp                 = VK_ATTACHMENT_STORE_OP_STORE;
+        colorAttachment.stencilLoadOp           = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        colorAttachment.stencilStoreOp          = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        colorAttachment.initialLayout           = VK_IMAGE_LAYOUT_UNDEFINED;
+        colorAttachment.finalLayout             = m_Settings.m_IsHeadless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+        // Populate color attachment reference information.
+        VkAttachmentReference colorAttachmentReference = {};
+        colorAttachmentReference.attachment            = 0;
+        colorAttachmentReference.layout                = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+        // Populate depth attachment description information.
+        VkAttachmentDescription depthAttachment = {};
+        depthAttachment.format                  = FindDepthFormat();
+        depthAttachment.samples                 = VK_SAMPLE_COUNT_1_BIT;
+        depthAttachment.loadOp                  = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        depthAttachment.storeOp                 = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        depthAttachment.stencilLoadOp           = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        depthAttachment.stencilStoreOp          = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        depthAttachment.initialLayout           = VK_IMAGE_LAYOUT_UNDEFINED;
+        depthAttachment.finalLayout             = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+        // Populate depth attachment reference information.
+        VkAttachmentReference depthAttachmentReference = {};
+        depthAttachmentReference.attachment            = 1;
+        depthAttachmentReference.layout                = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+        // Populate subpass information.
+        VkSubpassDescription subpass    = {};
+        subpass.pipelineBindPoint       = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.colorAttachmentCount    = 1;
+        subpass.pColorAttachments       = &colorAttachmentReference;
+        subpass.pDepthStencilAttachment = &depthAttachmentReference;
+
+        // Populate subpass dependency information.
+        std::array<VkSubpassDependency, 2> dependencies = {};
+        dependencies[0].srcSubpass                      = VK_SUBPASS_EXTERNAL;
+        dependencies[0].dstSubpass                      = 0;
+        dependencies[0].srcStageMask                    = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+        dependencies[0].srcAccessMask                   = 0;
+        dependencies[0].dstStageMask                    = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+        dependencies[0].dstAccessMask                   = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+        // Offscreen images are copied to capture buffers after the render pass.
+        dependencies[1].srcSubpass    = 0;
+        dependencies[1].dstSubpass    = VK_SUBPASS_EXTERNAL;
+        dependencies[1].srcStageMask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        dependencies[1].dstStageMask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+        // Populate render pass information.
+        const std::array<VkAttachmentDescription, 2> attachments = { colorAttachment, depthAttachment };
+
+        VkRenderPassCreateInfo renderPassInfo = {};
+        renderPassInfo.sType                  = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+        renderPassInfo.attachmentCount        = static_cast<uint32_t>( attachments.size() );
+        renderPassInfo.pAttachments           = attachments.data();
+        renderPassInfo.subpassCount           = 1;
+        renderPassInfo.pSubpasses             = &subpass;
+        renderPassInfo.dependencyCount        = m_Settings.m_IsHeadless ? 2 : 1;
+        renderPassInfo.pDependencies          = dependencies.data();
+
+        // Create render pass.
+        if( vkCreateRenderPass( m_Device, &renderPassInfo, nullptr, &m_RenderPass ) != VK_SUCCESS )
+        {
+            std::cerr << "Cannot create render pass!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Creates descriptor set layout.
+    ////////////////////////////////////////////////////////////
+    StatusCode CreateDescriptorSetLayout()
+    {
+        // Graphics descriptor set layouts.
+        VkDescriptorSetLayoutBinding uboLayoutBinding     = {};
+        VkDescriptorSetLayoutBinding samplerLayoutBinding = {};
+
+        // Uniform layout.
+        uboLayoutBinding.binding            = 0;
+        uboLayoutBinding.descriptorType     = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        uboLayoutBinding.descriptorCount    = 1;
+        uboLayoutBinding.stageFlags         = VK_SHADER_STAGE_VERTEX_BIT;
+        uboLayoutBinding.pImmutableSamplers = nullptr; // Optional.
+
+        // Sampler layout.
+        samplerLayoutBinding.binding            = 1;
+        samplerLayoutBinding.descriptorType     = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        samplerLayoutBinding.descriptorCount    = 1;
+        samplerLayoutBinding.stageFlags         = VK_SHADER_STAGE_FRAGMENT_BIT;
+        samplerLayoutBinding.pImmutableSamplers = nullptr; // Optional.
+
+        std::array<VkDescriptorSetLayoutBinding, 2> bindings = { uboLayoutBinding, samplerLayoutBinding };
+
+        VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+
+        layoutInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.bindingCount = static_cast<uint32_t>( bindings.size() );
+        layoutInfo.pBindings    = bindings.data();
+
+        if( vkCreateDescriptorSetLayout( m_Device, &layoutInfo, nullptr, &m_DescriptorSetLayout ) != VK_SUCCESS )
+        {
+            std::cerr << "Cannot create graphics descriptor set layout!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        // Compute descriptor set layout.
+        std::vector<VkDescriptorSetLayoutBinding> layoutBindings;
+
+        for( uint32_t i = 0; i < 3; i++ )
+        {
+            VkDescriptorSetLayoutBinding layoutBinding = {};
+            layoutBinding.binding                      = i;
+            layoutBinding.descriptorType               = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            layoutBinding.descriptorCount              = 1;
+            layoutBinding.stageFlags                   = VK_SHADER_STAGE_COMPUTE_BIT;
+            layoutBindings.push_back( layoutBinding );
+        }
+
+        VkDescriptorSetLayoutCreateInfo setLayoutCreateInfo = {};
+        setLayoutCreateInfo.sType                           = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        setLayoutCreateInfo.bindingCount                    = static_cast<uint32_t>( layoutBindings.size() );
+        setLayoutCreateInfo.pBindings                       = layoutBindings.data();
+
+        if( vkCreateDescriptorSetLayout( m_Device, &setLayoutCreateInfo, nullptr, &m_ComputeDescriptorSetLayout ) != VK_SUCCESS )
+        {
+            std::cerr << "Cannot create compute descriptor set layout!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Creates graphics pipeline.
+    ////////////////////////////////////////////////////////////
+    StatusCode CreateGraphicsPipeline()
+    {
+        // Wait for the bytecode of shaders.
+        if( WaitForAsset( m_ShaderLoading ) != StatusCode::Success )
+        {
+            std::cerr << "Empty shader files!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        // Create shader modules for the shaders.
+        VkShaderModule vertexShaderModule   = CreateShaderModule( m_VertexShaderCode );
+        VkShaderModule fragmentShaderModule = CreateShaderModule( m_FragmentShaderCode );
+
+        // Create vertex shader stage.
+        VkPipelineShaderStageCreateInfo vertexShaderStageInfo = {};
+        vertexShaderStageInfo.sType                           = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        vertexShaderStageInfo.stage                           = VK_SHADER_STAGE_VERTEX_BIT;
+        vertexShaderStageInfo.module                          = vertexShaderModule;
+        vertexShaderStageInfo.pName                           = "main";
+
+        // Create fragment shader stage.
+        VkPipelineShaderStageCreateInfo fragmentShaderStageInfo = {};
+        fragmentShaderStageInfo.sType                           = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        fragmentShaderStageInfo.stage                           = VK_SHADER_STAGE_FRAGMENT_BIT;
+        fragmentShaderStageInfo.module                          = fragmentShaderModule;
+        fragmentShaderStageInfo.pName                           = "main";
+
+        // Create programmable pipeline stages.
+        VkPipelineShaderStageCreateInfo shaderStages[] = {
+            vertexShaderStageInfo,
+            fragmentShaderStageInfo
+        };
+
+        // Create vertex input state.
+        const auto bindingDescription    = Vertex::GetBindingDescription();
+        const auto attributeDescriptions = Vertex::GetAttributeDescriptions();
+
+        VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
+        vertexInputInfo.sType                                = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+        vertexInputInfo.vertexBindingDescriptionCount        = 1;
+        vertexInputInfo.pVertexBindingDescriptions           = &bindingDescription;
+        vertexInputInfo.vertexAttributeDescriptionCount      = static_cast<uint32_t>( attributeDescriptions.size() );
+        vertexInputInfo.pVertexAttributeDescriptions         = attributeDescriptions.data();
+
+        // Create input assembly state.
+        VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+        inputAssembly.sType                                  = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+        inputAssembly.topology                               = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        inputAssembly.primitiveRestartEnable                 = VK_FALSE;
+
+        // Viewports.
+        VkViewport viewport = {};
+        viewport.x          = 0.0f;
+        viewport.y          = 0.0f;
+        viewport.width      = static_cast<float>( m_SwapChainExtent.width );
+        viewport.height     = static_cast<float>( m_SwapChainExtent.height );
+        viewport.minDepth   = 0.0f;
+        viewport.maxDepth   = 1.0f;
+
+        // Scissors.
+        VkRect2D scissor = {};
+        scissor.offset   = { 0, 0 };
+        scissor.extent   = m_SwapChainExtent;
+
+        // Create viewport state.
+        VkPipelineViewportStateCreateInfo viewportState = {};
+        viewportState.sType                             = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+        viewportState.viewportCount                     = 1;
+        viewportState.pViewports                        = &viewport;
+        viewportState.scissorCount                      = 1;
+        viewportState.pScissors                         = &scissor;
+
+        // Rasterizeration state.
+        VkPipelineRasterizationStateCreateInfo rasterizer = {};
+        rasterizer.sType                                  = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+        rasterizer.depthClampEnable                       = VK_FALSE;
+        rasterizer.rasterizerDiscardEnable                = VK_FALSE;
+        rasterizer.polygonMode                            = VK_POLYGON_MODE_FILL;
+        rasterizer.lineWidth                              = 1.0f;
+        rasterizer.cullMode                               = VK_CULL_MODE_BACK_BIT;
+        rasterizer.frontFace                              = VK_FRONT_FACE_CLOCKWISE; // VK_FRONT_FACE_COUNTER_CLOCKWISE
+        rasterizer.depthBiasEnable                        = VK_FALSE;
+        rasterizer.depthBiasConstantFactor                = 0.0f; // Optional.
+        rasterizer.depthBiasClamp                         = 0.0f; // Optional.
+        rasterizer.depthBiasSlopeFactor                   = 0.0f; // Optional.
+
+        // Multisample state.
+        VkPipelineMultisampleStateCreateInfo multisampling = {};
+        multisampling.sType                                = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+        multisampling.sampleShadingEnable                  = VK_FALSE;
+        multisampling.rasterizationSamples                 = VK_SAMPLE_COUNT_1_BIT;
+        multisampling.minSampleShading                     = 1.0f;     // Optional.
+        multisampling.pSampleMask                          = nullptr;  // Optional.
+        multisampling.alphaToCoverageEnable                = VK_FALSE; // Optional.
+        multisampling.alphaToOneEnable                     = VK_FALSE; // Optional.
+
+        // Color blending attachment state.
+        VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
+        colorBlendAttachment.colorWriteMask                      = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+        colorBlendAttachment.blendEnable                         = VK_FALSE;
+        colorBlendAttachment.srcColorBlendFactor                 = VK_BLEND_FACTOR_ONE;  // Optional.
+        colorBlendAttachment.dstColorBlendFactor                 = VK_BLEND_FACTOR_ZERO; // Optional.
+        colorBlendAttachment.colorBlendOp                        = VK_BLEND_OP_ADD;      // Optional.
+        colorBlendAttachment.srcAlphaBlendFactor                 = VK_BLEND_FACTOR_ONE;  // Optional.
+        colorBlendAttachment.dstAlphaBlendFactor                 = VK_BLEND_FACTOR_ZERO; // Optional.
+        colorBlendAttachment.alphaBlendOp                        = VK_BLEND_OP_ADD;      // Optional.
+
+        // Color blending state.
+        VkPipelineColorBlendStateCreateInfo colorBlending = {};
+        colorBlending.sType                               = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+        colorBlending.logicOpEnable                       = VK_FALSE;
+        colorBlending.logicOp                             = VK_LOGIC_OP_COPY; // Optional.
+        colorBlending.attachmentCount                     = 1;
+        colorBlending.pAttachments                        = &colorBlendAttachment;
+        colorBlending.blendConstants[0]                   = 0.0f; // Optional.
+        colorBlending.blendConstants[1]                   = 0.0f; // Optional.
+        colorBlending.blendConstants[2]                   = 0.0f; // Optional.
+        colorBlending.blendConstants[3]                   = 0.0f; // Optional.
+
+        // Create a pipeline layout.
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+        pipelineLayoutInfo.sType                      = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount             = 1;
+        pipelineLayoutInfo.pSetLayouts                = &m_DescriptorSetLayout;
+        pipelineLayoutInfo.pushConstantRangeCount     = 0;       // Optional.
+        pipelineLayoutInfo.pPushConstantRanges        = nullptr; // Optional.
+
+        if( vkCreatePipelineLayout( m_Device, &pipelineLayoutInfo, nullptr, &m_GraphicsPipelineLayout ) != VK_SUCCESS )
+        {
+            std::cerr << "Cannot create pipeline layout!" << std::endl;
+
+            // Destroy the shader modules.
+            vkDestroyShaderModule( m_Device, fragmentShaderModule, nullptr );
+            vkDestroyShaderModule( m_Device, vertexShaderModule, nullptr );
+
+            return StatusCode::Fail;
+        }
+
+        // Populate depth and stencil state.
+        VkPipelineDepthStencilStateCreateInfo depthStencil = {};
+
+        depthStencil.sType                 = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+        depthStencil.depthTestEnable       = VK_TRUE;
+        depthStencil.depthWriteEnable      = VK_TRUE;
+        depthStencil.depthCompareOp        = VK_COMPARE_OP_LESS;
+        depthStencil.depthBoundsTestEnable = VK_FALSE;
+        depthStencil.minDepthBounds        = 0.0f; // Optional.
+        depthStencil.maxDepthBounds        = 1.0f; // Optional.
+        depthStencil.stencilTestEnable     = VK_FALSE;
+        depthStencil.front                 = {}; // Optional.
+        depthStencil.back                  = {}; // Optional.
+
+        // Populate graphics pipeline information.
+        VkGraphicsPipelineCreateInfo pipelineInfo = {};
+        pipelineInfo.sType                        = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        pipelineInfo.stageCount                   = 2;
+        pipelineInfo.pStages                      = shaderStages;
+        pipelineInfo.pVertexInputState            = &vertexInputInfo;
+        pipelineInfo.pInputAssemblyState          = &inputAssembly;
+        pipelineInfo.pViewportState               = &viewportState;
+        pipelineInfo.pRasterizationState          = &rasterizer;
+        pipelineInfo.pMultisampleState            = &multisampling;
+        pipelineInfo.pDepthStencilState           = &depthStencil;
+        pipelineInfo.pColorBlendState             = &colorBlending;
+        pipelineInfo.pDynamicState                = nullptr; // Optional.
+        pipelineInfo.layout                       = m_GraphicsPipelineLayout;
+        pipelineInfo.renderPass                   = m_RenderPass;
+        pipelineInfo.subpass                      = 0;
+        pipelineInfo.basePipelineHandle           = VK_NULL_HANDLE; // Optional.
+        pipelineInfo.basePipelineIndex            = -1;             // Optional.
+
+        // Create graphics pipeline.
+        if( vkCreateGraphicsPipelines( m_Device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_GraphicsPipeline ) != VK_SUCCESS )
+        {
+            std::cerr << "Cannot create graphics pipeline!" << std::endl;
+
+            // Destroy the shader modules.
+            vkDestroyShaderModule( m_Device, fragmentShaderModule, nullptr );
+            vkDestroyShaderModule( m_Device, vertexShaderModule, nullptr );
+
+            return StatusCode::Fail;
+        }
+
+        // Destroy the shader modules.
+        vkDestroyShaderModule( m_Device, fragmentShaderModule, nullptr );
+        vkDestroyShaderModule( m_Device, vertexShaderModule, nullptr );
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Creates compute pipeline.
+    ////////////////////////////////////////////////////////////
+    StatusCode CreateComputePipeline()
+    {
+        // Wait for the bytecode of the compute shader.
+        if( WaitForAsset( m_ShaderLoading ) != StatusCode::Success )
+        {
+            std::cerr << "Empty compute shader file!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        // Create a shader module for the compute shader.
+        VkShaderModule computeShaderModule = CreateShaderModule( m_ComputeShaderCode );
+
+        // Create a compute pipeline layout.
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+        pipelineLayoutInfo.sType                      = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount             = 1;
+        pipelineLayoutInfo.pSetLayouts                = &m_ComputeDescriptorSetLayout;
+
+        // Element count for the bounds check of the last workgroup.
+        VkPushConstantRange pushConstantRange = {};
+        pushConstantRange.stageFlags          = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset              = 0;
+        pushConstantRange.size                = sizeof( uint32_t );
+
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges    = &pushConstantRange;
+
+        if( vkCreatePipelineLayout( m_Device, &pipelineLayoutInfo, nullptr, &m_ComputePipelineLayout ) != VK_SUCCESS )
+        {
+            std::cerr << "Cannot create pipeline layout!" << std::endl;
+
+            // Destroy the compute shader module.
+            vkDestroyShaderModule( m_Device, computeShaderModule, nullptr );
+
+            return StatusCode::Fail;
+        }
+
+        // Specialize the workgroup size (local_size_x_id = 0) chosen for the device.
+        VkSpecializationMapEntry specializationEntry = {};
+        specializationEntry.constantID               = 0;
+        specializationEntry.offset                   = 0;
+        specializationEntry.size                     = sizeof( uint32_t );
+
+        VkSpecializationInfo specializationInfo = {};
+        specializationInfo.mapEntryCount        = 1;
+        specializationInfo.pMapEntries          = &specializationEntry;
+        specializationInfo.dataSize             = sizeof( uint32_t );
+        specializationInfo.pData                = &m_ComputeWorkgroupSize;
+
+        // Populate compute pipeline information.
+        VkComputePipelineCreateInfo pipelineCreateInfo = {};
+        pipelineCreateInfo.sType                       = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineCreateInfo.stage.sType                 = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipelineCreateInfo.stage.stage                 = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipelineCreateInfo.stage.module                = computeShaderModule;
+        pipelineCreateInfo.stage.pName                 = "main";
+        pipelineCreateInfo.stage.pSpecializationInfo   = &specializationInfo;
+        pipelineCreateInfo.layout                      = m_ComputePipelineLayout;
+
+        // Create compute pipeline.
+        if( vkCreateComputePipelines( m_Device, VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &m_ComputePipeline ) != VK_SUCCESS )
+        {
+            std::cerr << "Cannot create compute pipeline!" << std::endl;
+
+            // Destroy the compute shader module.
+            vkDestroyShaderModule( m_Device, computeShaderModule, nullptr );
+
+            return StatusCode::Fail;
+        }
+
+        // Destroy the compute shader module.
+        vkDestroyShaderModule( m_Device, computeShaderModule, nullptr );
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Creates shader module.
+    ////////////////////////////////////////////////////////////
+    VkShaderModule CreateShaderModule( const std::vector<char>& code )
+    {
+        VkShaderModuleCreateInfo createInfo = {};
+        createInfo.sType                    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        createInfo.codeSize                 = code.size();
+        createInfo.pCode                    = reinterpret_cast<const uint32_t*>( code.data() );
+
+        VkShaderModule shaderModule = {};
+
+        if( vkCreateShaderModule( m_Device, &createInfo, nullptr, &shaderModule ) != VK_SUCCESS )
+        {
+            std::cerr << "Cannot create shader module!" << std::endl;
+            return shaderModule;
+        }
+
+        return shaderModule;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Creates frame buffers.
+    ////////////////////////////////////////////////////////////
+    StatusCode CreateFramebuffers()
+    {
+        // Create a frame buffer for all of the images in the swap chain.
+        m_SwapChainFramebuffers.resize( m_SwapChainImageViews.size() );
+
+        for( size_t i = 0; i < m_SwapChainImageViews.size(); ++i )
+        {
+            const std::array<VkImageView, 2> attachments = { m_SwapChainImageViews[i], m_DepthImageView };
+
+            VkFramebufferCreateInfo framebufferInfo = {};
+            framebufferInfo.sType                   = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+            framebufferInfo.renderPass              = m_RenderPass;
+            framebufferInfo.attachmentCount         = static_cast<uint32_t>( attachments.size() );
+            framebufferInfo.pAttachments            = attachments.data();
+            framebufferInfo.width                   = m_SwapChainExtent.width;
+            framebufferInfo.height                  = m_SwapChainExtent.height;
+            framebufferInfo.layers                  = 1;
+
+            if( vkCreateFramebuffer( m_Device, &framebufferInfo, nullptr, &m_SwapChainFramebuffers[i] ) != VK_SUCCESS )
+            {
+                std::cerr << "Cannot create frame buffer!" << std::endl;
+                return StatusCode::Fail;
+            }
+        }
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Creates command pools.
+    ////////////////////////////////////////////////////////////
+    StatusCode CreateCommandPools()
+    {
+        VkCommandPoolCreateInfo poolInfo = {};
+        poolInfo.sType                   = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex        = m_QueueFamilyIndices.m_GraphicsFamily;
+        poolInfo.flags                   = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT; // Re-recorded after defragmentation.
+
+        // Graphics command pool.
+        if( vkCreateCommandPool( m_Device, &poolInfo, nullptr, &m_CommandPoolGraphics ) != VK_SUCCESS )
+        {
+            std::cerr << "Cannot create graphics command pool!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        // Copy command pool.
+        poolInfo.queueFamilyIndex = m_QueueFamilyIndices.m_CopyFamily;
+        poolInfo.flags            = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT; // Short-lived command buffers.
+
+        if( vkCreateCommandPool( m_Device, &poolInfo, nullptr, &m_CommandPoolCopy ) != VK_SUCCESS )
+        {
+            std::cerr << "Cannot create copy command pool!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        // Compute command pool.
+        poolInfo.queueFamilyIndex = m_QueueFamilyIndices.m_ComputeFamily;
+        poolInfo.flags            = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT; // Re-recorded after defragmentation.
+
+        if( vkCreateCommandPool( m_Device, &poolInfo, nullptr, &m_CommandPoolCompute ) != VK_SUCCESS )
+        {
+            std::cerr << "Cannot create compute command pool!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Creates a buffer.
+    ////////////////////////////////////////////////////////////
+    StatusCode CreateBuffer(
+        const VkDeviceSize                 size,
+        const VkBufferUsageFlags           usage,
+        const GpuMemoryPreferences&        memoryPreferences,
+        const uint32_t                     queueFamilyIndexCount,
+        const uint32_t*                    queueFamilyIndices,
+        VkBuffer&                          buffer,
+        std::pair<uint32_t, VkDeviceSize>& bufferGpuMemoryOffsets )
+    {
+        VkBufferCreateInfo bufferInfo = {};
+
+        bufferInfo.sType                 = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.size                  = size;
+        bufferInfo.usage                 = usage;
+        bufferInfo.sharingMode           = VK_SHARING_MODE_EXCLUSIVE;
+        bufferInfo.queueFamilyIndexCount = queueFamilyIndexCount;
+        bufferInfo.pQueueFamilyIndices   = queueFamilyIndices;
+
+        if( vkCreateBuffer( m_Device, &bufferInfo, nullptr, &buffer ) != VK_SUCCESS )
+        {
+            std::cerr << "Cannot create vertex buffer!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        // Get gpu memory requirements for the buffer.
+        VkBufferMemoryRequirementsInfo2 gpuMemoryRequirementsInfo = {};
+        VkMemoryDedicatedRequirements   dedicatedRequirements     = {};
+        VkMemoryRequirements2           gpuMemoryRequirements     = {};
+        VkMemoryDedicatedAllocateInfo   dedicatedAllocateInfo     = {};
+
+        gpuMemoryRequirementsInfo.sType  = VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2;
+        gpuMemoryRequirementsInfo.buffer = buffer;
+        dedicatedRequirements.sType      = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+        gpuMemoryRequirements.sType      = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+        gpuMemoryRequirements.pNext      = &dedicatedRequirements;
+        dedicatedAllocateInfo.sType      = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+        dedicatedAllocateInfo.buffer     = buffer;
+
+        vkGetBufferMemoryRequirements2( m_Device, &gpuMemoryRequirementsInfo, &gpuMemoryRequirements );
+
+        const bool isDedicated =
+            dedicatedRequirements.prefersDedicatedAllocation ||
+            dedicatedRequirements.requiresDedicatedAllocation;
+
+        // Sub-allocate gpu memory for the buffer.
+        const StatusCode result = AllocateGpuMemory(
+            gpuMemoryRequirements.memoryRequirements,
+            memoryPreferences,
+            GpuMemoryResourceType::Linear,
+            isDedicated ? &dedicatedAllocateInfo : nullptr,
+            bufferGpuMemoryOffsets );
+
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Cannot allocate buffer gpu memory!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        // Bind allocated gpu memory with the buffer.
+        const auto [bufferGpuMemoryIndex, bufferGpuMemoryOffset] = bufferGpuMemoryOffsets;
+
+        if( vkBindBufferMemory( m_Device, buffer, m_GpuMemoryBlocks[bufferGpuMemoryIndex].m_Memory, bufferGpuMemoryOffset ) != VK_SUCCESS )
+        {
+            std::cerr << "Cannot bind buffer gpu memory!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Destroys a buffer and frees its gpu memory.
+    ////////////////////////////////////////////////////////////
+    void DestroyBuffer(
+        VkBuffer&                          buffer,
+        std::pair<uint32_t, VkDeviceSize>& bufferGpuMemoryOffsets )
+    {
+        if( buffer == VK_NULL_HANDLE )
+        {
+            return;
+        }
+
+        vkDestroyBuffer( m_Device, buffer, nullptr );
+        FreeGpuMemory( bufferGpuMemoryOffsets );
+
+        buffer = VK_NULL_HANDLE;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Sub-allocates gpu memory from the best suitable memory type.
+    ////////////////////////////////////////////////////////////
+    StatusCode AllocateGpuMemory(
+        const VkMemoryRequirements&          gpuMemoryRequirements,
+        const GpuMemoryPreferences&          memoryPreferences,
+        const GpuMemoryResourceType          resourceType,
+        const VkMemoryDedicatedAllocateInfo* dedicatedAllocateInfo,
+        std::pair<uint32_t, VkDeviceSize>&   gpuMemoryOffsets )
+    {
+        const std::vector<uint32_t> memoryTypeIndices = FindGpuMemoryTypes( gpuMemoryRequirements.memoryTypeBits, memoryPreferences );
+
+        if( memoryTypeIndices.empty() )
+        {
+            std::cerr << "Cannot find gpu memory type!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        // Fall back to less preferred memory types if a heap is exhausted.
+        for( const uint32_t memoryTypeIndex : memoryTypeIndices )
+        {
+            const StatusCode result = AllocateGpuMemory(
+                gpuMemoryRequirements,
+                memoryTypeIndex,
+                resourceType,
+                dedicatedAllocateInfo,
+                gpuMemoryOffsets );
+
+            if( result == StatusCode::Success )
+            {
+                return StatusCode::Success;
+            }
+        }
+
+        return StatusCode::Fail;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Sub-allocates gpu memory from blocks of the given memory type.
+    ////////////////////////////////////////////////////////////
+    StatusCode AllocateGpuMemory(
+        const VkMemoryRequirements&          gpuMemoryRequirements,
+        const uint32_t                       memoryTypeIndex,
+        const GpuMemoryResourceType          resourceType,
+        const VkMemoryDedicatedAllocateInfo* dedicatedAllocateInfo,
+        std::pair<uint32_t, VkDeviceSize>&   gpuMemoryOffsets )
+    {
+        const VkDeviceSize blockSize = GetGpuMemoryBlockSize( memoryTypeIndex );
+
+        // Give own memory to resources the driver wants dedicated and to resources
+        // that would waste most of a block.
+        const bool isDedicated =
+            dedicatedAllocateInfo != nullptr ||
+            gpuMemoryRequirements.size > blockSize / 2;
+
+        // Reuse free ranges of already allocated blocks first.
+        uint32_t freeBlockIndex = static_cast<uint32_t>( m_GpuMemoryBlocks.size() );
+
+        for( uint32_t i = 0; i < m_GpuMemoryBlocks.size(); ++i )
+        {
+            GpuMemoryBlock& block = m_GpuMemoryBlocks[i];
+
+            if( block.m_Memory == VK_NULL_HANDLE )
+            {
+                freeBlockIndex = std::min( freeBlockIndex, i );
+                continue;
+            }
+
+            if( isDedicated || block.m_IsDedicated || block.m_MemoryTypeIndex != memoryTypeIndex )
+            {
+                continue;
+            }
+
+            VkDeviceSize offset = 0;
+
+            if( block.Allocate( gpuMemoryRequirements.size, gpuMemoryRequirements.alignment, resourceType, offset ) )
+            {
+                gpuMemoryOffsets = std::make_pair( i, offset );
+                return StatusCode::Success;
+            }
+        }
+
+        // Allocate a new block, reuse a released block slot to keep the indices stable.
+        VkMemoryAllocateInfo allocationInfo = {};
+        VkDeviceMemory       gpuMemory      = VK_NULL_HANDLE;
+        VkResult             result         = VK_SUCCESS;
+
+        allocationInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocationInfo.pNext           = dedicatedAllocateInfo;
+        allocationInfo.allocationSize  = isDedicated ? gpuMemoryRequirements.size : blockSize;
+        allocationInfo.memoryTypeIndex = memoryTypeIndex;
+
+        // Retry with smaller blocks if the heap cannot fit a full block or it is over budget.
+        const uint32_t heapIndex = m_GpuMemoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+
+        while( true )
+        {
+            result = IsWithinGpuMemoryBudget( heapIndex, allocationInfo.allocationSize )
+                ? vkAllocateMemory( m_Device, &allocationInfo, nullptr, &gpuMemory )
+                : VK_ERROR_OUT_OF_DEVICE_MEMORY;
+
+            if( result == VK_SUCCESS || isDedicated || allocationInfo.allocationSize / 2 < gpuMemoryRequirements.size )
+            {
+                break;
+            }
+
+            allocationInfo.allocationSize /= 2;
+        }
+
+        if( result != VK_SUCCESS )
+        {
+            std::cerr << "Failed to allocate gpu memory!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        // Map host visible blocks once for their whole lifetime, a memory object cannot be mapped twice.
+        void* mappedData = nullptr;
+
+        if( m_GpuMemoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT )
+        {
+            if( vkMapMemory( m_Device, gpuMemory, 0, VK_WHOLE_SIZE, 0, &mappedData ) != VK_SUCCESS )
+            {
+                std::cerr << "Failed to map gpu memory!" << std::endl;
+                vkFreeMemory( m_Device, gpuMemory, nullptr );
+                return StatusCode::Fail;
+            }
+        }
+
+        if( freeBlockIndex == m_GpuMemoryBlocks.size() )
+        {
+            m_GpuMemoryBlocks.emplace_back();
+        }
+
+        GpuMemoryBlock& block  = m_GpuMemoryBlocks[freeBlockIndex];
+        VkDeviceSize    offset = 0;
+
+        block.Reset(
+            gpuMemory,
+            memoryTypeIndex,
+            allocationInfo.allocationSize,
+            m_PhysicalDeviceProperties.limits.bufferImageGranularity,
+            isDedicated );
+
+        block.m_MappedData = mappedData;
+
+        if( !block.Allocate( gpuMemoryRequirements.size, gpuMemoryRequirements.alignment, resourceType, offset ) )
+        {
+            std::cerr << "Cannot sub-allocate from a new gpu memory block!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        gpuMemoryOffsets = std::make_pair( freeBlockIndex, offset );
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Returns the size of the next gpu memory block of the given memory type.
+    ////////////////////////////////////////////////////////////
+    VkDeviceSize GetGpuMemoryBlockSize( const uint32_t memoryTypeIndex ) const
+    {
+        uint32_t blockCount = 0;
+
+        for( const GpuMemoryBlock& block : m_GpuMemoryBlocks )
+        {
+            if( block.m_Memory != VK_NULL_HANDLE &&
+                !block.m_IsDedicated &&
+                block.m_MemoryTypeIndex == memoryTypeIndex )
+            {
+                ++blockCount;
+            }
+        }
+
+        // Grow blocks from the min to the max size, so few resources take little memory
+        // and many resources take few allocations (maxMemoryAllocationCount).
+        const VkDeviceSize blockSize = std::min<VkDeviceSize>(
+            MinGpuMemoryBlockSize << std::min( blockCount, 2u ),
+            MaxGpuMemoryBlockSize );
+
+        // Do not let a single block take most of a small heap (like a 256 MiB BAR heap).
+        const uint32_t     heapIndex = m_GpuMemoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+        const VkDeviceSize heapSize  = m_GpuMemoryProperties.memoryHeaps[heapIndex].size;
+
+        return std::max<VkDeviceSize>( std::min( blockSize, heapSize / 8 ), Megabyte );
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Frees sub-allocated gpu memory.
+    ////////////////////////////////////////////////////////////
+    void FreeGpuMemory( const std::pair<uint32_t, VkDeviceSize>& gpuMemoryOffsets )
+    {
+        const auto [blockIndex, offset] = gpuMemoryOffsets;
+
+        if( blockIndex >= m_GpuMemoryBlocks.size() || m_GpuMemoryBlocks[blockIndex].m_Memory == VK_NULL_HANDLE )
+        {
+            std::cerr << "Cannot find gpu memory block to free!" << std::endl;
+            return;
+        }
+
+        GpuMemoryBlock& block = m_GpuMemoryBlocks[blockIndex];
+
+        block.Free( offset );
+
+        // Resources which did not fit before may fit now, so their blocks are defragmented again.
+        for( GpuMovableResource& resource : m_GpuMovableResources )
+        {
+            resource.m_IsMoveFailed = false;
+        }
+
+        if( !block.IsEmpty() )
+        {
+            return;
+        }
+
+        // Dedicated blocks cannot be reused by other resources.
+        if( block.m_IsDedicated )
+        {
+            vkFreeMemory( m_Device, block.m_Memory, nullptr );
+            block.Reset( VK_NULL_HANDLE, 0, 0 );
+            return;
+        }
+
+        // Keep one empty block per memory type for reuse and release the others.
+        for( uint32_t i = 0; i < m_GpuMemoryBlocks.size(); ++i )
+        {
+            const GpuMemoryBlock& otherBlock = m_GpuMemoryBlocks[i];
+
+            if( i != blockIndex &&
+                otherBlock.m_Memory != VK_NULL_HANDLE &&
+                !otherBlock.m_IsDedicated &&
+                otherBlock.m_MemoryTypeIndex == block.m_MemoryTypeIndex &&
+                otherBlock.IsEmpty() )
+            {
+                vkFreeMemory( m_Device, block.m_Memory, nullptr );
+                block.Reset( VK_NULL_HANDLE, 0, 0 );
+                return;
+            }
+        }
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Returns a host pointer to sub-allocated gpu memory.
+    ////////////////////////////////////////////////////////////
+    void* GetMappedGpuMemory( const std::pair<uint32_t, VkDeviceSize>& gpuMemoryOffsets ) const
+    {
+        const auto [blockIndex, offset] = gpuMemoryOffsets;
+        uint8_t* mappedData             = static_cast<uint8_t*>( m_GpuMemoryBlocks[blockIndex].m_MappedData );
+
+        return mappedData != nullptr ? mappedData + offset : nullptr;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Checks if allocating the given bytes keeps the heap within budget,
+    /// evicts optional memory first if it does not.
+    ////////////////////////////////////////////////////////////
+    bool IsWithinGpuMemoryBudget( const uint32_t heapIndex, const VkDeviceSize size )
+    {
+        GpuMemoryHeapStats stats = GetGpuMemoryStats()[heapIndex];
+
+        if( stats.m_Usage + size <= stats.m_Budget )
+        {
+            return true;
+        }
+
+        // Empty blocks kept for reuse are the only optional memory.
+        for( GpuMemoryBlock& block : m_GpuMemoryBlocks )
+        {
+            if( block.m_Memory != VK_NULL_HANDLE &&
+                block.IsEmpty() &&
+                m_GpuMemoryProperties.memoryTypes[block.m_MemoryTypeIndex].heapIndex == heapIndex )
+            {
+                vkFreeMemory( m_Device, block.m_Memory, nullptr );
+                block.Reset( VK_NULL_HANDLE, 0, 0 );
+            }
+        }
+
+        stats = GetGpuMemoryStats()[heapIndex];
+
+        return stats.m_Usage + size <= stats.m_Budget;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Returns gpu memory statistics per heap.
+    ////////////////////////////////////////////////////////////
+    std::vector<GpuMemoryHeapStats> GetGpuMemoryStats() const
+    {
+        std::vector<GpuMemoryHeapStats> stats( m_GpuMemoryProperties.memoryHeapCount, GpuMemoryHeapStats{} );
+
+        for( const GpuMemoryBlock& block : m_GpuMemoryBlocks )
+        {
+            if( block.m_Memory == VK_NULL_HANDLE )
+            {
+                continue;
+            }
+
+            GpuMemoryHeapStats& heapStats = stats[m_GpuMemoryProperties.memoryTypes[block.m_MemoryTypeIndex].heapIndex];
+
+            heapStats.m_AllocatedBytes += block.m_Size;
+            heapStats.m_UsedBytes += block.m_Usage;
+            heapStats.m_BlockCount += 1;
+            heapStats.m_AllocationCount += static_cast<uint32_t>( block.m_Allocations.size() );
+            heapStats.m_LargestFreeRange = std::max( heapStats.m_LargestFreeRange, block.GetLargestFreeRange() );
+        }
+
+        // Get budget from the driver, it accounts other processes too.
+        VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties = {};
+        VkPhysicalDeviceMemoryProperties2         memoryProperties = {};
+
+        if( m_IsMemoryBudgetSupported )
+        {
+            budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+            memoryProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+            memoryProperties.pNext = &budgetProperties;
+
+            vkGetPhysicalDeviceMemoryProperties2( m_PhysicalDevice, &memoryProperties );
+        }
+
+        for( uint32_t i = 0; i < stats.size(); ++i )
+        {
+            GpuMemoryHeapStats& heapStats = stats[i];
+
+            if( m_IsMemoryBudgetSupported )
+            {
+                heapStats.m_Budget = budgetProperties.heapBudget[i];
+                heapStats.m_Usage  = budgetProperties.heapUsage[i];
+            }
+            else
+            {
+                // Leave a fifth of the heap to other processes.
+                heapStats.m_Budget = m_GpuMemoryProperties.memoryHeaps[i].size / 5 * 4;
+                heapStats.m_Usage  = heapStats.m_AllocatedBytes;
+            }
+
+            const VkDeviceSize freeBytes = heapStats.m_AllocatedBytes - heapStats.m_UsedBytes;
+
+            heapStats.m_Fragmentation = freeBytes > 0
+                ? 1.0f - static_cast<float>( heapStats.m_LargestFreeRange ) / static_cast<float>( freeBytes )
+                : 0.0f;
+        }
+
+        return stats;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Prints gpu memory statistics per heap.
+    ////////////////////////////////////////////////////////////
+    void PrintGpuMemoryStats() const
+    {
+        const std::vector<GpuMemoryHeapStats> stats = GetGpuMemoryStats();
+
+        for( uint32_t i = 0; i < stats.size(); ++i )
+        {
+            std::cout << "Gpu memory heap " << i << ":"
+                      << " budget " << stats[i].m_Budget / Megabyte << " MiB,"
+                      << " usage " << stats[i].m_Usage / Megabyte << " MiB,"
+                      << " allocated " << stats[i].m_AllocatedBytes / Kilobyte << " KiB,"
+                      << " used " << stats[i].m_UsedBytes / Kilobyte << " KiB,"
+                      << " blocks " << stats[i].m_BlockCount << ","
+                      << " allocations " << stats[i].m_AllocationCount << ","
+                      << " fragmentation " << stats[i].m_Fragmentation * 100.0f << "%" << std::endl;
+        }
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Prints frame latency percentiles.
+    ////////////////////////////////////////////////////////////
+    void PrintFrameLatencyStats() const
+    {
+        if( m_FrameLatencies.empty() )
+        {
+            return;
+        }
+
+        std::vector<double> latencies = m_FrameLatencies;
+        std::sort( latencies.begin(), latencies.end() );
+
+        std::cout << "Frame latency (" << GetLatencyModeName( m_Settings.m_LatencyMode ) << ", "
+                  << m_FramesInFlight << " frames in flight, " << m_SwapChainImages.size() << " swap chain images):"
+                  << " average " << GetAverage( latencies ) << " ms,"
+                  << " median " << GetPercentile( latencies, 0.5 ) << " ms,"
+                  << " 99th percentile " << GetPercentile( latencies, 0.99 ) << " ms,"
+                  << " max " << latencies.back() << " ms" << std::endl;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Returns the percentile of sorted samples.
+    ////////////////////////////////////////////////////////////
+    static double GetPercentile( const std::vector<double>& sortedSamples, const double fraction )
+    {
+        return sortedSamples[static_cast<size_t>( fraction * ( sortedSamples.size() - 1 ) + 0.5 )];
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Returns the average of samples.
+    ////////////////////////////////////////////////////////////
+    static double GetAverage( const std::vector<double>& samples )
+    {
+        double sum = 0.0;
+
+        for( const double sample : samples )
+        {
+            sum += sample;
+        }
+
+        return sum / samples.size();
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Returns the name of the benchmark metric.
+    ////////////////////////////////////////////////////////////
+    static const char* GetBenchmarkMetricName( const BenchmarkMetric metric )
+    {
+        switch( metric )
+        {
+            case BenchmarkMetric::CpuFrameTime:
+                return "cpu_frame_time";
+
+            case BenchmarkMetric::GpuFrameTime:
+                return "gpu_frame_time";
+
+            case BenchmarkMetric::ComputeTime:
+                return "compute_time";
+
+            case BenchmarkMetric::AcquireTime:
+                return "acquire_time";
+
+            case BenchmarkMetric::SubmitTime:
+                return "submit_time";
+
+            case BenchmarkMetric::PresentTime:
+                return "present_time";
+
+            case BenchmarkMetric::FrameLatency:
+                return "frame_latency";
+
+            case BenchmarkMetric::ComputeOverlap:
+                return "compute_overlap";
+
+            default:
+                return "unknown";
+        }
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Returns the text escaped for a json string.
+    ////////////////////////////////////////////////////////////
+    static std::string GetJsonEscapedString( const char* text )
+    {
+        static const char hexDigits[] = "0123456789abcdef";
+
+        std::string escaped = {};
+
+        for( const char* c = text; *c != '\0'; ++c )
+        {
+            const unsigned char character = static_cast<unsigned char>( *c );
+
+            if( character == '"' || character == '\\' )
+            {
+                escaped += '\\';
+                escaped += *c;
+            }
+            else if( character < 0x20 )
+            {
+                // Control characters are written as unicode escapes.
+                escaped += "\\u00";
+                escaped += hexDigits[character >> 4];
+                escaped += hexDigits[character & 0xf];
+            }
+            else
+            {
+                escaped += *c;
+            }
+        }
+
+        return escaped;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Writes benchmark statistics of all metrics as json or csv.
+    ////////////////////////////////////////////////////////////
+    StatusCode WriteBenchmarkResults() const
+    {
+        std::ofstream file = {};
+
+        if( !m_Settings.m_BenchmarkOutput.empty() )
+        {
+            file.open( m_Settings.m_BenchmarkOutput );
+
+            if( !file.is_open() )
+            {
+                std::cerr << "Cannot open " << m_Settings.m_BenchmarkOutput << " file!" << std::endl;
+                return StatusCode::Fail;
+            }
+        }
+
+        std::ostream& output   = m_Settings.m_BenchmarkOutput.empty() ? std::cout : file;
+        const bool    isJson   = m_Settings.m_BenchmarkFormat == BenchmarkFormat::Json;
+        const double  duration = std::chrono::duration<double>( m_BenchmarkEndTime - m_BenchmarkStartTime ).count();
+        const size_t  frames   = m_FrameIndex > m_Settings.m_WarmupFrameCount ? m_FrameIndex - m_Settings.m_WarmupFrameCount : 0;
+
+        if( isJson )
+        {
+            output << "{\n"
+                   << "  \"device\": \"" << GetJsonEscapedString( m_PhysicalDeviceProperties.deviceName ) << "\",\n"
+                   << "  \"driver_version\": " << m_PhysicalDeviceProperties.driverVersion << ",\n"
+                   << "  \"latency_mode\": \"" << GetLatencyModeName( m_Settings.m_LatencyMode ) << "\",\n"
+                   << "  \"frames_in_flight\": " << m_FramesInFlight << ",\n"
+                   << "  \"headless\": " << ( m_Settings.m_IsHeadless ? "true" : "false" ) << ",\n"
+                   << "  \"warmup_frames\": " << m_Settings.m_WarmupFrameCount << ",\n"
+                   << "  \"frames\": " << frames << ",\n"
+                   << "  \"seconds\": " << duration << ",\n"
+                   << "  \"metrics\": {";
+        }
+        else
+        {
+            output << "metric,unit,count,min,avg,p50,p95,p99,max\n";
+        }
+
+        bool isFirst = true;
+
+        for( uint32_t i = 0; i < m_BenchmarkSamples.size(); ++i )
+        {
+            std::vector<double> samples = m_BenchmarkSamples[i];
+
+            // Metrics without samples are not supported in this mode, e.g. present in headless mode.
+            if( samples.empty() )
+            {
+                continue;
+            }
+
+            std::sort( samples.begin(), samples.end() );
+
+            const char* name = GetBenchmarkMetricName( static_cast<BenchmarkMetric>( i ) );
+
+            if( isJson )
+            {
+                output << ( isFirst ? "\n" : ",\n" )
+                       << "    \"" << name << "\": { \"unit\": \"ms\", \"count\": " << samples.size()
+                       << ", \"min\": " << samples.front()
+                       << ", \"avg\": " << GetAverage( samples )
+                       << ", \"p50\": " << GetPercentile( samples, 0.5 )
+                       << ", \"p95\": " << GetPercentile( samples, 0.95 )
+                       << ", \"p99\": " << GetPercentile( samples, 0.99 )
+                       << ", \"max\": " << samples.back() << " }";
+            }
+            else
+            {
+                output << name << ",ms," << samples.size()
+                       << "," << samples.front()
+                       << "," << GetAverage( samples )
+                       << "," << GetPercentile( samples, 0.5 )
+                       << "," << GetPercentile( samples, 0.95 )
+                       << "," << GetPercentile( samples, 0.99 )
+                       << "," << samples.back() << "\n";
+            }
+
+            isFirst = false;
+        }
+
+        if( isJson )
+        {
+            output << "\n  }\n}\n";
+        }
+
+        output.flush();
+
+        return output.good() ? StatusCode::Success : StatusCode::Fail;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Registers a buffer which defragmentation can move.
+    ////////////////////////////////////////////////////////////
+    void RegisterMovableBuffer(
+        VkBuffer&                          buffer,
+        std::pair<uint32_t, VkDeviceSize>& bufferGpuMemoryOffsets,
+        const VkDeviceSize                 size,
+        const VkBufferUsageFlags           usage,
+        const GpuResourceOwner             owner )
+    {
+        GpuMovableResource resource = {};
+
+        resource.m_Buffer                 = &buffer;
+        resource.m_GpuMemoryOffsets       = &bufferGpuMemoryOffsets;
+        resource.m_BufferInfo.sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        resource.m_BufferInfo.size        = size;
+        resource.m_BufferInfo.usage       = usage;
+        resource.m_BufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        resource.m_Owner                  = owner;
+
+        m_GpuMovableResources.emplace_back( resource );
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Registers an image (and its view) which defragmentation can move.
+    ////////////////////////////////////////////////////////////
+    void RegisterMovableImage(
+        VkImage&                           image,
+        VkImageView&                       imageView,
+        std::pair<uint32_t, VkDeviceSize>& imageGpuMemoryOffsets,
+        const VkExtent2D                   extent,
+        const VkFormat                     format,
+        const VkImageUsageFlags            usage,
+        const VkImageAspectFlags           aspect,
+        const VkImageLayout                layout,
+        const GpuResourceOwner             owner )
+    {
+        GpuMovableResource resource = {};
+
+        resource.m_Image                   = &image;
+        resource.m_ImageView               = &imageView;
+        resource.m_GpuMemoryOffsets        = &imageGpuMemoryOffsets;
+        resource.m_ImageInfo.sType         = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        resource.m_ImageInfo.imageType     = VK_IMAGE_TYPE_2D;
+        resource.m_ImageInfo.extent.width  = extent.width;
+        resource.m_ImageInfo.extent.height = extent.height;
+        resource.m_ImageInfo.extent.depth  = 1;
+        resource.m_ImageInfo.mipLevels     = 1;
+        resource.m_ImageInfo.arrayLayers   = 1;
+        resource.m_ImageInfo.format        = format;
+        resource.m_ImageInfo.tiling        = VK_IMAGE_TILING_OPTIMAL;
+        resource.m_ImageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        resource.m_ImageInfo.usage         = usage;
+        resource.m_ImageInfo.sharingMode   = VK_SHARING_MODE_EXCLUSIVE;
+        resource.m_ImageInfo.samples       = VK_SAMPLE_COUNT_1_BIT;
+        resource.m_ImageAspect             = aspect;
+        resource.m_ImageLayout             = layout;
+        resource.m_Owner                   = owner;
+
+        m_GpuMovableResources.emplace_back( resource );
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Moves a budgeted amount of resources per frame out of the emptiest
+    /// gpu memory block, so the block can be released.
+    ////////////////////////////////////////////////////////////
+    StatusCode DefragmentGpuMemory()
+    {
+        // The previous moves hold the old resources until no queue and no command buffer uses them.
+        if( !m_GpuMemoryMoves.empty() )
+        {
+            if( IsGpuMemoryMoveRetired() )
+            {
+                DestroyGpuMemoryMoves();
+            }
+
+            return StatusCode::Success;
+        }
+
+        // Do not move resources which are still being uploaded.
+        if( !m_SubmittedUploadBatches.empty() )
+        {
+            return StatusCode::Success;
+        }
+
+        const uint32_t sourceBlockIndex = FindGpuMemoryBlockToDefragment();
+
+        if( sourceBlockIndex == UINT32_MAX )
+        {
+            return StatusCode::Success;
+        }
+
+        // Create the moved resources in other blocks within the frame budget.
+        VkDeviceSize movedBytes = 0;
+
+        for( uint32_t i = 0; i < m_GpuMovableResources.size() && movedBytes < DefragmentationBytesPerFrame; ++i )
+        {
+            GpuMovableResource& resource = m_GpuMovableResources[i];
+
+            if( std::get<0>( *resource.m_GpuMemoryOffsets ) != sourceBlockIndex )
+            {
+                continue;
+            }
+
+            GpuMemoryMove move   = {};
+            move.m_ResourceIndex = i;
+
+            // The resource does not fit, so its block is not picked again until memory is freed instead of trying the move every frame.
+            if( BeginGpuMemoryMove( resource, sourceBlockIndex, move ) != StatusCode::Success )
+            {
+                resource.m_IsMoveFailed = true;
+                break;
+            }
+
+            movedBytes += m_GpuMemoryBlocks[sourceBlockIndex].m_Allocations.at( std::get<1>( *resource.m_GpuMemoryOffsets ) );
+
+            m_GpuMemoryMoves.emplace_back( move );
+        }
+
+        if( m_GpuMemoryMoves.empty() )
+        {
+            return StatusCode::Success;
+        }
+
+        if( SubmitGpuMemoryMoves() != StatusCode::Success )
+        {
+            DestroyGpuMemoryMoves();
+            return StatusCode::Fail;
+        }
+
+        return SwapGpuMemoryMoves();
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Finds the least used block whose resources fit into fuller blocks.
+    ////////////////////////////////////////////////////////////
+    uint32_t FindGpuMemoryBlockToDefragment() const
+    {
+        // Blocks with a resource which failed to move cannot be emptied.
+        std::vector<bool> isBlockPinned( m_GpuMemoryBlocks.size(), false );
+
+        for( const GpuMovableResource& resource : m_GpuMovableResources )
+        {
+            if( resource.m_IsMoveFailed )
+            {
+                isBlockPinned[std::get<0>( *resource.m_GpuMemoryOffsets )] = true;
+            }
+        }
+
+        uint32_t sourceBlockIndex = UINT32_MAX;
+
+        for( const GpuMovableResource& resource : m_GpuMovableResources )
+        {
+            const uint32_t        blockIndex = std::get<0>( *resource.m_GpuMemoryOffsets );
+            const GpuMemoryBlock& block      = m_GpuMemoryBlocks[blockIndex];
+
+            if( block.m_IsDedicated ||
+                isBlockPinned[blockIndex] ||
+                blockIndex == sourceBlockIndex ||
+                ( sourceBlockIndex != UINT32_MAX && m_GpuMemoryBlocks[sourceBlockIndex].m_Usage <= block.m_Usage ) )
+            {
+                continue;
+            }
+
+            // Moving only to fuller blocks makes the blocks emptier and fuller each time, so it cannot ping-pong.
+            VkDeviceSize freeBytes = 0;
+
+            for( uint32_t i = 0; i < m_GpuMemoryBlocks.size(); ++i )
+            {
+                if( IsGpuMemoryBlockDefragmentationTarget( i, blockIndex ) )
+                {
+                    freeBytes += m_GpuMemoryBlocks[i].m_Size - m_GpuMemoryBlocks[i].m_Usage;
+                }
+            }
+
+            if( freeBytes >= block.m_Usage )
+            {
+                sourceBlockIndex = blockIndex;
+            }
+        }
+
+        return sourceBlockIndex;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Checks if resources of the source block can be moved to the target block.
+    ////////////////////////////////////////////////////////////
+    bool IsGpuMemoryBlockDefragmentationTarget( const uint32_t targetBlockIndex, const uint32_t sourceBlockIndex ) const
+    {
+        const GpuMemoryBlock& target = m_GpuMemoryBlocks[targetBlockIndex];
+        const GpuMemoryBlock& source = m_GpuMemoryBlocks[sourceBlockIndex];
+
+        return targetBlockIndex != sourceBlockIndex &&
+            target.m_Memory != VK_NULL_HANDLE &&
+            !target.m_IsDedicated &&
+            target.m_MemoryTypeIndex == source.m_MemoryTypeIndex &&
+            target.m_Usage >= source.m_Usage;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Creates a copy of the resource (and its view) bound to another block.
+    ////////////////////////////////////////////////////////////
+    StatusCode BeginGpuMemoryMove( const GpuMovableResource& resource, const uint32_t sourceBlockIndex, GpuMemoryMove& move )
+    {
+        VkMemoryRequirements  gpuMemoryRequirements = {};
+        GpuMemoryResourceType resourceType          = GpuMemoryResourceType::Linear;
+
+        if( resource.m_Buffer != nullptr )
+        {
+            if( vkCreateBuffer( m_Device, &resource.m_BufferInfo, nullptr, &move.m_Buffer ) != VK_SUCCESS )
+            {
+                return StatusCode::Fail;
+            }
+
+            vkGetBufferMemoryRequirements( m_Device, move.m_Buffer, &gpuMemoryRequirements );
+        }
+        else
+        {
+            if( vkCreateImage( m_Device, &resource.m_ImageInfo, nullptr, &move.m_Image ) != VK_SUCCESS )
+            {
+                return StatusCode::Fail;
+            }
+
+            vkGetImageMemoryRequirements( m_Device, move.m_Image, &gpuMemoryRequirements );
+            resourceType = GpuMemoryResourceType::Optimal;
+        }
+
+        // Try the fullest blocks first.
+        std::vector<uint32_t> targetBlockIndices = {};
+
+        for( uint32_t i = 0; i < m_GpuMemoryBlocks.size(); ++i )
+        {
+            if( IsGpuMemoryBlockDefragmentationTarget( i, sourceBlockIndex ) &&
+                ( gpuMemoryRequirements.memoryTypeBits & ( 1 << m_GpuMemoryBlocks[i].m_MemoryTypeIndex ) ) )
+            {
+                targetBlockIndices.emplace_back( i );
+            }
+        }
+
+        std::sort(
+            targetBlockIndices.begin(),
+            targetBlockIndices.end(),
+            [this]( const uint32_t left, const uint32_t right ) { return m_GpuMemoryBlocks[left].m_Usage > m_GpuMemoryBlocks[right].m_Usage; } );
+
+        for( const uint32_t targetBlockIndex : targetBlockIndices )
+        {
+            GpuMemoryBlock& block  = m_GpuMemoryBlocks[targetBlockIndex];
+            VkDeviceSize    offset = 0;
+
+            if( !block.Allocate( gpuMemoryRequirements.size, gpuMemoryRequirements.alignment, resourceType, offset ) )
+            {
+                continue;
+            }
+
+            move.m_GpuMemoryOffsets = std::make_pair( targetBlockIndex, offset );
+
+            const VkResult result = resource.m_Buffer != nullptr
+                ? vkBindBufferMemory( m_Device, move.m_Buffer, block.m_Memory, offset )
+                : vkBindImageMemory( m_Device, move.m_Image, block.m_Memory, offset );
+
+            if( result != VK_SUCCESS ||
+                ( resource.m_Image != nullptr && CreateImageView( move.m_Image, resource.m_ImageInfo.format, resource.m_ImageAspect, move.m_ImageView ) != StatusCode::Success ) )
+            {
+                DestroyBuffer( move.m_Buffer, move.m_GpuMemoryOffsets );
+                DestroyImage( move.m_Image, move.m_GpuMemoryOffsets );
+                return StatusCode::Fail;
+            }
+
+            return StatusCode::Success;
+        }
+
+        // No room left in fuller blocks.
+        vkDestroyBuffer( m_Device, move.m_Buffer, nullptr );
+        vkDestroyImage( m_Device, move.m_Image, nullptr );
+
+        return StatusCode::Fail;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Gets the queue family of the queue which owns the resource.
+    ////////////////////////////////////////////////////////////
+    uint32_t GetGpuResourceOwnerQueueFamily( const GpuResourceOwner owner ) const
+    {
+        return owner == GpuResourceOwner::Compute ? m_QueueFamilyIndices.m_ComputeFamily : m_QueueFamilyIndices.m_GraphicsFamily;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Records a barrier of the old or the new resource of the move.
+    /// An ownership transfer is recorded by both queue families, other barriers only by the releasing one.
+    ////////////////////////////////////////////////////////////
+    void RecordGpuMemoryMoveBarrier(
+        const VkCommandBuffer commandBuffer,
+        const GpuMemoryMove&  move,
+        const bool            isNewResource,
+        const bool            isAcquire,
+        const uint32_t        srcQueueFamily,
+        const uint32_t        dstQueueFamily,
+        const VkImageLayout   oldLayout,
+        const VkImageLayout   newLayout,
+        const VkAccessFlags   srcAccessMask,
+        const VkAccessFlags   dstAccessMask )
+    {
+        const GpuMovableResource& resource            = m_GpuMovableResources[move.m_ResourceIndex];
+        const bool                isOwnershipTransfer = srcQueueFamily != dstQueueFamily;
+
+        if( isAcquire && !isOwnershipTransfer )
+        {
+            return;
+        }
+
+        if( resource.m_Buffer != nullptr )
+        {
+            VkBufferMemoryBarrier barrier = {};
+
+            barrier.sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            barrier.srcAccessMask       = srcAccessMask;
+            barrier.dstAccessMask       = dstAccessMask;
+            barrier.srcQueueFamilyIndex = isOwnershipTransfer ? srcQueueFamily : VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = isOwnershipTransfer ? dstQueueFamily : VK_QUEUE_FAMILY_IGNORED;
+            barrier.buffer              = isNewResource ? move.m_Buffer : *resource.m_Buffer;
+            barrier.offset              = 0;
+            barrier.size                = VK_WHOLE_SIZE;
+
+            vkCmdPipelineBarrier( commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr );
+            return;
+        }
+
+        VkImageMemoryBarrier barrier = {};
+
+        barrier.sType                           = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask                   = srcAccessMask;
+        barrier.dstAccessMask                   = dstAccessMask;
+        barrier.oldLayout                       = oldLayout;
+        barrier.newLayout                       = newLayout;
+        barrier.srcQueueFamilyIndex             = isOwnershipTransfer ? srcQueueFamily : VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex             = isOwnershipTransfer ? dstQueueFamily : VK_QUEUE_FAMILY_IGNORED;
+        barrier.image                           = isNewResource ? move.m_Image : *resource.m_Image;
+        barrier.subresourceRange.aspectMask     = resource.m_ImageAspect;
+        barrier.subresourceRange.baseMipLevel   = 0;
+        barrier.subresourceRange.levelCount     = resource.m_ImageInfo.mipLevels;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount     = resource.m_ImageInfo.arrayLayers;
+
+        vkCmdPipelineBarrier( commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier );
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Allocates and begins a command buffer submitted once.
+    ////////////////////////////////////////////////////////////
+    StatusCode BeginOneTimeCommandBuffer( const VkCommandPool commandPool, VkCommandBuffer& commandBuffer )
+    {
+        VkCommandBufferAllocateInfo allocationInfo = {};
+        allocationInfo.sType                       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocationInfo.commandPool                 = commandPool;
+        allocationInfo.level                       = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocationInfo.commandBufferCount          = 1;
+
+        if( vkAllocateCommandBuffers( m_Device, &allocationInfo, &commandBuffer ) != VK_SUCCESS )
+        {
+            std::cerr << "Failed to allocate one time command buffer!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        VkCommandBufferBeginInfo beginInfo = {};
+        beginInfo.sType                    = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags                    = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        if( vkBeginCommandBuffer( commandBuffer, &beginInfo ) != VK_SUCCESS )
+        {
+            std::cerr << "Failed to begin one time command buffer!" << std::endl;
+            vkFreeCommandBuffers( m_Device, commandPool, 1, &commandBuffer );
+            commandBuffer = VK_NULL_HANDLE;
+            return StatusCode::Fail;
+        }
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Records and submits the ownership transfers of the moves of the owner queue,
+    /// releasing the old resources to the copy queue family before the copies or
+    /// acquiring the old and the new resources after them.
+    ////////////////////////////////////////////////////////////
+    StatusCode SubmitGpuMemoryMoveOwnership( const GpuResourceOwner owner, const bool isAcquire, const std::vector<GpuSemaphoreWait>& waits, uint64_t& timelineValue )
+    {
+        const bool          isCompute     = owner == GpuResourceOwner::Compute;
+        const VkQueue       queue         = isCompute ? m_ComputeQueue : m_GraphicsQueue;
+        const VkCommandPool commandPool   = isCompute ? m_CommandPoolCompute : m_CommandPoolGraphics;
+        GpuTimeline&        timeline      = isCompute ? m_ComputeTimeline : m_GraphicsTimeline;
+        const uint32_t      ownerFamily   = GetGpuResourceOwnerQueueFamily( owner );
+        const uint32_t      copyFamily    = m_QueueFamilyIndices.m_CopyFamily;
+        VkCommandBuffer&    commandBuffer = m_DefragmentationOwnerCommandBuffers[static_cast<uint32_t>( owner )][isAcquire ? 1 : 0];
+
+        if( BeginOneTimeCommandBuffer( commandPool, commandBuffer ) != StatusCode::Success )
+        {
+            return StatusCode::Fail;
+        }
+
+        // The barrier chains the wait for the copies to the later submissions of the queue.
+        if( isAcquire )
+        {
+            VkMemoryBarrier barrier = {};
+
+            barrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+            vkCmdPipelineBarrier( commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr );
+        }
+
+        for( const GpuMemoryMove& move : m_GpuMemoryMoves )
+        {
+            const GpuMovableResource& resource = m_GpuMovableResources[move.m_ResourceIndex];
+
+            if( resource.m_Owner != owner )
+            {
+                continue;
+            }
+
+            if( isAcquire )
+            {
+                RecordGpuMemoryMoveBarrier( commandBuffer, move, false, true, copyFamily, ownerFamily, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, resource.m_ImageLayout, 0, VK_ACCESS_MEMORY_READ_BIT );
+                RecordGpuMemoryMoveBarrier( commandBuffer, move, true, true, copyFamily, ownerFamily, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, resource.m_ImageLayout, 0, VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT );
+            }
+            else
+            {
+                RecordGpuMemoryMoveBarrier( commandBuffer, move, false, false, ownerFamily, copyFamily, resource.m_ImageLayout, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_MEMORY_WRITE_BIT, 0 );
+            }
+        }
+
+        vkEndCommandBuffer( commandBuffer );
+
+        if( SubmitCommandBuffer( queue, commandBuffer, waits, timeline, VK_NULL_HANDLE, timelineValue ) != StatusCode::Success )
+        {
+            std::cerr << "Failed to submit defragmentation ownership transfer!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Records and submits copies of the moved resources on the copy queue,
+    /// between ownership transfers on the queues which own the resources.
+    ////////////////////////////////////////////////////////////
+    StatusCode SubmitGpuMemoryMoves()
+    {
+        const uint32_t                                                       copyFamily = m_QueueFamilyIndices.m_CopyFamily;
+        std::array<bool, static_cast<uint32_t>( GpuResourceOwner::Count )> isOwner    = {};
+
+        for( const GpuMemoryMove& move : m_GpuMemoryMoves )
+        {
+            isOwner[static_cast<uint32_t>( m_GpuMovableResources[move.m_ResourceIndex].m_Owner )] = true;
+        }
+
+        // The owners release the old resources after the work they submitted so far.
+        std::vector<GpuSemaphoreWait> copyWaits = {};
+
+        for( uint32_t i = 0; i < isOwner.size(); ++i )
+        {
+            if( !isOwner[i] )
+            {
+                continue;
+            }
+
+            const GpuResourceOwner owner = static_cast<GpuResourceOwner>( i );
+
+            if( SubmitGpuMemoryMoveOwnership( owner, false, {}, m_DefragmentationReleaseTimelineValues[i] ) != StatusCode::Success )
+            {
+                return StatusCode::Fail;
+            }
+
+            const GpuTimeline& timeline = owner == GpuResourceOwner::Compute ? m_ComputeTimeline : m_GraphicsTimeline;
+
+            copyWaits.push_back( { timeline.m_Semaphore, m_DefragmentationReleaseTimelineValues[i], VK_PIPELINE_STAGE_TRANSFER_BIT } );
+        }
+
+        if( BeginOneTimeCommandBuffer( m_CommandPoolCopy, m_DefragmentationCommandBuffer ) != StatusCode::Success )
+        {
+            return StatusCode::Fail;
+        }
+
+        for( const GpuMemoryMove& move : m_GpuMemoryMoves )
+        {
+            const GpuMovableResource& resource    = m_GpuMovableResources[move.m_ResourceIndex];
+            const uint32_t            ownerFamily = GetGpuResourceOwnerQueueFamily( resource.m_Owner );
+
+            RecordGpuMemoryMoveBarrier( m_DefragmentationCommandBuffer, move, false, true, ownerFamily, copyFamily, resource.m_ImageLayout, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, 0, VK_ACCESS_TRANSFER_READ_BIT );
+
+            if( resource.m_Buffer != nullptr )
+            {
+                VkBufferCopy copyRegion = {};
+                copyRegion.size         = resource.m_BufferInfo.size;
+
+                vkCmdCopyBuffer( m_DefragmentationCommandBuffer, *resource.m_Buffer, move.m_Buffer, 1, &copyRegion );
+            }
+            else
+            {
+                RecordGpuMemoryMoveBarrier( m_DefragmentationCommandBuffer, move, true, false, copyFamily, copyFamily, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, VK_ACCESS_TRANSFER_WRITE_BIT );
+
+                VkImageCopy copyRegion                   = {};
+                copyRegion.srcSubresource.aspectMask     = resource.m_ImageAspect;
+                copyRegion.srcSubresource.mipLevel       = 0;
+                copyRegion.srcSubresource.baseArrayLayer = 0;
+                copyRegion.srcSubresource.layerCount     = resource.m_ImageInfo.arrayLayers;
+                copyRegion.dstSubresource                = copyRegion.srcSubresource;
+                copyRegion.extent                        = resource.m_ImageInfo.extent;
+
+                vkCmdCopyImage(
+                    m_DefragmentationCommandBuffer,
+                    *resource.m_Image,
+                    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                    move.m_Image,
+                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                    1,
+                    &copyRegion );
+            }
+
+            // Both resources go back to the owner, frames recorded before the move keep using the old one.
+            RecordGpuMemoryMoveBarrier( m_DefragmentationCommandBuffer, move, false, false, copyFamily, ownerFamily, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, resource.m_ImageLayout, 0, 0 );
+            RecordGpuMemoryMoveBarrier( m_DefragmentationCommandBuffer, move, true, false, copyFamily, ownerFamily, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, resource.m_ImageLayout, VK_ACCESS_TRANSFER_WRITE_BIT, 0 );
+        }
+
+        vkEndCommandBuffer( m_DefragmentationCommandBuffer );
+
+        if( SubmitCommandBuffer( m_CopyQueue, m_DefragmentationCommandBuffer, copyWaits, m_CopyTimeline, VK_NULL_HANDLE, m_DefragmentationTimelineValue ) != StatusCode::Success )
+        {
+            std::cerr << "Failed to submit defragmentation command buffer!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        // The owners acquire both resources before the work they submit later, which waits for the copies on the gpu.
+        const std::vector<GpuSemaphoreWait> acquireWaits = { { m_CopyTimeline.m_Semaphore, m_DefragmentationTimelineValue, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT } };
+
+        for( uint32_t i = 0; i < isOwner.size(); ++i )
+        {
+            if( isOwner[i] && SubmitGpuMemoryMoveOwnership( static_cast<GpuResourceOwner>( i ), true, acquireWaits, m_DefragmentationAcquireTimelineValues[i] ) != StatusCode::Success )
+            {
+                return StatusCode::Fail;
+            }
+        }
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Swaps the moved resources in, so the moves hold the old resources until they retire.
+    /// Command buffers are recorded again once the frame of their image
+    /// or the dispatch of their readback buffer is done.
+    ////////////////////////////////////////////////////////////
+    StatusCode SwapGpuMemoryMoves()
+    {
+        bool isComputeMoved  = false;
+        bool isGraphicsMoved = false;
+
+        for( GpuMemoryMove& move : m_GpuMemoryMoves )
+        {
+            const GpuMovableResource& resource = m_GpuMovableResources[move.m_ResourceIndex];
+
+            if( resource.m_Buffer != nullptr )
+            {
+                std::swap( *resource.m_Buffer, move.m_Buffer );
+            }
+            else
+            {
+                std::swap( *resource.m_Image, move.m_Image );
+                std::swap( *resource.m_ImageView, move.m_ImageView );
+            }
+
+            std::swap( *resource.m_GpuMemoryOffsets, move.m_GpuMemoryOffsets );
+
+            isComputeMoved |= resource.m_Owner == GpuResourceOwner::Compute;
+            isGraphicsMoved |= resource.m_Owner == GpuResourceOwner::Graphics;
+        }
+
+        // Dispatches submitted later run after the acquire.
+        if( isComputeMoved )
+        {
+            m_IsReadbackUsingMovedGpuMemory.assign( m_IsReadbackUsingMovedGpuMemory.size(), true );
+        }
+
+        if( isGraphicsMoved )
+        {
+            m_IsImageUsingMovedGpuMemory.assign( m_IsImageUsingMovedGpuMemory.size(), true );
+        }
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Points the descriptor sets and the command buffer of the image to the moved resources.
+    /// The frame of the image must be done.
+    ////////////////////////////////////////////////////////////
+    StatusCode UpdateImageAfterGpuMemoryMoves( const uint32_t imageIndex )
+    {
+        if( !m_IsImageUsingMovedGpuMemory[imageIndex] )
+        {
+            return StatusCode::Success;
+        }
+
+        m_IsImageUsingMovedGpuMemory[imageIndex] = false;
+
+        UpdateGraphicsDescriptorSets( imageIndex );
+
+        return RecordGraphicsCommandBuffer( imageIndex );
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Points the descriptor set and the command buffers of the readback buffer to the moved resources.
+    /// The dispatch of the readback buffer must be done.
+    ////////////////////////////////////////////////////////////
+    StatusCode UpdateReadbackAfterGpuMemoryMoves( const uint32_t readbackIndex )
+    {
+        if( !m_IsReadbackUsingMovedGpuMemory[readbackIndex] )
+        {
+            return StatusCode::Success;
+        }
+
+        m_IsReadbackUsingMovedGpuMemory[readbackIndex] = false;
+
+        UpdateComputeDescriptorSet( readbackIndex );
+
+        if( RecordComputeCommandBuffer( readbackIndex ) != StatusCode::Success )
+        {
+            return StatusCode::Fail;
+        }
+
+        return RecordComputeCommandBuffer( m_ComputeReadbackCount + readbackIndex );
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Checks if the old resources of the moves are no longer used.
+    ////////////////////////////////////////////////////////////
+    bool IsGpuMemoryMoveRetired() const
+    {
+        if( std::find( m_IsImageUsingMovedGpuMemory.begin(), m_IsImageUsingMovedGpuMemory.end(), true ) != m_IsImageUsingMovedGpuMemory.end() ||
+            std::find( m_IsReadbackUsingMovedGpuMemory.begin(), m_IsReadbackUsingMovedGpuMemory.end(), true ) != m_IsReadbackUsingMovedGpuMemory.end() )
+        {
+            return false;
+        }
+
+        // The copies read the old resources until the acquires.
+        return IsTimelineValueReached( m_GraphicsTimeline, m_DefragmentationAcquireTimelineValues[static_cast<uint32_t>( GpuResourceOwner::Graphics )] ) &&
+            IsTimelineValueReached( m_ComputeTimeline, m_DefragmentationAcquireTimelineValues[static_cast<uint32_t>( GpuResourceOwner::Compute )] );
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Waits for the moves and destroys the resources they hold,
+    /// the old ones of swapped moves or the new ones of failed moves.
+    ////////////////////////////////////////////////////////////
+    void DestroyGpuMemoryMoves()
+    {
+        if( m_GpuMemoryMoves.empty() )
+        {
+            return;
+        }
+
+        const uint32_t graphics = static_cast<uint32_t>( GpuResourceOwner::Graphics );
+        const uint32_t compute  = static_cast<uint32_t>( GpuResourceOwner::Compute );
+
+        WaitForTimelineValue( m_CopyTimeline, m_DefragmentationTimelineValue );
+        WaitForTimelineValue( m_GraphicsTimeline, std::max( m_DefragmentationReleaseTimelineValues[graphics], m_DefragmentationAcquireTimelineValues[graphics] ) );
+        WaitForTimelineValue( m_ComputeTimeline, std::max( m_DefragmentationReleaseTimelineValues[compute], m_DefragmentationAcquireTimelineValues[compute] ) );
+
+        for( GpuMemoryMove& move : m_GpuMemoryMoves )
+        {
+            vkDestroyImageView( m_Device, move.m_ImageView, nullptr );
+            DestroyBuffer( move.m_Buffer, move.m_GpuMemoryOffsets );
+            DestroyImage( move.m_Image, move.m_GpuMemoryOffsets );
+        }
+
+        // Freeing null command buffers is ignored.
+        vkFreeCommandBuffers( m_Device, m_CommandPoolCopy, 1, &m_DefragmentationCommandBuffer );
+        vkFreeCommandBuffers( m_Device, m_CommandPoolGraphics, 2, m_DefragmentationOwnerCommandBuffers[graphics].data() );
+        vkFreeCommandBuffers( m_Device, m_CommandPoolCompute, 2, m_DefragmentationOwnerCommandBuffers[compute].data() );
+
+        m_DefragmentationCommandBuffer         = VK_NULL_HANDLE;
+        m_DefragmentationOwnerCommandBuffers   = {};
+        m_DefragmentationReleaseTimelineValues = {};
+        m_DefragmentationAcquireTimelineValues = {};
+        m_GpuMemoryMoves.clear();
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Creates an image view.
+    ////////////////////////////////////////////////////////////
+    StatusCode CreateImageView(
+        const VkImage      image,
+        const VkFormat     format,
+        VkImageAspectFlags aspectFlags,
+        VkImageView&       imageView )
+    {
+        VkImageViewCreateInfo viewInfo = {};
+
+        viewInfo.sType                           = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image                           = image;
+        viewInfo.viewType                        = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format                          = format;
+        viewInfo.subresourceRange.aspectMask     = aspectFlags;
+        viewInfo.subresourceRange.baseMipLevel   = 0;
+        viewInfo.subresourceRange.levelCount     = 1;
+        viewInfo.subresourceRange.baseArrayLayer = 0;
+        viewInfo.subresourceRange.layerCount     = 1;
+        viewInfo.components.r                    = VK_COMPONENT_SWIZZLE_IDENTITY;
+        viewInfo.components.g                    = VK_COMPONENT_SWIZZLE_IDENTITY;
+        viewInfo.components.b                    = VK_COMPONENT_SWIZZLE_IDENTITY;
+        viewInfo.components.a                    = VK_COMPONENT_SWIZZLE_IDENTITY;
+
+        if( vkCreateImageView( m_Device, &viewInfo, nullptr, &imageView ) != VK_SUCCESS )
+        {
+            std::cerr << "Cannot create image view!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Begins a new upload batch if none is being recorded.
+    ////////////////////////////////////////////////////////////
+    StatusCode BeginUploadBatch()
+    {
+        if( m_UploadBatch.m_CopyCommandBuffer != VK_NULL_HANDLE )
+        {
+            return StatusCode::Success;
+        }
+
+        VkCommandBufferAllocateInfo allocationInfo = {};
+
+        allocationInfo.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocationInfo.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocationInfo.commandBufferCount = 1;
+
+        VkCommandBuffer copyCommandBuffer     = VK_NULL_HANDLE;
+        VkCommandBuffer graphicsCommandBuffer = VK_NULL_HANDLE;
+
+        allocationInfo.commandPool = m_CommandPoolCopy;
+        VkResult result            = vkAllocateCommandBuffers( m_Device, &allocationInfo, &copyCommandBuffer );
+
+        if( result == VK_SUCCESS )
+        {
+            allocationInfo.commandPool = m_CommandPoolGraphics;
+            result                     = vkAllocateCommandBuffers( m_Device, &allocationInfo, &graphicsCommandBuffer );
+        }
+
+        VkCommandBufferBeginInfo beginInfo = {};
+
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        if( result == VK_SUCCESS )
+        {
+            result = vkBeginCommandBuffer( copyCommandBuffer, &beginInfo );
+        }
+
+        if( result == VK_SUCCESS )
+        {
+            result = vkBeginCommandBuffer( graphicsCommandBuffer, &beginInfo );
+        }
+
+        // Freeing null command buffers is ignored.
+        if( result != VK_SUCCESS )
+        {
+            std::cerr << "Failed to begin upload batch!" << std::endl;
+
+            vkFreeCommandBuffers( m_Device, m_CommandPoolCopy, 1, &copyCommandBuffer );
+            vkFreeCommandBuffers( m_Device, m_CommandPoolGraphics, 1, &graphicsCommandBuffer );
+            return StatusCode::Fail;
+        }
+
+        m_UploadBatch.m_CopyCommandBuffer     = copyCommandBuffer;
+        m_UploadBatch.m_GraphicsCommandBuffer = graphicsCommandBuffer;
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Checks if the copy and graphics queues need ownership transfers.
+    ////////////////////////////////////////////////////////////
+    bool IsQueueOwnershipTransferNeeded() const
+    {
+        return m_QueueFamilyIndices.m_CopyFamily != m_QueueFamilyIndices.m_GraphicsFamily;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Reserves staging memory for an upload chunk.
+    /// If the ring is full, submits the batch and waits for the oldest uploads.
+    ////////////////////////////////////////////////////////////
+    StatusCode ReserveStagingMemory(
+        const VkDeviceSize size,
+        const VkDeviceSize minSize,
+        VkDeviceSize&      offset,
+        VkDeviceSize&      reservedSize )
+    {
+        if( minSize > m_StagingRingBuffer.m_Size )
+        {
+            std::cerr << "Upload chunk does not fit into the staging ring buffer!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        reservedSize = m_StagingRingBuffer.Reserve( size, minSize, offset );
+
+        while( reservedSize == 0 )
+        {
+            if( SubmitUploadBatch() != StatusCode::Success )
+            {
+                return StatusCode::Fail;
+            }
+
+            // Nothing in flight holds staging memory, so waiting would not free any.
+            if( m_SubmittedUploadBatches.empty() )
+            {
+                std::cerr << "Staging ring buffer is full without uploads in flight!" << std::endl;
+                return StatusCode::Fail;
+            }
+
+            WaitForUpload( m_SubmittedUploadBatches.front().m_Ticket );
+
+            reservedSize = m_StagingRingBuffer.Reserve( size, minSize, offset );
+        }
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Records copies of the data to a buffer through the staging ring buffer.
+    /// The graphics queue acquires the buffer in the upload batch, other queues have to acquire it themselves.
+    ////////////////////////////////////////////////////////////
+    StatusCode UploadBuffer(
+        const void*                data,
+        const VkDeviceSize         size,
+        const VkBuffer             buffer,
+        const uint32_t             dstQueueFamily,
+        const VkPipelineStageFlags dstStage,
+        const VkAccessFlags        dstAccess )
+    {
+        const uint8_t* source   = static_cast<const uint8_t*>( data );
+        VkDeviceSize   uploaded = 0;
+
+        // Stream the data in chunks, a batch is submitted whenever the ring is full.
+        while( uploaded < size )
+        {
+            VkDeviceSize stagingOffset = 0;
+            VkDeviceSize chunkSize     = 0;
+
+            // Reserving may submit the batch, so the next one begins after it.
+            if( ReserveStagingMemory( size - uploaded, 1, stagingOffset, chunkSize ) != StatusCode::Success ||
+                BeginUploadBatch() != StatusCode::Success )
+            {
+                return StatusCode::Fail;
+            }
+
+            memcpy( m_StagingRingBuffer.m_MappedData + stagingOffset, source + uploaded, static_cast<size_t>( chunkSize ) );
+
+            VkBufferCopy copyRegion = {};
+
+            copyRegion.srcOffset = stagingOffset;
+            copyRegion.dstOffset = uploaded;
+            copyRegion.size      = chunkSize;
+
+            vkCmdCopyBuffer( m_UploadBatch.m_CopyCommandBuffer, m_StagingRingBuffer.m_Buffer, buffer, 1, &copyRegion );
+
+            uploaded += chunkSize;
+        }
+
+        if( BeginUploadBatch() != StatusCode::Success )
+        {
+            return StatusCode::Fail;
+        }
+
+        GpuUploadBatch& batch = m_UploadBatch;
+
+        // The semaphore between the queues makes the copy visible, only the ownership has to move.
+        if( m_QueueFamilyIndices.m_CopyFamily != dstQueueFamily )
+        {
+            VkBufferMemoryBarrier barrier = {};
+
+            barrier.sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            barrier.srcQueueFamilyIndex = m_QueueFamilyIndices.m_CopyFamily;
+            barrier.dstQueueFamilyIndex = dstQueueFamily;
+            barrier.buffer              = buffer;
+            barrier.offset              = 0;
+            barrier.size                = VK_WHOLE_SIZE;
+
+            // Release.
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = 0;
+
+            vkCmdPipelineBarrier( batch.m_CopyCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr );
+
+            // Acquire.
+            if( dstQueueFamily == m_QueueFamilyIndices.m_GraphicsFamily )
+            {
+                barrier.srcAccessMask = 0;
+                barrier.dstAccessMask = dstAccess;
+
+                vkCmdPipelineBarrier( batch.m_GraphicsCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, dstStage, 0, 0, nullptr, 1, &barrier, 0, nullptr );
+            }
+        }
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Records copies of the pixels to a color image through the staging ring buffer
+    /// and its transition to the final layout.
+    ////////////////////////////////////////////////////////////
+    StatusCode UploadImage(
+        const void*                pixels,
+        const uint32_t             width,
+        const uint32_t             height,
+        const uint32_t             bytesPerPixel,
+        const VkImage              image,
+        const VkImageLayout        finalLayout,
+        const VkPipelineStageFlags dstStage,
+        const VkAccessFlags        dstAccess )
+    {
+        VkImageMemoryBarrier barrier = {};
+
+        barrier.sType                           = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image                           = image;
+        barrier.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseMipLevel   = 0;
+        barrier.subresourceRange.levelCount     = 1;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount     = 1;
+
+        // Undefined -> transfer destination.
+        barrier.oldLayout     = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+        if( BeginUploadBatch() != StatusCode::Success )
+        {
+            return StatusCode::Fail;
+        }
+
+        vkCmdPipelineBarrier( m_UploadBatch.m_CopyCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier );
+
+        const uint8_t*     source   = static_cast<const uint8_t*>( pixels );
+        const VkDeviceSize rowSize  = static_cast<VkDeviceSize>( width ) * bytesPerPixel;
+        uint32_t           uploaded = 0;
+
+        // Stream whole rows, a batch is submitted whenever the ring is full.
+        while( uploaded < height )
+        {
+            VkDeviceSize stagingOffset = 0;
+            VkDeviceSize chunkSize     = 0;
+
+            if( ReserveStagingMemory( ( height - uploaded ) * rowSize, rowSize, stagingOffset, chunkSize ) != StatusCode::Success ||
+                BeginUploadBatch() != StatusCode::Success )
+            {
+                return StatusCode::Fail;
+            }
+
+            const uint32_t rowCount = static_cast<uint32_t>( chunkSize / rowSize );
+
+            memcpy( m_StagingRingBuffer.m_MappedData + stagingOffset, source + uploaded * rowSize, static_cast<size_t>( rowCount * rowSize ) );
+
+            VkBufferImageCopy region = {};
+
+            region.bufferOffset      = stagingOffset;
+            region.bufferRowLength   = 0;
+            region.bufferImageHeight = 0;
+
+            region.imageSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+            region.imageSubresource.mipLevel       = 0;
+            region.imageSubresource.baseArrayLayer = 0;
+            region.imageSubresource.layerCount     = 1;
+
+            region.imageOffset = { 0, static_cast<int32_t>( uploaded ), 0 };
+            region.imageExtent = { width, rowCount, 1 };
+
+            vkCmdCopyBufferToImage(
+                m_UploadBatch.m_CopyCommandBuffer,
+                m_StagingRingBuffer.m_Buffer,
+                image,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                1,
+                &region );
+
+            uploaded += rowCount;
+        }
+
+        if( BeginUploadBatch() != StatusCode::Success )
+        {
+            return StatusCode::Fail;
+        }
+
+        GpuUploadBatch& batch = m_UploadBatch;
+
+        // Transfer destination -> final layout, done by the graphics queue, with a release on the copy queue if needed.
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = finalLayout;
+
+        if( IsQueueOwnershipTransferNeeded() )
+        {
+            barrier.srcQueueFamilyIndex = m_QueueFamilyIndices.m_CopyFamily;
+            barrier.dstQueueFamilyIndex = m_QueueFamilyIndices.m_GraphicsFamily;
+            barrier.srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask       = 0;
+
+            vkCmdPipelineBarrier( batch.m_CopyCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier );
+        }
+
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = dstAccess;
+
+        vkCmdPipelineBarrier( batch.m_GraphicsCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, dstStage, 0, 0, nullptr, 0, nullptr, 1, &barrier );
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Submits the recorded upload batch, its ticket becomes the upload ticket.
+    /// Later graphics submissions are ordered after the uploads, so only the host needs to wait on the ticket.
+    /// A batch which fails to submit is dropped and gets no ticket.
+    ////////////////////////////////////////////////////////////
+    StatusCode SubmitUploadBatch()
+    {
+        if( m_UploadBatch.m_CopyCommandBuffer == VK_NULL_HANDLE )
+        {
+            return StatusCode::Success;
+        }
+
+        GpuUploadBatch batch = m_UploadBatch;
+        m_UploadBatch        = {};
+
+        StatusCode result = StatusCode::Success;
+
+        if( vkEndCommandBuffer( batch.m_CopyCommandBuffer ) != VK_SUCCESS ||
+            vkEndCommandBuffer( batch.m_GraphicsCommandBuffer ) != VK_SUCCESS )
+        {
+            std::cerr << "Failed to record upload batch!" << std::endl;
+            result = StatusCode::Fail;
+        }
+
+        // Submit the copies.
+        uint64_t copyTimelineValue = 0;
+
+        if( result == StatusCode::Success &&
+            SubmitCommandBuffer( m_CopyQueue, batch.m_CopyCommandBuffer, {}, m_CopyTimeline, VK_NULL_HANDLE, copyTimelineValue ) != StatusCode::Success )
+        {
+            std::cerr << "Failed to submit upload copy command buffer!" << std::endl;
+            result = StatusCode::Fail;
+        }
+
+        // Submit the ownership acquires and layout transitions once the copies are done.
+        const std::vector<GpuSemaphoreWait> waits = {
+            { m_CopyTimeline.m_Semaphore, copyTimelineValue, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT }
+        };
+
+        if( result == StatusCode::Success &&
+            SubmitCommandBuffer( m_GraphicsQueue, batch.m_GraphicsCommandBuffer, waits, m_GraphicsTimeline, VK_NULL_HANDLE, batch.m_TimelineValue ) != StatusCode::Success )
+        {
+            std::cerr << "Failed to submit upload graphics command buffer!" << std::endl;
+            result = StatusCode::Fail;
+        }
+
+        if( result != StatusCode::Success )
+        {
+            // The copies may have been submitted, their staging memory is released with the next batch.
+            WaitForTimelineValue( m_CopyTimeline, copyTimelineValue );
+
+            vkFreeCommandBuffers( m_Device, m_CommandPoolCopy, 1, &batch.m_CopyCommandBuffer );
+            vkFreeCommandBuffers( m_Device, m_CommandPoolGraphics, 1, &batch.m_GraphicsCommandBuffer );
+            return StatusCode::Fail;
+        }
+
+        batch.m_Ticket                = ++m_UploadTicket;
+        batch.m_StagingRingBufferHead = m_StagingRingBuffer.m_Head;
+
+        m_SubmittedUploadBatches.emplace_back( batch );
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Checks if the uploads of the ticket (and all earlier tickets) are complete.
+    ////////////////////////////////////////////////////////////
+    bool IsUploadComplete( const uint64_t ticket ) const
+    {
+        for( const GpuUploadBatch& batch : m_SubmittedUploadBatches )
+        {
+            if( batch.m_Ticket <= ticket && !IsTimelineValueReached( m_GraphicsTimeline, batch.m_TimelineValue ) )
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Waits for the uploads of the ticket (and all earlier tickets).
+    ////////////////////////////////////////////////////////////
+    void WaitForUpload( const uint64_t ticket )
+    {
+        for( const GpuUploadBatch& batch : m_SubmittedUploadBatches )
+        {
+            if( batch.m_Ticket <= ticket )
+            {
+                WaitForTimelineValue( m_GraphicsTimeline, batch.m_TimelineValue );
+            }
+        }
+
+        ReleaseCompletedUploadBatches();
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Releases staging memory and command buffers of completed upload batches.
+    ////////////////////////////////////////////////////////////
+    void ReleaseCompletedUploadBatches()
+    {
+        auto batch = m_SubmittedUploadBatches.begin();
+
+        while( batch != m_SubmittedUploadBatches.end() )
+        {
+            if( !IsTimelineValueReached( m_GraphicsTimeline, batch->m_TimelineValue ) )
+            {
+                ++batch;
+                continue;
+            }
+
+            m_StagingRingBuffer.Release( batch->m_StagingRingBufferHead );
+
+            vkFreeCommandBuffers( m_Device, m_CommandPoolCopy, 1, &batch->m_CopyCommandBuffer );
+            vkFreeCommandBuffers( m_Device, m_CommandPoolGraphics, 1, &batch->m_GraphicsCommandBuffer );
+
+            batch = m_SubmittedUploadBatches.erase( batch );
+        }
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Records image layout transition to the graphics command buffer of the upload batch.
+    ////////////////////////////////////////////////////////////
+    StatusCode TransitionImageLayout(
+        const VkImage       image,
+        const VkFormat      format,
+        const VkImageLayout oldLayout,
+        const VkImageLayout newLayout )
+    {
+        if( BeginUploadBatch() != StatusCode::Success )
+        {
+            return StatusCode::Fail;
+        }
+
+        VkCommandBuffer commandBuffer = m_UploadBatch.m_GraphicsCommandBuffer;
+
+        VkImageMemoryBarrier barrier          = {};
+        VkPipelineStageFlags sourceStage      = 0;
+        VkPipelineStageFlags destinationStage = 0;
+
+        barrier.sType                           = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.oldLayout                       = oldLayout;
+        barrier.newLayout                       = newLayout;
+        barrier.srcQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image                           = image;
+        barrier.subresourceRange.baseMipLevel   = 0;
+        barrier.subresourceRange.levelCount     = 1;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount     = 1;
+
+        // For depth testing.
+        if( newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL )
+        {
+            barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+
+            if( HasStencilComponent( format ) )
+            {
+                barrier.subresourceRange.aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
+            }
+        }
+        else
+        {
+            barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        }
+
+        if( oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL )
+        {
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+            sourceStage      = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+            destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        }
+        else if( oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL )
+        {
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+            sourceStage      = VK_PIPELINE_STAGE_TRANSFER_BIT;
+            destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+        }
+        else if( oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL )
+        {
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+            sourceStage      = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+            destinationStage = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+        }
+        else
+        {
+            std::cerr << "Unsupported layout transition!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            sourceStage,
+            destinationStage,
+            0,
+            0,
+            nullptr,
+            0,
+            nullptr,
+            1,
+            &barrier );
+
+        return StatusCode::Success;
+    }
+
+
+    ////////////////////////////////////////////////////////////
+    /// Creates texture image.
+    ////////////////////////////////////////////////////////////
+    StatusCode CreateImage(
+        const uint32_t                     textureWidth,
+        const uint32_t                     textureHeight,
+        const VkFormat                     format,
+        const VkImageTiling                tiling,
+        const VkImageUsageFlags            usage,
+        const GpuMemoryPreferences&        memoryPreferences,
+        VkImage&                           image,
+        std::pair<uint32_t, VkDeviceSize>& bufferGpuMemoryOffsets )
+    {
+        VkImageCreateInfo imageInfo = {};
+
+        imageInfo.sType         = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType     = VK_IMAGE_TYPE_2D;
+        imageInfo.extent.width  = textureWidth;
+        imageInfo.extent.height = textureHeight;
+        imageInfo.extent.depth  = 1;
+        imageInfo.mipLevels     = 1;
+        imageInfo.arrayLayers   = 1;
+        imageInfo.format        = format;
+        imageInfo.tiling        = tiling;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageInfo.usage         = usage;
+        imageInfo.sharingMode   = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.samples       = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.flags         = 0; // Optional.
+
+        if( vkCreateImage( m_Device, &imageInfo, nullptr, &image ) != VK_SUCCESS )
+        {
+            std::cerr << "Cannot create image!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        // Get gpu memory requirements for the image.
+        VkImageMemoryRequirementsInfo2 gpuMemoryRequirementsInfo = {};
+        VkMemoryDedicatedRequirements  dedicatedRequirements     = {};
+        VkMemoryRequirements2          gpuMemoryRequirements     = {};
+        VkMemoryDedicatedAllocateInfo  dedicatedAllocateInfo     = {};
+
+        gpuMemoryRequirementsInfo.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2;
+        gpuMemoryRequirementsInfo.image = image;
+        dedicatedRequirements.sType     = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+        gpuMemoryRequirements.sType     = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+        gpuMemoryRequirements.pNext     = &dedicatedRequirements;
+        dedicatedAllocateInfo.sType     = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+        dedicatedAllocateInfo.image     = image;
+
+        vkGetImageMemoryRequirements2( m_Device, &gpuMemoryRequirementsInfo, &gpuMemoryRequirements );
+
+        const bool isDedicated =
+            dedicatedRequirements.prefersDedicatedAllocation ||
+            dedicatedRequirements.requiresDedicatedAllocation;
+
+        // Sub-allocate gpu memory for the image.
+        const StatusCode result = AllocateGpuMemory(
+            gpuMemoryRequirements.memoryRequirements,
+            memoryPreferences,
+            tiling == VK_IMAGE_TILING_OPTIMAL ? GpuMemoryResourceType::Optimal : GpuMemoryResourceType::Linear,
+            isDedicated ? &dedicatedAllocateInfo : nullptr,
+            bufferGpuMemoryOffsets );
+
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Cannot allocate image gpu memory!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        // Bind allocated gpu memory with the given image.
+        const auto [bufferGpuMemoryIndex, bufferGpuMemoryOffset] = bufferGpuMemoryOffsets;
+
+        if( vkBindImageMemory( m_Device, image, m_GpuMemoryBlocks[bufferGpuMemoryIndex].m_Memory, bufferGpuMemoryOffset ) != VK_SUCCESS )
+        {
+            std::cerr << "Cannot bind buffer gpu memory!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Destroys an image and frees its gpu memory.
+    ////////////////////////////////////////////////////////////
+    void DestroyImage(
+        VkImage&                           image,
+        std::pair<uint32_t, VkDeviceSize>& imageGpuMemoryOffsets )
+    {
+        if( image == VK_NULL_HANDLE )
+        {
+            return;
+        }
+
+        vkDestroyImage( m_Device, image, nullptr );
+        FreeGpuMemory( imageGpuMemoryOffsets );
+
+        image = VK_NULL_HANDLE;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Creates depth resources.
+    ////////////////////////////////////////////////////////////
+    StatusCode CreateDepthResources()
+    {
+        StatusCode     result      = StatusCode::Success;
+        const VkFormat depthFormat = FindDepthFormat();
+
+        result = CreateImage(
+            m_SwapChainExtent.width,
+            m_SwapChainExtent.height,
+            depthFormat,
+            VK_IMAGE_TILING_OPTIMAL,
+            VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+            { VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT },
+            m_DepthImage,
+            m_DepthImageGpuMemoryOffset );
+
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Cannot create image for depth!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        result = CreateImageView(
+            m_DepthImage,
+            depthFormat,
+            VK_IMAGE_ASPECT_DEPTH_BIT,
+            m_DepthImageView );
+
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Cannot create image view for depth!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        TransitionImageLayout(
+            m_DepthImage,
+            depthFormat,
+            VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL );
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Creates texture image.
+    ////////////////////////////////////////////////////////////
+    StatusCode CreateTextureImage()
+    {
+        constexpr uint32_t bytesPerPixel = 4;
+        StatusCode         result        = StatusCode::Success;
+
+        // Wait for the texture decoded by the worker thread.
+        if( WaitForAsset( m_TextureLoading ) != StatusCode::Success )
+        {
+            std::cerr << "Failed to load texture image!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        Pixels*       pixels        = m_LoadedTexture.m_Pixels;
+        const int32_t textureWidth  = m_LoadedTexture.m_Width;
+        const int32_t textureHeight = m_LoadedTexture.m_Height;
+
+        m_LoadedTexture = {};
+
+        // Create image.
+        result = CreateImage(
+            textureWidth,
+            textureHeight,
+            VK_FORMAT_R8G8B8A8_SRGB,
+            VK_IMAGE_TILING_OPTIMAL,
+            VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+            { VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT },
+            m_TextureImage,
+            m_TextureImageGpuMemoryOffset );
+
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Cannot create image for texture image!" << std::endl;
+            StbImage::unloadRbga( pixels );
+            return StatusCode::Fail;
+        }
+
+        // Copy the texture to image and transition it to shader read only.
+        result = UploadImage(
+            pixels,
+            static_cast<uint32_t>( textureWidth ),
+            static_cast<uint32_t>( textureHeight ),
+            bytesPerPixel,
+            m_TextureImage,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            VK_ACCESS_SHADER_READ_BIT );
+
+        // Free texture.
+        StbImage::unloadRbga( pixels );
+
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Cannot upload texture image!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        RegisterMovableImage(
+            m_TextureImage,
+            m_TextureImageView,
+            m_TextureImageGpuMemoryOffset,
+            { static_cast<uint32_t>( textureWidth ), static_cast<uint32_t>( textureHeight ) },
+            VK_FORMAT_R8G8B8A8_SRGB,
+            VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+            VK_IMAGE_ASPECT_COLOR_BIT,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            GpuResourceOwner::Graphics );
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Creates texture image view.
+    ////////////////////////////////////////////////////////////
+    StatusCode CreateTextureImageView()
+    {
+        const StatusCode result = CreateImageView(
+            m_TextureImage,
+            VK_FORMAT_R8G8B8A8_SRGB,
+            VK_IMAGE_ASPECT_COLOR_BIT,
+            m_TextureImageView );
+
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Cannot create texture image view!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        return result;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Creates texture sampler.
+    ////////////////////////////////////////////////////////////
+    StatusCode CreateTextureSampler()
+    {
+        VkSamplerCreateInfo samplerInfo = {};
+
+        samplerInfo.sType                   = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        samplerInfo.magFilter               = VK_FILTER_LINEAR;
+        samplerInfo.minFilter               = VK_FILTER_LINEAR;
+        samplerInfo.addressModeU            = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        samplerInfo.addressModeV            = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        samplerInfo.addressModeW            = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        samplerInfo.borderColor             = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+        samplerInfo.unnormalizedCoordinates = VK_FALSE;
+        samplerInfo.compareEnable           = VK_FALSE;
+        samplerInfo.compareOp               = VK_COMPARE_OP_ALWAYS;
+        samplerInfo.mipmapMode              = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+        samplerInfo.mipLodBias              = 0.0f;
+        samplerInfo.minLod                  = 0.0f;
+        samplerInfo.maxLod                  = 0.0f;
+        samplerInfo.maxAnisotropy           = m_MaxSamplerAnisotropy;
+
+        if( m_MaxSamplerAnisotropy > 1.0f )
+        {
+            samplerInfo.anisotropyEnable = VK_TRUE;
+        }
+        else
+        {
+            samplerInfo.anisotropyEnable = VK_FALSE;
+        }
+
+        if( vkCreateSampler( m_Device, &samplerInfo, nullptr, &m_TextureSampler ) != VK_SUCCESS )
+        {
+            std::cerr << "Cannot create texture sampler!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Creates vertex buffers.
+    ////////////////////////////////////////////////////////////
+    StatusCode CreateVertexBuffer()
+    {
+        // Wait for the model loaded by the worker thread.
+        if( WaitForAsset( m_ModelLoading ) != StatusCode::Success )
+        {
+            std::cerr << "Failed to load model!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        const VkDeviceSize bufferSize = sizeof( Vertices[0] ) * Vertices.size();
+
+        const StatusCode result = CreateDeviceLocalBuffer(
+            Vertices.data(),
+            bufferSize,
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+            VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT,
+            m_VertexBuffer,
+            m_VertexBufferGpuMemoryOffset );
+
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Cannot create buffer for vertex buffer!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        RegisterMovableBuffer(
+            m_VertexBuffer,
+            m_VertexBufferGpuMemoryOffset,
+            bufferSize,
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            GpuResourceOwner::Graphics );
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Creates index buffers.
+    ////////////////////////////////////////////////////////////
+    StatusCode CreateIndexBuffer()
+    {
+        const VkDeviceSize bufferSize = sizeof( Indices[0] ) * Indices.size();
+
+        const StatusCode result = CreateDeviceLocalBuffer(
+            Indices.data(),
+            bufferSize,
+            VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+            VK_ACCESS_INDEX_READ_BIT,
+            m_IndexBuffer,
+            m_IndexBufferGpuMemoryOffset );
+
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Cannot create buffer for index buffer!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        RegisterMovableBuffer(
+            m_IndexBuffer,
+            m_IndexBufferGpuMemoryOffset,
+            bufferSize,
+            VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            GpuResourceOwner::Graphics );
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Splits the indices to clusters with bounding spheres and creates the culling kernel.
+    ////////////////////////////////////////////////////////////
+    StatusCode CreateCullingClusters()
+    {
+        const uint32_t clusterIndexCount = CullingClusterTriangleCount * 3;
+        const uint32_t indexCount        = static_cast<uint32_t>( Indices.size() );
+
+        std::vector<CullingCluster> clusters = {};
+
+        for( uint32_t firstIndex = 0; firstIndex < indexCount; firstIndex += clusterIndexCount )
+        {
+            CullingCluster cluster = {};
+            cluster.m_FirstIndex   = firstIndex;
+            cluster.m_IndexCount   = std::min( clusterIndexCount, indexCount - firstIndex );
+
+            // Center the sphere in the bounding box, the radius reaches the farthest vertex.
+            glm::vec3 minimum = Vertices[Indices[firstIndex]].position;
+            glm::vec3 maximum = minimum;
+
+            for( uint32_t i = firstIndex; i < firstIndex + cluster.m_IndexCount; ++i )
+            {
+                minimum = glm::min( minimum, Vertices[Indices[i]].position );
+                maximum = glm::max( maximum, Vertices[Indices[i]].position );
+            }
+
+            const glm::vec3 center = ( minimum + maximum ) * 0.5f;
+            float           radius = 0.0f;
+
+            for( uint32_t i = firstIndex; i < firstIndex + cluster.m_IndexCount; ++i )
+            {
+                radius = std::max( radius, glm::length( Vertices[Indices[i]].position - center ) );
+            }
+
+            cluster.m_BoundingSphere = glm::vec4( center, radius );
+
+            clusters.emplace_back( cluster );
+        }
+
+        m_CullingClusterCount = static_cast<uint32_t>( clusters.size() );
+
+        if( m_CullingClusterCount == 0 )
+        {
+            return StatusCode::Success;
+        }
+
+        if( GetComputeDispatchSize( m_PhysicalDeviceProperties.limits, m_CullingClusterCount, m_ComputeWorkgroupSize, m_CullingDispatchSize ) != StatusCode::Success )
+        {
+            std::cerr << "Culling dispatch of " << m_CullingClusterCount << " clusters exceeds the workgroup count limits!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        // Clusters are read on the graphics queue, so the upload releases them to the graphics family.
+        const StatusCode result = CreateDeviceLocalBuffer(
+            clusters.data(),
+            sizeof( CullingCluster ) * clusters.size(),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_ACCESS_SHADER_READ_BIT,
+            m_CullingClusterBuffer,
+            m_CullingClusterBufferGpuMemoryOffset );
+
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Cannot create buffer for culling clusters!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        return RegisterComputeKernel( "Shaders/cull.spv", 0, sizeof( CullingConstants ), m_CullingKernel );
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Returns true if draws are culled on the gpu and drawn with an indirect count.
+    ////////////////////////////////////////////////////////////
+    bool IsGpuCullingEnabled() const
+    {
+        return m_IsGpuCullingSupported && m_CullingClusterCount > 0;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Creates the draw buffers written by the culling kernel, one per swap chain image.
+    ////////////////////////////////////////////////////////////
+    StatusCode CreateCullingDrawBuffers()
+    {
+        if( !IsGpuCullingEnabled() )
+        {
+            return StatusCode::Success;
+        }
+
+        const VkDeviceSize bufferSize = CullingDrawCommandOffset + sizeof( VkDrawIndexedIndirectCommand ) * m_CullingClusterCount;
+
+        m_CullingDrawBuffers.resize( m_SwapChainImages.size(), VK_NULL_HANDLE );
+        m_CullingDrawBuffersGpuMemoryOffsets.resize( m_SwapChainImages.size() );
+
+        for( size_t i = 0; i < m_CullingDrawBuffers.size(); ++i )
+        {
+            const StatusCode result = CreateBuffer(
+                bufferSize,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                { VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT },
+                0,
+                nullptr,
+                m_CullingDrawBuffers[i],
+                m_CullingDrawBuffersGpuMemoryOffsets[i] );
+
+            if( result != StatusCode::Success )
+            {
+                std::cerr << "Cannot create buffer for culling draws!" << std::endl;
+                return StatusCode::Fail;
+            }
+        }
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Records the culling dispatch of the image, its draws are ready for indirect draws after it.
+    ////////////////////////////////////////////////////////////
+    void RecordCulling( const VkCommandBuffer commandBuffer, const uint32_t imageIndex )
+    {
+        const ComputeKernel& kernel = m_ComputeKernels[m_CullingKernel];
+
+        m_GraphicsProfiler.BeginScope( commandBuffer, imageIndex, "culling" );
+
+        // Clear the draw count, the previous submission of the command buffer has completed.
+        vkCmdFillBuffer( commandBuffer, m_CullingDrawBuffers[imageIndex], 0, sizeof( uint32_t ), 0 );
+
+        VkMemoryBarrier barrier = {};
+        barrier.sType           = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask   = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask   = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+        vkCmdPipelineBarrier( commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr );
+
+        CullingConstants constants = {};
+        constants.m_ClusterCount   = m_CullingClusterCount;
+
+        vkCmdBindPipeline( commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, kernel.m_Pipeline );
+        vkCmdBindDescriptorSets( commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, kernel.m_PipelineLayout, 0, 1, &m_CullingDescriptorSets[imageIndex], 0, nullptr );
+        vkCmdPushConstants( commandBuffer, kernel.m_PipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof( constants ), &constants );
+        vkCmdDispatch( commandBuffer, m_CullingDispatchSize[0], m_CullingDispatchSize[1], m_CullingDispatchSize[2] );
+
+        // Compacted draws and their count are read by the indirect draw.
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+
+        vkCmdPipelineBarrier( commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr );
+
+        m_GraphicsProfiler.EndScope( commandBuffer, imageIndex );
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Creates device local buffer filled with the given data.
+    ////////////////////////////////////////////////////////////
+    StatusCode CreateDeviceLocalBuffer(
+        const void*                        sourceData,
+        const VkDeviceSize                 bufferSize,
+        const VkBufferUsageFlags           usage,
+        const VkPipelineStageFlags         dstStage,
+        const VkAccessFlags                dstAccess,
+        VkBuffer&                          buffer,
+        std::pair<uint32_t, VkDeviceSize>& bufferGpuMemoryOffsets )
+    {
+        StatusCode result = StatusCode::Success;
+
+        // Write directly to device local memory if the host can see all of it.
+        if( m_IsDeviceLocalMemoryHostVisible )
+        {
+            result = CreateBuffer(
+                bufferSize,
+                usage,
+                { VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT },
+                0,
+                nullptr,
+                buffer,
+                bufferGpuMemoryOffsets );
+
+            if( result == StatusCode::Success )
+            {
+                memcpy_s( GetMappedGpuMemory( bufferGpuMemoryOffsets ), bufferSize, sourceData, bufferSize );
+                return StatusCode::Success;
+            }
+
+            // Host visible device local heap is exhausted, fall back to staging.
+        }
+
+        result = CreateBuffer(
+            bufferSize,
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT | usage,
+            { VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT },
+            0,
+            nullptr,
+            buffer,
+            bufferGpuMemoryOffsets );
+
+        if( result != StatusCode::Success )
+        {
+            return StatusCode::Fail;
+        }
+
+        // Copy data through the staging ring buffer to device local buffer.
+        return UploadBuffer( sourceData, bufferSize, buffer, m_QueueFamilyIndices.m_GraphicsFamily, dstStage, dstAccess );
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Creates staging ring buffer used by all uploads.
+    ////////////////////////////////////////////////////////////
+    StatusCode CreateStagingRingBuffer()
+    {
+        m_StagingRingBuffer.m_Size      = StagingRingBufferSize;
+        m_StagingRingBuffer.m_Alignment = std::max<VkDeviceSize>( m_PhysicalDeviceProperties.limits.optimalBufferCopyOffsetAlignment, 16 );
+
+        const StatusCode result = CreateBuffer(
+            m_StagingRingBuffer.m_Size,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            { VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 0, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT },
+            0,
+            nullptr,
+            m_StagingRingBuffer.m_Buffer,
+            m_StagingRingBuffer.m_GpuMemoryOffsets );
+
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Cannot create buffer for staging ring buffer!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        m_StagingRingBuffer.m_MappedData = static_cast<uint8_t*>( GetMappedGpuMemory( m_StagingRingBuffer.m_GpuMemoryOffsets ) );
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Creates uniform buffers.
+    ////////////////////////////////////////////////////////////
+    StatusCode CreateUniformBuffers()
+    {
+        const uint32_t swapChainImageCount = static_cast<uint32_t>( m_SwapChainImages.size() );
+
+        // One region per swap chain image, big enough for many per-object uniforms.
+        // The culling kernel reads regions as storage buffers, so they are aligned for both.
+        m_UniformRingBuffer.m_Alignment = std::max(
+            m_PhysicalDeviceProperties.limits.minUniformBufferOffsetAlignment,
+            m_PhysicalDeviceProperties.limits.minStorageBufferOffsetAlignment );
+        m_UniformRingBuffer.m_RegionSize = GpuMemoryBlock::AlignUp( sizeof( UniformBufferObject ), m_UniformRingBuffer.m_Alignment ) * MaxUniformsPerFrame;
+
+        const StatusCode result = CreateBuffer(
+            m_UniformRingBuffer.m_RegionSize * swapChainImageCount,
+            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            { VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT },
+            0,
+            nullptr,
+            m_UniformRingBuffer.m_Buffer,
+            m_UniformRingBuffer.m_GpuMemoryOffsets );
+
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Cannot create buffer for uniform buffer!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        m_UniformRingBuffer.m_MappedData = static_cast<uint8_t*>( GetMappedGpuMemory( m_UniformRingBuffer.m_GpuMemoryOffsets ) );
+
+        // The uniforms of a frame are pushed first, to the start of the region of its image.
+        m_UniformDynamicOffsets.resize( swapChainImageCount );
+
+        for( uint32_t i = 0; i < swapChainImageCount; ++i )
+        {
+            m_UniformDynamicOffsets[i] = static_cast<uint32_t>( m_UniformRingBuffer.GetRegionOffset( i ) );
+        }
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Creates compute buffers.
+    ////////////////////////////////////////////////////////////
+    StatusCode CreateComputeBuffers()
+    {
+        m_NumbersA = new float[m_VectorElementCount];
+        m_NumbersB = new float[m_VectorElementCount];
+        m_Results  = new float[m_VectorElementCount];
+
+        std::random_device                     rand_dev;
+        std::mt19937                           generator( rand_dev() );
+        std::uniform_int_distribution<int32_t> distr( 1, 1000 );
+
+        for( uint32_t i = 0; i < m_VectorElementCount; ++i )
+        {
+            m_NumbersA[i] = static_cast<float>( distr( generator ) ) / distr( generator );
+            m_NumbersB[i] = static_cast<float>( distr( generator ) ) / distr( generator );
+            m_Results[i]  = m_NumbersA[i] * m_NumbersB[i];
+        }
+
+        m_ComputeBuffers.resize( 3 );
+        m_ComputeBuffersGpuMemoryOffsets.resize( 3 );
+
+        // On discrete gpus host visible buffers would be accessed across the bus by every dispatch.
+        m_IsComputeBufferDeviceLocal =
+            m_Settings.m_ComputeBufferMode == ComputeBufferMode::DeviceLocal ||
+            ( m_Settings.m_ComputeBufferMode == ComputeBufferMode::Auto && !m_IsDeviceLocalMemoryHostVisible );
+
+        const GpuMemoryPreferences computeMemoryPreferences =
+            m_IsComputeBufferDeviceLocal
+                ? GpuMemoryPreferences( VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT )
+                : GpuMemoryPreferences( VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+
+        for( uint32_t i = 0; i < m_ComputeBuffers.size(); ++i )
+        {
+            const StatusCode result = CreateBuffer(
+                m_VectorElementCount * sizeof( float ),
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                computeMemoryPreferences,
+                1,
+                &m_QueueFamilyIndices.m_ComputeFamily,
+                m_ComputeBuffers[i],
+                m_ComputeBuffersGpuMemoryOffsets[i] );
+
+            if( result != StatusCode::Success )
+            {
+                std::cerr << "Cannot create buffer for compute buffer!" << std::endl;
+                return StatusCode::Fail;
+            }
+
+            RegisterMovableBuffer(
+                m_ComputeBuffers[i],
+                m_ComputeBuffersGpuMemoryOffsets[i],
+                m_VectorElementCount * sizeof( float ),
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                GpuResourceOwner::Compute );
+
+            if( m_IsComputeBufferDeviceLocal )
+            {
+                continue;
+            }
+
+            // Copy random float numbers to the buffer.
+            void* data = GetMappedGpuMemory( m_ComputeBuffersGpuMemoryOffsets[i] );
+
+            switch( i )
+            {
+                case 0:
+                    memcpy( data, m_NumbersA, m_VectorElementCount * sizeof( float ) );
+                    break;
+
+                case 1:
+                    memcpy( data, m_NumbersB, m_VectorElementCount * sizeof( float ) );
+                    break;
+
+                default:
+                    // Do nothing.
+                    break;
+            }
+        }
+
+        if( m_IsComputeBufferDeviceLocal && UploadComputeBuffers() != StatusCode::Success )
+        {
+            std::cerr << "Cannot upload compute buffers!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        // Results are copied to readback buffers, so the host never reads a buffer the gpu may write.
+        // Cached memory makes the verification read fast.
+        m_ComputeReadbackBuffers.resize( m_ComputeReadbackCount );
+        m_ComputeReadbackBuffersGpuMemoryOffsets.resize( m_ComputeReadbackCount );
+        m_IsComputeResultPending.resize( m_ComputeReadbackCount, false );
+        m_IsComputeReadbackSubmitted.resize( m_ComputeReadbackCount, false );
+        m_ComputeVerifications.resize( m_ComputeReadbackCount );
+
+        for( uint32_t i = 0; i < m_ComputeReadbackCount; ++i )
+        {
+            const StatusCode result = CreateBuffer(
+                m_VectorElementCount * sizeof( float ),
+                VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                { VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_MEMORY_PROPERTY_HOST_CACHED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT },
+                1,
+                &m_QueueFamilyIndices.m_ComputeFamily,
+                m_ComputeReadbackBuffers[i],
+                m_ComputeReadbackBuffersGpuMemoryOffsets[i] );
+
+            if( result != StatusCode::Success )
+            {
+                std::cerr << "Cannot create buffer for compute readback buffer!" << std::endl;
+                return StatusCode::Fail;
+            }
+        }
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Uploads the compute inputs to device local buffers on the copy queue
+    /// and acquires them on the compute queue.
+    ////////////////////////////////////////////////////////////
+    StatusCode UploadComputeBuffers()
+    {
+        const std::array<const float*, 2> inputs = { m_NumbersA, m_NumbersB };
+
+        for( uint32_t i = 0; i < inputs.size(); ++i )
+        {
+            if( UploadBuffer( inputs[i], m_VectorElementCount * sizeof( float ), m_ComputeBuffers[i], m_QueueFamilyIndices.m_ComputeFamily, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT ) != StatusCode::Success )
+            {
+                return StatusCode::Fail;
+            }
+        }
+
+        if( SubmitUploadBatch() != StatusCode::Success )
+        {
+            return StatusCode::Fail;
+        }
+
+        return AcquireUploadedComputeBuffers( { m_ComputeBuffers[0], m_ComputeBuffers[1] } );
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Acquires buffers uploaded on the copy queue on the compute queue.
+    /// The host waits, so later dispatches need no waits on the copy queue.
+    ////////////////////////////////////////////////////////////
+    StatusCode AcquireUploadedComputeBuffers( const std::vector<VkBuffer>& buffers )
+    {
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+
+        if( BeginOneTimeCommandBuffer( m_CommandPoolCompute, commandBuffer ) != StatusCode::Success )
+        {
+            return StatusCode::Fail;
+        }
+
+        if( m_QueueFamilyIndices.m_CopyFamily != m_QueueFamilyIndices.m_ComputeFamily )
+        {
+            std::vector<VkBufferMemoryBarrier> barriers( buffers.size() );
+
+            for( uint32_t i = 0; i < barriers.size(); ++i )
+            {
+                barriers[i].sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+                barriers[i].srcAccessMask       = 0;
+                barriers[i].dstAccessMask       = VK_ACCESS_SHADER_READ_BIT;
+                barriers[i].srcQueueFamilyIndex = m_QueueFamilyIndices.m_CopyFamily;
+                barriers[i].dstQueueFamilyIndex = m_QueueFamilyIndices.m_ComputeFamily;
+                barriers[i].buffer              = buffers[i];
+                barriers[i].offset              = 0;
+                barriers[i].size                = VK_WHOLE_SIZE;
+            }
+
+            // Acquire.
+            vkCmdPipelineBarrier( commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, static_cast<uint32_t>( barriers.size() ), barriers.data(), 0, nullptr );
+        }
+
+        // The acquire waits for the copies.
+        const std::vector<GpuSemaphoreWait> waits = { { m_CopyTimeline.m_Semaphore, m_CopyTimeline.m_Value, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT } };
+
+        return SubmitOneTimeCommandBuffer( m_ComputeQueue, m_CommandPoolCompute, waits, m_ComputeTimeline, commandBuffer );
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Ends and submits a one time command buffer, waits for it and frees it.
+    ////////////////////////////////////////////////////////////
+    StatusCode SubmitOneTimeCommandBuffer(
+        const VkQueue                        queue,
+        const VkCommandPool                  commandPool,
+        const std::vector<GpuSemaphoreWait>& waits,
+        GpuTimeline&                         timeline,
+        const VkCommandBuffer                commandBuffer )
+    {
+        vkEndCommandBuffer( commandBuffer );
+
+        uint64_t         timelineValue = 0;
+        const StatusCode result        = SubmitCommandBuffer( queue, commandBuffer, waits, timeline, VK_NULL_HANDLE, timelineValue );
+
+        if( result == StatusCode::Success )
+        {
+            WaitForTimelineValue( timeline, timelineValue );
+        }
+        else
+        {
+            std::cerr << "Failed to submit one time command buffer!" << std::endl;
+        }
+
+        vkFreeCommandBuffers( m_Device, commandPool, 1, &commandBuffer );
+
+        return result;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Returns the number of descriptor bindings of a spir-v module, zero if it is not valid.
+    ////////////////////////////////////////////////////////////
+    static uint32_t GetSpirvBindingCount( const std::vector<char>& code )
+    {
+        constexpr uint32_t SpirvMagicNumber       = 0x07230203;
+        constexpr uint32_t SpirvHeaderWordCount   = 5;
+        constexpr uint32_t SpirvOpDecorate        = 71;
+        constexpr uint32_t SpirvDecorationBinding = 33;
+
+        std::vector<uint32_t> words( code.size() / sizeof( uint32_t ) );
+        memcpy( words.data(), code.data(), words.size() * sizeof( uint32_t ) );
+
+        if( words.size() < SpirvHeaderWordCount || words[0] != SpirvMagicNumber )
+        {
+            return 0;
+        }
+
+        uint32_t bindingCount = 0;
+
+        // The high half of the first word of an instruction is its word count, the low half is its opcode.
+        for( size_t i = SpirvHeaderWordCount; i < words.size(); )
+        {
+            const uint32_t wordCount = words[i] >> 16;
+            const uint32_t opcode    = words[i] & 0xFFFF;
+
+            if( wordCount == 0 || i + wordCount > words.size() )
+            {
+                return 0;
+            }
+
+            // OpDecorate target Binding number.
+            if( opcode == SpirvOpDecorate && wordCount >= 4 && words[i + 2] == SpirvDecorationBinding )
+            {
+                bindingCount = std::max( bindingCount, words[i + 3] + 1 );
+            }
+
+            i += wordCount;
+        }
+
+        return bindingCount;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Creates the descriptor set layout, the pipeline layout and the pipeline of a compute kernel.
+    ////////////////////////////////////////////////////////////
+    StatusCode CreateComputeKernelPipeline( const std::vector<char>& code, ComputeKernel& kernel )
+    {
+        std::vector<VkDescriptorSetLayoutBinding> layoutBindings( kernel.m_BindingCount );
+
+        for( uint32_t i = 0; i < kernel.m_BindingCount; ++i )
+        {
+            layoutBindings[i].binding         = i;
+            layoutBindings[i].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            layoutBindings[i].descriptorCount = 1;
+            layoutBindings[i].stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT;
+        }
+
+        VkDescriptorSetLayoutCreateInfo setLayoutCreateInfo = {};
+        setLayoutCreateInfo.sType                           = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        setLayoutCreateInfo.bindingCount                    = static_cast<uint32_t>( layoutBindings.size() );
+        setLayoutCreateInfo.pBindings                       = layoutBindings.data();
+
+        if( vkCreateDescriptorSetLayout( m_Device, &setLayoutCreateInfo, nullptr, &kernel.m_DescriptorSetLayout ) != VK_SUCCESS )
+        {
+            return StatusCode::Fail;
+        }
+
+        VkPushConstantRange pushConstantRange = {};
+        pushConstantRange.stageFlags          = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset              = 0;
+        pushConstantRange.size                = kernel.m_PushConstantSize;
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+        pipelineLayoutInfo.sType                      = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount             = 1;
+        pipelineLayoutInfo.pSetLayouts                = &kernel.m_DescriptorSetLayout;
+        pipelineLayoutInfo.pushConstantRangeCount     = kernel.m_PushConstantSize != 0 ? 1 : 0;
+        pipelineLayoutInfo.pPushConstantRanges        = &pushConstantRange;
+
+        if( vkCreatePipelineLayout( m_Device, &pipelineLayoutInfo, nullptr, &kernel.m_PipelineLayout ) != VK_SUCCESS )
+        {
+            return StatusCode::Fail;
+        }
+
+        VkShaderModule shaderModule = CreateShaderModule( code );
+
+        if( shaderModule == VK_NULL_HANDLE )
+        {
+            return StatusCode::Fail;
+        }
+
+        // Kernels share the workgroup size of the vector multiply.
+        VkSpecializationMapEntry specializationEntry = {};
+        specializationEntry.constantID               = 0;
+        specializationEntry.offset                   = 0;
+        specializationEntry.size                     = sizeof( uint32_t );
+
+        VkSpecializationInfo specializationInfo = {};
+        specializationInfo.mapEntryCount        = 1;
+        specializationInfo.pMapEntries          = &specializationEntry;
+        specializationInfo.dataSize             = sizeof( uint32_t );
+        specializationInfo.pData                = &m_ComputeWorkgroupSize;
+
+        VkComputePipelineCreateInfo pipelineCreateInfo = {};
+        pipelineCreateInfo.sType                       = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineCreateInfo.stage.sType                 = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipelineCreateInfo.stage.stage                 = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipelineCreateInfo.stage.module                = shaderModule;
+        pipelineCreateInfo.stage.pName                 = "main";
+        pipelineCreateInfo.stage.pSpecializationInfo   = &specializationInfo;
+        pipelineCreateInfo.layout                      = kernel.m_PipelineLayout;
+
+        const VkResult result = vkCreateComputePipelines( m_Device, VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &kernel.m_Pipeline );
+
+        vkDestroyShaderModule( m_Device, shaderModule, nullptr );
+
+        return result == VK_SUCCESS ? StatusCode::Success : StatusCode::Fail;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Destroys the pipeline and the layouts of a compute kernel.
+    ////////////////////////////////////////////////////////////
+    void DestroyComputeKernel( ComputeKernel& kernel )
+    {
+        vkDestroyPipeline( m_Device, kernel.m_Pipeline, nullptr );
+        vkDestroyPipelineLayout( m_Device, kernel.m_PipelineLayout, nullptr );
+        vkDestroyDescriptorSetLayout( m_Device, kernel.m_DescriptorSetLayout, nullptr );
+
+        kernel = {};
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Creates the descriptor pool of compute jobs.
+    ////////////////////////////////////////////////////////////
+    StatusCode CreateComputeJobDescriptorPool()
+    {
+        VkDescriptorPoolSize poolSize = {};
+        poolSize.type                 = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        poolSize.descriptorCount      = MaxComputeJobsInFlight * MaxComputeKernelBindings;
+
+        VkDescriptorPoolCreateInfo poolInfo = {};
+        poolInfo.sType                      = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.flags                      = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+        poolInfo.maxSets                    = MaxComputeJobsInFlight;
+        poolInfo.poolSizeCount              = 1;
+        poolInfo.pPoolSizes                 = &poolSize;
+
+        if( vkCreateDescriptorPool( m_Device, &poolInfo, nullptr, &m_ComputeJobDescriptorPool ) != VK_SUCCESS )
+        {
+            std::cerr << "Cannot create compute job descriptor pool!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Allocates a descriptor set of a compute job, waits for earlier jobs if the pool is full.
+    ////////////////////////////////////////////////////////////
+    StatusCode AllocateComputeJobDescriptorSet( const ComputeKernel& kernel, VkDescriptorSet& descriptorSet )
+    {
+        VkDescriptorSetAllocateInfo allocationInfo = {};
+        allocationInfo.sType                       = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocationInfo.descriptorPool              = m_ComputeJobDescriptorPool;
+        allocationInfo.descriptorSetCount          = 1;
+        allocationInfo.pSetLayouts                 = &kernel.m_DescriptorSetLayout;
 
-        // Find all needed queue families.
-        uint32_t index = 0;
-        for( const auto& queueFamily : queueFamilies )
+        ReleaseCompletedComputeJobs();
+
+        while( vkAllocateDescriptorSets( m_Device, &allocationInfo, &descriptorSet ) != VK_SUCCESS )
         {
-            // Graphics queue family.
-            if( queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT &&
-                !indices.m_HasGraphicsFamily )
+            if( m_ComputeJobSubmissions.empty() )
             {
-                indices.m_GraphicsFamily    = index;
-                indices.m_HasGraphicsFamily = true;
-                indices.m_GraphicsCount     = queueFamily.queueCount;
+                std::cerr << "Cannot allocate compute job descriptor set!" << std::endl;
+                return StatusCode::Fail;
             }
 
-            // Compute queue family (explicitly).
-            if( queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT &&
-                !( queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT ) &&
-                !indices.m_HasComputeFamily )
+            WaitForTimelineValue( m_ComputeTimeline, m_ComputeJobSubmissions.front().m_TimelineValue );
+            ReleaseCompletedComputeJobs();
+        }
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Checks that the kernel, the buffers and the push constants of the job match.
+    ////////////////////////////////////////////////////////////
+    StatusCode ValidateComputeJob( const ComputeJob& job ) const
+    {
+        if( job.m_Kernel >= m_ComputeKernels.size() || m_ComputeKernels[job.m_Kernel].m_Pipeline == VK_NULL_HANDLE )
+        {
+            std::cerr << "Compute job has no valid kernel!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        const ComputeKernel& kernel = m_ComputeKernels[job.m_Kernel];
+
+        if( job.m_Buffers.size() != kernel.m_BindingCount || job.m_PushConstants.size() != kernel.m_PushConstantSize )
+        {
+            std::cerr << "Compute job does not match the layout of its kernel!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        for( const uint32_t buffer : job.m_Buffers )
+        {
+            if( buffer >= m_ComputeJobBuffers.size() || m_ComputeJobBuffers[buffer].m_Buffer == VK_NULL_HANDLE )
             {
-                indices.m_ComputeFamily    = index;
-                indices.m_HasComputeFamily = true;
-                indices.m_ComputeCount     = queueFamily.queueCount;
+                std::cerr << "Compute job uses a destroyed buffer!" << std::endl;
+                return StatusCode::Fail;
             }
+        }
 
-            // Memory transfer queue family (explicitly).
-            if( queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT &&
-                !( queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT ) &&
-                !( queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT ) &&
-                !indices.m_HasCopyFamily )
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Starts the thread completing compute jobs, the compute timeline must exist.
+    ////////////////////////////////////////////////////////////
+    void StartComputeJobWaiter()
+    {
+        m_IsComputeJobWaiterStopping = false;
+        m_ComputeJobWaiter           = std::thread( [this]() { WaitForComputeJobs(); } );
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Stops the thread completing compute jobs once all submitted jobs are completed.
+    ////////////////////////////////////////////////////////////
+    void StopComputeJobWaiter()
+    {
+        if( !m_ComputeJobWaiter.joinable() )
+        {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock( m_ComputeJobMutex );
+            m_IsComputeJobWaiterStopping = true;
+        }
+
+        m_ComputeJobCondition.notify_one();
+        m_ComputeJobWaiter.join();
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Completes compute jobs on the waiter thread.
+    /// Timeline values grow with submissions, so only the oldest job is waited for.
+    ////////////////////////////////////////////////////////////
+    void WaitForComputeJobs()
+    {
+        std::unique_lock<std::mutex> lock( m_ComputeJobMutex );
+
+        while( true )
+        {
+            m_ComputeJobCondition.wait( lock, [this]() { return m_IsComputeJobWaiterStopping || !m_ComputeJobCompletions.empty(); } );
+
+            // Stopping waits for the pending jobs first, their futures may still be waited for.
+            if( m_ComputeJobCompletions.empty() )
             {
-                indices.m_CopyFamily    = index;
-                indices.m_HasCopyFamily = true;
-                indices.m_CopyCount     = queueFamily.queueCount;
+                return;
             }
 
-            // Present queue family.
-            if( !indices.m_HasPresentFamily )
+            const uint64_t timelineValue = m_ComputeJobCompletions.front().first;
+
+            lock.unlock();
+            WaitForTimelineValue( m_ComputeTimeline, timelineValue );
+            lock.lock();
+
+            m_ComputeJobCompletions.front().second.set_value( StatusCode::Success );
+            m_ComputeJobCompletions.pop_front();
+        }
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Releases command buffers and descriptor sets of completed compute jobs.
+    ////////////////////////////////////////////////////////////
+    void ReleaseCompletedComputeJobs()
+    {
+        auto submission = m_ComputeJobSubmissions.begin();
+
+        while( submission != m_ComputeJobSubmissions.end() )
+        {
+            if( !IsTimelineValueReached( m_ComputeTimeline, submission->m_TimelineValue ) )
             {
-                VkBool32 presentSupported = false;
-                vkGetPhysicalDeviceSurfaceSupportKHR( physicalDevice, index, m_Surface, &presentSupported );
-                if( presentSupported )
-                {
-                    indices.m_PresentFamily    = index;
-                    indices.m_HasPresentFamily = true;
-                    indices.m_PresentCount     = queueFamily.queueCount;
-                }
+                ++submission;
+                continue;
             }
 
-            ++index;
+            vkFreeCommandBuffers( m_Device, m_CommandPoolCompute, 1, &submission->m_CommandBuffer );
+            vkFreeDescriptorSets( m_Device, m_ComputeJobDescriptorPool, 1, &submission->m_DescriptorSet );
+
+            submission = m_ComputeJobSubmissions.erase( submission );
+        }
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Creates a compute job buffer, device local buffers are filled through the staging ring buffer.
+    /// Job buffers are not registered for defragmentation, handles keep their buffers.
+    ////////////////////////////////////////////////////////////
+    StatusCode CreateComputeJobBuffer( const VkDeviceSize size, const void* data, uint32_t& buffer )
+    {
+        ComputeJobBuffer jobBuffer = {};
+        jobBuffer.m_Size           = size;
+        jobBuffer.m_IsDeviceLocal  = m_IsComputeBufferDeviceLocal;
+
+        const GpuMemoryPreferences memoryPreferences =
+            jobBuffer.m_IsDeviceLocal
+                ? GpuMemoryPreferences( VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT )
+                : GpuMemoryPreferences( VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+
+        const StatusCode result = CreateBuffer(
+            size,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            memoryPreferences,
+            1,
+            &m_QueueFamilyIndices.m_ComputeFamily,
+            jobBuffer.m_Buffer,
+            jobBuffer.m_GpuMemoryOffsets );
+
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Cannot create compute job buffer!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        buffer = static_cast<uint32_t>( m_ComputeJobBuffers.size() );
+        m_ComputeJobBuffers.emplace_back( jobBuffer );
+
+        if( data == nullptr )
+        {
+            return StatusCode::Success;
+        }
+
+        if( !jobBuffer.m_IsDeviceLocal )
+        {
+            memcpy( GetMappedGpuMemory( jobBuffer.m_GpuMemoryOffsets ), data, static_cast<size_t>( size ) );
+            return StatusCode::Success;
+        }
+
+        if( UploadBuffer( data, size, jobBuffer.m_Buffer, m_QueueFamilyIndices.m_ComputeFamily, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT ) != StatusCode::Success )
+        {
+            return StatusCode::Fail;
+        }
+
+        if( SubmitUploadBatch() != StatusCode::Success )
+        {
+            return StatusCode::Fail;
+        }
+
+        return AcquireUploadedComputeBuffers( { jobBuffer.m_Buffer } );
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Reads a compute job buffer, device local buffers are copied to a temporary readback buffer.
+    ////////////////////////////////////////////////////////////
+    StatusCode ReadComputeJobBuffer( const uint32_t buffer, void* data, const VkDeviceSize size )
+    {
+        const ComputeJobBuffer& jobBuffer = m_ComputeJobBuffers[buffer];
+
+        if( jobBuffer.m_Buffer == VK_NULL_HANDLE || size > jobBuffer.m_Size )
+        {
+            return StatusCode::Fail;
+        }
+
+        if( !jobBuffer.m_IsDeviceLocal )
+        {
+            memcpy( data, GetMappedGpuMemory( jobBuffer.m_GpuMemoryOffsets ), static_cast<size_t>( size ) );
+            return StatusCode::Success;
+        }
+
+        VkBuffer                          readbackBuffer                 = VK_NULL_HANDLE;
+        std::pair<uint32_t, VkDeviceSize> readbackBufferGpuMemoryOffsets = {};
+
+        StatusCode result = CreateBuffer(
+            size,
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            { VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_MEMORY_PROPERTY_HOST_CACHED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT },
+            1,
+            &m_QueueFamilyIndices.m_ComputeFamily,
+            readbackBuffer,
+            readbackBufferGpuMemoryOffsets );
+
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+
+        if( result == StatusCode::Success )
+        {
+            result = BeginOneTimeCommandBuffer( m_CommandPoolCompute, commandBuffer );
+        }
+
+        if( result == StatusCode::Success )
+        {
+            // Jobs submitted earlier to the compute queue are done writing.
+            VkMemoryBarrier barrier = {};
+            barrier.sType           = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            barrier.srcAccessMask   = VK_ACCESS_SHADER_WRITE_BIT;
+            barrier.dstAccessMask   = VK_ACCESS_TRANSFER_READ_BIT;
+
+            vkCmdPipelineBarrier( commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr );
+
+            VkBufferCopy copyRegion = {};
+            copyRegion.size         = size;
+
+            vkCmdCopyBuffer( commandBuffer, jobBuffer.m_Buffer, readbackBuffer, 1, &copyRegion );
+
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+            vkCmdPipelineBarrier( commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr );
+
+            result = SubmitOneTimeCommandBuffer( m_ComputeQueue, m_CommandPoolCompute, {}, m_ComputeTimeline, commandBuffer );
+        }
+
+        if( result == StatusCode::Success )
+        {
+            memcpy( data, GetMappedGpuMemory( readbackBufferGpuMemoryOffsets ), static_cast<size_t>( size ) );
+        }
+        else
+        {
+            std::cerr << "Cannot read back compute job buffer!" << std::endl;
+        }
+
+        DestroyBuffer( readbackBuffer, readbackBufferGpuMemoryOffsets );
+
+        return result;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Creates descriptor pool.
+    ////////////////////////////////////////////////////////////
+    StatusCode CreateDescriptorPool()
+    {
+        const uint32_t                      descriptorCount = static_cast<uint32_t>( m_SwapChainImages.size() );
+        std::array<VkDescriptorPoolSize, 3> poolSizes       = {};
+        VkDescriptorPoolCreateInfo          poolInfo        = {};
+
+        // For uniform.
+        poolSizes[0].type            = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        poolSizes[0].descriptorCount = descriptorCount;
+
+        // For sampler.
+        poolSizes[1].type            = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        poolSizes[1].descriptorCount = descriptorCount;
+
+        // For culling, uniform region, clusters and draws.
+        poolSizes[2].type            = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        poolSizes[2].descriptorCount = descriptorCount * 3;
+
+        poolInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.poolSizeCount = static_cast<uint32_t>( poolSizes.size() );
+        poolInfo.pPoolSizes    = poolSizes.data();
+        poolInfo.maxSets       = descriptorCount * 2;
+        poolInfo.flags         = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+
+        if( vkCreateDescriptorPool( m_Device, &poolInfo, nullptr, &m_DescriptorPool ) != VK_SUCCESS )
+        {
+            std::cerr << "Cannot create descriptor pool!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        // For compute.
+        VkDescriptorPoolSize computePoolSize = {};
+        computePoolSize.type                 = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        computePoolSize.descriptorCount      = 3 * m_ComputeReadbackCount;
+
+        poolInfo.poolSizeCount = 1;
+        poolInfo.pPoolSizes    = &computePoolSize;
+        poolInfo.maxSets       = m_ComputeReadbackCount;
+
+        if( vkCreateDescriptorPool( m_Device, &poolInfo, nullptr, &m_ComputeDescriptorPool ) != VK_SUCCESS )
+        {
+            std::cerr << "Cannot create compute descriptor pool!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Creates descriptor sets.
+    ////////////////////////////////////////////////////////////
+    StatusCode CreateDescriptorSets()
+    {
+        // For graphics.
+        const uint32_t                     descriptorSetCount = static_cast<uint32_t>( m_SwapChainImages.size() );
+        VkDescriptorSetAllocateInfo        allocationInfo     = {};
+        std::vector<VkDescriptorSetLayout> layouts( descriptorSetCount, m_DescriptorSetLayout );
+
+        allocationInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocationInfo.descriptorPool     = m_DescriptorPool;
+        allocationInfo.descriptorSetCount = descriptorSetCount;
+        allocationInfo.pSetLayouts        = layouts.data();
+
+        m_DescriptorSets.resize( descriptorSetCount );
+
+        if( vkAllocateDescriptorSets( m_Device, &allocationInfo, m_DescriptorSets.data() ) != VK_SUCCESS )
+        {
+            std::cerr << "Cannot allocate descriptor sets!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        // For culling.
+        if( IsGpuCullingEnabled() )
+        {
+            layouts.assign( descriptorSetCount, m_ComputeKernels[m_CullingKernel].m_DescriptorSetLayout );
+
+            allocationInfo.pSetLayouts = layouts.data();
+
+            m_CullingDescriptorSets.resize( descriptorSetCount );
+
+            if( vkAllocateDescriptorSets( m_Device, &allocationInfo, m_CullingDescriptorSets.data() ) != VK_SUCCESS )
+            {
+                std::cerr << "Cannot allocate culling descriptor sets!" << std::endl;
+                return StatusCode::Fail;
+            }
+        }
+
+        // For compute.
+        layouts.assign( m_ComputeReadbackCount, m_ComputeDescriptorSetLayout );
+
+        allocationInfo.descriptorPool     = m_ComputeDescriptorPool;
+        allocationInfo.descriptorSetCount = m_ComputeReadbackCount;
+        allocationInfo.pSetLayouts        = layouts.data();
+
+        m_ComputeDescriptorSets.resize( m_ComputeReadbackCount );
+
+        if( vkAllocateDescriptorSets( m_Device, &allocationInfo, m_ComputeDescriptorSets.data() ) != VK_SUCCESS )
+        {
+            std::cerr << "Cannot allocate compute descriptor sets!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        UpdateDescriptorSets();
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Writes resources to descriptor sets.
+    ////////////////////////////////////////////////////////////
+    void UpdateDescriptorSets()
+    {
+        for( uint32_t i = 0; i < m_DescriptorSets.size(); ++i )
+        {
+            UpdateGraphicsDescriptorSets( i );
         }
 
-        return indices;
+        for( uint32_t i = 0; i < m_ComputeDescriptorSets.size(); ++i )
+        {
+            UpdateComputeDescriptorSet( i );
+        }
     }
 
     ////////////////////////////////////////////////////////////
-    /// Finds a given supported format.
+    /// Writes resources to the graphics and culling descriptor sets of a swap chain image.
     ////////////////////////////////////////////////////////////
-    VkFormat FindSupportedFormat(
-        const std::vector<VkFormat>& candidates,
-        const VkImageTiling          tiling,
-        const VkFormatFeatureFlags   features )
+    void UpdateGraphicsDescriptorSets( const uint32_t imageIndex )
     {
-        // List of candidate formats in order from most desirable to least desirable.
-        for( VkFormat format : candidates )
+        // For graphics.
+        VkDescriptorBufferInfo bufferInfo = {};
+
+        bufferInfo.buffer = m_UniformRingBuffer.m_Buffer;
+        bufferInfo.offset = 0;
+        bufferInfo.range  = sizeof( UniformBufferObject );
+
+        VkDescriptorImageInfo imageInfo = {};
+
+        imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        imageInfo.imageView   = m_TextureImageView;
+        imageInfo.sampler     = m_TextureSampler;
+
+        std::array<VkWriteDescriptorSet, 2> descriptorWrites = {};
+
+        descriptorWrites[0].sType            = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[0].dstSet           = m_DescriptorSets[imageIndex];
+        descriptorWrites[0].dstBinding       = 0;
+        descriptorWrites[0].dstArrayElement  = 0;
+        descriptorWrites[0].descriptorType   = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        descriptorWrites[0].descriptorCount  = 1;
+        descriptorWrites[0].pBufferInfo      = &bufferInfo;
+        descriptorWrites[0].pImageInfo       = nullptr; // Optional.
+        descriptorWrites[0].pTexelBufferView = nullptr; // Optional.
+
+        descriptorWrites[1].sType            = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[1].dstSet           = m_DescriptorSets[imageIndex];
+        descriptorWrites[1].dstBinding       = 1;
+        descriptorWrites[1].dstArrayElement  = 0;
+        descriptorWrites[1].descriptorType   = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        descriptorWrites[1].descriptorCount  = 1;
+        descriptorWrites[1].pBufferInfo      = nullptr; // Optional.
+        descriptorWrites[1].pImageInfo       = &imageInfo;
+        descriptorWrites[1].pTexelBufferView = nullptr; // Optional.
+
+        vkUpdateDescriptorSets(
+            m_Device,
+            static_cast<uint32_t>( descriptorWrites.size() ),
+            descriptorWrites.data(),
+            0,
+            nullptr );
+
+        // For culling, the uniforms of the image are read as a storage buffer.
+        if( imageIndex < m_CullingDescriptorSets.size() )
         {
-            VkFormatProperties props = {};
-            vkGetPhysicalDeviceFormatProperties( m_PhysicalDevice, format, &props );
+            std::array<VkDescriptorBufferInfo, 3> bufferInfos = {};
 
-            if( tiling == VK_IMAGE_TILING_LINEAR && ( props.linearTilingFeatures & features ) == features )
-            {
-                return format;
-            }
-            else if( tiling == VK_IMAGE_TILING_OPTIMAL && ( props.optimalTilingFeatures & features ) == features )
+            bufferInfos[0].buffer = m_UniformRingBuffer.m_Buffer;
+            bufferInfos[0].offset = m_UniformDynamicOffsets[imageIndex];
+            bufferInfos[0].range  = sizeof( UniformBufferObject );
+
+            bufferInfos[1].buffer = m_CullingClusterBuffer;
+            bufferInfos[1].offset = 0;
+            bufferInfos[1].range  = VK_WHOLE_SIZE;
+
+            bufferInfos[2].buffer = m_CullingDrawBuffers[imageIndex];
+            bufferInfos[2].offset = 0;
+            bufferInfos[2].range  = VK_WHOLE_SIZE;
+
+            std::array<VkWriteDescriptorSet, 3> cullingWrites = {};
+
+            for( uint32_t binding = 0; binding < cullingWrites.size(); ++binding )
             {
-                return format;
+                cullingWrites[binding].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                cullingWrites[binding].dstSet          = m_CullingDescriptorSets[imageIndex];
+                cullingWrites[binding].dstBinding      = binding;
+                cullingWrites[binding].dstArrayElement = 0;
+                cullingWrites[binding].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                cullingWrites[binding].descriptorCount = 1;
+                cullingWrites[binding].pBufferInfo     = &bufferInfos[binding];
             }
-        }
 
-        return VK_FORMAT_UNDEFINED;
+            vkUpdateDescriptorSets( m_Device, static_cast<uint32_t>( cullingWrites.size() ), cullingWrites.data(), 0, nullptr );
+        }
     }
 
     ////////////////////////////////////////////////////////////
-    /// Finds a supported depth format.
+    /// Writes the compute buffers to the compute descriptor set of a readback buffer.
     ////////////////////////////////////////////////////////////
-    VkFormat FindDepthFormat()
+    void UpdateComputeDescriptorSet( const uint32_t readbackIndex )
     {
-        return FindSupportedFormat(
-            { VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT },
-            VK_IMAGE_TILING_OPTIMAL,
-            VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT );
+        // For compute.
+        std::vector<VkWriteDescriptorSet>   descriptorSetWrites( m_ComputeBuffers.size() );
+        std::vector<VkDescriptorBufferInfo> bufferInfos( m_ComputeBuffers.size() );
+
+        for( uint32_t i = 0; i < m_ComputeBuffers.size(); ++i )
+        {
+            VkWriteDescriptorSet writeDescriptorSet = {};
+            writeDescriptorSet.sType                = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writeDescriptorSet.dstSet               = m_ComputeDescriptorSets[readbackIndex];
+            writeDescriptorSet.dstBinding           = i;
+            writeDescriptorSet.dstArrayElement      = 0;
+            writeDescriptorSet.descriptorCount      = 1;
+            writeDescriptorSet.descriptorType       = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+
+            VkDescriptorBufferInfo bufferInfo = {};
+            bufferInfo.buffer                 = m_ComputeBuffers[i];
+            bufferInfo.offset                 = 0;
+            bufferInfo.range                  = VK_WHOLE_SIZE;
+            bufferInfos[i]                    = bufferInfo;
+
+            writeDescriptorSet.pBufferInfo = &bufferInfos[i];
+            descriptorSetWrites[i]         = writeDescriptorSet;
+        }
+
+        vkUpdateDescriptorSets( m_Device, static_cast<uint32_t>( descriptorSetWrites.size() ), descriptorSetWrites.data(), 0, nullptr );
     }
 
     ////////////////////////////////////////////////////////////
-    /// Checks if a given format has stencil component.
+    /// Finds gpu memory types ordered from the most to the least preferred.
     ////////////////////////////////////////////////////////////
-    bool HasStencilComponent( const VkFormat format )
+    std::vector<uint32_t> FindGpuMemoryTypes( const uint32_t typeFilter, const GpuMemoryPreferences& memoryPreferences )
     {
-        return ( format == VK_FORMAT_D32_SFLOAT_S8_UINT ) ||
-            ( format == VK_FORMAT_D24_UNORM_S8_UINT );
+        std::vector<std::pair<int32_t, uint32_t>> scoredMemoryTypes = {};
+
+        for( uint32_t i = 0; i < m_GpuMemoryProperties.memoryTypeCount; i++ )
+        {
+            const VkMemoryPropertyFlags propertyFlags = m_GpuMemoryProperties.memoryTypes[i].propertyFlags;
+
+            if( ( typeFilter & ( 1 << i ) ) &&
+                ( propertyFlags & memoryPreferences.m_Required ) == memoryPreferences.m_Required )
+            {
+                const int32_t score =
+                    std::popcount( propertyFlags & memoryPreferences.m_Preferred ) -
+                    std::popcount( propertyFlags & memoryPreferences.m_Avoided );
+
+                scoredMemoryTypes.emplace_back( score, i );
+            }
+        }
+
+        // Memory types are reported from the fastest one, so keep that order for equal scores.
+        std::stable_sort(
+            scoredMemoryTypes.begin(),
+            scoredMemoryTypes.end(),
+            []( const auto& left, const auto& right ) { return left.first > right.first; } );
+
+        std::vector<uint32_t> memoryTypeIndices = {};
+
+        for( const auto& scoredMemoryType : scoredMemoryTypes )
+        {
+            memoryTypeIndices.emplace_back( scoredMemoryType.second );
+        }
+
+        if( memoryTypeIndices.empty() )
+        {
+            std::cerr << "Failed to find suitable memory type!" << std::endl;
+        }
+
+        return memoryTypeIndices;
     }
 
     ////////////////////////////////////////////////////////////
-    /// Creates swap chain.
+    /// Creates command buffers.
     ////////////////////////////////////////////////////////////
-    StatusCode CreateSwapChain()
+    StatusCode CreateCommandBuffers()
     {
-        // Get swap chain support details
-        SwapChainSupportDetails details = QuerySwapChainSupport( m_PhysicalDevice );
+        // Create a command buffer for all frame buffers.
+        m_GraphicsCommandBuffers.resize( m_SwapChainFramebuffers.size() );
 
-        // Set swap chain settings.
-        VkSurfaceFormatKHR surfaceFormat = ChooseSwapSurfaceFormat( details.m_Formats );
-        VkPresentModeKHR   presentMode   = ChooseSwapPresentMode( details.m_PresentModes );
-        VkExtent2D         extent        = ChooseSwapExtent( details.m_Capabilities );
+        // Populate command buffer allocate information.
+        VkCommandBufferAllocateInfo allocInfo = {};
+        allocInfo.sType                       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool                 = m_CommandPoolGraphics;
+        allocInfo.level                       = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount          = static_cast<uint32_t>( m_GraphicsCommandBuffers.size() );
 
-        // Swap chain count.
-        uint32_t imageCount = details.m_Capabilities.minImageCount + 1;
+        // Create graphics command buffers.
+        if( vkAllocateCommandBuffers( m_Device, &allocInfo, m_GraphicsCommandBuffers.data() ) != VK_SUCCESS )
+        {
+            std::cerr << "Cannot create graphics command buffer!" << std::endl;
+            return StatusCode::Fail;
+        }
 
-        if( details.m_Capabilities.maxImageCount > 0 &&
-            details.m_Capabilities.maxImageCount < imageCount )
+        // Create compute command buffers, the ones without the readback follow the ones with it.
+        m_ComputeCommandBuffers.resize( 2 * m_ComputeReadbackCount );
+
+        allocInfo.commandPool        = m_CommandPoolCompute;
+        allocInfo.commandBufferCount = static_cast<uint32_t>( m_ComputeCommandBuffers.size() );
+
+        if( vkAllocateCommandBuffers( m_Device, &allocInfo, m_ComputeCommandBuffers.data() ) != VK_SUCCESS )
         {
-            // Limit swap chain count to the maximum.
-            imageCount = details.m_Capabilities.maxImageCount;
+            std::cerr << "Cannot create compute command buffer!" << std::endl;
+            return StatusCode::Fail;
         }
 
-        // Populate swap chain create information.
-        VkSwapchainCreateInfoKHR createInfo = {};
-        createInfo.sType                    = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
-        createInfo.surface                  = m_Surface;
-        createInfo.minImageCount            = imageCount;
-        createInfo.imageFormat              = surfaceFormat.format;
-        createInfo.imageColorSpace          = surfaceFormat.colorSpace;
-        createInfo.imageExtent              = extent;
-        createInfo.imageArrayLayers         = 1; // More than one for stereoscopic 3d applications.
-        createInfo.imageUsage               = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+        return StatusCode::Success;
+    }
 
-        std::vector<uint32_t> queueFamilyIndices = {};
+    ////////////////////////////////////////////////////////////
+    /// Creates queries to collect metrics.
+    ////////////////////////////////////////////////////////////
+    StatusCode CreateQueries()
+    {
+        VkQueryPoolCreateInfo queryPoolInfo = {};
 
-        if( m_QueueFamilyIndices.m_PresentFamily != m_QueueFamilyIndices.m_GraphicsFamily )
+        // Query pools are indexed by query type, unsupported ones stay null.
+        m_QueryPools.resize( static_cast<uint32_t>( QueryType::Count ), VK_NULL_HANDLE );
+
+        if( m_IsPipelineStatisticsQuerySupported )
         {
-            // Add both queues if they are in different queue families.
-            queueFamilyIndices.emplace_back( m_QueueFamilyIndices.m_GraphicsFamily );
-            queueFamilyIndices.emplace_back( m_QueueFamilyIndices.m_PresentFamily );
+            queryPoolInfo.sType      = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+            queryPoolInfo.queryType  = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+            queryPoolInfo.queryCount = static_cast<uint32_t>( m_GraphicsCommandBuffers.size() );
+            queryPoolInfo.pipelineStatistics =
+                VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
+                VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+                VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+                VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT |
+                VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+                VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
+                VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+
+            VkQueryPool queryPool = {};
+
+            if( vkCreateQueryPool( m_Device, &queryPoolInfo, nullptr, &queryPool ) != VK_SUCCESS )
+            {
+                std::cerr << "Failed to create queries!" << std::endl;
+                return StatusCode::Fail;
+            }
+
+            m_QueryPools[static_cast<uint32_t>( QueryType::PipelineStatistics )] = queryPool;
+            m_PipelineStatistics.resize( PipelineStatisticCount );
         }
-        else
+
+        if( CreateGpuProfiler( m_GraphicsProfiler, static_cast<uint32_t>( m_GraphicsCommandBuffers.size() ), m_QueueFamilyIndices.m_GraphicsFamily ) != StatusCode::Success ||
+            CreateGpuProfiler( m_ComputeProfiler, static_cast<uint32_t>( m_ComputeCommandBuffers.size() ), m_QueueFamilyIndices.m_ComputeFamily ) != StatusCode::Success )
         {
-            // Add one queue if graphics and present queues are in the same queue family.
-            queueFamilyIndices.emplace_back( m_QueueFamilyIndices.m_GraphicsFamily );
+            return StatusCode::Fail;
         }
 
-        if( m_QueueFamilyIndices.m_ComputeFamily != m_QueueFamilyIndices.m_GraphicsFamily )
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Creates a timestamp query pool for each slot of the gpu profiler.
+    ////////////////////////////////////////////////////////////
+    StatusCode CreateGpuProfiler( GpuProfiler& profiler, const uint32_t slotCount, const uint32_t queueFamily )
+    {
+        profiler.m_TimestampPeriod = m_PhysicalDeviceProperties.limits.timestampPeriod;
+        profiler.m_TimestampMask   = GetTimestampMask( queueFamily );
+
+        if( !m_IsTimestampQuerySupported )
         {
-            // Add compute queue family if it is in different queue family then graphics one.
-            queueFamilyIndices.emplace_back( m_QueueFamilyIndices.m_ComputeFamily );
+            return StatusCode::Success;
         }
 
-        if( m_QueueFamilyIndices.m_CopyFamily != m_QueueFamilyIndices.m_GraphicsFamily ||
-            m_QueueFamilyIndices.m_CopyFamily != m_QueueFamilyIndices.m_ComputeFamily )
+        VkQueryPoolCreateInfo queryPoolInfo = {};
+        queryPoolInfo.sType                 = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryPoolInfo.queryType             = VK_QUERY_TYPE_TIMESTAMP;
+        queryPoolInfo.queryCount            = GpuProfilerQueryCount;
+
+        profiler.m_QueryPools.resize( slotCount, VK_NULL_HANDLE );
+        profiler.m_Scopes.resize( slotCount );
+
+        for( auto& queryPool : profiler.m_QueryPools )
         {
-            // Add copy queue family if it is in different queue family then graphics or compute one.
-            queueFamilyIndices.emplace_back( m_QueueFamilyIndices.m_CopyFamily );
+            if( vkCreateQueryPool( m_Device, &queryPoolInfo, nullptr, &queryPool ) != VK_SUCCESS )
+            {
+                std::cerr << "Failed to create timestamp queries!" << std::endl;
+                return StatusCode::Fail;
+            }
         }
 
-        if( queueFamilyIndices.size() > 1 )
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Destroys query pools of the gpu profiler.
+    ////////////////////////////////////////////////////////////
+    void DestroyGpuProfiler( GpuProfiler& profiler )
+    {
+        for( auto& queryPool : profiler.m_QueryPools )
         {
-            // Graphics, compute, copy and present queues are in different queue families.
-            createInfo.imageSharingMode      = VK_SHARING_MODE_CONCURRENT;
-            createInfo.queueFamilyIndexCount = static_cast<uint32_t>( queueFamilyIndices.size() );
-            createInfo.pQueueFamilyIndices   = queueFamilyIndices.data();
+            vkDestroyQueryPool( m_Device, queryPool, nullptr );
         }
-        else
+
+        profiler.m_QueryPools.clear();
+        profiler.m_Scopes.clear();
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Returns the mask of the valid timestamp bits of the queue family.
+    ////////////////////////////////////////////////////////////
+    uint64_t GetTimestampMask( const uint32_t queueFamily ) const
+    {
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties( m_PhysicalDevice, &queueFamilyCount, nullptr );
+
+        std::vector<VkQueueFamilyProperties> queueFamilies( queueFamilyCount );
+        vkGetPhysicalDeviceQueueFamilyProperties( m_PhysicalDevice, &queueFamilyCount, queueFamilies.data() );
+
+        const uint32_t validBits = queueFamilies[queueFamily].timestampValidBits;
+
+        return validBits >= 64 ? UINT64_MAX : ( uint64_t( 1 ) << validBits ) - 1;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Correlates gpu timestamps of the queue with the trace clock.
+    /// Calibrated timestamps sample both clocks at once, otherwise a timestamp is written between two cpu times
+    /// and the offset is as accurate as half of the shortest submission round trip.
+    ////////////////////////////////////////////////////////////
+    StatusCode CalibrateGpuTimestamps(
+        const VkQueue            queue,
+        const uint32_t           queueFamily,
+        const VkCommandPool      commandPool,
+        GpuTimeline&             timeline,
+        GpuTimestampCalibration& calibration )
+    {
+        if( m_IsCalibratedTimestampSupported && SampleGpuTimestampCalibration( queueFamily, calibration ) == StatusCode::Success )
         {
-            // Graphics, compute, copy and present queues are in the same queue family.
-            createInfo.imageSharingMode      = VK_SHARING_MODE_EXCLUSIVE;
-            createInfo.queueFamilyIndexCount = 0;       // Optional.
-            createInfo.pQueueFamilyIndices   = nullptr; // Optional.
+            return StatusCode::Success;
         }
 
-        // Check supported formats.
-        VkImageFormatProperties imageFormatProperties = {};
-        if( vkGetPhysicalDeviceImageFormatProperties(
-                m_PhysicalDevice,
-                createInfo.imageFormat,
-                VK_IMAGE_TYPE_2D,
-                VK_IMAGE_TILING_OPTIMAL,
-                createInfo.imageUsage,
-                0,
-                &imageFormatProperties ) != VK_SUCCESS )
+        VkQueryPoolCreateInfo queryPoolInfo = {};
+        queryPoolInfo.sType                 = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryPoolInfo.queryType             = VK_QUERY_TYPE_TIMESTAMP;
+        queryPoolInfo.queryCount            = 1;
+
+        VkQueryPool queryPool = VK_NULL_HANDLE;
+
+        if( vkCreateQueryPool( m_Device, &queryPoolInfo, nullptr, &queryPool ) != VK_SUCCESS )
         {
-            std::cerr << "Cannot get physical device image format properties!" << std::endl;
+            std::cerr << "Failed to create calibration query!" << std::endl;
+            return StatusCode::Fail;
+        }
+
+        VkCommandBufferAllocateInfo allocationInfo = {};
+        allocationInfo.sType                       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocationInfo.commandPool                 = commandPool;
+        allocationInfo.level                       = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocationInfo.commandBufferCount          = 1;
+
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+
+        if( vkAllocateCommandBuffers( m_Device, &allocationInfo, &commandBuffer ) != VK_SUCCESS )
+        {
+            std::cerr << "Failed to allocate calibration command buffer!" << std::endl;
+            vkDestroyQueryPool( m_Device, queryPool, nullptr );
             return StatusCode::Fail;
         }
 
-        if( imageFormatProperties.maxExtent.height < extent.height || imageFormatProperties.maxExtent.width < extent.width )
-        {
-            std::cerr << "Image extent is bigger than max extent!" << std::endl;
-            return StatusCode::Fail;
+        VkCommandBufferBeginInfo beginInfo = {};
+        beginInfo.sType                    = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+
+        vkBeginCommandBuffer( commandBuffer, &beginInfo );
+        vkCmdResetQueryPool( commandBuffer, queryPool, 0, 1 );
+        vkCmdWriteTimestamp( commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, 0 );
+        vkEndCommandBuffer( commandBuffer );
+
+        const Tracer& tracer    = Tracer::Get();
+        StatusCode    result    = StatusCode::Success;
+        int64_t       roundTrip = INT64_MAX;
+
+        for( uint32_t i = 0; i < GpuTimestampCalibrationCount; ++i )
+        {
+            uint64_t      timelineValue = 0;
+            const int64_t submitTime    = tracer.GetTime();
+
+            if( SubmitCommandBuffer( queue, commandBuffer, {}, timeline, VK_NULL_HANDLE, timelineValue ) != StatusCode::Success )
+            {
+                std::cerr << "Failed to submit calibration command buffer!" << std::endl;
+                result = StatusCode::Fail;
+                break;
+            }
+
+            WaitForTimelineValue( timeline, timelineValue );
+
+            const int64_t finishTime = tracer.GetTime();
+            uint64_t      timestamp  = 0;
+
+            if( vkGetQueryPoolResults( m_Device, queryPool, 0, 1, sizeof( timestamp ), &timestamp, sizeof( timestamp ), VK_QUERY_RESULT_64_BIT ) == VK_SUCCESS &&
+                finishTime - submitTime < roundTrip )
+            {
+                roundTrip                     = finishTime - submitTime;
+                calibration.m_Timestamp       = timestamp;
+                calibration.m_Time            = submitTime + roundTrip / 2;
+                calibration.m_TimestampPeriod = m_PhysicalDeviceProperties.limits.timestampPeriod;
+                calibration.m_TimestampMask   = GetTimestampMask( queueFamily );
+                calibration.m_IsCalibrated    = true;
+            }
         }
 
-        createInfo.preTransform   = details.m_Capabilities.currentTransform;
-        createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
-        createInfo.presentMode    = presentMode;
-        createInfo.clipped        = VK_TRUE;
-        createInfo.oldSwapchain   = VK_NULL_HANDLE;
+        vkFreeCommandBuffers( m_Device, commandPool, 1, &commandBuffer );
+        vkDestroyQueryPool( m_Device, queryPool, nullptr );
 
-        // Create swap chain.
-        if( vkCreateSwapchainKHR( m_Device, &createInfo, nullptr, &m_SwapChain ) != VK_SUCCESS )
+        return result;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Correlates gpu timestamps of the queue family with the trace clock by sampling both with calibrated timestamps.
+    /// The sample with the smallest deviation is used.
+    ////////////////////////////////////////////////////////////
+    StatusCode SampleGpuTimestampCalibration( const uint32_t queueFamily, GpuTimestampCalibration& calibration )
+    {
+        std::array<VkCalibratedTimestampInfoEXT, 2> timestampInfos = {};
+        timestampInfos[0].sType                                    = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+        timestampInfos[0].timeDomain                               = VK_TIME_DOMAIN_DEVICE_EXT;
+        timestampInfos[1].sType                                    = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+        timestampInfos[1].timeDomain                               = TraceTimeDomain;
+
+        const Tracer& tracer           = Tracer::Get();
+        uint64_t      minimumDeviation = UINT64_MAX;
+
+        for( uint32_t i = 0; i < GpuTimestampCalibrationCount; ++i )
         {
-            std::cerr << "Cannot create swap chain!" << std::endl;
-            return StatusCode::Fail;
-        }
+            std::array<uint64_t, 2> timestamps = {};
+            uint64_t                deviation  = 0;
 
-        // Get swap chain images.
-        vkGetSwapchainImagesKHR( m_Device, m_SwapChain, &imageCount, nullptr );
-        m_SwapChainImages.resize( imageCount );
-        vkGetSwapchainImagesKHR( m_Device, m_SwapChain, &imageCount, m_SwapChainImages.data() );
+            if( vkGetCalibratedTimestampsExtension( m_Device, static_cast<uint32_t>( timestampInfos.size() ), timestampInfos.data(), timestamps.data(), &deviation ) != VK_SUCCESS )
+            {
+                std::cerr << "Failed to get calibrated timestamps!" << std::endl;
+                return StatusCode::Fail;
+            }
 
-        // Store swap chain format and extent.
-        m_SwapChainImageFormat = surfaceFormat.format;
-        m_SwapChainExtent      = extent;
+            if( deviation < minimumDeviation )
+            {
+                minimumDeviation              = deviation;
+                calibration.m_Timestamp       = timestamps[0];
+                calibration.m_Time            = tracer.GetTime( timestamps[1] );
+                calibration.m_TimestampPeriod = m_PhysicalDeviceProperties.limits.timestampPeriod;
+                calibration.m_TimestampMask   = GetTimestampMask( queueFamily );
+                calibration.m_IsCalibrated    = true;
+            }
+        }
 
         return StatusCode::Success;
     }
 
     ////////////////////////////////////////////////////////////
-    /// Queries swap chain support.
+    /// Adds resolved gpu profiler scopes to the trace track of their queue,
+    /// using the calibration of that queue.
     ////////////////////////////////////////////////////////////
-    SwapChainSupportDetails QuerySwapChainSupport( VkPhysicalDevice physicalDevice )
+    void TraceGpuProfile( const std::vector<GpuProfilerResult>& results, const GpuTimestampCalibration& calibration, const uint32_t track ) const
     {
-        SwapChainSupportDetails details = {};
-
-        // Get swap chain capabilities.
-        vkGetPhysicalDeviceSurfaceCapabilitiesKHR( physicalDevice, m_Surface, &details.m_Capabilities );
-
-        // Get swap chain formats.
-        uint32_t formatCount;
-        vkGetPhysicalDeviceSurfaceFormatsKHR( physicalDevice, m_Surface, &formatCount, nullptr );
+        Tracer& tracer = Tracer::Get();
 
-        if( formatCount != 0 )
+        if( !tracer.IsEnabled() || !calibration.m_IsCalibrated )
         {
-            details.m_Formats.resize( formatCount );
-            vkGetPhysicalDeviceSurfaceFormatsKHR( physicalDevice, m_Surface, &formatCount, details.m_Formats.data() );
+            return;
         }
 
-        // Get swap chain present modes.
-        uint32_t presentModeCount;
-        vkGetPhysicalDeviceSurfacePresentModesKHR( physicalDevice, m_Surface, &presentModeCount, nullptr );
-
-        if( presentModeCount != 0 )
+        for( const GpuProfilerResult& result : results )
         {
-            details.m_PresentModes.resize( presentModeCount );
-            vkGetPhysicalDeviceSurfacePresentModesKHR( physicalDevice, m_Surface, &presentModeCount, details.m_PresentModes.data() );
+            tracer.AddEvent( result.m_Name, calibration.GetTime( result.m_BeginTimestamp ), calibration.GetTime( result.m_EndTimestamp ), track );
         }
-
-        return details;
     }
 
     ////////////////////////////////////////////////////////////
-    /// Chooses swap chain surface format.
+    /// Records command buffers.
     ////////////////////////////////////////////////////////////
-    VkSurfaceFormatKHR ChooseSwapSurfaceFormat( const std::vector<VkSurfaceFormatKHR>& availableFormats )
+    StatusCode RecordCommandBuffers()
     {
-        for( const auto& availableFormat : availableFormats )
+        for( uint32_t i = 0; i < m_GraphicsCommandBuffers.size(); ++i )
         {
-            // Use 32 bits per pixel (blue, green, red, alpha with 8 bit)/
-            if( availableFormat.format == VK_FORMAT_B8G8R8A8_SRGB &&
-                availableFormat.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR )
+            if( RecordGraphicsCommandBuffer( i ) != StatusCode::Success )
             {
-                return availableFormat;
+                return StatusCode::Fail;
             }
         }
 
-        std::cerr << "Cannot choose a desire swap chain surface format! Used the first format!" << std::endl;
-        return availableFormats[0];
+        return RecordComputeCommandBuffers();
     }
 
     ////////////////////////////////////////////////////////////
-    /// Chooses swap chain present mode.
+    /// Records compute command buffers.
     ////////////////////////////////////////////////////////////
-    VkPresentModeKHR ChooseSwapPresentMode( const std::vector<VkPresentModeKHR>& availablePresentModes )
+    StatusCode RecordComputeCommandBuffers()
     {
-        for( const auto& availablePresentMode : availablePresentModes )
+        for( uint32_t i = 0; i < m_ComputeCommandBuffers.size(); ++i )
         {
-            // Triple buffering is much better than double buffering.
-            if( availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR )
+            if( RecordComputeCommandBuffer( i ) != StatusCode::Success )
             {
-                return availablePresentMode;
+                return StatusCode::Fail;
             }
         }
 
-        // Choose double buffering if triple buffering is not available.
-        return VK_PRESENT_MODE_FIFO_KHR;
+        return StatusCode::Success;
     }
 
     ////////////////////////////////////////////////////////////
-    /// Chooses swap chain extent.
+    /// Records a compute command buffer.
     ////////////////////////////////////////////////////////////
-    VkExtent2D ChooseSwapExtent( const VkSurfaceCapabilitiesKHR& capabilities )
+    StatusCode RecordComputeCommandBuffer( const uint32_t commandBufferIndex )
     {
-        if( capabilities.currentExtent.width != UINT32_MAX )
-        {
-            return capabilities.currentExtent;
-        }
-        else
+        // For compute, each command buffer copies the results to its own readback buffer or skips the readback.
+        const uint32_t readbackIndex = commandBufferIndex % m_ComputeReadbackCount;
+        const bool     isReadback    = commandBufferIndex < m_ComputeReadbackCount;
+
+        VkCommandBufferBeginInfo beginInfo = {};
+        beginInfo.sType                    = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags                    = 0;       // Optional.
+        beginInfo.pInheritanceInfo         = nullptr; // Optional.
+
+        vkBeginCommandBuffer( m_ComputeCommandBuffers[commandBufferIndex], &beginInfo );
+
+        m_ComputeProfiler.BeginSlot( m_ComputeCommandBuffers[commandBufferIndex], commandBufferIndex );
+        m_ComputeProfiler.BeginScope( m_ComputeCommandBuffers[commandBufferIndex], commandBufferIndex, "compute" );
+
+        // The previous dispatch may still copy the results out.
+        vkCmdPipelineBarrier( m_ComputeCommandBuffers[commandBufferIndex], VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 0, nullptr );
+
+        vkCmdBindPipeline( m_ComputeCommandBuffers[commandBufferIndex], VK_PIPELINE_BIND_POINT_COMPUTE, m_ComputePipeline );
+
+        vkCmdBindDescriptorSets( m_ComputeCommandBuffers[commandBufferIndex], VK_PIPELINE_BIND_POINT_COMPUTE, m_ComputePipelineLayout, 0, 1, &m_ComputeDescriptorSets[readbackIndex], 0, nullptr );
+
+        vkCmdPushConstants( m_ComputeCommandBuffers[commandBufferIndex], m_ComputePipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof( m_VectorElementCount ), &m_VectorElementCount );
+
+        m_ComputeProfiler.BeginScope( m_ComputeCommandBuffers[commandBufferIndex], commandBufferIndex, "dispatch" );
+        vkCmdDispatch( m_ComputeCommandBuffers[commandBufferIndex], m_ComputeDispatchSize[0], m_ComputeDispatchSize[1], m_ComputeDispatchSize[2] );
+        m_ComputeProfiler.EndScope( m_ComputeCommandBuffers[commandBufferIndex], commandBufferIndex, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT );
+
+        if( isReadback )
         {
-            VkExtent2D actualExtent = { m_Width, m_Height };
+            VkMemoryBarrier barrier = {};
+            barrier.sType           = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            barrier.srcAccessMask   = VK_ACCESS_SHADER_WRITE_BIT;
+            barrier.dstAccessMask   = VK_ACCESS_TRANSFER_READ_BIT;
 
-            actualExtent.width  = std::max( capabilities.minImageExtent.width, std::min( capabilities.maxImageExtent.width, actualExtent.width ) );
-            actualExtent.height = std::max( capabilities.minImageExtent.height, std::min( capabilities.maxImageExtent.height, actualExtent.height ) );
+            vkCmdPipelineBarrier( m_ComputeCommandBuffers[commandBufferIndex], VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr );
 
-            return actualExtent;
+            VkBufferCopy copyRegion = {};
+            copyRegion.size         = m_VectorElementCount * sizeof( float );
+
+            m_ComputeProfiler.BeginScope( m_ComputeCommandBuffers[commandBufferIndex], commandBufferIndex, "readback_copy" );
+            vkCmdCopyBuffer( m_ComputeCommandBuffers[commandBufferIndex], m_ComputeBuffers[2], m_ComputeReadbackBuffers[readbackIndex], 1, &copyRegion );
+            m_ComputeProfiler.EndScope( m_ComputeCommandBuffers[commandBufferIndex], commandBufferIndex, VK_PIPELINE_STAGE_TRANSFER_BIT );
+
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+            vkCmdPipelineBarrier( m_ComputeCommandBuffers[commandBufferIndex], VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr );
         }
+
+        m_ComputeProfiler.EndScope( m_ComputeCommandBuffers[commandBufferIndex], commandBufferIndex );
+
+        vkEndCommandBuffer( m_ComputeCommandBuffers[commandBufferIndex] );
+
+        return StatusCode::Success;
     }
 
     ////////////////////////////////////////////////////////////
-    /// Creates image views.
+    /// Records the graphics command buffer of a swap chain image.
     ////////////////////////////////////////////////////////////
-    StatusCode CreateImageViews()
+    StatusCode RecordGraphicsCommandBuffer( const uint32_t imageIndex )
     {
-        const uint32_t swapChainImageCount = static_cast<uint32_t>( m_SwapChainImages.size() );
+        // Populate command buffer begin information.
+        VkCommandBufferBeginInfo beginInfo = {};
+        beginInfo.sType                    = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags                    = 0;       // Optional.
+        beginInfo.pInheritanceInfo         = nullptr; // Optional.
 
-        // Match swap chain image views to swap chain images.
-        m_SwapChainImageViews.resize( swapChainImageCount );
+        // Begin recording the command buffer.
+        if( vkBeginCommandBuffer( m_GraphicsCommandBuffers[imageIndex], &beginInfo ) != VK_SUCCESS )
+        {
+            std::cerr << "Failed to begin recording command buffer!" << std::endl;
+            return StatusCode::Fail;
+        }
 
-        for( uint32_t i = 0; i < swapChainImageCount; ++i )
+        // Reset query before render pass begin.
+        if( m_IsPipelineStatisticsQuerySupported )
         {
-            // For stereographics 3d applications a swap chain with multiple layers is required and
-            // with multiple image views as well.
-            const StatusCode result = CreateImageView(
-                m_SwapChainImages[i],
-                m_SwapChainImageFormat,
-                VK_IMAGE_ASPECT_COLOR_BIT,
-                m_SwapChainImageViews[i] );
+            const uint32_t queryPoolIndex = static_cast<uint32_t>( QueryType::PipelineStatistics );
 
-            if( result != StatusCode::Success )
-            {
-                std::cerr << "Cannot create swap chain image view!" << std::endl;
-                return StatusCode::Fail;
-            }
+            vkCmdResetQueryPool( m_GraphicsCommandBuffers[imageIndex], m_QueryPools[queryPoolIndex], imageIndex, 1 );
+        }
+
+        const uint32_t slot = imageIndex;
+
+        m_GraphicsProfiler.BeginSlot( m_GraphicsCommandBuffers[imageIndex], slot );
+        m_GraphicsProfiler.BeginScope( m_GraphicsCommandBuffers[imageIndex], slot, "frame" );
+
+        // Cull clusters against the frustum of the image uniform before the render pass.
+        if( IsGpuCullingEnabled() )
+        {
+            RecordCulling( m_GraphicsCommandBuffers[imageIndex], slot );
+        }
+
+        // Define a clear color and depth.
+        std::array<VkClearValue, 2> clearValues = {};
+        clearValues[0].color.float32[0]         = 0.1f; // Red channel.
+        clearValues[0].color.float32[1]         = 0.4f; // Green channel.
+        clearValues[0].color.float32[2]         = 0.5f; // Blue channel.
+        clearValues[0].color.float32[3]         = 1.0f; // Alpha channel.
+        clearValues[1].depthStencil.depth       = 1.0f;
+        clearValues[1].depthStencil.stencil     = 0;
+
+        // Populate render pass begin information.
+        VkRenderPassBeginInfo renderPassInfo = {};
+        renderPassInfo.sType                 = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassInfo.renderPass            = m_RenderPass;
+        renderPassInfo.framebuffer           = m_SwapChainFramebuffers[imageIndex];
+        renderPassInfo.renderArea.offset     = { 0, 0 };
+        renderPassInfo.renderArea.extent     = m_SwapChainExtent;
+        renderPassInfo.clearValueCount       = static_cast<uint32_t>( clearValues.size() );
+        renderPassInfo.pClearValues          = clearValues.data();
+
+        // Begin the render pass.
+        m_GraphicsProfiler.BeginScope( m_GraphicsCommandBuffers[imageIndex], slot, "render_pass" );
+        vkCmdBeginRenderPass( m_GraphicsCommandBuffers[imageIndex], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE );
+
+        // Bind the graphics pipeline.
+        vkCmdBindPipeline( m_GraphicsCommandBuffers[imageIndex], VK_PIPELINE_BIND_POINT_GRAPHICS, m_GraphicsPipeline );
+
+        // Bind the vertex buffers.
+        const VkBuffer     vertexBuffers[] = { m_VertexBuffer };
+        const VkDeviceSize offsets[]       = { 0 };
+        vkCmdBindVertexBuffers( m_GraphicsCommandBuffers[imageIndex], 0, 1, vertexBuffers, offsets );
+
+        // Bind the index buffer.
+        vkCmdBindIndexBuffer( m_GraphicsCommandBuffers[imageIndex], m_IndexBuffer, 0, VK_INDEX_TYPE_UINT32 );
+
+        // Bind the descriptor sets at the offset of the uniforms pushed for the image.
+        vkCmdBindDescriptorSets( m_GraphicsCommandBuffers[imageIndex], VK_PIPELINE_BIND_POINT_GRAPHICS, m_GraphicsPipelineLayout, 0, 1, &m_DescriptorSets[imageIndex], 1, &m_UniformDynamicOffsets[imageIndex] );
+
+        // Query begin.
+        if( m_IsPipelineStatisticsQuerySupported )
+        {
+            const uint32_t queryPoolIndex = static_cast<uint32_t>( QueryType::PipelineStatistics );
+
+            vkCmdBeginQuery( m_GraphicsCommandBuffers[imageIndex], m_QueryPools[queryPoolIndex], imageIndex, 0 );
+        }
+
+        // Draw.
+        // vkCmdDraw( m_CommandBuffers[imageIndex], static_cast<uint32_t>( Vertices.size() ), 1, 0, 0 );
+        // Visible clusters are drawn by a single indirect draw, whatever the cluster count.
+        m_GraphicsProfiler.BeginScope( m_GraphicsCommandBuffers[imageIndex], slot, "draw" );
+
+        if( IsGpuCullingEnabled() )
+        {
+            vkCmdDrawIndexedIndirectCount(
+                m_GraphicsCommandBuffers[imageIndex],
+                m_CullingDrawBuffers[imageIndex],
+                CullingDrawCommandOffset,
+                m_CullingDrawBuffers[imageIndex],
+                0,
+                m_CullingClusterCount,
+                sizeof( VkDrawIndexedIndirectCommand ) );
+        }
+        else
+        {
+            vkCmdDrawIndexed( m_GraphicsCommandBuffers[imageIndex], static_cast<uint32_t>( Indices.size() ), 1, 0, 0, 0 );
+        }
+
+        m_GraphicsProfiler.EndScope( m_GraphicsCommandBuffers[imageIndex], slot );
+
+        // Query end.
+        if( m_IsPipelineStatisticsQuerySupported )
+        {
+            const uint32_t queryPoolIndex = static_cast<uint32_t>( QueryType::PipelineStatistics );
+
+            vkCmdEndQuery( m_GraphicsCommandBuffers[imageIndex], m_QueryPools[queryPoolIndex], imageIndex );
+        }
+
+        // End the render pass.
+        vkCmdEndRenderPass( m_GraphicsCommandBuffers[imageIndex] );
+        m_GraphicsProfiler.EndScope( m_GraphicsCommandBuffers[imageIndex], slot );
+
+        // Copy the offscreen image to its capture buffer.
+        if( !m_CaptureBuffers.empty() )
+        {
+            m_GraphicsProfiler.BeginScope( m_GraphicsCommandBuffers[imageIndex], slot, "capture_copy" );
+
+            VkBufferImageCopy region           = {};
+            region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            region.imageSubresource.layerCount = 1;
+            region.imageExtent                 = { m_SwapChainExtent.width, m_SwapChainExtent.height, 1 };
+
+            vkCmdCopyImageToBuffer( m_GraphicsCommandBuffers[imageIndex], m_SwapChainImages[imageIndex], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_CaptureBuffers[imageIndex], 1, &region );
+
+            VkMemoryBarrier barrier = {};
+            barrier.sType           = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            barrier.srcAccessMask   = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask   = VK_ACCESS_HOST_READ_BIT;
+
+            vkCmdPipelineBarrier( m_GraphicsCommandBuffers[imageIndex], VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr );
+
+            m_GraphicsProfiler.EndScope( m_GraphicsCommandBuffers[imageIndex], slot );
+        }
+
+        m_GraphicsProfiler.EndScope( m_GraphicsCommandBuffers[imageIndex], slot );
+
+        // End recoring the command buffer.
+        if( vkEndCommandBuffer( m_GraphicsCommandBuffers[imageIndex] ) != VK_SUCCESS )
+        {
+            std::cerr << "Failed to record command buffer!" << std::endl;
+            return StatusCode::Fail;
         }
 
         return StatusCode::Success;
     }
 
     ////////////////////////////////////////////////////////////
-    /// Creates render pass.
+    /// Recreates swap chain.
     ////////////////////////////////////////////////////////////
-    StatusCode CreateRenderPass()
+    StatusCode RecreateSwapChain()
     {
-        // Populate color attachment description information.
-        VkAttachmentDescription colorAttachment = {};
-        colorAttachment.format                  = m_SwapChainImageFormat;
-        colorAttachment.samples                 = VK_SAMPLE_COUNT_1_BIT;
-        colorAttachment.loadOp                  = VK_ATTACHMENT_LOAD_OP_CLEAR;
-        colorAttachment.storeOp                 = VK_ATTACHMENT_STORE_OP_STORE;
-        colorAttachment.stencilLoadOp           = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-        colorAttachment.stencilStoreOp          = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-        colorAttachment.initialLayout           = VK_IMAGE_LAYOUT_UNDEFINED;
-        colorAttachment.finalLayout             = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-        // Populate color attachment reference information.
-        VkAttachmentReference colorAttachmentReference = {};
-        colorAttachmentReference.attachment            = 0;
-        colorAttachmentReference.layout                = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        int32_t width  = 0;
+        int32_t height = 0;
 
-        // Populate depth attachment description information.
-        VkAttachmentDescription depthAttachment = {};
-        depthAttachment.format                  = FindDepthFormat();
-        depthAttachment.samples                 = VK_SAMPLE_COUNT_1_BIT;
-        depthAttachment.loadOp                  = VK_ATTACHMENT_LOAD_OP_CLEAR;
-        depthAttachment.storeOp                 = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-        depthAttachment.stencilLoadOp           = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-        depthAttachment.stencilStoreOp          = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-        depthAttachment.initialLayout           = VK_IMAGE_LAYOUT_UNDEFINED;
-        depthAttachment.finalLayout             = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        glfwGetFramebufferSize( m_Window, &width, &height );
 
-        // Populate depth attachment reference information.
-        VkAttachmentReference depthAttachmentReference = {};
-        depthAttachmentReference.attachment            = 1;
-        depthAttachmentReference.layout                = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        while( width == 0 || height == 0 )
+        {
+            // Pause until the windows is minimized.
+            glfwGetFramebufferSize( m_Window, &width, &height );
+            glfwWaitEvents();
+        }
 
-        // Populate subpass information.
-        VkSubpassDescription subpass    = {};
-        subpass.pipelineBindPoint       = VK_PIPELINE_BIND_POINT_GRAPHICS;
-        subpass.colorAttachmentCount    = 1;
-        subpass.pColorAttachments       = &colorAttachmentReference;
-        subpass.pDepthStencilAttachment = &depthAttachmentReference;
+        if( vkDeviceWaitIdle( m_Device ) != VK_SUCCESS )
+        {
+            std::cerr << "Failed to waiting for device!" << std::endl;
+            return StatusCode::Fail;
+        }
 
-        // Populate subpass dependency information.
-        VkSubpassDependency dependency = {};
-        dependency.srcSubpass          = VK_SUBPASS_EXTERNAL;
-        dependency.dstSubpass          = 0;
-        dependency.srcStageMask        = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-        dependency.srcAccessMask       = 0;
-        dependency.dstStageMask        = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-        dependency.dstAccessMask       = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        CleanupSwapChain();
 
-        // Populate render pass information.
-        const std::array<VkAttachmentDescription, 2> attachments = { colorAttachment, depthAttachment };
+        StatusCode result = StatusCode::Success;
 
-        VkRenderPassCreateInfo renderPassInfo = {};
-        renderPassInfo.sType                  = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-        renderPassInfo.attachmentCount        = static_cast<uint32_t>( attachments.size() );
-        renderPassInfo.pAttachments           = attachments.data();
-        renderPassInfo.subpassCount           = 1;
-        renderPassInfo.pSubpasses             = &subpass;
-        renderPassInfo.dependencyCount        = 1;
-        renderPassInfo.pDependencies          = &dependency;
+        result = CreateSwapChain();
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Swap chain creation failed!" << std::endl;
+            return result;
+        }
 
-        // Create render pass.
-        if( vkCreateRenderPass( m_Device, &renderPassInfo, nullptr, &m_RenderPass ) != VK_SUCCESS )
+        // The device is idle, so no image has a frame in flight.
+        m_ImageTimelineValues.assign( m_SwapChainImages.size(), 0 );
+        m_ImageFrameIndices.assign( m_SwapChainImages.size(), 0 );
+
+        result = CreateImageViews();
+        if( result != StatusCode::Success )
         {
-            std::cerr << "Cannot create render pass!" << std::endl;
-            return StatusCode::Fail;
+            std::cerr << "Image views creation failed!" << std::endl;
+            return result;
         }
 
-        return StatusCode::Success;
-    }
+        result = CreateRenderPass();
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Render pass creation failed!" << std::endl;
+            return result;
+        }
 
-    ////////////////////////////////////////////////////////////
-    /// Creates descriptor set layout.
-    ////////////////////////////////////////////////////////////
-    StatusCode CreateDescriptorSetLayout()
-    {
-        // Graphics descriptor set layouts.
-        VkDescriptorSetLayoutBinding uboLayoutBinding     = {};
-        VkDescriptorSetLayoutBinding samplerLayoutBinding = {};
+        result = CreateGraphicsPipeline();
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Graphics pipeline creation failed!" << std::endl;
+            return result;
+        }
 
-        // Uniform layout.
-        uboLayoutBinding.binding            = 0;
-        uboLayoutBinding.descriptorType     = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        uboLayoutBinding.descriptorCount    = 1;
-        uboLayoutBinding.stageFlags         = VK_SHADER_STAGE_VERTEX_BIT;
-        uboLayoutBinding.pImmutableSamplers = nullptr; // Optional.
+        result = CreateDepthResources();
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Depth resources creation failed!" << std::endl;
+            return result;
+        }
 
-        // Sampler layout.
-        samplerLayoutBinding.binding            = 1;
-        samplerLayoutBinding.descriptorType     = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        samplerLayoutBinding.descriptorCount    = 1;
-        samplerLayoutBinding.stageFlags         = VK_SHADER_STAGE_FRAGMENT_BIT;
-        samplerLayoutBinding.pImmutableSamplers = nullptr; // Optional.
+        result = SubmitUploadBatch();
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Upload batch submission failed!" << std::endl;
+            return result;
+        }
 
-        std::array<VkDescriptorSetLayoutBinding, 2> bindings = { uboLayoutBinding, samplerLayoutBinding };
+        result = CreateFramebuffers();
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Frame buffers creation failed!" << std::endl;
+            return result;
+        }
 
-        VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+        result = CreateUniformBuffers();
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Unifrom buffers creation failed!" << std::endl;
+            return result;
+        }
 
-        layoutInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-        layoutInfo.bindingCount = static_cast<uint32_t>( bindings.size() );
-        layoutInfo.pBindings    = bindings.data();
+        result = CreateCullingDrawBuffers();
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Culling draw buffers creation failed!" << std::endl;
+            return result;
+        }
 
-        if( vkCreateDescriptorSetLayout( m_Device, &layoutInfo, nullptr, &m_DescriptorSetLayout ) != VK_SUCCESS )
+        result = CreateDescriptorPool();
+        if( result != StatusCode::Success )
         {
-            std::cerr << "Cannot create graphics descriptor set layout!" << std::endl;
-            return StatusCode::Fail;
+            std::cerr << "Descriptor pool creation failed!" << std::endl;
+            return result;
         }
 
-        // Compute descriptor set layout.
-        std::vector<VkDescriptorSetLayoutBinding> layoutBindings;
+        result = CreateDescriptorSets();
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Descriptor sets creation failed!" << std::endl;
+            return result;
+        }
 
-        for( uint32_t i = 0; i < 3; i++ )
+        result = CreateCommandBuffers();
+        if( result != StatusCode::Success )
         {
-            VkDescriptorSetLayoutBinding layoutBinding = {};
-            layoutBinding.binding                      = i;
-            layoutBinding.descriptorType               = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-            layoutBinding.descriptorCount              = 1;
-            layoutBinding.stageFlags                   = VK_SHADER_STAGE_COMPUTE_BIT;
-            layoutBindings.push_back( layoutBinding );
+            std::cerr << "Command buffers creation failed!" << std::endl;
+            return result;
         }
 
-        VkDescriptorSetLayoutCreateInfo setLayoutCreateInfo = {};
-        setLayoutCreateInfo.sType                           = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-        setLayoutCreateInfo.bindingCount                    = static_cast<uint32_t>( layoutBindings.size() );
-        setLayoutCreateInfo.pBindings                       = layoutBindings.data();
+        // Command buffers are recorded again below, with the moved resources.
+        m_IsImageUsingMovedGpuMemory.assign( m_SwapChainImages.size(), false );
+        m_IsReadbackUsingMovedGpuMemory.assign( m_ComputeReadbackCount, false );
 
-        if( vkCreateDescriptorSetLayout( m_Device, &setLayoutCreateInfo, nullptr, &m_ComputeDescriptorSetLayout ) != VK_SUCCESS )
+        // The image count may change, so queries are sized again.
+        result = CreateQueries();
+        if( result != StatusCode::Success )
         {
-            std::cerr << "Cannot create compute descriptor set layout!" << std::endl;
-            return StatusCode::Fail;
+            std::cerr << "Queries creation failed!" << std::endl;
+            return result;
+        }
+
+        result = RecordCommandBuffers();
+        if( result != StatusCode::Success )
+        {
+            std::cerr << "Command buffers recording failed!" << std::endl;
+            return result;
         }
 
         return StatusCode::Success;
     }
 
     ////////////////////////////////////////////////////////////
-    /// Creates graphics pipeline.
+    /// Creates semaphores to perform gpu-gpu synchronization.
     ////////////////////////////////////////////////////////////
-    StatusCode CreateGraphicsPipeline()
+    StatusCode CreateSemaphores()
     {
-        // Read the bytecode of shaders.
-        const auto vertexShaderCode   = ReadBinaryFile( "Shaders/vert.spv" );
-        const auto fragmentShaderCode = ReadBinaryFile( "Shaders/frag.spv" );
+        m_ImageAvailableSemaphores.resize( m_FramesInFlight );
+        m_RenderFinishedSemaphores.resize( m_FramesInFlight );
+
+        VkSemaphoreCreateInfo semaphoreInfo = {};
+        semaphoreInfo.sType                 = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-        if( vertexShaderCode.empty() || fragmentShaderCode.empty() )
+        for( uint32_t i = 0; i < m_FramesInFlight; ++i )
         {
-            std::cerr << "Empty shader files!" << std::endl;
-            return StatusCode::Fail;
+            if( vkCreateSemaphore( m_Device, &semaphoreInfo, nullptr, &m_ImageAvailableSemaphores[i] ) != VK_SUCCESS ||
+                vkCreateSemaphore( m_Device, &semaphoreInfo, nullptr, &m_RenderFinishedSemaphores[i] ) != VK_SUCCESS )
+            {
+                std::cerr << "Failed to create semaphores!" << std::endl;
+                return StatusCode::Fail;
+            }
         }
 
-        // Create shader modules for the shaders.
-        VkShaderModule vertexShaderModule   = CreateShaderModule( vertexShaderCode );
-        VkShaderModule fragmentShaderModule = CreateShaderModule( fragmentShaderCode );
-
-        // Create vertex shader stage.
-        VkPipelineShaderStageCreateInfo vertexShaderStageInfo = {};
-        vertexShaderStageInfo.sType                           = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-        vertexShaderStageInfo.stage                           = VK_SHADER_STAGE_VERTEX_BIT;
-        vertexShaderStageInfo.module                          = vertexShaderModule;
-        vertexShaderStageInfo.pName                           = "main";
-
-        // Create fragment shader stage.
-        VkPipelineShaderStageCreateInfo fragmentShaderStageInfo = {};
-        fragmentShaderStageInfo.sType                           = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-        fragmentShaderStageInfo.stage                           = VK_SHADER_STAGE_FRAGMENT_BIT;
-        fragmentShaderStageInfo.module                          = fragmentShaderModule;
-        fragmentShaderStageInfo.pName                           = "main";
-
-        // Create programmable pipeline stages.
-        VkPipelineShaderStageCreateInfo shaderStages[] = {
-            vertexShaderStageInfo,
-            fragmentShaderStageInfo
-        };
-
-        // Create vertex input state.
-        const auto bindingDescription    = Vertex::GetBindingDescription();
-        const auto attributeDescriptions = Vertex::GetAttributeDescriptions();
-
-        VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
-        vertexInputInfo.sType                                = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-        vertexInputInfo.vertexBindingDescriptionCount        = 1;
-        vertexInputInfo.pVertexBindingDescriptions           = &bindingDescription;
-        vertexInputInfo.vertexAttributeDescriptionCount      = static_cast<uint32_t>( attributeDescriptions.size() );
-        vertexInputInfo.pVertexAttributeDescriptions         = attributeDescriptions.data();
-
-        // Create input assembly state.
-        VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
-        inputAssembly.sType                                  = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-        inputAssembly.topology                               = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-        inputAssembly.primitiveRestartEnable                 = VK_FALSE;
-
-        // Viewports.
-        VkViewport viewport = {};
-        viewport.x          = 0.0f;
-        viewport.y          = 0.0f;
-        viewport.width      = static_cast<float>( m_SwapChainExtent.width );
-        viewport.height     = static_cast<float>( m_SwapChainExtent.height );
-        viewport.minDepth   = 0.0f;
-        viewport.maxDepth   = 1.0f;
-
-        // Scissors.
-        VkRect2D scissor = {};
-        scissor.offset   = { 0, 0 };
-        scissor.extent   = m_SwapChainExtent;
+        return StatusCode::Success;
+    }
 
-        // Create viewport state.
-        VkPipelineViewportStateCreateInfo viewportState = {};
-        viewportState.sType                             = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-        viewportState.viewportCount                     = 1;
-        viewportState.pViewports                        = &viewport;
-        viewportState.scissorCount                      = 1;
-        viewportState.pScissors                         = &scissor;
+    ////////////////////////////////////////////////////////////
+    /// Creates timeline semaphores to perform cpu-gpu and queue-queue synchronization.
+    ////////////////////////////////////////////////////////////
+    StatusCode CreateTimelines()
+    {
+        m_FrameTimelineValues.resize( m_FramesInFlight, 0 );
+        m_FrameStartTimes.resize( m_FramesInFlight );
+        m_ImageTimelineValues.resize( m_SwapChainImages.size(), 0 );
+        m_ImageFrameIndices.resize( m_SwapChainImages.size(), 0 );
+        m_IsImageUsingMovedGpuMemory.resize( m_SwapChainImages.size(), false );
+        m_ComputeTimelineValues.resize( m_ComputeReadbackCount, 0 );
+        m_IsReadbackUsingMovedGpuMemory.resize( m_ComputeReadbackCount, false );
+
+        VkSemaphoreTypeCreateInfo semaphoreTypeInfo = {};
+        semaphoreTypeInfo.sType                     = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+        semaphoreTypeInfo.semaphoreType             = VK_SEMAPHORE_TYPE_TIMELINE;
+        semaphoreTypeInfo.initialValue              = 0;
 
-        // Rasterizeration state.
-        VkPipelineRasterizationStateCreateInfo rasterizer = {};
-        rasterizer.sType                                  = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-        rasterizer.depthClampEnable                       = VK_FALSE;
-        rasterizer.rasterizerDiscardEnable                = VK_FALSE;
-        rasterizer.polygonMode                            = VK_POLYGON_MODE_FILL;
-        rasterizer.lineWidth                              = 1.0f;
-        rasterizer.cullMode                               = VK_CULL_MODE_BACK_BIT;
-        rasterizer.frontFace                              = VK_FRONT_FACE_CLOCKWISE; // VK_FRONT_FACE_COUNTER_CLOCKWISE
-        rasterizer.depthBiasEnable                        = VK_FALSE;
-        rasterizer.depthBiasConstantFactor                = 0.0f; // Optional.
-        rasterizer.depthBiasClamp                         = 0.0f; // Optional.
-        rasterizer.depthBiasSlopeFactor                   = 0.0f; // Optional.
+        VkSemaphoreCreateInfo semaphoreInfo = {};
+        semaphoreInfo.sType                 = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        semaphoreInfo.pNext                 = &semaphoreTypeInfo;
 
-        // Multisample state.
-        VkPipelineMultisampleStateCreateInfo multisampling = {};
-        multisampling.sType                                = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-        multisampling.sampleShadingEnable                  = VK_FALSE;
-        multisampling.rasterizationSamples                 = VK_SAMPLE_COUNT_1_BIT;
-        multisampling.minSampleShading                     = 1.0f;     // Optional.
-        multisampling.pSampleMask                          = nullptr;  // Optional.
-        multisampling.alphaToCoverageEnable                = VK_FALSE; // Optional.
-        multisampling.alphaToOneEnable                     = VK_FALSE; // Optional.
+        for( GpuTimeline* timeline : { &m_GraphicsTimeline, &m_ComputeTimeline, &m_CopyTimeline } )
+        {
+            if( vkCreateSemaphore( m_Device, &semaphoreInfo, nullptr, &timeline->m_Semaphore ) != VK_SUCCESS )
+            {
+                std::cerr << "Failed to create timeline semaphores!" << std::endl;
+                return StatusCode::Fail;
+            }
 
-        // Color blending attachment state.
-        VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
-        colorBlendAttachment.colorWriteMask                      = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-        colorBlendAttachment.blendEnable                         = VK_FALSE;
-        colorBlendAttachment.srcColorBlendFactor                 = VK_BLEND_FACTOR_ONE;  // Optional.
-        colorBlendAttachment.dstColorBlendFactor                 = VK_BLEND_FACTOR_ZERO; // Optional.
-        colorBlendAttachment.colorBlendOp                        = VK_BLEND_OP_ADD;      // Optional.
-        colorBlendAttachment.srcAlphaBlendFactor                 = VK_BLEND_FACTOR_ONE;  // Optional.
-        colorBlendAttachment.dstAlphaBlendFactor                 = VK_BLEND_FACTOR_ZERO; // Optional.
-        colorBlendAttachment.alphaBlendOp                        = VK_BLEND_OP_ADD;      // Optional.
+            timeline->m_Value = 0;
+        }
 
-        // Color blending state.
-        VkPipelineColorBlendStateCreateInfo colorBlending = {};
-        colorBlending.sType                               = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-        colorBlending.logicOpEnable                       = VK_FALSE;
-        colorBlending.logicOp                             = VK_LOGIC_OP_COPY; // Optional.
-        colorBlending.attachmentCount                     = 1;
-        colorBlending.pAttachments                        = &colorBlendAttachment;
-        colorBlending.blendConstants[0]                   = 0.0f; // Optional.
-        colorBlending.blendConstants[1]                   = 0.0f; // Optional.
-        colorBlending.blendConstants[2]                   = 0.0f; // Optional.
-        colorBlending.blendConstants[3]                   = 0.0f; // Optional.
+        return StatusCode::Success;
+    }
 
-        // Create a pipeline layout.
-        VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
-        pipelineLayoutInfo.sType                      = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-        pipelineLayoutInfo.setLayoutCount             = 1;
-        pipelineLayoutInfo.pSetLayouts                = &m_DescriptorSetLayout;
-        pipelineLayoutInfo.pushConstantRangeCount     = 0;       // Optional.
-        pipelineLayoutInfo.pPushConstantRanges        = nullptr; // Optional.
+    ////////////////////////////////////////////////////////////
+    /// Submits a command buffer which signals the next value of the timeline
+    /// and optionally a binary semaphore for presentation.
+    ////////////////////////////////////////////////////////////
+    StatusCode SubmitCommandBuffer(
+        const VkQueue                        queue,
+        const VkCommandBuffer                commandBuffer,
+        const std::vector<GpuSemaphoreWait>& waits,
+        GpuTimeline&                         timeline,
+        const VkSemaphore                    binarySemaphore,
+        uint64_t&                            timelineValue )
+    {
+        std::vector<VkSemaphore>          waitSemaphores = {};
+        std::vector<uint64_t>             waitValues     = {};
+        std::vector<VkPipelineStageFlags> waitStages     = {};
 
-        if( vkCreatePipelineLayout( m_Device, &pipelineLayoutInfo, nullptr, &m_GraphicsPipelineLayout ) != VK_SUCCESS )
+        for( const GpuSemaphoreWait& wait : waits )
         {
-            std::cerr << "Cannot create pipeline layout!" << std::endl;
+            waitSemaphores.emplace_back( wait.m_Semaphore );
+            waitValues.emplace_back( wait.m_Value );
+            waitStages.emplace_back( wait.m_Stage );
+        }
 
-            // Destroy the shader modules.
-            vkDestroyShaderModule( m_Device, fragmentShaderModule, nullptr );
-            vkDestroyShaderModule( m_Device, vertexShaderModule, nullptr );
+        const uint64_t                   value            = timeline.m_Value + 1;
+        const std::array<VkSemaphore, 2> signalSemaphores = { timeline.m_Semaphore, binarySemaphore };
+        const std::array<uint64_t, 2>    signalValues     = { value, 0 };
+        const uint32_t                   signalCount      = binarySemaphore != VK_NULL_HANDLE ? 2 : 1;
+
+        VkTimelineSemaphoreSubmitInfo timelineInfo = {};
+        timelineInfo.sType                         = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        timelineInfo.waitSemaphoreValueCount       = static_cast<uint32_t>( waitValues.size() );
+        timelineInfo.pWaitSemaphoreValues          = waitValues.data();
+        timelineInfo.signalSemaphoreValueCount     = signalCount;
+        timelineInfo.pSignalSemaphoreValues        = signalValues.data();
+
+        VkSubmitInfo submitInfo         = {};
+        submitInfo.sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.pNext                = &timelineInfo;
+        submitInfo.waitSemaphoreCount   = static_cast<uint32_t>( waitSemaphores.size() );
+        submitInfo.pWaitSemaphores      = waitSemaphores.data();
+        submitInfo.pWaitDstStageMask    = waitStages.data();
+        submitInfo.commandBufferCount   = 1;
+        submitInfo.pCommandBuffers      = &commandBuffer;
+        submitInfo.signalSemaphoreCount = signalCount;
+        submitInfo.pSignalSemaphores    = signalSemaphores.data();
 
+        if( vkQueueSubmit( queue, 1, &submitInfo, VK_NULL_HANDLE ) != VK_SUCCESS )
+        {
             return StatusCode::Fail;
         }
 
-        // Populate depth and stencil state.
-        VkPipelineDepthStencilStateCreateInfo depthStencil = {};
+        timeline.m_Value = value;
+        timelineValue    = value;
 
-        depthStencil.sType                 = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-        depthStencil.depthTestEnable       = VK_TRUE;
-        depthStencil.depthWriteEnable      = VK_TRUE;
-        depthStencil.depthCompareOp        = VK_COMPARE_OP_LESS;
-        depthStencil.depthBoundsTestEnable = VK_FALSE;
-        depthStencil.minDepthBounds        = 0.0f; // Optional.
-        depthStencil.maxDepthBounds        = 1.0f; // Optional.
-        depthStencil.stencilTestEnable     = VK_FALSE;
-        depthStencil.front                 = {}; // Optional.
-        depthStencil.back                  = {}; // Optional.
+        return StatusCode::Success;
+    }
 
-        // Populate graphics pipeline information.
-        VkGraphicsPipelineCreateInfo pipelineInfo = {};
-        pipelineInfo.sType                        = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-        pipelineInfo.stageCount                   = 2;
-        pipelineInfo.pStages                      = shaderStages;
-        pipelineInfo.pVertexInputState            = &vertexInputInfo;
-        pipelineInfo.pInputAssemblyState          = &inputAssembly;
-        pipelineInfo.pViewportState               = &viewportState;
-        pipelineInfo.pRasterizationState          = &rasterizer;
-        pipelineInfo.pMultisampleState            = &multisampling;
-        pipelineInfo.pDepthStencilState           = &depthStencil;
-        pipelineInfo.pColorBlendState             = &colorBlending;
-        pipelineInfo.pDynamicState                = nullptr; // Optional.
-        pipelineInfo.layout                       = m_GraphicsPipelineLayout;
-        pipelineInfo.renderPass                   = m_RenderPass;
-        pipelineInfo.subpass                      = 0;
-        pipelineInfo.basePipelineHandle           = VK_NULL_HANDLE; // Optional.
-        pipelineInfo.basePipelineIndex            = -1;             // Optional.
+    ////////////////////////////////////////////////////////////
+    /// Checks if the gpu has reached the timeline value.
+    ////////////////////////////////////////////////////////////
+    bool IsTimelineValueReached( const GpuTimeline& timeline, const uint64_t value ) const
+    {
+        uint64_t currentValue = 0;
 
-        // Create graphics pipeline.
-        if( vkCreateGraphicsPipelines( m_Device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_GraphicsPipeline ) != VK_SUCCESS )
+        vkGetSemaphoreCounterValue( m_Device, timeline.m_Semaphore, &currentValue );
+
+        return currentValue >= value;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Waits until the gpu reaches the timeline value.
+    ////////////////////////////////////////////////////////////
+    void WaitForTimelineValue( const GpuTimeline& timeline, const uint64_t value ) const
+    {
+        const TraceZone zone( "WaitForTimelineValue" );
+
+        VkSemaphoreWaitInfo waitInfo = {};
+        waitInfo.sType               = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+        waitInfo.semaphoreCount      = 1;
+        waitInfo.pSemaphores         = &timeline.m_Semaphore;
+        waitInfo.pValues             = &value;
+
+        vkWaitSemaphores( m_Device, &waitInfo, UINT64_MAX );
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Updates uniform buffer.
+    ////////////////////////////////////////////////////////////
+    StatusCode UpdateUniformBuffer( const uint32_t currentImage )
+    {
+        const TraceZone zone( "UpdateUniformBuffer" );
+
+        static auto startTime = std::chrono::high_resolution_clock::now();
+
+        const auto currentTime = std::chrono::high_resolution_clock::now();
+        float      time        = std::chrono::duration<float, std::chrono::seconds::period>( currentTime - startTime ).count();
+
+        // Headless frames do not depend on the rendering speed.
+        if( m_Settings.m_IsHeadless )
         {
-            std::cerr << "Cannot create graphics pipeline!" << std::endl;
+            time = m_FrameIndex / HeadlessFrameRate;
+        }
 
-            // Destroy the shader modules.
-            vkDestroyShaderModule( m_Device, fragmentShaderModule, nullptr );
-            vkDestroyShaderModule( m_Device, vertexShaderModule, nullptr );
+        UniformBufferObject ubo = {};
+
+        // Rotate only z-axis.
+        ubo.model = glm::rotate( glm::mat4( 1.0f ), time * glm::radians( 90.0f ), glm::vec3( 0.0f, 0.0f, 1.0f ) );
+
+        // Eye position, center position, up axis.
+        ubo.view = glm::lookAt( glm::vec3( 2.0f, 2.0f, 2.0f ), glm::vec3( 0.0f, 0.0f, 0.0f ), glm::vec3( 0.0f, 0.0f, -1.0f ) );
+
+        // Field of view, aspect ratio, near view plane, far view plane.
+        ubo.proj = glm::perspective( glm::radians( 45.0f ), m_SwapChainExtent.width / static_cast<float>( m_SwapChainExtent.height ), 0.1f, 10.0f );
+
+        // ubo.proj[1][1] *= -1;
+
+        // Copy data to the region of the image, the image timeline value guards it from the gpu.
+        uint32_t dynamicOffset = 0;
 
+        m_UniformRingBuffer.BeginRegion( currentImage );
+
+        if( !m_UniformRingBuffer.Push( &ubo, sizeof( ubo ), dynamicOffset ) )
+        {
+            std::cerr << "Uniform ring buffer region is full!" << std::endl;
             return StatusCode::Fail;
         }
 
-        // Destroy the shader modules.
-        vkDestroyShaderModule( m_Device, fragmentShaderModule, nullptr );
-        vkDestroyShaderModule( m_Device, vertexShaderModule, nullptr );
+        // Command buffers are recorded with the offset, so the image is recorded again if its uniforms moved.
+        if( dynamicOffset != m_UniformDynamicOffsets[currentImage] )
+        {
+            m_UniformDynamicOffsets[currentImage] = dynamicOffset;
+
+            UpdateGraphicsDescriptorSets( currentImage );
+
+            return RecordGraphicsCommandBuffer( currentImage );
+        }
 
         return StatusCode::Success;
     }
 
     ////////////////////////////////////////////////////////////
-    /// Creates compute pipeline.
+    /// Waits for the frame which used this frame slot before and starts the frame clock.
     ////////////////////////////////////////////////////////////
-    StatusCode CreateComputePipeline()
+    void BeginFrame()
     {
-        // Read the bytecode of the compute shader.
-        const auto computeShaderCode = ReadBinaryFile( "Shaders/comp.spv" );
+        WaitForTimelineValue( m_GraphicsTimeline, m_FrameTimelineValues[m_CurrentFrame] );
+
+        CollectFrameLatencies();
 
-        if( computeShaderCode.empty() )
+        const FrameClock::time_point now = FrameClock::now();
+
+        // The previous frame ends where this one starts.
+        if( m_FrameIndex > m_Settings.m_WarmupFrameCount )
         {
-            std::cerr << "Empty compute shader file!" << std::endl;
-            return StatusCode::Fail;
+            AddBenchmarkSample( BenchmarkMetric::CpuFrameTime, std::chrono::duration<double, std::milli>( now - m_PreviousFrameStartTime ).count() );
+        }
+        else if( m_FrameIndex == m_Settings.m_WarmupFrameCount )
+        {
+            m_BenchmarkStartTime = now;
         }
 
-        // Create a shader module for the compute shader.
-        VkShaderModule computeShaderModule = CreateShaderModule( computeShaderCode );
+        m_PreviousFrameStartTime          = now;
+        m_FrameStartTimes[m_CurrentFrame] = now;
+    }
 
-        // Create a compute pipeline layout.
-        VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
-        pipelineLayoutInfo.sType                      = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-        pipelineLayoutInfo.setLayoutCount             = 1;
-        pipelineLayoutInfo.pSetLayouts                = &m_ComputeDescriptorSetLayout;
+    ////////////////////////////////////////////////////////////
+    /// Checks if the warm-up of the benchmark is over.
+    ////////////////////////////////////////////////////////////
+    bool IsBenchmarkMeasuring() const
+    {
+        return m_Settings.m_IsBenchmark && m_FrameIndex >= m_Settings.m_WarmupFrameCount;
+    }
 
-        if( vkCreatePipelineLayout( m_Device, &pipelineLayoutInfo, nullptr, &m_ComputePipelineLayout ) != VK_SUCCESS )
+    ////////////////////////////////////////////////////////////
+    /// Records a benchmark sample in milliseconds, samples of warm-up frames are dropped.
+    /// Gpu samples are read a few frames late, so the first measured frames may record warm-up work.
+    ////////////////////////////////////////////////////////////
+    void AddBenchmarkSample( const BenchmarkMetric metric, const double milliseconds )
+    {
+        if( IsBenchmarkMeasuring() )
         {
-            std::cerr << "Cannot create pipeline layout!" << std::endl;
+            m_BenchmarkSamples[static_cast<uint32_t>( metric )].emplace_back( milliseconds );
+        }
+    }
 
-            // Destroy the compute shader module.
-            vkDestroyShaderModule( m_Device, computeShaderModule, nullptr );
+    ////////////////////////////////////////////////////////////
+    /// Updates rolling averages with the resolved scopes.
+    ////////////////////////////////////////////////////////////
+    void UpdateGpuProfileAverages( const std::vector<GpuProfilerResult>& results )
+    {
+        for( const GpuProfilerResult& result : results )
+        {
+            const auto [average, isInserted] = m_GpuProfileAverages.try_emplace( result.m_Name, result.m_Milliseconds );
 
-            return StatusCode::Fail;
+            if( !isInserted )
+            {
+                average->second += ( result.m_Milliseconds - average->second ) * RollingAverageWeight;
+            }
         }
+    }
 
-        // Populate compute pipeline information.
-        VkComputePipelineCreateInfo pipelineCreateInfo = {};
-        pipelineCreateInfo.sType                       = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
-        pipelineCreateInfo.stage.sType                 = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-        pipelineCreateInfo.stage.stage                 = VK_SHADER_STAGE_COMPUTE_BIT;
-        pipelineCreateInfo.stage.module                = computeShaderModule;
-        pipelineCreateInfo.stage.pName                 = "main";
-        pipelineCreateInfo.layout                      = m_ComputePipelineLayout;
+    ////////////////////////////////////////////////////////////
+    /// Prints rolling averages of the gpu profiler scopes once in a while.
+    ////////////////////////////////////////////////////////////
+    void PrintGpuProfile()
+    {
+        const FrameClock::time_point now = FrameClock::now();
 
-        // Create compute pipeline.
-        if( vkCreateComputePipelines( m_Device, VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &m_ComputePipeline ) != VK_SUCCESS )
+        if( !m_Settings.m_IsGpuProfileLogged ||
+            std::chrono::duration<double>( now - m_GpuProfileLogTime ).count() < LogIntervalSeconds )
         {
-            std::cerr << "Cannot create compute pipeline!" << std::endl;
+            return;
+        }
 
-            // Destroy the compute shader module.
-            vkDestroyShaderModule( m_Device, computeShaderModule, nullptr );
+        m_GpuProfileLogTime = now;
 
-            return StatusCode::Fail;
+        std::cout << "Gpu profile (rolling average):" << std::endl;
+
+        for( const auto* profile : { &m_GraphicsGpuProfile, &m_ComputeGpuProfile } )
+        {
+            for( const GpuProfilerResult& result : *profile )
+            {
+                std::cout << std::string( 2 * ( result.m_Depth + 1 ), ' ' ) << result.m_Name << " "
+                          << GetGpuProfileAverage( result.m_Name ) << " ms" << std::endl;
+            }
         }
 
-        // Destroy the compute shader module.
-        vkDestroyShaderModule( m_Device, computeShaderModule, nullptr );
+        std::cout << "  compute_overlap " << GetGpuProfileAverage( "compute_overlap" ) << " ms"
+                  << ( m_Settings.m_IsComputeSerialized ? " (serialized)" : " (async)" ) << std::endl;
+    }
 
-        return StatusCode::Success;
+    ////////////////////////////////////////////////////////////
+    /// Makes the next graphics submission wait for a compute timeline value.
+    /// Only graphics work consuming compute output waits, everything else overlaps the compute queue.
+    ////////////////////////////////////////////////////////////
+    void ConsumeComputeOutput( const uint64_t computeTimelineValue, const VkPipelineStageFlags dstStage )
+    {
+        m_GraphicsComputeWaits.push_back( { m_ComputeTimeline.m_Semaphore, computeTimelineValue, dstStage } );
     }
 
     ////////////////////////////////////////////////////////////
-    /// Creates shader module.
+    /// Records the gpu interval of a resolved frame and measures the dispatches that cannot overlap later frames.
+    /// Queues may not share a time domain, so intervals are intersected on the trace clock,
+    /// which makes the overlap as accurate as the calibrations of both queues.
     ////////////////////////////////////////////////////////////
-    VkShaderModule CreateShaderModule( const std::vector<char>& code )
+    void AddGraphicsFrameInterval( const std::vector<GpuProfilerResult>& results )
     {
-        VkShaderModuleCreateInfo createInfo = {};
-        createInfo.sType                    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-        createInfo.codeSize                 = code.size();
-        createInfo.pCode                    = reinterpret_cast<const uint32_t*>( code.data() );
+        const GpuProfilerResult* frame = FindGpuProfileScope( results, "frame" );
 
-        VkShaderModule shaderModule = {};
+        if( frame == nullptr || !m_GraphicsTimestampCalibration.m_IsCalibrated )
+        {
+            return;
+        }
 
-        if( vkCreateShaderModule( m_Device, &createInfo, nullptr, &shaderModule ) != VK_SUCCESS )
+        const int64_t frameBeginTime = m_GraphicsTimestampCalibration.GetTime( frame->m_BeginTimestamp );
+
+        m_GraphicsFrameIntervals.emplace_back( frameBeginTime, m_GraphicsTimestampCalibration.GetTime( frame->m_EndTimestamp ) );
+
+        if( m_GraphicsFrameIntervals.size() > ComputeOverlapFrameCount )
         {
-            std::cerr << "Cannot create shader module!" << std::endl;
-            return shaderModule;
+            m_GraphicsFrameIntervals.pop_front();
         }
 
-        return shaderModule;
+        // Graphics runs in order, so a dispatch that ended before this frame began is overlapped only by recorded frames.
+        while( !m_PendingComputeIntervals.empty() && m_PendingComputeIntervals.front().second <= frameBeginTime )
+        {
+            const auto [computeBegin, computeEnd] = m_PendingComputeIntervals.front();
+            int64_t overlap                       = 0;
+
+            for( const auto& [frameBegin, frameEnd] : m_GraphicsFrameIntervals )
+            {
+                const int64_t begin = std::max( computeBegin, frameBegin );
+                const int64_t end   = std::min( computeEnd, frameEnd );
+
+                overlap += end > begin ? end - begin : 0;
+            }
+
+            const double milliseconds = overlap / 1e6;
+
+            UpdateGpuProfileAverages( { { "compute_overlap", 0, milliseconds, 0, 0 } } );
+            AddBenchmarkSample( BenchmarkMetric::ComputeOverlap, milliseconds );
+
+            m_PendingComputeIntervals.pop_front();
+        }
     }
 
     ////////////////////////////////////////////////////////////
-    /// Creates frame buffers.
+    /// Records the gpu interval of a resolved dispatch, it is measured once the frames around it are resolved.
     ////////////////////////////////////////////////////////////
-    StatusCode CreateFramebuffers()
+    void AddComputeInterval( const std::vector<GpuProfilerResult>& results )
     {
-        // Create a frame buffer for all of the images in the swap chain.
-        m_SwapChainFramebuffers.resize( m_SwapChainImageViews.size() );
+        const GpuProfilerResult* dispatch = FindGpuProfileScope( results, "dispatch" );
 
-        for( size_t i = 0; i < m_SwapChainImageViews.size(); ++i )
+        if( dispatch == nullptr || !m_ComputeTimestampCalibration.m_IsCalibrated )
         {
-            const std::array<VkImageView, 2> attachments = { m_SwapChainImageViews[i], m_DepthImageView };
+            return;
+        }
 
-            VkFramebufferCreateInfo framebufferInfo = {};
-            framebufferInfo.sType                   = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-            framebufferInfo.renderPass              = m_RenderPass;
-            framebufferInfo.attachmentCount         = static_cast<uint32_t>( attachments.size() );
-            framebufferInfo.pAttachments            = attachments.data();
-            framebufferInfo.width                   = m_SwapChainExtent.width;
-            framebufferInfo.height                  = m_SwapChainExtent.height;
-            framebufferInfo.layers                  = 1;
+        m_PendingComputeIntervals.emplace_back(
+            m_ComputeTimestampCalibration.GetTime( dispatch->m_BeginTimestamp ),
+            m_ComputeTimestampCalibration.GetTime( dispatch->m_EndTimestamp ) );
 
-            if( vkCreateFramebuffer( m_Device, &framebufferInfo, nullptr, &m_SwapChainFramebuffers[i] ) != VK_SUCCESS )
+        // Dispatches not followed by resolved frames are dropped.
+        if( m_PendingComputeIntervals.size() > ComputeOverlapFrameCount )
+        {
+            m_PendingComputeIntervals.pop_front();
+        }
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Returns the named scope, null if it is not in the results.
+    ////////////////////////////////////////////////////////////
+    static const GpuProfilerResult* FindGpuProfileScope( const std::vector<GpuProfilerResult>& results, const std::string& name )
+    {
+        for( const GpuProfilerResult& result : results )
+        {
+            if( name == result.m_Name )
             {
-                std::cerr << "Cannot create frame buffer!" << std::endl;
-                return StatusCode::Fail;
+                return &result;
             }
         }
 
-        return StatusCode::Success;
+        return nullptr;
     }
 
     ////////////////////////////////////////////////////////////
-    /// Creates command pools.
+    /// Returns the duration of the named scope, zero if it is not in the results.
     ////////////////////////////////////////////////////////////
-    StatusCode CreateCommandPools()
+    static double GetGpuProfileScope( const std::vector<GpuProfilerResult>& results, const std::string& name )
     {
-        VkCommandPoolCreateInfo poolInfo = {};
-        poolInfo.sType                   = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-        poolInfo.queueFamilyIndex        = m_QueueFamilyIndices.m_GraphicsFamily;
-        poolInfo.flags                   = 0; // Optional.
+        for( const GpuProfilerResult& result : results )
+        {
+            if( name == result.m_Name )
+            {
+                return result.m_Milliseconds;
+            }
+        }
+
+        return 0.0;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Adds the latencies measured by the waiter thread.
+    ////////////////////////////////////////////////////////////
+    void CollectFrameLatencies()
+    {
+        std::vector<double> latencies;
 
-        // Graphics command pool.
-        if( vkCreateCommandPool( m_Device, &poolInfo, nullptr, &m_CommandPoolGraphics ) != VK_SUCCESS )
         {
-            std::cerr << "Cannot create graphics command pool!" << std::endl;
-            return StatusCode::Fail;
+            std::lock_guard<std::mutex> lock( m_FrameLatencyMutex );
+            latencies.swap( m_MeasuredFrameLatencies );
         }
 
-        // Copy command pool.
-        poolInfo.queueFamilyIndex = m_QueueFamilyIndices.m_CopyFamily;
-        poolInfo.flags            = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT; // Short-lived command buffers.
+        for( const double latency : latencies )
+        {
+            m_FrameLatencies.emplace_back( latency );
 
-        if( vkCreateCommandPool( m_Device, &poolInfo, nullptr, &m_CommandPoolCopy ) != VK_SUCCESS )
+            AddBenchmarkSample( BenchmarkMetric::FrameLatency, latency );
+        }
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Starts the thread measuring frame latencies, the graphics timeline must exist.
+    ////////////////////////////////////////////////////////////
+    void StartFrameLatencyWaiter()
+    {
+        m_IsFrameLatencyWaiterStopping = false;
+        m_FrameLatencyWaiter           = std::thread( [this]() { WaitForFrameLatencies(); } );
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Stops the thread measuring frame latencies once all submitted frames are measured.
+    ////////////////////////////////////////////////////////////
+    void StopFrameLatencyWaiter()
+    {
+        if( !m_FrameLatencyWaiter.joinable() )
+        {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock( m_FrameLatencyMutex );
+            m_IsFrameLatencyWaiterStopping = true;
+        }
+
+        m_FrameLatencyCondition.notify_one();
+        m_FrameLatencyWaiter.join();
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Measures frame latencies on the waiter thread as soon as the gpu finishes each frame,
+    /// instead of at the next frame boundary. Frames finish in timeline order, so only the oldest one is waited for.
+    ////////////////////////////////////////////////////////////
+    void WaitForFrameLatencies()
+    {
+        std::unique_lock<std::mutex> lock( m_FrameLatencyMutex );
+
+        while( true )
         {
-            std::cerr << "Cannot create copy command pool!" << std::endl;
-            return StatusCode::Fail;
-        }
+            m_FrameLatencyCondition.wait( lock, [this]() { return m_IsFrameLatencyWaiterStopping || !m_PendingFrameLatencies.empty(); } );
 
-        // Compute command pool.
-        poolInfo.queueFamilyIndex = m_QueueFamilyIndices.m_ComputeFamily;
-        poolInfo.flags            = 0; // Optional.
+            // Stopping measures the submitted frames first.
+            if( m_PendingFrameLatencies.empty() )
+            {
+                return;
+            }
 
-        if( vkCreateCommandPool( m_Device, &poolInfo, nullptr, &m_CommandPoolCompute ) != VK_SUCCESS )
-        {
-            std::cerr << "Cannot create compute command pool!" << std::endl;
-            return StatusCode::Fail;
-        }
+            const PendingFrameLatency frame = m_PendingFrameLatencies.front();
 
-        return StatusCode::Success;
+            lock.unlock();
+            WaitForTimelineValue( m_GraphicsTimeline, frame.m_TimelineValue );
+            const FrameClock::time_point now = FrameClock::now();
+            lock.lock();
+
+            m_MeasuredFrameLatencies.emplace_back( std::chrono::duration<double, std::milli>( now - frame.m_StartTime ).count() );
+            m_PendingFrameLatencies.pop_front();
+        }
     }
 
     ////////////////////////////////////////////////////////////
-    /// Creates a buffer.
+    /// Draws a frame and multiplies vector.
     ////////////////////////////////////////////////////////////
-    StatusCode CreateBuffer(
-        const VkDeviceSize                 size,
-        const VkBufferUsageFlags           usage,
-        const VkMemoryPropertyFlags        properties,
-        const uint32_t                     queueFamilyIndexCount,
-        const uint32_t*                    queueFamilyIndices,
-        VkBuffer&                          buffer,
-        std::pair<uint32_t, VkDeviceSize>& bufferGpuMemoryOffsets )
+    StatusCode DrawFrameAndMultiplyVector()
     {
-        VkBufferCreateInfo bufferInfo = {};
+        VkResult result = VK_SUCCESS;
 
-        bufferInfo.sType                 = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-        bufferInfo.size                  = size;
-        bufferInfo.usage                 = usage;
-        bufferInfo.sharingMode           = VK_SHARING_MODE_EXCLUSIVE;
-        bufferInfo.queueFamilyIndexCount = queueFamilyIndexCount;
-        bufferInfo.pQueueFamilyIndices   = queueFamilyIndices;
+        // Verify finished compute results in the background.
+        CollectComputeResults();
 
-        if( vkCreateBuffer( m_Device, &bufferInfo, nullptr, &buffer ) != VK_SUCCESS )
+        // Acquire an image from the swap chain, offscreen images are used in turn.
+        uint32_t imageIndex = static_cast<uint32_t>( m_FrameIndex % m_SwapChainImages.size() );
+
+        if( !m_Settings.m_IsHeadless )
         {
-            std::cerr << "Cannot create vertex buffer!" << std::endl;
-            return StatusCode::Fail;
-        }
+            const TraceZone              zone( "AcquireNextImage" );
+            const FrameClock::time_point acquireStart = FrameClock::now();
 
-        // Get gpu memory requirements for the buffer.
-        VkMemoryRequirements gpuMemoryRequirements = {};
+            result = vkAcquireNextImageKHR( m_Device, m_SwapChain, UINT64_MAX, m_ImageAvailableSemaphores[m_CurrentFrame], VK_NULL_HANDLE, &imageIndex );
+
+            AddBenchmarkSample( BenchmarkMetric::AcquireTime, std::chrono::duration<double, std::milli>( FrameClock::now() - acquireStart ).count() );
+        }
 
-        vkGetBufferMemoryRequirements( m_Device, buffer, &gpuMemoryRequirements );
+        // Check swap chain status and recreate it if needed.
+        if( result == VK_ERROR_OUT_OF_DATE_KHR )
+        {
+            RecreateSwapChain();
+            return StatusCode::Success;
+        }
+        else if( result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR ) // Suboptimal swap chain is ok.
+        {
+            std::cerr << "Failed to acquire swap chain image!" << std::endl;
+            return StatusCode::Fail;
+        }
 
-        // Check if buffer has enough free space.
-        if( properties == VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT )
+        // Check if a previous frame is using this image (i.e. there is its timeline value to wait on).
+        if( m_ImageTimelineValues[imageIndex] != 0 )
         {
-            VkDeviceSize&      bufferGpuMemoryUsage = m_BufferGpuMemoryLocalUsage.back();
-            const VkDeviceSize memoryAlignment      = bufferGpuMemoryUsage % gpuMemoryRequirements.alignment;
-            const VkDeviceSize requiredSize         = memoryAlignment != 0
-                        ? bufferGpuMemoryUsage + gpuMemoryRequirements.size + ( gpuMemoryRequirements.alignment - memoryAlignment )
-                        : bufferGpuMemoryUsage + gpuMemoryRequirements.size;
+            WaitForTimelineValue( m_GraphicsTimeline, m_ImageTimelineValues[imageIndex] );
 
-            if( requiredSize > m_BufferGpuMemoryLocalSize.back() )
+            // The previous frame of this image is done, so its query results and its capture are ready.
+            if( ReadPipelineStatistics( imageIndex ) != StatusCode::Success )
             {
-                m_BufferGpuMemoryLocal.emplace_back( VK_NULL_HANDLE );
-                m_BufferGpuMemoryLocalSize.emplace_back( 0 );
-                m_BufferGpuMemoryLocalUsage.emplace_back( 0 );
-            }
-            else
-            {
-                bufferGpuMemoryUsage += ( gpuMemoryRequirements.alignment - memoryAlignment ) % gpuMemoryRequirements.alignment;
+                return StatusCode::Fail;
             }
-        }
-        else
-        {
-            VkDeviceSize&      bufferGpuMemoryUsage = m_BufferGpuMemoryCpuVisibleUsage.back();
-            const VkDeviceSize memoryAlignment      = bufferGpuMemoryUsage % gpuMemoryRequirements.alignment;
-            const VkDeviceSize requiredSize         = memoryAlignment != 0
-                        ? bufferGpuMemoryUsage + gpuMemoryRequirements.size + ( gpuMemoryRequirements.alignment - memoryAlignment )
-                        : bufferGpuMemoryUsage + gpuMemoryRequirements.size;
 
-            if( requiredSize > m_BufferGpuMemoryCpuVisibleSize.back() )
+            if( !m_CaptureBuffers.empty() && WriteCapturedFrame( imageIndex ) != StatusCode::Success )
             {
-                m_BufferGpuMemoryCpuVisible.emplace_back( VK_NULL_HANDLE );
-                m_BufferGpuMemoryCpuVisibleSize.emplace_back( 0 );
-                m_BufferGpuMemoryCpuVisibleUsage.emplace_back( 0 );
+                return StatusCode::Fail;
             }
-            else
+
+            if( m_GraphicsProfiler.Resolve( m_Device, imageIndex, m_GraphicsGpuProfile ) )
             {
-                bufferGpuMemoryUsage += ( gpuMemoryRequirements.alignment - memoryAlignment ) % gpuMemoryRequirements.alignment;
+                UpdateGpuProfileAverages( m_GraphicsGpuProfile );
+                TraceGpuProfile( m_GraphicsGpuProfile, m_GraphicsTimestampCalibration, TraceGraphicsQueueTrack );
+                AddBenchmarkSample( BenchmarkMetric::GpuFrameTime, GetGpuProfileScope( m_GraphicsGpuProfile, "frame" ) );
+                AddGraphicsFrameInterval( m_GraphicsGpuProfile );
             }
         }
 
-        // Allocate buffer.
-        VkDeviceMemory& bufferGpuMemory = ( properties == VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT )
-            ? m_BufferGpuMemoryLocal.back()
-            : m_BufferGpuMemoryCpuVisible.back();
-
-        VkDeviceSize& bufferGpuMemorySize = ( properties == VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT )
-            ? m_BufferGpuMemoryLocalSize.back()
-            : m_BufferGpuMemoryCpuVisibleSize.back();
-
-        VkDeviceSize& bufferGpuMemoryUsage = ( properties == VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT )
-            ? m_BufferGpuMemoryLocalUsage.back()
-            : m_BufferGpuMemoryCpuVisibleUsage.back();
-
-        if( bufferGpuMemoryUsage == 0 )
+        // Nothing uses the command buffer of the image anymore.
+        if( UpdateImageAfterGpuMemoryMoves( imageIndex ) != StatusCode::Success )
         {
-            // Allocate gpu memory for the buffer.
-            VkMemoryAllocateInfo allocationInfo = {};
+            std::cerr << "Failed to record command buffer after gpu memory moves!" << std::endl;
+            return StatusCode::Fail;
+        }
 
-            const VkDeviceSize bytesToAllocate = ( ( gpuMemoryRequirements.size / Megabyte ) + 1 ) * Megabyte;
+        // Update uniform buffer, the gpu is done with the ring buffer region of this image.
+        if( UpdateUniformBuffer( imageIndex ) != StatusCode::Success )
+        {
+            return StatusCode::Fail;
+        }
 
-            allocationInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-            allocationInfo.allocationSize  = bytesToAllocate;
-            allocationInfo.memoryTypeIndex = FindGpuMemoryType(
-                gpuMemoryRequirements.memoryTypeBits,
-                properties );
+        const FrameClock::time_point submitStart = FrameClock::now();
 
-            if( allocationInfo.memoryTypeIndex == UINT32_MAX )
+        // The serialized baseline submits the dispatch first and makes graphics wait for it.
+        if( m_Settings.m_IsComputeSerialized )
+        {
+            if( SubmitComputeWorkload() != StatusCode::Success )
             {
-                std::cerr << "Cannot find gpu memory type!" << std::endl;
                 return StatusCode::Fail;
             }
 
-            if( vkAllocateMemory( m_Device, &allocationInfo, nullptr, &bufferGpuMemory ) != VK_SUCCESS )
+            ConsumeComputeOutput( m_ComputeTimeline.m_Value, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT );
+        }
+
+        // Submit the graphics command buffer, swap chain images still use binary semaphores.
+        std::vector<GpuSemaphoreWait> waits          = m_GraphicsComputeWaits;
+        VkSemaphore                   renderFinished = VK_NULL_HANDLE;
+
+        m_GraphicsComputeWaits.clear();
+
+        if( !m_Settings.m_IsHeadless )
+        {
+            waits.push_back( { m_ImageAvailableSemaphores[m_CurrentFrame], 0, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT } );
+            renderFinished = m_RenderFinishedSemaphores[m_CurrentFrame];
+        }
+
+        {
+            const TraceZone zone( "SubmitGraphics" );
+
+            if( SubmitCommandBuffer( m_GraphicsQueue, m_GraphicsCommandBuffers[imageIndex], waits, m_GraphicsTimeline, renderFinished, m_FrameTimelineValues[m_CurrentFrame] ) != StatusCode::Success )
             {
-                std::cerr << "Failed to allocate buffer memory!" << std::endl;
+                std::cerr << "Failed to submit draw command buffer!" << std::endl;
                 return StatusCode::Fail;
             }
-
-            bufferGpuMemorySize = bytesToAllocate;
         }
 
-        // Bind allocated gpu memory with the buffer.
-        if( bufferGpuMemoryUsage % gpuMemoryRequirements.alignment != 0 )
+        // Graphics does not consume the vector multiply, so its next dispatch runs on the compute queue while this frame renders.
+        if( !m_Settings.m_IsComputeSerialized && SubmitComputeWorkload() != StatusCode::Success )
         {
-            std::cerr << "Buffer offset      = " << bufferGpuMemoryUsage << std::endl;
-            std::cerr << "Required alignment = " << gpuMemoryRequirements.alignment << std::endl;
-            std::cerr << "Gpu memory offset is not aligned!" << std::endl;
             return StatusCode::Fail;
         }
 
-        if( vkBindBufferMemory( m_Device, buffer, bufferGpuMemory, bufferGpuMemoryUsage ) != VK_SUCCESS )
+        AddBenchmarkSample( BenchmarkMetric::SubmitTime, std::chrono::duration<double, std::milli>( FrameClock::now() - submitStart ).count() );
+
+        // Mark the image as now being in use by this frame.
+        m_ImageTimelineValues[imageIndex] = m_FrameTimelineValues[m_CurrentFrame];
+        m_ImageFrameIndices[imageIndex]   = m_FrameIndex;
+
         {
-            std::cerr << "Cannot bind buffer gpu memory!" << std::endl;
-            return StatusCode::Fail;
+            std::lock_guard<std::mutex> lock( m_FrameLatencyMutex );
+            m_PendingFrameLatencies.push_back( { m_FrameTimelineValues[m_CurrentFrame], m_FrameStartTimes[m_CurrentFrame] } );
         }
 
-        if( properties == VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT )
+        m_FrameLatencyCondition.notify_one();
+
+        if( !m_CaptureBuffers.empty() )
         {
-            bufferGpuMemoryOffsets = std::make_pair( static_cast<uint32_t>( m_BufferGpuMemoryLocal.size() - 1 ), bufferGpuMemoryUsage );
+            m_CapturedFrameIndices[imageIndex] = m_FrameIndex + 1;
         }
-        else
+
+        ++m_FrameIndex;
+
+        // Offscreen images are not presented.
+        if( m_Settings.m_IsHeadless )
+        {
+            m_CurrentFrame = ( m_CurrentFrame + 1 ) % m_FramesInFlight;
+            return StatusCode::Success;
+        }
+
+        // Present the swap chain.
+        VkPresentInfoKHR presentInfo   = {};
+        presentInfo.sType              = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+        presentInfo.waitSemaphoreCount = 1;
+        presentInfo.pWaitSemaphores    = &m_RenderFinishedSemaphores[m_CurrentFrame];
+        presentInfo.swapchainCount     = 1;
+        presentInfo.pSwapchains        = &m_SwapChain;
+        presentInfo.pImageIndices      = &imageIndex;
+        presentInfo.pResults           = nullptr; // Optional.
+
+        {
+            const TraceZone              zone( "Present" );
+            const FrameClock::time_point presentStart = FrameClock::now();
+
+            result = vkQueuePresentKHR( m_PresentQueue, &presentInfo );
+
+            AddBenchmarkSample( BenchmarkMetric::PresentTime, std::chrono::duration<double, std::milli>( FrameClock::now() - presentStart ).count() );
+        }
+
+        // Check swap chain status and recreate it if needed.
+        if( result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || m_IsFrameBufferResized )
+        {
+            m_IsFrameBufferResized = false;
+            RecreateSwapChain();
+        }
+        else if( result != VK_SUCCESS )
         {
-            bufferGpuMemoryOffsets = std::make_pair( static_cast<uint32_t>( m_BufferGpuMemoryCpuVisible.size() - 1 ), bufferGpuMemoryUsage );
+            std::cerr << "Failed to present swap chain image!" << std::endl;
+            return StatusCode::Fail;
         }
 
-        bufferGpuMemoryUsage += gpuMemoryRequirements.size;
+        m_CurrentFrame = ( m_CurrentFrame + 1 ) % m_FramesInFlight;
 
         return StatusCode::Success;
     }
 
     ////////////////////////////////////////////////////////////
-    /// Creates an image view.
+    /// Reads pipeline statistics of the image, its frame must be finished.
     ////////////////////////////////////////////////////////////
-    StatusCode CreateImageView(
-        const VkImage      image,
-        const VkFormat     format,
-        VkImageAspectFlags aspectFlags,
-        VkImageView&       imageView )
+    StatusCode ReadPipelineStatistics( const uint32_t imageIndex )
     {
-        VkImageViewCreateInfo viewInfo = {};
+        if( !m_IsPipelineStatisticsQuerySupported )
+        {
+            return StatusCode::Success;
+        }
 
-        viewInfo.sType                           = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-        viewInfo.image                           = image;
-        viewInfo.viewType                        = VK_IMAGE_VIEW_TYPE_2D;
-        viewInfo.format                          = format;
-        viewInfo.subresourceRange.aspectMask     = aspectFlags;
-        viewInfo.subresourceRange.baseMipLevel   = 0;
-        viewInfo.subresourceRange.levelCount     = 1;
-        viewInfo.subresourceRange.baseArrayLayer = 0;
-        viewInfo.subresourceRange.layerCount     = 1;
-        viewInfo.components.r                    = VK_COMPONENT_SWIZZLE_IDENTITY;
-        viewInfo.components.g                    = VK_COMPONENT_SWIZZLE_IDENTITY;
-        viewInfo.components.b                    = VK_COMPONENT_SWIZZLE_IDENTITY;
-        viewInfo.components.a                    = VK_COMPONENT_SWIZZLE_IDENTITY;
+        const size_t             queryDataSize  = m_PipelineStatistics.size() * sizeof( m_PipelineStatistics[0] );
+        const VkQueryResultFlags queryDataFlags = VK_QUERY_RESULT_64_BIT;
+        const uint32_t           queryPoolIndex = static_cast<uint32_t>( QueryType::PipelineStatistics );
 
-        if( vkCreateImageView( m_Device, &viewInfo, nullptr, &imageView ) != VK_SUCCESS )
+        const VkResult queryResult = vkGetQueryPoolResults( m_Device, m_QueryPools[queryPoolIndex], imageIndex, 1, queryDataSize, m_PipelineStatistics.data(), queryDataSize, queryDataFlags );
+
+        // Not ready only if the image was never drawn with the query, keep the previous results.
+        if( queryResult != VK_SUCCESS && queryResult != VK_NOT_READY )
         {
-            std::cerr << "Cannot create image view!" << std::endl;
+            std::cerr << "Failed to get query data!" << std::endl;
             return StatusCode::Fail;
         }
 
+        if( queryResult == VK_SUCCESS )
+        {
+            RecordPipelineStatistics( m_ImageFrameIndices[imageIndex] );
+        }
+
         return StatusCode::Success;
     }
 
     ////////////////////////////////////////////////////////////
-    /// Begins single time gpu commands within command buffer.
+    /// Derives ratios of the read pipeline statistics and updates rolling averages.
     ////////////////////////////////////////////////////////////
-    VkCommandBuffer BeginSingleTimeCommands( const bool isCopyQueueIsUsed )
+    void RecordPipelineStatistics( const uint64_t frameIndex )
     {
-        VkCommandBufferAllocateInfo allocationInfo = {};
-        VkCommandPool               commandPool    = isCopyQueueIsUsed ? m_CommandPoolCopy : m_CommandPoolGraphics;
+        const FrameClock::time_point now           = FrameClock::now();
+        const bool                   isFirstSample = m_PipelineStatisticsStartTime == FrameClock::time_point{};
 
-        allocationInfo.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-        allocationInfo.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-        allocationInfo.commandPool        = commandPool;
-        allocationInfo.commandBufferCount = 1;
+        if( isFirstSample )
+        {
+            m_PipelineStatisticsStartTime = now;
+        }
 
-        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        PipelineStatisticsSample& sample = m_PipelineStatisticsSample;
 
-        vkAllocateCommandBuffers( m_Device, &allocationInfo, &commandBuffer );
+        sample.m_FrameIndex   = frameIndex;
+        sample.m_Milliseconds = std::chrono::duration<double, std::milli>( now - m_PipelineStatisticsStartTime ).count();
 
-        VkCommandBufferBeginInfo beginInfo = {};
+        for( uint32_t i = 0; i < PipelineStatisticCount; ++i )
+        {
+            sample.m_Counters[i] = static_cast<double>( m_PipelineStatistics[i] );
+        }
 
-        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT; // Tells the driver that our intent is to use the command buffer once
-                                                                       // and wait with returning from the function until the copy operation has finished executing.
+        const double pixels              = static_cast<double>( m_SwapChainExtent.width ) * m_SwapChainExtent.height;
+        const double indices             = sample.m_Counters[1] * 3.0; // Drawn triangles, gpu culling draws only visible clusters.
+        const double clippingInvocations = sample.m_Counters[3];
+        const double clippingPrimitives  = sample.m_Counters[4];
 
-        vkBeginCommandBuffer( commandBuffer, &beginInfo );
+        sample.m_Overdraw              = pixels > 0.0 ? sample.m_Counters[5] / pixels : 0.0;
+        sample.m_VertexCacheEfficiency = indices > 0.0 ? sample.m_Counters[2] / indices : 0.0;
 
-        return commandBuffer;
-    }
+        // Clipping may split a primitive into several, so more primitives can leave clipping than entered it.
+        sample.m_ClipRejectionRate = clippingInvocations > 0.0 ? std::clamp( 1.0 - clippingPrimitives / clippingInvocations, 0.0, 1.0 ) : 0.0;
 
-    ////////////////////////////////////////////////////////////
-    /// End single time gpu commands within command buffer.
-    ////////////////////////////////////////////////////////////
-    void EndSingleTimeCommands( const bool isCopyQueueIsUsed, VkCommandBuffer commandBuffer )
-    {
-        vkEndCommandBuffer( commandBuffer );
+        // The first sample starts the averages.
+        PipelineStatisticsSample& average = m_PipelineStatisticsAverage;
+        const double              weight  = isFirstSample ? 1.0 : RollingAverageWeight;
 
-        VkSubmitInfo  submitInfo  = {};
-        VkQueue       queue       = isCopyQueueIsUsed ? m_CopyQueue : m_GraphicsQueue;
-        VkCommandPool commandPool = isCopyQueueIsUsed ? m_CommandPoolCopy : m_CommandPoolGraphics;
+        for( uint32_t i = 0; i < PipelineStatisticCount; ++i )
+        {
+            average.m_Counters[i] += ( sample.m_Counters[i] - average.m_Counters[i] ) * weight;
+        }
 
-        submitInfo.sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-        submitInfo.commandBufferCount = 1;
-        submitInfo.pCommandBuffers    = &commandBuffer;
+        average.m_Overdraw += ( sample.m_Overdraw - average.m_Overdraw ) * weight;
+        average.m_VertexCacheEfficiency += ( sample.m_VertexCacheEfficiency - average.m_VertexCacheEfficiency ) * weight;
+        average.m_ClipRejectionRate += ( sample.m_ClipRejectionRate - average.m_ClipRejectionRate ) * weight;
+        average.m_FrameIndex   = sample.m_FrameIndex;
+        average.m_Milliseconds = sample.m_Milliseconds;
 
-        vkQueueSubmit( queue, 1, &submitInfo, VK_NULL_HANDLE );
+        if( m_Settings.m_PipelineStatisticsExport == PipelineStatisticsExport::Csv ||
+            m_Settings.m_PipelineStatisticsExport == PipelineStatisticsExport::ChromeTrace )
+        {
+            m_PipelineStatisticsSamples.emplace_back( sample );
+        }
+    }
 
-        // Wait for the queue to become idle.
-        vkQueueWaitIdle( queue );
+    ////////////////////////////////////////////////////////////
+    /// Returns the name of the pipeline statistic.
+    ////////////////////////////////////////////////////////////
+    static const char* GetPipelineStatisticName( const uint32_t statistic )
+    {
+        constexpr std::array<const char*, PipelineStatisticCount> names = {
+            "input_assembly_vertices",
+            "input_assembly_primitives",
+            "vertex_shader_invocations",
+            "clipping_invocations",
+            "clipping_primitives",
+            "fragment_shader_invocations",
+            "compute_shader_invocations"
+        };
 
-        vkFreeCommandBuffers( m_Device, commandPool, 1, &commandBuffer );
+        return names[statistic];
     }
 
     ////////////////////////////////////////////////////////////
-    /// Copies data from one buffer to another.
+    /// Prints pipeline statistics of the latest frame and their rolling averages once in a while.
     ////////////////////////////////////////////////////////////
-    void CopyBuffer( const VkBuffer srcBuffer, const VkBuffer dstBuffer, const VkDeviceSize size )
+    void PrintPipelineStatistics()
     {
-        const bool      isCopyQueueIsUsed = true;
-        VkCommandBuffer commandBuffer     = BeginSingleTimeCommands( isCopyQueueIsUsed );
+        const FrameClock::time_point now = FrameClock::now();
 
-        VkBufferCopy copyRegion = {};
+        if( m_Settings.m_PipelineStatisticsExport != PipelineStatisticsExport::Stdout ||
+            m_PipelineStatistics.empty() ||
+            std::chrono::duration<double>( now - m_PipelineStatisticsLogTime ).count() < LogIntervalSeconds )
+        {
+            return;
+        }
+
+        m_PipelineStatisticsLogTime = now;
 
-        copyRegion.srcOffset = 0; // Optional.
-        copyRegion.dstOffset = 0; // Optional.
-        copyRegion.size      = size;
+        const PipelineStatisticsSample& sample  = m_PipelineStatisticsSample;
+        const PipelineStatisticsSample& average = m_PipelineStatisticsAverage;
 
-        vkCmdCopyBuffer( commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion );
+        std::cout << "Pipeline statistics of frame " << sample.m_FrameIndex << " (rolling average):" << std::endl;
+
+        for( uint32_t i = 0; i < PipelineStatisticCount; ++i )
+        {
+            std::cout << "  " << GetPipelineStatisticName( i ) << " " << sample.m_Counters[i] << " (" << average.m_Counters[i] << ")" << std::endl;
+        }
 
-        EndSingleTimeCommands( isCopyQueueIsUsed, commandBuffer );
+        std::cout << "  overdraw " << sample.m_Overdraw << " (" << average.m_Overdraw << ")" << std::endl
+                  << "  vertex_cache_efficiency " << sample.m_VertexCacheEfficiency << " (" << average.m_VertexCacheEfficiency << ")" << std::endl
+                  << "  clip_rejection_rate " << sample.m_ClipRejectionRate << " (" << average.m_ClipRejectionRate << ")" << std::endl;
     }
 
     ////////////////////////////////////////////////////////////
-    /// Handles image layout transitions .
+    /// Writes pipeline statistics of all frames as csv or chrome trace counter events.
     ////////////////////////////////////////////////////////////
-    StatusCode TransitionImageLayout(
-        const VkImage       image,
-        const VkFormat      format,
-        const VkImageLayout oldLayout,
-        const VkImageLayout newLayout )
+    StatusCode WritePipelineStatistics() const
     {
-        const bool      isCopyQueueIsUsed = false;
-        VkCommandBuffer commandBuffer     = BeginSingleTimeCommands( isCopyQueueIsUsed );
+        const bool isCsv   = m_Settings.m_PipelineStatisticsExport == PipelineStatisticsExport::Csv;
+        const bool isTrace = m_Settings.m_PipelineStatisticsExport == PipelineStatisticsExport::ChromeTrace;
 
-        VkImageMemoryBarrier barrier          = {};
-        VkPipelineStageFlags sourceStage      = 0;
-        VkPipelineStageFlags destinationStage = 0;
+        if( !isCsv && !isTrace )
+        {
+            return StatusCode::Success;
+        }
 
-        barrier.sType                           = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-        barrier.oldLayout                       = oldLayout;
-        barrier.newLayout                       = newLayout;
-        barrier.srcQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
-        barrier.dstQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
-        barrier.image                           = image;
-        barrier.subresourceRange.baseMipLevel   = 0;
-        barrier.subresourceRange.levelCount     = 1;
-        barrier.subresourceRange.baseArrayLayer = 0;
-        barrier.subresourceRange.layerCount     = 1;
+        std::ofstream file( m_Settings.m_PipelineStatisticsOutput );
 
-        // For depth testing.
-        if( newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL )
+        if( !file.is_open() )
         {
-            barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+            std::cerr << "Cannot open " << m_Settings.m_PipelineStatisticsOutput << " file!" << std::endl;
+            return StatusCode::Fail;
+        }
 
-            if( HasStencilComponent( format ) )
+        if( isCsv )
+        {
+            file << "frame,milliseconds";
+
+            for( uint32_t i = 0; i < PipelineStatisticCount; ++i )
             {
-                barrier.subresourceRange.aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
+                file << "," << GetPipelineStatisticName( i );
             }
-        }
-        else
-        {
-            barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        }
 
-        if( oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL )
-        {
-            barrier.srcAccessMask = 0;
-            barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            file << ",overdraw,vertex_cache_efficiency,clip_rejection_rate\n";
 
-            sourceStage      = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-            destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-        }
-        else if( oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL )
-        {
-            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            for( const PipelineStatisticsSample& sample : m_PipelineStatisticsSamples )
+            {
+                file << sample.m_FrameIndex << "," << sample.m_Milliseconds;
 
-            sourceStage      = VK_PIPELINE_STAGE_TRANSFER_BIT;
-            destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-        }
-        else if( oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL )
-        {
-            barrier.srcAccessMask = 0;
-            barrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+                for( const double counter : sample.m_Counters )
+                {
+                    file << "," << counter;
+                }
 
-            sourceStage      = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-            destinationStage = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+                file << "," << sample.m_Overdraw << "," << sample.m_VertexCacheEfficiency << "," << sample.m_ClipRejectionRate << "\n";
+            }
         }
         else
         {
-            std::cerr << "Unsupported layout transition!" << std::endl;
-            return StatusCode::Fail;
-        }
+            // Counters and ratios are separate tracks, because their scales differ.
+            file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
 
-        vkCmdPipelineBarrier(
-            commandBuffer,
-            sourceStage,
-            destinationStage,
-            0,
-            0,
-            nullptr,
-            0,
-            nullptr,
-            1,
-            &barrier );
+            bool isFirst = true;
+
+            for( const PipelineStatisticsSample& sample : m_PipelineStatisticsSamples )
+            {
+                const uint64_t microseconds = static_cast<uint64_t>( sample.m_Milliseconds * 1000.0 );
 
-        EndSingleTimeCommands( isCopyQueueIsUsed, commandBuffer );
+                file << ( isFirst ? "\n" : ",\n" )
+                     << "{\"name\": \"pipeline_statistics\", \"ph\": \"C\", \"pid\": 1, \"tid\": 1, \"ts\": " << microseconds << ", \"args\": {";
 
-        return StatusCode::Success;
+                for( uint32_t i = 0; i < PipelineStatisticCount; ++i )
+                {
+                    file << ( i == 0 ? "" : ", " ) << "\"" << GetPipelineStatisticName( i ) << "\": " << sample.m_Counters[i];
+                }
+
+                file << "}},\n"
+                     << "{\"name\": \"pipeline_ratios\", \"ph\": \"C\", \"pid\": 1, \"tid\": 1, \"ts\": " << microseconds << ", \"args\": {"
+                     << "\"overdraw\": " << sample.m_Overdraw
+                     << ", \"vertex_cache_efficiency\": " << sample.m_VertexCacheEfficiency
+                     << ", \"clip_rejection_rate\": " << sample.m_ClipRejectionRate << "}}";
+
+                isFirst = false;
+            }
+
+            file << "\n]}\n";
+        }
+
+        return file.good() ? StatusCode::Success : StatusCode::Fail;
     }
 
     ////////////////////////////////////////////////////////////
-    /// Copies data from a buffer to an image.
+    /// Submits the compute workload, its results are read back a few frames later.
     ////////////////////////////////////////////////////////////
-    void CopyBufferToImage(
-        const VkBuffer buffer,
-        const VkImage  image,
-        const uint32_t width,
-        const uint32_t height )
+    StatusCode SubmitComputeWorkload()
     {
-        const bool      isCopyQueueIsUsed = true;
-        VkCommandBuffer commandBuffer     = BeginSingleTimeCommands( isCopyQueueIsUsed );
+        const TraceZone zone( "SubmitComputeWorkload" );
+
+        const uint32_t readbackIndex = m_ComputeReadbackIndex;
+
+        // Results in the readback buffer must be verified before the next dispatch overwrites them.
+        if( m_IsComputeResultPending[readbackIndex] )
+        {
+            WaitForTimelineValue( m_ComputeTimeline, m_ComputeTimelineValues[readbackIndex] );
+            StartComputeVerification( readbackIndex );
+        }
 
-        VkBufferImageCopy region = {};
+        if( m_ComputeVerifications[readbackIndex].valid() &&
+            m_ComputeVerifications[readbackIndex].get() != StatusCode::Success )
+        {
+            std::cerr << "Failed to verify compute workload!" << std::endl;
+            return StatusCode::Fail;
+        }
 
-        region.bufferOffset      = 0;
-        region.bufferRowLength   = 0;
-        region.bufferImageHeight = 0;
+        // Nothing uses the command buffers of the readback buffer anymore.
+        if( UpdateReadbackAfterGpuMemoryMoves( readbackIndex ) != StatusCode::Success )
+        {
+            std::cerr << "Failed to record compute command buffers after gpu memory moves!" << std::endl;
+            return StatusCode::Fail;
+        }
 
-        region.imageSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
-        region.imageSubresource.mipLevel       = 0;
-        region.imageSubresource.baseArrayLayer = 0;
-        region.imageSubresource.layerCount     = 1;
+        // Results are read back only when they are verified.
+        const bool     isReadback    = m_FrameIndex % std::max( m_Settings.m_ComputeReadbackInterval, 1u ) == 0;
+        const uint32_t commandBuffer = isReadback ? readbackIndex : m_ComputeReadbackCount + readbackIndex;
 
-        region.imageOffset = { 0, 0, 0 };
-        region.imageExtent = { width, height, 1 };
+        if( SubmitCommandBuffer( m_ComputeQueue, m_ComputeCommandBuffers[commandBuffer], {}, m_ComputeTimeline, VK_NULL_HANDLE, m_ComputeTimelineValues[readbackIndex] ) != StatusCode::Success )
+        {
+            std::cerr << "Failed to submit dispatch command buffer!" << std::endl;
+            return StatusCode::Fail;
+        }
 
-        vkCmdCopyBufferToImage(
-            commandBuffer,
-            buffer,
-            image,
-            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-            1,
-            &region );
+        m_IsComputeResultPending[readbackIndex]     = true;
+        m_IsComputeReadbackSubmitted[readbackIndex] = isReadback;
+        m_ComputeReadbackIndex                      = ( readbackIndex + 1 ) % m_ComputeReadbackCount;
 
-        EndSingleTimeCommands( isCopyQueueIsUsed, commandBuffer );
+        return StatusCode::Success;
     }
 
     ////////////////////////////////////////////////////////////
-    /// Creates texture image.
+    /// Streams chunks through upload, dispatch and readback and prints the sustained throughput.
+    /// Chunks in consecutive slots overlap: the copy queue uploads a chunk and reads back the previous one
+    /// while the compute queue multiplies, and the cpu produces the next chunk meanwhile.
     ////////////////////////////////////////////////////////////
-    StatusCode CreateImage(
-        const uint32_t                     textureWidth,
-        const uint32_t                     textureHeight,
-        const VkFormat                     format,
-        const VkImageTiling                tiling,
-        const VkImageUsageFlags            usage,
-        const VkMemoryPropertyFlags        properties,
-        VkImage&                           image,
-        std::pair<uint32_t, VkDeviceSize>& bufferGpuMemoryOffsets )
+    StatusCode RunComputeStream()
     {
-        VkImageCreateInfo imageInfo = {};
+        const TraceZone zone( "RunComputeStream" );
 
-        imageInfo.sType         = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-        imageInfo.imageType     = VK_IMAGE_TYPE_2D;
-        imageInfo.extent.width  = textureWidth;
-        imageInfo.extent.height = textureHeight;
-        imageInfo.extent.depth  = 1;
-        imageInfo.mipLevels     = 1;
-        imageInfo.arrayLayers   = 1;
-        imageInfo.format        = format;
-        imageInfo.tiling        = tiling;
-        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        imageInfo.usage         = usage;
-        imageInfo.sharingMode   = VK_SHARING_MODE_EXCLUSIVE;
-        imageInfo.samples       = VK_SAMPLE_COUNT_1_BIT;
-        imageInfo.flags         = 0; // Optional.
+        StatusCode result = CreateComputeStream();
 
-        if( vkCreateImage( m_Device, &imageInfo, nullptr, &image ) != VK_SUCCESS )
+        const uint32_t chunkCount = m_Settings.m_ComputeStreamChunkCount;
+        const uint32_t slotCount  = static_cast<uint32_t>( m_ComputeStreamSlots.size() );
+        const auto     start      = FrameClock::now();
+
+        // The readback of each chunk is submitted after the upload of the next one, so copies of both overlap the dispatch.
+        for( uint32_t chunk = 0; result == StatusCode::Success && chunk <= chunkCount; ++chunk )
         {
-            std::cerr << "Cannot create image!" << std::endl;
-            return StatusCode::Fail;
-        }
+            if( chunk < chunkCount )
+            {
+                ComputeStreamSlot& slot = m_ComputeStreamSlots[chunk % slotCount];
 
-        // Get gpu memory requirements for the image.
-        VkMemoryRequirements gpuMemoryRequirements = {};
+                if( slot.m_IsInFlight )
+                {
+                    result = ConsumeComputeChunk( slot );
+                }
 
-        vkGetImageMemoryRequirements( m_Device, image, &gpuMemoryRequirements );
+                if( result == StatusCode::Success )
+                {
+                    ProduceComputeChunk( slot, chunk );
+                    result = SubmitComputeChunk( slot );
+                }
+            }
 
-        // Check if buffer has enough free space.
-        if( properties == VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT )
-        {
-            if( ( m_BufferGpuMemoryLocalUsage.back() + gpuMemoryRequirements.size ) > m_BufferGpuMemoryLocalSize.back() )
+            if( result == StatusCode::Success && chunk != 0 )
             {
-                m_BufferGpuMemoryLocal.emplace_back( VK_NULL_HANDLE );
-                m_BufferGpuMemoryLocalSize.emplace_back( 0 );
-                m_BufferGpuMemoryLocalUsage.emplace_back( 0 );
+                result = SubmitComputeChunkReadback( m_ComputeStreamSlots[( chunk - 1 ) % slotCount] );
             }
         }
-        else
+
+        for( ComputeStreamSlot& slot : m_ComputeStreamSlots )
         {
-            if( ( m_BufferGpuMemoryCpuVisibleUsage.back() + gpuMemoryRequirements.size ) > m_BufferGpuMemoryCpuVisibleSize.back() )
+            if( result == StatusCode::Success && slot.m_IsInFlight )
             {
-                m_BufferGpuMemoryCpuVisible.emplace_back( VK_NULL_HANDLE );
-                m_BufferGpuMemoryCpuVisibleSize.emplace_back( 0 );
-                m_BufferGpuMemoryCpuVisibleUsage.emplace_back( 0 );
+                result = ConsumeComputeChunk( slot );
             }
         }
 
-        // Allocate buffer.
-        VkDeviceMemory& bufferGpuMemory = ( properties == VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT )
-            ? m_BufferGpuMemoryLocal.back()
-            : m_BufferGpuMemoryCpuVisible.back();
+        const double seconds = std::chrono::duration<double>( FrameClock::now() - start ).count();
 
-        VkDeviceSize& bufferGpuMemorySize = ( properties == VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT )
-            ? m_BufferGpuMemoryLocalSize.back()
-            : m_BufferGpuMemoryCpuVisibleSize.back();
+        DestroyComputeStream();
 
-        VkDeviceSize& bufferGpuMemoryUsage = ( properties == VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT )
-            ? m_BufferGpuMemoryLocalUsage.back()
-            : m_BufferGpuMemoryCpuVisibleUsage.back();
-
-        if( bufferGpuMemoryUsage == 0 )
+        if( result != StatusCode::Success )
         {
-            VkMemoryAllocateInfo allocationInfo = {};
+            std::cerr << "Compute stream failed!" << std::endl;
+            return result;
+        }
+
+        // Both inputs are uploaded and the result is read back.
+        const double bytes = 3.0 * sizeof( float ) * m_VectorElementCount * chunkCount;
+
+        std::cout << "Compute stream (" << slotCount << " slots): " << chunkCount << " chunks of " << m_VectorElementCount << " elements in " << seconds << " s, "
+                  << bytes / std::max( seconds, 1e-9 ) / 1e9 << " GB/s sustained" << std::endl;
+
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Creates buffers, descriptor sets and command buffers of the compute stream slots.
+    ////////////////////////////////////////////////////////////
+    StatusCode CreateComputeStream()
+    {
+        const uint32_t     slotCount  = std::clamp( m_Settings.m_ComputeStreamSlotCount != 0 ? m_Settings.m_ComputeStreamSlotCount : MaxComputeStreamSlotCount, MinComputeStreamSlotCount, MaxComputeStreamSlotCount );
+        const VkDeviceSize bufferSize = m_VectorElementCount * sizeof( float );
 
-            const VkDeviceSize bytesToAllocate = ( ( gpuMemoryRequirements.size / Megabyte ) + 1 ) * Megabyte;
+        m_ComputeStreamSlots.resize( slotCount );
 
-            allocationInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-            allocationInfo.allocationSize  = bytesToAllocate;
-            allocationInfo.memoryTypeIndex = FindGpuMemoryType( gpuMemoryRequirements.memoryTypeBits, properties );
+        for( ComputeStreamSlot& slot : m_ComputeStreamSlots )
+        {
+            StatusCode result = StatusCode::Success;
 
-            if( allocationInfo.memoryTypeIndex == UINT32_MAX )
+            // The cpu writes the staging buffers directly, without reading them.
+            for( uint32_t i = 0; result == StatusCode::Success && i < slot.m_StagingBuffers.size(); ++i )
             {
-                std::cerr << "Cannot find gpu memory type!" << std::endl;
-                return StatusCode::Fail;
+                result = CreateBuffer(
+                    bufferSize,
+                    VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                    { VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 0, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT },
+                    1,
+                    &m_QueueFamilyIndices.m_CopyFamily,
+                    slot.m_StagingBuffers[i],
+                    slot.m_StagingBuffersGpuMemoryOffsets[i] );
             }
 
-            if( vkAllocateMemory( m_Device, &allocationInfo, nullptr, &bufferGpuMemory ) != VK_SUCCESS )
+            for( uint32_t i = 0; result == StatusCode::Success && i < slot.m_Buffers.size(); ++i )
             {
-                std::cerr << "Cannot allocate image memory!" << std::endl;
-                return StatusCode::Fail;
+                result = CreateBuffer(
+                    bufferSize,
+                    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                    { VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT },
+                    1,
+                    &m_QueueFamilyIndices.m_ComputeFamily,
+                    slot.m_Buffers[i],
+                    slot.m_BuffersGpuMemoryOffsets[i] );
             }
 
-            bufferGpuMemorySize = bytesToAllocate;
-        }
+            if( result == StatusCode::Success )
+            {
+                result = CreateBuffer(
+                    bufferSize,
+                    VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                    { VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_MEMORY_PROPERTY_HOST_CACHED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT },
+                    1,
+                    &m_QueueFamilyIndices.m_CopyFamily,
+                    slot.m_ReadbackBuffer,
+                    slot.m_ReadbackBufferGpuMemoryOffsets );
+            }
 
-        // Bind allocated gpu memory with the given buffer.
-        if( bufferGpuMemoryUsage % gpuMemoryRequirements.alignment != 0 )
-        {
-            std::cerr << "Buffer offset      = " << bufferGpuMemoryUsage << std::endl;
-            std::cerr << "Required alignment = " << gpuMemoryRequirements.alignment << std::endl;
-            std::cerr << "Gpu memory offset is not aligned!" << std::endl;
-            return StatusCode::Fail;
-        }
+            if( result == StatusCode::Success )
+            {
+                result = CreateComputeStreamCommandBuffers( slot );
+            }
 
-        if( vkBindImageMemory( m_Device, image, bufferGpuMemory, bufferGpuMemoryUsage ) != VK_SUCCESS )
-        {
-            std::cerr << "Cannot bind buffer gpu memory!" << std::endl;
-            return StatusCode::Fail;
-        }
+            if( result != StatusCode::Success )
+            {
+                std::cerr << "Cannot create compute stream slot!" << std::endl;
+                return StatusCode::Fail;
+            }
 
-        if( properties == VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT )
-        {
-            bufferGpuMemoryOffsets = std::make_pair( static_cast<uint32_t>( m_BufferGpuMemoryLocal.size() - 1 ), bufferGpuMemoryUsage );
-        }
-        else
-        {
-            bufferGpuMemoryOffsets = std::make_pair( static_cast<uint32_t>( m_BufferGpuMemoryCpuVisible.size() - 1 ), bufferGpuMemoryUsage );
+            slot.m_Results.resize( m_VectorElementCount );
         }
 
-        bufferGpuMemoryUsage += gpuMemoryRequirements.size;
-
         return StatusCode::Success;
     }
 
     ////////////////////////////////////////////////////////////
-    /// Creates depth resources.
+    /// Allocates the descriptor set of a compute stream slot and records its command buffers.
+    /// Inputs move from the copy to the compute queue family, results back. Stale contents are discarded without transfers.
     ////////////////////////////////////////////////////////////
-    StatusCode CreateDepthResources()
+    StatusCode CreateComputeStreamCommandBuffers( ComputeStreamSlot& slot )
     {
-        StatusCode     result      = StatusCode::Success;
-        const VkFormat depthFormat = FindDepthFormat();
-
-        result = CreateImage(
-            m_SwapChainExtent.width,
-            m_SwapChainExtent.height,
-            depthFormat,
-            VK_IMAGE_TILING_OPTIMAL,
-            VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-            m_DepthImage,
-            m_DepthImageGpuMemoryOffset );
+        // Stream slots share the pool of compute jobs.
+        VkDescriptorSetAllocateInfo setAllocationInfo = {};
+        setAllocationInfo.sType                       = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        setAllocationInfo.descriptorPool              = m_ComputeJobDescriptorPool;
+        setAllocationInfo.descriptorSetCount          = 1;
+        setAllocationInfo.pSetLayouts                 = &m_ComputeDescriptorSetLayout;
 
-        if( result != StatusCode::Success )
+        if( vkAllocateDescriptorSets( m_Device, &setAllocationInfo, &slot.m_DescriptorSet ) != VK_SUCCESS )
         {
-            std::cerr << "Cannot create image for depth!" << std::endl;
             return StatusCode::Fail;
         }
 
-        result = CreateImageView(
-            m_DepthImage,
-            depthFormat,
-            VK_IMAGE_ASPECT_DEPTH_BIT,
-            m_DepthImageView );
+        std::array<VkDescriptorBufferInfo, 3> bufferInfos         = {};
+        std::array<VkWriteDescriptorSet, 3>   writeDescriptorSets = {};
 
-        if( result != StatusCode::Success )
+        for( uint32_t i = 0; i < bufferInfos.size(); ++i )
         {
-            std::cerr << "Cannot create image view for depth!" << std::endl;
-            return StatusCode::Fail;
+            bufferInfos[i].buffer = slot.m_Buffers[i];
+            bufferInfos[i].offset = 0;
+            bufferInfos[i].range  = VK_WHOLE_SIZE;
+
+            writeDescriptorSets[i].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writeDescriptorSets[i].dstSet          = slot.m_DescriptorSet;
+            writeDescriptorSets[i].dstBinding      = i;
+            writeDescriptorSets[i].descriptorCount = 1;
+            writeDescriptorSets[i].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            writeDescriptorSets[i].pBufferInfo     = &bufferInfos[i];
         }
 
-        TransitionImageLayout(
-            m_DepthImage,
-            depthFormat,
-            VK_IMAGE_LAYOUT_UNDEFINED,
-            VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL );
+        vkUpdateDescriptorSets( m_Device, static_cast<uint32_t>( writeDescriptorSets.size() ), writeDescriptorSets.data(), 0, nullptr );
 
-        return StatusCode::Success;
-    }
+        VkCommandBufferAllocateInfo allocationInfo = {};
+        allocationInfo.sType                       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocationInfo.level                       = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocationInfo.commandBufferCount          = 1;
 
-    ////////////////////////////////////////////////////////////
-    /// Creates texture image.
-    ////////////////////////////////////////////////////////////
-    StatusCode CreateTextureImage()
-    {
-        constexpr uint32_t bytesPerPixel   = 4;
-        int32_t            textureWidth    = 0;
-        int32_t            textureHeight   = 0;
-        int32_t            textureChannels = 0;
-        // std::string        textureFileName = "Textures/texture.jpg";
-        std::string textureFileName = "Textures/viking_room.png";
-        StatusCode  result          = StatusCode::Success;
+        allocationInfo.commandPool = m_CommandPoolCopy;
+
+        if( vkAllocateCommandBuffers( m_Device, &allocationInfo, &slot.m_UploadCommandBuffer ) != VK_SUCCESS ||
+            vkAllocateCommandBuffers( m_Device, &allocationInfo, &slot.m_ReadbackCommandBuffer ) != VK_SUCCESS )
+        {
+            return StatusCode::Fail;
+        }
 
-        Pixels* pixels = StbImage::loadRgba( textureFileName, textureWidth, textureHeight, textureChannels );
+        allocationInfo.commandPool = m_CommandPoolCompute;
 
-        if( pixels == nullptr )
+        if( vkAllocateCommandBuffers( m_Device, &allocationInfo, &slot.m_DispatchCommandBuffer ) != VK_SUCCESS )
         {
-            std::cerr << "Failed to load texture image!" << std::endl;
             return StatusCode::Fail;
         }
 
-        const VkDeviceSize imageSize = textureWidth * textureHeight * bytesPerPixel;
+        const bool isOwnershipTransferred = m_QueueFamilyIndices.m_CopyFamily != m_QueueFamilyIndices.m_ComputeFamily;
+        const auto getTransferBarrier     = []( const VkBuffer buffer, const VkAccessFlags srcAccess, const VkAccessFlags dstAccess, const uint32_t srcQueueFamily, const uint32_t dstQueueFamily ) {
+            VkBufferMemoryBarrier barrier = {};
+            barrier.sType                 = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            barrier.srcAccessMask         = srcAccess;
+            barrier.dstAccessMask         = dstAccess;
+            barrier.srcQueueFamilyIndex   = srcQueueFamily;
+            barrier.dstQueueFamilyIndex   = dstQueueFamily;
+            barrier.buffer                = buffer;
+            barrier.offset                = 0;
+            barrier.size                  = VK_WHOLE_SIZE;
+            return barrier;
+        };
 
-        VkBuffer                          stagingBuffer        = VK_NULL_HANDLE;
-        std::pair<uint32_t, VkDeviceSize> stagingBufferOffsets = {};
+        const uint32_t copyFamily    = m_QueueFamilyIndices.m_CopyFamily;
+        const uint32_t computeFamily = m_QueueFamilyIndices.m_ComputeFamily;
 
-        result = CreateBuffer(
-            imageSize,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            0,
-            nullptr,
-            stagingBuffer,
-            stagingBufferOffsets );
+        VkBufferCopy copyRegion = {};
+        copyRegion.size         = m_VectorElementCount * sizeof( float );
 
-        if( result != StatusCode::Success )
+        VkCommandBufferBeginInfo beginInfo = {};
+        beginInfo.sType                    = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+
+        // Upload, the semaphores between the queues make the copies visible.
+        vkBeginCommandBuffer( slot.m_UploadCommandBuffer, &beginInfo );
+
+        for( uint32_t i = 0; i < slot.m_StagingBuffers.size(); ++i )
         {
-            std::cerr << "Cannot create staging buffer for texture image!" << std::endl;
-            return StatusCode::Fail;
+            vkCmdCopyBuffer( slot.m_UploadCommandBuffer, slot.m_StagingBuffers[i], slot.m_Buffers[i], 1, &copyRegion );
         }
 
-        // Copy the texture to staging buffer.
-        void* data                  = nullptr;
-        auto  bufferGpuMemory       = m_BufferGpuMemoryCpuVisible[std::get<0>( stagingBufferOffsets )];
-        auto  bufferGpuMemoryOffset = std::get<1>( stagingBufferOffsets );
+        if( isOwnershipTransferred )
+        {
+            // Release.
+            const std::array<VkBufferMemoryBarrier, 2> barriers = {
+                getTransferBarrier( slot.m_Buffers[0], VK_ACCESS_TRANSFER_WRITE_BIT, 0, copyFamily, computeFamily ),
+                getTransferBarrier( slot.m_Buffers[1], VK_ACCESS_TRANSFER_WRITE_BIT, 0, copyFamily, computeFamily )
+            };
 
-        vkMapMemory( m_Device, bufferGpuMemory, bufferGpuMemoryOffset, imageSize, 0, &data );
-        memcpy( data, pixels, static_cast<size_t>( imageSize ) );
-        vkUnmapMemory( m_Device, bufferGpuMemory );
+            vkCmdPipelineBarrier( slot.m_UploadCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, static_cast<uint32_t>( barriers.size() ), barriers.data(), 0, nullptr );
+        }
 
-        // Free texture.
-        StbImage::unloadRbga( pixels );
+        vkEndCommandBuffer( slot.m_UploadCommandBuffer );
 
-        // Create image.
-        result = CreateImage(
-            textureWidth,
-            textureHeight,
-            VK_FORMAT_R8G8B8A8_SRGB,
-            VK_IMAGE_TILING_OPTIMAL,
-            VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-            m_TextureImage,
-            m_TextureImageGpuMemoryOffset );
+        // Dispatch.
+        vkBeginCommandBuffer( slot.m_DispatchCommandBuffer, &beginInfo );
 
-        if( result != StatusCode::Success )
+        if( isOwnershipTransferred )
         {
-            std::cerr << "Cannot create image for texture image!" << std::endl;
-            return StatusCode::Fail;
+            // Acquire.
+            const std::array<VkBufferMemoryBarrier, 2> barriers = {
+                getTransferBarrier( slot.m_Buffers[0], 0, VK_ACCESS_SHADER_READ_BIT, copyFamily, computeFamily ),
+                getTransferBarrier( slot.m_Buffers[1], 0, VK_ACCESS_SHADER_READ_BIT, copyFamily, computeFamily )
+            };
+
+            vkCmdPipelineBarrier( slot.m_DispatchCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, static_cast<uint32_t>( barriers.size() ), barriers.data(), 0, nullptr );
         }
 
-        // Transition image layout from undefined to transfer destination.
-        result = TransitionImageLayout(
-            m_TextureImage,
-            VK_FORMAT_R8G8B8A8_SRGB,
-            VK_IMAGE_LAYOUT_UNDEFINED,
-            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL );
+        vkCmdBindPipeline( slot.m_DispatchCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_ComputePipeline );
+        vkCmdBindDescriptorSets( slot.m_DispatchCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_ComputePipelineLayout, 0, 1, &slot.m_DescriptorSet, 0, nullptr );
+        vkCmdPushConstants( slot.m_DispatchCommandBuffer, m_ComputePipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof( m_VectorElementCount ), &m_VectorElementCount );
+        vkCmdDispatch( slot.m_DispatchCommandBuffer, m_ComputeDispatchSize[0], m_ComputeDispatchSize[1], m_ComputeDispatchSize[2] );
 
-        if( result != StatusCode::Success )
+        if( isOwnershipTransferred )
         {
-            std::cerr << "Cannot handle image layout transition!" << std::endl;
-            return StatusCode::Fail;
+            // Release.
+            const VkBufferMemoryBarrier barrier = getTransferBarrier( slot.m_Buffers[2], VK_ACCESS_SHADER_WRITE_BIT, 0, computeFamily, copyFamily );
+
+            vkCmdPipelineBarrier( slot.m_DispatchCommandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr );
         }
 
-        // Copy buffer to image.
-        CopyBufferToImage(
-            stagingBuffer,
-            m_TextureImage,
-            static_cast<uint32_t>( textureWidth ),
-            static_cast<uint32_t>( textureHeight ) );
+        vkEndCommandBuffer( slot.m_DispatchCommandBuffer );
 
-        // Transition image layout from transfer destination to shader read only.
-        result = TransitionImageLayout(
-            m_TextureImage,
-            VK_FORMAT_R8G8B8A8_SRGB,
-            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL );
+        // Readback.
+        vkBeginCommandBuffer( slot.m_ReadbackCommandBuffer, &beginInfo );
 
-        if( result != StatusCode::Success )
+        if( isOwnershipTransferred )
         {
-            std::cerr << "Cannot handle image layout transition!" << std::endl;
-            return StatusCode::Fail;
+            // Acquire.
+            const VkBufferMemoryBarrier barrier = getTransferBarrier( slot.m_Buffers[2], 0, VK_ACCESS_TRANSFER_READ_BIT, computeFamily, copyFamily );
+
+            vkCmdPipelineBarrier( slot.m_ReadbackCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr );
         }
 
-        vkDestroyBuffer( m_Device, stagingBuffer, nullptr );
+        vkCmdCopyBuffer( slot.m_ReadbackCommandBuffer, slot.m_Buffers[2], slot.m_ReadbackBuffer, 1, &copyRegion );
+
+        VkMemoryBarrier barrier = {};
+        barrier.sType           = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask   = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask   = VK_ACCESS_HOST_READ_BIT;
+
+        vkCmdPipelineBarrier( slot.m_ReadbackCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr );
+
+        vkEndCommandBuffer( slot.m_ReadbackCommandBuffer );
 
         return StatusCode::Success;
     }
 
     ////////////////////////////////////////////////////////////
-    /// Creates texture image view.
+    /// Destroys the compute stream slots once the queues are done with them.
     ////////////////////////////////////////////////////////////
-    StatusCode CreateTextureImageView()
+    void DestroyComputeStream()
     {
-        const StatusCode result = CreateImageView(
-            m_TextureImage,
-            VK_FORMAT_R8G8B8A8_SRGB,
-            VK_IMAGE_ASPECT_COLOR_BIT,
-            m_TextureImageView );
+        WaitForTimelineValue( m_CopyTimeline, m_CopyTimeline.m_Value );
+        WaitForTimelineValue( m_ComputeTimeline, m_ComputeTimeline.m_Value );
 
-        if( result != StatusCode::Success )
+        for( ComputeStreamSlot& slot : m_ComputeStreamSlots )
         {
-            std::cerr << "Cannot create texture image view!" << std::endl;
-            return StatusCode::Fail;
+            for( uint32_t i = 0; i < slot.m_StagingBuffers.size(); ++i )
+            {
+                DestroyBuffer( slot.m_StagingBuffers[i], slot.m_StagingBuffersGpuMemoryOffsets[i] );
+            }
+
+            for( uint32_t i = 0; i < slot.m_Buffers.size(); ++i )
+            {
+                DestroyBuffer( slot.m_Buffers[i], slot.m_BuffersGpuMemoryOffsets[i] );
+            }
+
+            DestroyBuffer( slot.m_ReadbackBuffer, slot.m_ReadbackBufferGpuMemoryOffsets );
+
+            if( slot.m_DescriptorSet != VK_NULL_HANDLE )
+            {
+                vkFreeDescriptorSets( m_Device, m_ComputeJobDescriptorPool, 1, &slot.m_DescriptorSet );
+            }
+
+            for( const VkCommandBuffer commandBuffer : { slot.m_UploadCommandBuffer, slot.m_ReadbackCommandBuffer } )
+            {
+                if( commandBuffer != VK_NULL_HANDLE )
+                {
+                    vkFreeCommandBuffers( m_Device, m_CommandPoolCopy, 1, &commandBuffer );
+                }
+            }
+
+            if( slot.m_DispatchCommandBuffer != VK_NULL_HANDLE )
+            {
+                vkFreeCommandBuffers( m_Device, m_CommandPoolCompute, 1, &slot.m_DispatchCommandBuffer );
+            }
         }
 
-        return result;
+        m_ComputeStreamSlots.clear();
     }
 
     ////////////////////////////////////////////////////////////
-    /// Creates texture sampler.
+    /// Writes inputs of a chunk to the staging buffers of its slot on worker threads.
+    /// Cpu results are kept for the verification.
     ////////////////////////////////////////////////////////////
-    StatusCode CreateTextureSampler()
+    void ProduceComputeChunk( ComputeStreamSlot& slot, const uint32_t chunk )
     {
-        VkSamplerCreateInfo samplerInfo = {};
+        const TraceZone zone( "ProduceComputeChunk" );
 
-        samplerInfo.sType                   = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-        samplerInfo.magFilter               = VK_FILTER_LINEAR;
-        samplerInfo.minFilter               = VK_FILTER_LINEAR;
-        samplerInfo.addressModeU            = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-        samplerInfo.addressModeV            = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-        samplerInfo.addressModeW            = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-        samplerInfo.borderColor             = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
-        samplerInfo.unnormalizedCoordinates = VK_FALSE;
-        samplerInfo.compareEnable           = VK_FALSE;
-        samplerInfo.compareOp               = VK_COMPARE_OP_ALWAYS;
-        samplerInfo.mipmapMode              = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-        samplerInfo.mipLodBias              = 0.0f;
-        samplerInfo.minLod                  = 0.0f;
-        samplerInfo.maxLod                  = 0.0f;
-        samplerInfo.maxAnisotropy           = m_MaxSamplerAnisotropy;
+        float* numbersA = static_cast<float*>( GetMappedGpuMemory( slot.m_StagingBuffersGpuMemoryOffsets[0] ) );
+        float* numbersB = static_cast<float*>( GetMappedGpuMemory( slot.m_StagingBuffersGpuMemoryOffsets[1] ) );
+        float* results  = slot.m_Results.data();
 
-        if( m_MaxSamplerAnisotropy > 1.0f )
-        {
-            samplerInfo.anisotropyEnable = VK_TRUE;
-        }
-        else
+        const uint32_t rangeCount = GetCpuReferenceRangeCount( m_VectorElementCount );
+
+        ThreadPool::Get().ForEachRange( m_VectorElementCount, rangeCount, [=]( const uint32_t, const uint32_t begin, const uint32_t end ) {
+            for( uint32_t i = begin; i < end; ++i )
+            {
+                // Hashed indices keep the chunks different and reproducible.
+                uint32_t hash = ( chunk * 0x9E3779B1u ) ^ ( i * 0x85EBCA6Bu );
+                hash ^= hash >> 15;
+                hash *= 0x2C1B3C6Du;
+                hash ^= hash >> 12;
+
+                const float a = static_cast<float>( hash % 1000 + 1 ) / static_cast<float>( ( hash >> 10 ) % 1000 + 1 );
+                const float b = static_cast<float>( ( hash >> 20 ) % 1000 + 1 ) / 8.0f;
+
+                numbersA[i] = a;
+                numbersB[i] = b;
+                results[i]  = a * b;
+            }
+        } );
+
+        slot.m_Chunk = chunk;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Submits the upload and the dispatch of a chunk, the dispatch waits for the upload.
+    ////////////////////////////////////////////////////////////
+    StatusCode SubmitComputeChunk( ComputeStreamSlot& slot )
+    {
+        if( SubmitCommandBuffer( m_CopyQueue, slot.m_UploadCommandBuffer, {}, m_CopyTimeline, VK_NULL_HANDLE, slot.m_UploadTimelineValue ) != StatusCode::Success )
         {
-            samplerInfo.anisotropyEnable = VK_FALSE;
+            std::cerr << "Failed to submit compute stream upload!" << std::endl;
+            return StatusCode::Fail;
         }
 
-        if( vkCreateSampler( m_Device, &samplerInfo, nullptr, &m_TextureSampler ) != VK_SUCCESS )
+        const std::vector<GpuSemaphoreWait> waits = { { m_CopyTimeline.m_Semaphore, slot.m_UploadTimelineValue, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT } };
+
+        if( SubmitCommandBuffer( m_ComputeQueue, slot.m_DispatchCommandBuffer, waits, m_ComputeTimeline, VK_NULL_HANDLE, slot.m_DispatchTimelineValue ) != StatusCode::Success )
         {
-            std::cerr << "Cannot create texture sampler!" << std::endl;
+            std::cerr << "Failed to submit compute stream dispatch!" << std::endl;
             return StatusCode::Fail;
         }
 
+        slot.m_IsInFlight = true;
+
         return StatusCode::Success;
     }
 
     ////////////////////////////////////////////////////////////
-    /// Creates vertex buffers.
+    /// Submits the readback of a chunk, it waits for the dispatch.
     ////////////////////////////////////////////////////////////
-    StatusCode CreateVertexBuffer()
+    StatusCode SubmitComputeChunkReadback( ComputeStreamSlot& slot )
     {
-        StatusCode                        result               = StatusCode::Success;
-        VkBuffer                          stagingBuffer        = VK_NULL_HANDLE;
-        std::pair<uint32_t, VkDeviceSize> stagingBufferOffsets = {};
-        const VkDeviceSize                bufferSize           = sizeof( Vertices[0] ) * Vertices.size();
-
-        result = CreateBuffer(
-            bufferSize,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            0,
-            nullptr,
-            stagingBuffer,
-            stagingBufferOffsets );
+        const std::vector<GpuSemaphoreWait> waits = { { m_ComputeTimeline.m_Semaphore, slot.m_DispatchTimelineValue, VK_PIPELINE_STAGE_TRANSFER_BIT } };
 
-        if( result != StatusCode::Success )
+        if( SubmitCommandBuffer( m_CopyQueue, slot.m_ReadbackCommandBuffer, waits, m_CopyTimeline, VK_NULL_HANDLE, slot.m_ReadbackTimelineValue ) != StatusCode::Success )
         {
-            std::cerr << "Cannot create staging buffer for vertex buffer!" << std::endl;
+            std::cerr << "Failed to submit compute stream readback!" << std::endl;
             return StatusCode::Fail;
         }
 
-        // Fill the vertex buffer.
-        void* data                  = nullptr;
-        auto  bufferGpuMemory       = m_BufferGpuMemoryCpuVisible[std::get<0>( stagingBufferOffsets )];
-        auto  bufferGpuMemoryOffset = std::get<1>( stagingBufferOffsets );
+        return StatusCode::Success;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Waits for the readback of a chunk and verifies it, the slot can be reused afterwards.
+    ////////////////////////////////////////////////////////////
+    StatusCode ConsumeComputeChunk( ComputeStreamSlot& slot )
+    {
+        const TraceZone zone( "ConsumeComputeChunk" );
 
-        vkMapMemory( m_Device, bufferGpuMemory, bufferGpuMemoryOffset, bufferSize, 0, &data );
-        memcpy_s( data, bufferSize, Vertices.data(), bufferSize );
-        vkUnmapMemory( m_Device, bufferGpuMemory );
+        WaitForTimelineValue( m_CopyTimeline, slot.m_ReadbackTimelineValue );
 
-        result = CreateBuffer(
-            bufferSize,
-            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-            0,
-            nullptr,
-            m_VertexBuffer,
-            m_VertexBufferGpuMemoryOffset );
+        slot.m_IsInFlight = false;
 
-        if( result != StatusCode::Success )
+        if constexpr( EnableComputeVerification )
         {
-            std::cerr << "Cannot create buffer for vertex buffer!" << std::endl;
-            return StatusCode::Fail;
-        }
-
-        // Copy data from the staging buffer to vertex buffer.
-        CopyBuffer( stagingBuffer, m_VertexBuffer, bufferSize );
+            const float* result = static_cast<const float*>( GetMappedGpuMemory( slot.m_ReadbackBufferGpuMemoryOffsets ) );
 
-        vkDestroyBuffer( m_Device, stagingBuffer, nullptr );
+            if( VerifyComputeWorkload( result, slot.m_Results.data(), slot.m_Chunk ) != StatusCode::Success )
+            {
+                std::cerr << "Failed to verify compute stream chunk " << slot.m_Chunk << "!" << std::endl;
+                return StatusCode::Fail;
+            }
+        }
 
         return StatusCode::Success;
     }
 
     ////////////////////////////////////////////////////////////
-    /// Creates index buffers.
+    /// Starts verification of the finished dispatches without waiting.
     ////////////////////////////////////////////////////////////
-    StatusCode CreateIndexBuffer()
+    void CollectComputeResults()
     {
-        StatusCode                        result               = StatusCode::Success;
-        VkBuffer                          stagingBuffer        = VK_NULL_HANDLE;
-        std::pair<uint32_t, VkDeviceSize> stagingBufferOffsets = {};
-        const VkDeviceSize                bufferSize           = sizeof( Indices[0] ) * Indices.size();
-
-        result = CreateBuffer(
-            bufferSize,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            0,
-            nullptr,
-            stagingBuffer,
-            stagingBufferOffsets );
-
-        if( result != StatusCode::Success )
+        for( uint32_t i = 0; i < m_ComputeReadbackCount; ++i )
         {
-            std::cerr << "Cannot create staging buffer for index buffer!" << std::endl;
-            return StatusCode::Fail;
+            if( m_IsComputeResultPending[i] && IsTimelineValueReached( m_ComputeTimeline, m_ComputeTimelineValues[i] ) )
+            {
+                StartComputeVerification( i );
+            }
         }
+    }
 
-        // Fill the index buffer.
-        void* data                  = nullptr;
-        auto  bufferGpuMemory       = m_BufferGpuMemoryCpuVisible[std::get<0>( stagingBufferOffsets )];
-        auto  bufferGpuMemoryOffset = std::get<1>( stagingBufferOffsets );
+    ////////////////////////////////////////////////////////////
+    /// Starts verification of a readback buffer on a worker thread.
+    ////////////////////////////////////////////////////////////
+    void StartComputeVerification( const uint32_t readbackIndex )
+    {
+        const bool     isReadback = m_IsComputeReadbackSubmitted[readbackIndex];
+        const uint32_t slot       = isReadback ? readbackIndex : m_ComputeReadbackCount + readbackIndex;
 
-        vkMapMemory( m_Device, bufferGpuMemory, bufferGpuMemoryOffset, bufferSize, 0, &data );
-        memcpy_s( data, bufferSize, Indices.data(), bufferSize );
-        vkUnmapMemory( m_Device, bufferGpuMemory );
+        m_IsComputeResultPending[readbackIndex] = false;
 
-        result = CreateBuffer(
-            bufferSize,
-            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-            0,
-            nullptr,
-            m_IndexBuffer,
-            m_IndexBufferGpuMemoryOffset );
+        if( m_ComputeProfiler.Resolve( m_Device, slot, m_ComputeGpuProfile ) )
+        {
+            UpdateGpuProfileAverages( m_ComputeGpuProfile );
+            TraceGpuProfile( m_ComputeGpuProfile, m_ComputeTimestampCalibration, TraceComputeQueueTrack );
+            AddBenchmarkSample( BenchmarkMetric::ComputeTime, GetGpuProfileScope( m_ComputeGpuProfile, "dispatch" ) );
+            AddComputeInterval( m_ComputeGpuProfile );
+        }
 
-        // Copy data from the staging buffer to index buffer.
-        CopyBuffer( stagingBuffer, m_IndexBuffer, bufferSize );
+        if( !isReadback )
+        {
+            return;
+        }
 
-        vkDestroyBuffer( m_Device, stagingBuffer, nullptr );
+        if constexpr( EnableComputeVerification )
+        {
+            // Gpu memory blocks may change on this thread, so the mapping is resolved here.
+            const float*   result = static_cast<const float*>( GetMappedGpuMemory( m_ComputeReadbackBuffersGpuMemoryOffsets[readbackIndex] ) );
+            const uint32_t phase  = m_ComputeVerificationIndex++;
 
-        return StatusCode::Success;
+            m_ComputeVerifications[readbackIndex] = std::async( std::launch::async, [this, result, phase]() { return VerifyComputeWorkload( result, m_Results, phase ); } );
+        }
     }
 
     ////////////////////////////////////////////////////////////
-    /// Creates uniform buffers.
+    /// Waits for all dispatches and their verification.
     ////////////////////////////////////////////////////////////
-    StatusCode CreateUniformBuffers()
+    StatusCode FinishComputeVerification()
     {
-        const uint32_t     swapChainImageCount = static_cast<uint32_t>( m_SwapChainImages.size() );
-        const VkDeviceSize bufferSize          = sizeof( UniformBufferObject );
-
-        m_UniformBuffers.resize( swapChainImageCount );
-        m_UniformBuffersGpuMemoryOffsets.resize( swapChainImageCount );
+        StatusCode result = StatusCode::Success;
 
-        for( uint32_t i = 0; i < swapChainImageCount; ++i )
+        for( uint32_t i = 0; i < m_ComputeVerifications.size(); ++i )
         {
-            // TODO: try to use already freed uniform buffers.
-            const StatusCode result = CreateBuffer(
-                bufferSize,
-                VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                0,
-                nullptr,
-                m_UniformBuffers[i],
-                m_UniformBuffersGpuMemoryOffsets[i] );
+            if( m_IsComputeResultPending[i] )
+            {
+                WaitForTimelineValue( m_ComputeTimeline, m_ComputeTimelineValues[i] );
+                StartComputeVerification( i );
+            }
 
-            if( result != StatusCode::Success )
+            if( m_ComputeVerifications[i].valid() && m_ComputeVerifications[i].get() != StatusCode::Success )
             {
-                std::cerr << "Cannot create buffer for uniform buffer!" << std::endl;
-                return StatusCode::Fail;
+                result = StatusCode::Fail;
             }
         }
 
-        return StatusCode::Success;
+        return result;
     }
 
     ////////////////////////////////////////////////////////////
-    /// Creates compute buffers.
+    /// Verifies compute workload copied to a readback buffer, prints the first mismatches on failure.
+    /// Readback buffers stay mapped, so nothing is released on a mismatch.
     ////////////////////////////////////////////////////////////
-    StatusCode CreateComputeBuffers()
+    StatusCode VerifyComputeWorkload( const float* result, const float* expected, const uint32_t phase ) const
     {
-        m_NumbersA = new float[m_VectorElementCount];
-        m_NumbersB = new float[m_VectorElementCount];
-        m_Results  = new float[m_VectorElementCount];
+        const TraceZone zone( "VerifyComputeWorkload" );
 
-        std::random_device                     rand_dev;
-        std::mt19937                           generator( rand_dev() );
-        std::uniform_int_distribution<int32_t> distr( 1, 1000 );
+        const ComputeVerificationMode   mode   = m_Settings.m_ComputeVerificationMode;
+        const ComputeVerificationReport report = VerifyComputeResults( result, expected, m_VectorElementCount, phase );
 
-        for( uint32_t i = 0; i < m_VectorElementCount; ++i )
+        if( report.m_MismatchCount == 0 )
         {
-            m_NumbersA[i] = static_cast<float>( distr( generator ) ) / distr( generator );
-            m_NumbersB[i] = static_cast<float>( distr( generator ) ) / distr( generator );
-            m_Results[i]  = m_NumbersA[i] * m_NumbersB[i];
+            return StatusCode::Success;
         }
 
-        m_ComputeBuffers.resize( 3 );
-        m_ComputeBuffersGpuMemoryOffsets.resize( 3 );
+        const std::streamsize precision = std::cerr.precision( std::numeric_limits<float>::max_digits10 );
 
-        for( uint32_t i = 0; i < m_ComputeBuffers.size(); ++i )
+        std::cerr << "Compute verification found " << report.m_MismatchCount << " mismatches in " << report.m_VerifiedCount << " elements,"
+                  << " max error " << report.m_MaxError << ( mode == ComputeVerificationMode::Ulp ? " ulps" : mode == ComputeVerificationMode::Relative ? " relative" : "" ) << ":" << std::endl;
+
+        for( const ComputeMismatch& mismatch : report.m_Mismatches )
         {
-            const StatusCode result = CreateBuffer(
-                m_VectorElementCount * sizeof( float ),
-                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                1,
-                &m_QueueFamilyIndices.m_ComputeFamily,
-                m_ComputeBuffers[i],
-                m_ComputeBuffersGpuMemoryOffsets[i] );
+            std::cerr << "  element " << mismatch.m_Index << " is " << mismatch.m_Value << ", expected " << mismatch.m_Expected << std::endl;
+        }
 
-            if( result != StatusCode::Success )
-            {
-                std::cerr << "Cannot create buffer for compute buffer!" << std::endl;
-                return StatusCode::Fail;
-            }
+        std::cerr.precision( precision );
 
-            // Copy random float numbers to the buffer.
-            void* data                                         = nullptr;
-            auto [bufferGpuMemoryIndex, bufferGpuMemoryOffset] = m_ComputeBuffersGpuMemoryOffsets[i];
-            auto bufferGpuMemory                               = m_BufferGpuMemoryCpuVisible[bufferGpuMemoryIndex];
+        return StatusCode::Fail;
+    }
 
-            vkMapMemory( m_Device, bufferGpuMemory, bufferGpuMemoryOffset, m_VectorElementCount * sizeof( float ), 0, &data );
-            switch( i )
-            {
-                case 0:
-                    memcpy( data, m_NumbersA, m_VectorElementCount * sizeof( float ) );
-                    break;
+    ////////////////////////////////////////////////////////////
+    /// Compares compute results with cpu results on worker threads.
+    /// Sampled verification checks one of every n blocks, the phase selects which one.
+    ////////////////////////////////////////////////////////////
+    ComputeVerificationReport VerifyComputeResults( const float* values, const float* expected, const uint32_t elementCount, const uint32_t phase ) const
+    {
+        const ComputeVerificationMode mode          = m_Settings.m_ComputeVerificationMode;
+        const float                   tolerance     = GetComputeVerificationTolerance();
+        const uint32_t                mismatchLimit = m_Settings.m_ComputeMismatchReports != 0 ? m_Settings.m_ComputeMismatchReports : DefaultComputeMismatchReports;
 
-                case 1:
-                    memcpy( data, m_NumbersB, m_VectorElementCount * sizeof( float ) );
-                    break;
+        const uint32_t blockCount        = ( elementCount + ComputeVerificationBlockSize - 1 ) / ComputeVerificationBlockSize;
+        const uint32_t blockStep         = std::max( m_Settings.m_ComputeVerificationSampling, 1u );
+        const uint32_t firstBlock        = phase % blockStep;
+        const uint32_t sampledBlockCount = blockCount > firstBlock ? ( blockCount - firstBlock + blockStep - 1 ) / blockStep : 0;
+        const uint32_t rangeCount        = std::clamp( sampledBlockCount, 1u, ThreadPool::Get().GetThreadCount() );
 
-                default:
-                    // Do nothing.
-                    break;
+        std::vector<ComputeVerificationReport> reports( rangeCount );
+
+        ThreadPool::Get().ForEachRange( sampledBlockCount, rangeCount, [&]( const uint32_t r, const uint32_t begin, const uint32_t end ) {
+            for( uint32_t sample = begin; sample < end; ++sample )
+            {
+                const uint32_t blockBegin = ( firstBlock + sample * blockStep ) * ComputeVerificationBlockSize;
+                const uint32_t blockEnd   = std::min( blockBegin + ComputeVerificationBlockSize, elementCount );
+
+                VerifyComputeRange( values, expected, blockBegin, blockEnd, mode, tolerance, mismatchLimit, reports[r] );
             }
+        } );
+
+        // Ranges are in index order, so the first mismatches of the ranges are the first ones overall.
+        ComputeVerificationReport report = {};
+
+        for( const ComputeVerificationReport& rangeReport : reports )
+        {
+            report.m_VerifiedCount += rangeReport.m_VerifiedCount;
+            report.m_MismatchCount += rangeReport.m_MismatchCount;
+            report.m_MaxError = std::max( report.m_MaxError, rangeReport.m_MaxError );
 
-            vkUnmapMemory( m_Device, bufferGpuMemory );
+            for( const ComputeMismatch& mismatch : rangeReport.m_Mismatches )
+            {
+                if( report.m_Mismatches.size() < mismatchLimit )
+                {
+                    report.m_Mismatches.emplace_back( mismatch );
+                }
+            }
         }
 
-        return StatusCode::Success;
+        return report;
     }
 
     ////////////////////////////////////////////////////////////
-    /// Creates descriptor pool.
+    /// Returns the verification tolerance of the mode, ulp tolerances are clamped to the range of the simd comparison.
     ////////////////////////////////////////////////////////////
-    StatusCode CreateDescriptorPool()
+    float GetComputeVerificationTolerance() const
     {
-        const uint32_t                      descriptorCount = static_cast<uint32_t>( m_SwapChainImages.size() );
-        std::array<VkDescriptorPoolSize, 2> poolSizes       = {};
-        VkDescriptorPoolCreateInfo          poolInfo        = {};
+        const float tolerance = m_Settings.m_ComputeVerificationTolerance;
 
-        // For uniform.
-        poolSizes[0].type            = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        poolSizes[0].descriptorCount = descriptorCount;
+        switch( m_Settings.m_ComputeVerificationMode )
+        {
+            case ComputeVerificationMode::Ulp:
+                return std::min( tolerance > 0.0f ? tolerance : DefaultComputeVerificationUlps, MaxComputeVerificationUlps );
 
-        // For sampler.
-        poolSizes[1].type            = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        poolSizes[1].descriptorCount = descriptorCount;
+            case ComputeVerificationMode::Relative:
+                return tolerance > 0.0f ? tolerance : DefaultComputeRelativeError;
 
-        poolInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-        poolInfo.poolSizeCount = static_cast<uint32_t>( poolSizes.size() );
-        poolInfo.pPoolSizes    = poolSizes.data();
-        poolInfo.maxSets       = descriptorCount;
-        poolInfo.flags         = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+            default:
+                return 0.0f;
+        }
+    }
 
-        if( vkCreateDescriptorPool( m_Device, &poolInfo, nullptr, &m_DescriptorPool ) != VK_SUCCESS )
+    ////////////////////////////////////////////////////////////
+    /// Returns bits of a float ordered like the floats, so their difference counts ulps.
+    ////////////////////////////////////////////////////////////
+    static int32_t GetOrderedFloatBits( const float value )
+    {
+        const int32_t bits = std::bit_cast<int32_t>( value );
+
+        return bits < 0 ? std::numeric_limits<int32_t>::min() - bits : bits;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Returns the error of a compute result, absolute, in ulps or relative by the mode.
+    ////////////////////////////////////////////////////////////
+    static float GetComputeError( const float value, const float expected, const ComputeVerificationMode mode )
+    {
+        const float difference = std::abs( value - expected );
+
+        switch( mode )
         {
-            std::cerr << "Cannot create descriptor pool!" << std::endl;
-            return StatusCode::Fail;
-        }
+            case ComputeVerificationMode::Ulp:
+                return static_cast<float>( std::abs( static_cast<int64_t>( GetOrderedFloatBits( value ) ) - GetOrderedFloatBits( expected ) ) );
 
-        // For compute.
-        VkDescriptorPoolSize computePoolSize = {};
-        computePoolSize.type                 = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        computePoolSize.descriptorCount      = 3;
+            case ComputeVerificationMode::Relative:
+            {
+                const float scale = std::max( std::abs( value ), std::abs( expected ) );
+                return scale > 0.0f ? difference / scale : difference;
+            }
 
-        poolInfo.poolSizeCount = 1;
-        poolInfo.pPoolSizes    = &computePoolSize;
-        poolInfo.maxSets       = 1;
+            default:
+                return difference;
+        }
+    }
 
-        if( vkCreateDescriptorPool( m_Device, &poolInfo, nullptr, &m_ComputeDescriptorPool ) != VK_SUCCESS )
+    ////////////////////////////////////////////////////////////
+    /// Checks if a compute result is out of tolerance, nans never match.
+    ////////////////////////////////////////////////////////////
+    static bool IsComputeMismatch( const float value, const float expected, const ComputeVerificationMode mode, const float tolerance )
+    {
+        if( std::isnan( value ) || std::isnan( expected ) )
         {
-            std::cerr << "Cannot create compute descriptor pool!" << std::endl;
-            return StatusCode::Fail;
+            return true;
         }
 
-        return StatusCode::Success;
+        switch( mode )
+        {
+            case ComputeVerificationMode::Ulp:
+            case ComputeVerificationMode::Relative:
+                return GetComputeError( value, expected, mode ) > tolerance;
+
+            default:
+                return value != expected;
+        }
     }
 
     ////////////////////////////////////////////////////////////
-    /// Creates descriptor sets.
+    /// Records a mismatch found by the simd comparison.
     ////////////////////////////////////////////////////////////
-    StatusCode CreateDescriptorSets()
+    static void AddComputeMismatch( const float* values, const float* expected, const uint32_t i, const ComputeVerificationMode mode, const uint32_t mismatchLimit, ComputeVerificationReport& report )
     {
-        // For graphics.
-        const uint32_t                     descriptorSetCount = static_cast<uint32_t>( m_SwapChainImages.size() );
-        VkDescriptorSetAllocateInfo        allocationInfo     = {};
-        std::vector<VkDescriptorSetLayout> layouts( descriptorSetCount, m_DescriptorSetLayout );
-
-        allocationInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-        allocationInfo.descriptorPool     = m_DescriptorPool;
-        allocationInfo.descriptorSetCount = descriptorSetCount;
-        allocationInfo.pSetLayouts        = layouts.data();
+        ++report.m_MismatchCount;
 
-        m_DescriptorSets.resize( descriptorSetCount );
+        // Errors wrapped by the simd comparison are recomputed here.
+        report.m_MaxError = std::max( report.m_MaxError, GetComputeError( values[i], expected[i], mode ) );
 
-        if( vkAllocateDescriptorSets( m_Device, &allocationInfo, m_DescriptorSets.data() ) != VK_SUCCESS )
+        if( report.m_Mismatches.size() < mismatchLimit )
         {
-            std::cerr << "Cannot allocate descriptor sets!" << std::endl;
-            return StatusCode::Fail;
+            report.m_Mismatches.push_back( { i, values[i], expected[i] } );
         }
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Compares a range of compute results, eight lanes at a time with avx2 and four with neon.
+    ////////////////////////////////////////////////////////////
+    static void VerifyComputeRange(
+        const float*                  values,
+        const float*                  expected,
+        const uint32_t                begin,
+        const uint32_t                end,
+        const ComputeVerificationMode mode,
+        const float                   tolerance,
+        const uint32_t                mismatchLimit,
+        ComputeVerificationReport&    report )
+    {
+        uint32_t i = begin;
+
+#if defined( __AVX2__ )
+        constexpr uint32_t LaneCount = 8;
+
+        const __m256  absoluteMask  = _mm256_castsi256_ps( _mm256_set1_epi32( 0x7FFFFFFF ) );
+        const __m256  toleranceLane = _mm256_set1_ps( tolerance );
+        const __m256i ulpLane       = _mm256_set1_epi32( static_cast<int32_t>( tolerance ) );
+        const __m256i signLane      = _mm256_set1_epi32( std::numeric_limits<int32_t>::min() );
+        const __m256  zero          = _mm256_setzero_ps();
+        __m256        maxError      = zero;
+
+        // Negative floats are mirrored, so the ordered bits grow with the floats.
+        const auto getOrderedBits = [signLane]( const __m256 lane ) {
+            const __m256i bits = _mm256_castps_si256( lane );
+            return _mm256_blendv_epi8( bits, _mm256_sub_epi32( signLane, bits ), _mm256_srai_epi32( bits, 31 ) );
+        };
 
-        for( uint32_t i = 0; i < descriptorSetCount; ++i )
+        for( ; i + LaneCount <= end; i += LaneCount )
         {
-            VkDescriptorBufferInfo bufferInfo = {};
+            const __m256 value      = _mm256_loadu_ps( values + i );
+            const __m256 reference  = _mm256_loadu_ps( expected + i );
+            const __m256 difference = _mm256_and_ps( _mm256_sub_ps( value, reference ), absoluteMask );
+            __m256       error      = difference;
+            __m256       mismatch   = zero;
 
-            bufferInfo.buffer = m_UniformBuffers[i];
-            bufferInfo.offset = 0;
-            bufferInfo.range  = sizeof( UniformBufferObject );
-
-            VkDescriptorImageInfo imageInfo = {};
-
-            imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-            imageInfo.imageView   = m_TextureImageView;
-            imageInfo.sampler     = m_TextureSampler;
-
-            std::array<VkWriteDescriptorSet, 2> descriptorWrites = {};
-
-            descriptorWrites[0].sType            = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            descriptorWrites[0].dstSet           = m_DescriptorSets[i];
-            descriptorWrites[0].dstBinding       = 0;
-            descriptorWrites[0].dstArrayElement  = 0;
-            descriptorWrites[0].descriptorType   = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-            descriptorWrites[0].descriptorCount  = 1;
-            descriptorWrites[0].pBufferInfo      = &bufferInfo;
-            descriptorWrites[0].pImageInfo       = nullptr; // Optional.
-            descriptorWrites[0].pTexelBufferView = nullptr; // Optional.
-
-            descriptorWrites[1].sType            = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            descriptorWrites[1].dstSet           = m_DescriptorSets[i];
-            descriptorWrites[1].dstBinding       = 1;
-            descriptorWrites[1].dstArrayElement  = 0;
-            descriptorWrites[1].descriptorType   = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-            descriptorWrites[1].descriptorCount  = 1;
-            descriptorWrites[1].pBufferInfo      = nullptr; // Optional.
-            descriptorWrites[1].pImageInfo       = &imageInfo;
-            descriptorWrites[1].pTexelBufferView = nullptr; // Optional.
-
-            vkUpdateDescriptorSets(
-                m_Device,
-                static_cast<uint32_t>( descriptorWrites.size() ),
-                descriptorWrites.data(),
-                0,
-                nullptr );
+            switch( mode )
+            {
+                case ComputeVerificationMode::Ulp:
+                {
+                    // Distances of at least 2^31 wrap to negative values, they are mismatches.
+                    const __m256i distance = _mm256_abs_epi32( _mm256_sub_epi32( getOrderedBits( value ), getOrderedBits( reference ) ) );
+                    const __m256i isFar    = _mm256_or_si256( _mm256_cmpgt_epi32( distance, ulpLane ), _mm256_cmpgt_epi32( _mm256_setzero_si256(), distance ) );
+
+                    error    = _mm256_cvtepi32_ps( distance );
+                    mismatch = _mm256_or_ps( _mm256_castsi256_ps( isFar ), _mm256_cmp_ps( value, reference, _CMP_UNORD_Q ) );
+                    break;
+                }
+
+                case ComputeVerificationMode::Relative:
+                {
+                    const __m256 scale = _mm256_max_ps( _mm256_and_ps( value, absoluteMask ), _mm256_and_ps( reference, absoluteMask ) );
+
+                    error    = _mm256_blendv_ps( difference, _mm256_div_ps( difference, scale ), _mm256_cmp_ps( scale, zero, _CMP_GT_OQ ) );
+                    mismatch = _mm256_cmp_ps( difference, _mm256_mul_ps( toleranceLane, scale ), _CMP_NLE_UQ );
+                    break;
+                }
+
+                default:
+                    mismatch = _mm256_cmp_ps( value, reference, _CMP_NEQ_UQ );
+                    break;
+            }
+
+            // Nan errors keep the previous maximum.
+            maxError = _mm256_max_ps( error, maxError );
+
+            const int32_t mismatchMask = _mm256_movemask_ps( mismatch );
+
+            if( mismatchMask != 0 )
+            {
+                for( uint32_t lane = 0; lane < LaneCount; ++lane )
+                {
+                    if( mismatchMask & ( 1 << lane ) )
+                    {
+                        AddComputeMismatch( values, expected, i + lane, mode, mismatchLimit, report );
+                    }
+                }
+            }
         }
 
-        // For compute.
-        allocationInfo.descriptorPool     = m_ComputeDescriptorPool;
-        allocationInfo.descriptorSetCount = 1;
-        allocationInfo.pSetLayouts        = &m_ComputeDescriptorSetLayout;
+        std::array<float, LaneCount> maxErrors = {};
+        _mm256_storeu_ps( maxErrors.data(), maxError );
 
-        if( vkAllocateDescriptorSets( m_Device, &allocationInfo, &m_ComputeDescriptorSet ) != VK_SUCCESS )
+        for( const float laneMaxError : maxErrors )
         {
-            std::cerr << "Cannot allocate compute descriptor set!" << std::endl;
-            return StatusCode::Fail;
+            report.m_MaxError = std::max( report.m_MaxError, laneMaxError );
         }
+#elif defined( __ARM_NEON ) && defined( __aarch64__ )
+        constexpr uint32_t LaneCount = 4;
 
-        std::vector<VkWriteDescriptorSet>   descriptorSetWrites( m_ComputeBuffers.size() );
-        std::vector<VkDescriptorBufferInfo> bufferInfos( m_ComputeBuffers.size() );
+        const int32x4_t  ulpLane  = vdupq_n_s32( static_cast<int32_t>( tolerance ) );
+        const int32x4_t  signLane = vdupq_n_s32( std::numeric_limits<int32_t>::min() );
+        const float32x4_t zero    = vdupq_n_f32( 0.0f );
+        float32x4_t      maxError = zero;
 
-        for( uint32_t i = 0; i < m_ComputeBuffers.size(); ++i )
+        // Negative floats are mirrored, so the ordered bits grow with the floats.
+        const auto getOrderedBits = [signLane]( const float32x4_t lane ) {
+            const int32x4_t bits = vreinterpretq_s32_f32( lane );
+            return vbslq_s32( vcltzq_s32( bits ), vsubq_s32( signLane, bits ), bits );
+        };
+
+        for( ; i + LaneCount <= end; i += LaneCount )
         {
-            VkWriteDescriptorSet writeDescriptorSet = {};
-            writeDescriptorSet.sType                = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            writeDescriptorSet.dstSet               = m_ComputeDescriptorSet;
-            writeDescriptorSet.dstBinding           = i;
-            writeDescriptorSet.dstArrayElement      = 0;
-            writeDescriptorSet.descriptorCount      = 1;
-            writeDescriptorSet.descriptorType       = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            const float32x4_t value      = vld1q_f32( values + i );
+            const float32x4_t reference  = vld1q_f32( expected + i );
+            const float32x4_t difference = vabdq_f32( value, reference );
+            const uint32x4_t  isOrdered  = vandq_u32( vceqq_f32( value, value ), vceqq_f32( reference, reference ) );
+            float32x4_t       error      = difference;
+            uint32x4_t        mismatch   = vdupq_n_u32( 0 );
 
-            VkDescriptorBufferInfo bufferInfo = {};
-            bufferInfo.buffer                 = m_ComputeBuffers[i];
-            bufferInfo.offset                 = 0;
-            bufferInfo.range                  = VK_WHOLE_SIZE;
-            bufferInfos[i]                    = bufferInfo;
+            switch( mode )
+            {
+                case ComputeVerificationMode::Ulp:
+                {
+                    // Saturated distances stay above any tolerance.
+                    const int32x4_t distance = vqabsq_s32( vqsubq_s32( getOrderedBits( value ), getOrderedBits( reference ) ) );
 
-            writeDescriptorSet.pBufferInfo = &bufferInfos[i];
-            descriptorSetWrites[i]         = writeDescriptorSet;
-        }
+                    error    = vcvtq_f32_s32( distance );
+                    mismatch = vorrq_u32( vcgtq_s32( distance, ulpLane ), vmvnq_u32( isOrdered ) );
+                    break;
+                }
+
+                case ComputeVerificationMode::Relative:
+                {
+                    const float32x4_t scale = vmaxq_f32( vabsq_f32( value ), vabsq_f32( reference ) );
 
-        vkUpdateDescriptorSets( m_Device, static_cast<uint32_t>( descriptorSetWrites.size() ), descriptorSetWrites.data(), 0, nullptr );
+                    error    = vbslq_f32( vcgtq_f32( scale, zero ), vdivq_f32( difference, scale ), difference );
+                    mismatch = vmvnq_u32( vcleq_f32( difference, vmulq_n_f32( scale, tolerance ) ) );
+                    break;
+                }
 
-        return StatusCode::Success;
-    }
+                default:
+                    mismatch = vmvnq_u32( vceqq_f32( value, reference ) );
+                    break;
+            }
 
-    ////////////////////////////////////////////////////////////
-    /// Finds gpu memory type.
-    ////////////////////////////////////////////////////////////
-    uint32_t FindGpuMemoryType( const uint32_t typeFilter, const VkMemoryPropertyFlags properties )
-    {
-        VkPhysicalDeviceMemoryProperties gpuMemoryProperties = {};
+            // Nan errors keep the previous maximum.
+            maxError = vmaxnmq_f32( maxError, error );
+
+            if( vmaxvq_u32( mismatch ) != 0 )
+            {
+                for( uint32_t lane = 0; lane < LaneCount; ++lane )
+                {
+                    if( IsComputeMismatch( values[i + lane], expected[i + lane], mode, tolerance ) )
+                    {
+                        AddComputeMismatch( values, expected, i + lane, mode, mismatchLimit, report );
+                    }
+                }
+            }
+        }
 
-        // Get gpu memory properties.
-        vkGetPhysicalDeviceMemoryProperties( m_PhysicalDevice, &gpuMemoryProperties );
+        report.m_MaxError = std::max( report.m_MaxError, vmaxvq_f32( maxError ) );
+#endif
 
-        for( uint32_t i = 0; i < gpuMemoryProperties.memoryTypeCount; i++ )
+        // Scalar tail, or the whole range without simd.
+        for( ; i < end; ++i )
         {
-            if( ( typeFilter & ( 1 << i ) ) &&
-                ( gpuMemoryProperties.memoryTypes[i].propertyFlags & properties ) == properties )
+            if( IsComputeMismatch( values[i], expected[i], mode, tolerance ) )
             {
-                return i;
+                AddComputeMismatch( values, expected, i, mode, mismatchLimit, report );
+            }
+            else
+            {
+                report.m_MaxError = std::max( report.m_MaxError, GetComputeError( values[i], expected[i], mode ) );
             }
         }
 
-        std::cerr << "Failed to find suitable memory type!" << std::endl;
-
-        return UINT32_MAX;
+        report.m_VerifiedCount += end - begin;
     }
 
     ////////////////////////////////////////////////////////////
-    /// Creates command buffers.
+    /// Runs the saxpy kernel as a compute job and compares it with the cpu.
     ////////////////////////////////////////////////////////////
-    StatusCode CreateCommandBuffers()
+    StatusCode VerifyComputeKernels()
     {
-        // Create a command buffer for all frame buffers.
-        m_GraphicsCommandBuffers.resize( m_SwapChainFramebuffers.size() );
+        struct SaxpyConstants
+        {
+            uint32_t m_ElementCount;
+            float    m_A;
+        };
 
-        // Populate command buffer allocate information.
-        VkCommandBufferAllocateInfo allocInfo = {};
-        allocInfo.sType                       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-        allocInfo.commandPool                 = m_CommandPoolGraphics;
-        allocInfo.level                       = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-        allocInfo.commandBufferCount          = static_cast<uint32_t>( m_GraphicsCommandBuffers.size() );
+        uint32_t kernel = 0;
 
-        // Create graphics command buffers.
-        if( vkAllocateCommandBuffers( m_Device, &allocInfo, m_GraphicsCommandBuffers.data() ) != VK_SUCCESS )
+        if( RegisterComputeKernel( "Shaders/saxpy.spv", 0, sizeof( SaxpyConstants ), kernel ) != StatusCode::Success )
         {
-            std::cerr << "Cannot create graphics command buffer!" << std::endl;
             return StatusCode::Fail;
         }
 
-        // Create compute command buffers.
-        allocInfo.commandPool        = m_CommandPoolCompute;
-        allocInfo.commandBufferCount = 1;
+        std::vector<float> x( m_VectorElementCount );
+        std::vector<float> y( m_VectorElementCount );
 
-        if( vkAllocateCommandBuffers( m_Device, &allocInfo, &m_ComputeCommandBuffer ) != VK_SUCCESS )
+        for( uint32_t i = 0; i < m_VectorElementCount; ++i )
+        {
+            x[i] = static_cast<float>( i % 1024 ) * 0.25f;
+            y[i] = static_cast<float>( i % 512 ) - 256.0f;
+        }
+
+        ComputeBufferHandle<float> xBuffer = {};
+        ComputeBufferHandle<float> yBuffer = {};
+
+        if( CreateComputeJobBuffer( m_VectorElementCount, x.data(), xBuffer ) != StatusCode::Success ||
+            CreateComputeJobBuffer( m_VectorElementCount, y.data(), yBuffer ) != StatusCode::Success )
         {
-            std::cerr << "Cannot create compute command buffer!" << std::endl;
             return StatusCode::Fail;
         }
 
-        return StatusCode::Success;
-    }
+        const SaxpyConstants constants = { m_VectorElementCount, 3.0f };
 
-    ////////////////////////////////////////////////////////////
-    /// Creates queries to collect metrics.
-    ////////////////////////////////////////////////////////////
-    StatusCode CreateQueries()
-    {
-        VkQueryPoolCreateInfo queryPoolInfo = {};
+        ComputeJob job        = {};
+        job.m_Kernel          = kernel;
+        job.m_InvocationCount = m_VectorElementCount;
+        job.AddBuffer( xBuffer );
+        job.AddBuffer( yBuffer );
+        job.SetPushConstants( constants );
 
-        if( m_IsPipelineStatisticsQuerySupported )
+        std::shared_future<StatusCode> completion;
+        std::vector<float>             result;
+
+        if( SubmitComputeJob( job, completion ) != StatusCode::Success ||
+            completion.get() != StatusCode::Success ||
+            ReadComputeJobBuffer( yBuffer, result ) != StatusCode::Success )
         {
-            queryPoolInfo.sType      = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
-            queryPoolInfo.queryType  = VK_QUERY_TYPE_PIPELINE_STATISTICS;
-            queryPoolInfo.queryCount = static_cast<uint32_t>( m_GraphicsCommandBuffers.size() );
-            queryPoolInfo.pipelineStatistics =
-                VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
-                VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
-                VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
-                VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT |
-                VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
-                VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
-                VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+            return StatusCode::Fail;
+        }
 
-            VkQueryPool queryPool = {};
+        DestroyComputeJobBuffer( xBuffer );
+        DestroyComputeJobBuffer( yBuffer );
 
-            if( vkCreateQueryPool( m_Device, &queryPoolInfo, nullptr, &queryPool ) != VK_SUCCESS )
+        // The gpu may fuse the multiply and the add, so results are compared with a tolerance.
+        for( uint32_t i = 0; i < m_VectorElementCount; ++i )
+        {
+            const float expected = constants.m_A * x[i] + y[i];
+
+            if( std::abs( result[i] - expected ) > 1e-5f * std::max( 1.0f, std::abs( expected ) ) )
             {
-                std::cerr << "Failed to create queries!" << std::endl;
                 return StatusCode::Fail;
             }
+        }
 
-            m_QueryPools.push_back( queryPool );
+        // Reductions and scans are optional.
+        if( m_IsSubgroupArithmeticSupported )
+        {
+            return VerifyParallelPrimitives();
         }
 
         return StatusCode::Success;
     }
 
     ////////////////////////////////////////////////////////////
-    /// Records command buffers.
+    /// Compares gpu reductions and scans with the cpu references, prints both times.
     ////////////////////////////////////////////////////////////
-    StatusCode RecordCommandBuffers()
+    StatusCode VerifyParallelPrimitives()
     {
-        for( size_t i = 0; i < m_GraphicsCommandBuffers.size(); ++i )
-        {
-            // Populate command buffer begin information.
-            VkCommandBufferBeginInfo beginInfo = {};
-            beginInfo.sType                    = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-            beginInfo.flags                    = 0;       // Optional.
-            beginInfo.pInheritanceInfo         = nullptr; // Optional.
+        // Small integers keep sums exact, so any mismatch is an error rather than rounding.
+        std::vector<float> a( m_VectorElementCount );
+        std::vector<float> b( m_VectorElementCount );
 
-            // Begin recording the command buffer.
-            if( vkBeginCommandBuffer( m_GraphicsCommandBuffers[i], &beginInfo ) != VK_SUCCESS )
-            {
-                std::cerr << "Failed to begin recording command buffer!" << std::endl;
-                return StatusCode::Fail;
-            }
-
-            // Reset query before render pass begin.
-            if( m_IsPipelineStatisticsQuerySupported )
-            {
-                const uint32_t queryPoolIndex = static_cast<uint32_t>( QueryType::PipelineStatistics );
+        for( uint32_t i = 0; i < m_VectorElementCount; ++i )
+        {
+            a[i] = static_cast<float>( i % 7 ) - 2.0f;
+            b[i] = static_cast<float>( i % 5 ) - 1.0f;
+        }
 
-                vkCmdResetQueryPool( m_GraphicsCommandBuffers[i], m_QueryPools[queryPoolIndex], static_cast<uint32_t>( i ), 1 );
-            }
+        ComputeBufferHandle<float> aBuffer    = {};
+        ComputeBufferHandle<float> bBuffer    = {};
+        ComputeBufferHandle<float> sumsBuffer = {};
 
-            // Define a clear color and depth.
-            std::array<VkClearValue, 2> clearValues = {};
-            clearValues[0].color.float32[0]         = 0.1f; // Red channel.
-            clearValues[0].color.float32[1]         = 0.4f; // Green channel.
-            clearValues[0].color.float32[2]         = 0.5f; // Blue channel.
-            clearValues[0].color.float32[3]         = 1.0f; // Alpha channel.
-            clearValues[1].depthStencil.depth       = 1.0f;
-            clearValues[1].depthStencil.stencil     = 0;
+        if( CreateComputeJobBuffer( m_VectorElementCount, a.data(), aBuffer ) != StatusCode::Success ||
+            CreateComputeJobBuffer( m_VectorElementCount, b.data(), bBuffer ) != StatusCode::Success ||
+            CreateComputeJobBuffer<float>( m_VectorElementCount, nullptr, sumsBuffer ) != StatusCode::Success )
+        {
+            return StatusCode::Fail;
+        }
 
-            // Populate render pass begin information.
-            VkRenderPassBeginInfo renderPassInfo = {};
-            renderPassInfo.sType                 = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-            renderPassInfo.renderPass            = m_RenderPass;
-            renderPassInfo.framebuffer           = m_SwapChainFramebuffers[i];
-            renderPassInfo.renderArea.offset     = { 0, 0 };
-            renderPassInfo.renderArea.extent     = m_SwapChainExtent;
-            renderPassInfo.clearValueCount       = static_cast<uint32_t>( clearValues.size() );
-            renderPassInfo.pClearValues          = clearValues.data();
+        StatusCode result = StatusCode::Success;
 
-            // Begin the render pass.
-            vkCmdBeginRenderPass( m_GraphicsCommandBuffers[i], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE );
+        for( const ComputeReduction reduction : { ComputeReduction::Sum, ComputeReduction::Min, ComputeReduction::Max, ComputeReduction::Dot } )
+        {
+            float gpuResult = 0.0f;
 
-            // Bind the graphics pipeline.
-            vkCmdBindPipeline( m_GraphicsCommandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, m_GraphicsPipeline );
+            const auto  gpuStart = FrameClock::now();
+            result               = ReduceComputeBuffer( aBuffer, bBuffer, m_VectorElementCount, reduction, gpuResult );
+            const auto  cpuStart = FrameClock::now();
+            const float expected = ReduceOnCpu( a.data(), b.data(), m_VectorElementCount, reduction );
+            const auto  cpuEnd   = FrameClock::now();
 
-            // Bind the vertex buffers.
-            const VkBuffer     vertexBuffers[] = { m_VertexBuffer };
-            const VkDeviceSize offsets[]       = { 0 };
-            vkCmdBindVertexBuffers( m_GraphicsCommandBuffers[i], 0, 1, vertexBuffers, offsets );
+            PrintParallelPrimitiveTimes( GetComputeReductionName( reduction ), cpuStart - gpuStart, cpuEnd - cpuStart );
 
-            // Bind the index buffer.
-            vkCmdBindIndexBuffer( m_GraphicsCommandBuffers[i], m_IndexBuffer, 0, VK_INDEX_TYPE_UINT32 );
+            if( result != StatusCode::Success || !IsNearlyEqual( gpuResult, expected ) )
+            {
+                std::cerr << "Compute " << GetComputeReductionName( reduction ) << " is " << gpuResult << ", expected " << expected << "!" << std::endl;
+                result = StatusCode::Fail;
+                break;
+            }
+        }
 
-            // Bind the descriptor sets.
-            vkCmdBindDescriptorSets( m_GraphicsCommandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, m_GraphicsPipelineLayout, 0, 1, &m_DescriptorSets[i], 0, nullptr );
+        std::vector<float> gpuSums;
+        std::vector<float> expectedSums( m_VectorElementCount );
 
-            // Query begin.
-            if( m_IsPipelineStatisticsQuerySupported )
+        for( const ComputeScan scan : { ComputeScan::Inclusive, ComputeScan::Exclusive } )
+        {
+            if( result != StatusCode::Success )
             {
-                const uint32_t queryPoolIndex = static_cast<uint32_t>( QueryType::PipelineStatistics );
-
-                vkCmdBeginQuery( m_GraphicsCommandBuffers[i], m_QueryPools[queryPoolIndex], static_cast<uint32_t>( i ), 0 );
+                break;
             }
 
-            // Draw.
-            // vkCmdDraw( m_CommandBuffers[i], static_cast<uint32_t>( Vertices.size() ), 1, 0, 0 );
-            vkCmdDrawIndexed( m_GraphicsCommandBuffers[i], static_cast<uint32_t>( Indices.size() ), 1, 0, 0, 0 );
+            const auto gpuStart = FrameClock::now();
+            result              = ScanComputeBuffer( aBuffer, sumsBuffer, m_VectorElementCount, scan );
+            const auto cpuStart = FrameClock::now();
+            ScanOnCpu( a.data(), expectedSums.data(), m_VectorElementCount, scan );
+            const auto cpuEnd = FrameClock::now();
 
-            // Query end.
-            if( m_IsPipelineStatisticsQuerySupported )
-            {
-                const uint32_t queryPoolIndex = static_cast<uint32_t>( QueryType::PipelineStatistics );
+            const char* name = scan == ComputeScan::Exclusive ? "exclusive scan" : "inclusive scan";
 
-                vkCmdEndQuery( m_GraphicsCommandBuffers[i], m_QueryPools[queryPoolIndex], static_cast<uint32_t>( i ) );
-            }
+            PrintParallelPrimitiveTimes( name, cpuStart - gpuStart, cpuEnd - cpuStart );
 
-            // End the render pass.
-            vkCmdEndRenderPass( m_GraphicsCommandBuffers[i] );
+            if( result == StatusCode::Success )
+            {
+                result = ReadComputeJobBuffer( sumsBuffer, gpuSums );
+            }
 
-            // End recoring the command buffer.
-            if( vkEndCommandBuffer( m_GraphicsCommandBuffers[i] ) != VK_SUCCESS )
+            for( uint32_t i = 0; result == StatusCode::Success && i < m_VectorElementCount; ++i )
             {
-                std::cerr << "Failed to record command buffer!" << std::endl;
-                return StatusCode::Fail;
+                if( !IsNearlyEqual( gpuSums[i], expectedSums[i] ) )
+                {
+                    std::cerr << "Compute " << name << " element " << i << " is " << gpuSums[i] << ", expected " << expectedSums[i] << "!" << std::endl;
+                    result = StatusCode::Fail;
+                }
             }
         }
 
-        // For compute.
-        VkCommandBufferBeginInfo beginInfo = {};
-        beginInfo.sType                    = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-        beginInfo.flags                    = 0;       // Optional.
-        beginInfo.pInheritanceInfo         = nullptr; // Optional.
+        DestroyComputeJobBuffer( aBuffer );
+        DestroyComputeJobBuffer( bBuffer );
+        DestroyComputeJobBuffer( sumsBuffer );
+
+        return result;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// Prints gpu and cpu times of a reduction or scan, gpu times include submission and readback.
+    ////////////////////////////////////////////////////////////
+    static void PrintParallelPrimitiveTimes( const char* name, const FrameClock::duration gpuTime, const FrameClock::duration cpuTime )
+    {
+        const double gpuMilliseconds = std::chrono::duration<double, std::milli>( gpuTime ).count();
+        const double cpuMilliseconds = std::chrono::duration<double, std::milli>( cpuTime ).count();
 
-        vkBeginCommandBuffer( m_ComputeCommandBuffer, &beginInfo );
+        std::cout << "Compute " << name << ": gpu " << gpuMilliseconds << " ms, cpu " << cpuMilliseconds << " ms"
+                  << " (speedup " << cpuMilliseconds / std::max( gpuMilliseconds, 1e-6 ) << "x)" << std::endl;
+    }
 
-        vkCmdBindPipeline( m_ComputeCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_ComputePipeline );
+    ////////////////////////////////////////////////////////////
+    /// Returns name of the reduction.
+    ////////////////////////////////////////////////////////////
+    static const char* GetComputeReductionName( const ComputeReduction reduction )
+    {
+        switch( reduction )
+        {
+            case ComputeReduction::Min:
+                return "min";
 
-        vkCmdBindDescriptorSets( m_ComputeCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_ComputePipelineLayout, 0, 1, &m_ComputeDescriptorSet, 0, nullptr );
-        vkCmdDispatch( m_ComputeCommandBuffer, m_VectorElementCount, 1, 1 );
+            case ComputeReduction::Max:
+                return "max";
 
-        vkEndCommandBuffer( m_ComputeCommandBuffer );
+            case ComputeReduction::Dot:
+                return "dot";
 
-        return StatusCode::Success;
+            default:
+                return "sum";
+        }
     }
 
     ////////////////////////////////////////////////////////////
-    /// Recreates swap chain.
+    /// Compares a gpu result with a cpu reference summed in a different order.
     ////////////////////////////////////////////////////////////
-    StatusCode RecreateSwapChain()
+    static bool IsNearlyEqual( const float value, const float expected )
     {
-        int32_t width  = 0;
-        int32_t height = 0;
+        return std::abs( value - expected ) <= 1e-5f * std::max( 1.0f, std::abs( expected ) );
+    }
 
-        glfwGetFramebufferSize( m_Window, &width, &height );
+    ////////////////////////////////////////////////////////////
+    /// Returns the number of worker threads of a cpu reference.
+    ////////////////////////////////////////////////////////////
+    static uint32_t GetCpuReferenceRangeCount( const uint32_t elementCount )
+    {
+        return std::clamp( ( elementCount + MinCpuReferenceRangeSize - 1 ) / MinCpuReferenceRangeSize, 1u, ThreadPool::Get().GetThreadCount() );
+    }
 
-        while( width == 0 || height == 0 )
+    ////////////////////////////////////////////////////////////
+    /// Returns the identity of the reduction.
+    ////////////////////////////////////////////////////////////
+    static float GetComputeReductionIdentity( const ComputeReduction reduction )
+    {
+        switch( reduction )
         {
-            // Pause until the windows is minimized.
-            glfwGetFramebufferSize( m_Window, &width, &height );
-            glfwWaitEvents();
+            case ComputeReduction::Min:
+                return std::numeric_limits<float>::infinity();
+
+            case ComputeReduction::Max:
+                return -std::numeric_limits<float>::infinity();
+
+            default:
+                return 0.0f;
         }
+    }
 
-        if( vkDeviceWaitIdle( m_Device ) != VK_SUCCESS )
+    ////////////////////////////////////////////////////////////
+    /// Combines two partial results of the reduction.
+    ////////////////////////////////////////////////////////////
+    static float CombineOnCpu( const float x, const float y, const ComputeReduction reduction )
+    {
+        switch( reduction )
         {
-            std::cerr << "Failed to waiting for device!" << std::endl;
-            return StatusCode::Fail;
+            case ComputeReduction::Min:
+                return std::min( x, y );
+
+            case ComputeReduction::Max:
+                return std::max( x, y );
+
+            default:
+                return x + y;
         }
+    }
 
-        CleanupSwapChain();
+    ////////////////////////////////////////////////////////////
+    /// Reduces a range, eight lanes at a time with avx2 and four with neon.
+    /// Dot products multiply by the second buffer, other reductions ignore it.
+    ////////////////////////////////////////////////////////////
+    static float ReduceRangeOnCpu( const float* a, const float* b, const uint32_t begin, const uint32_t end, const ComputeReduction reduction )
+    {
+        float    result = GetComputeReductionIdentity( reduction );
+        uint32_t i      = begin;
 
-        StatusCode result = StatusCode::Success;
+#if defined( __AVX2__ )
+        constexpr uint32_t LaneCount = 8;
 
-        result = CreateSwapChain();
-        if( result != StatusCode::Success )
-        {
-            std::cerr << "Swap chain creation failed!" << std::endl;
-            return result;
-        }
+        __m256 accumulator = _mm256_set1_ps( result );
 
-        result = CreateImageViews();
-        if( result != StatusCode::Success )
+        for( ; i + LaneCount <= end; i += LaneCount )
         {
-            std::cerr << "Image views creation failed!" << std::endl;
-            return result;
-        }
+            const __m256 value = _mm256_loadu_ps( a + i );
 
-        result = CreateRenderPass();
-        if( result != StatusCode::Success )
-        {
-            std::cerr << "Render pass creation failed!" << std::endl;
-            return result;
-        }
+            switch( reduction )
+            {
+                case ComputeReduction::Min:
+                    accumulator = _mm256_min_ps( accumulator, value );
+                    break;
 
-        result = CreateGraphicsPipeline();
-        if( result != StatusCode::Success )
-        {
-            std::cerr << "Graphics pipeline creation failed!" << std::endl;
-            return result;
-        }
+                case ComputeReduction::Max:
+                    accumulator = _mm256_max_ps( accumulator, value );
+                    break;
 
-        result = CreateDepthResources();
-        if( result != StatusCode::Success )
-        {
-            std::cerr << "Depth resources creation failed!" << std::endl;
-            return result;
-        }
+                case ComputeReduction::Dot:
+                    accumulator = _mm256_add_ps( accumulator, _mm256_mul_ps( value, _mm256_loadu_ps( b + i ) ) );
+                    break;
 
-        result = CreateFramebuffers();
-        if( result != StatusCode::Success )
-        {
-            std::cerr << "Frame buffers creation failed!" << std::endl;
-            return result;
+                default:
+                    accumulator = _mm256_add_ps( accumulator, value );
+                    break;
+            }
         }
 
-        result = CreateUniformBuffers();
-        if( result != StatusCode::Success )
-        {
-            std::cerr << "Unifrom buffers creation failed!" << std::endl;
-            return result;
-        }
+        std::array<float, LaneCount> lanes = {};
+        _mm256_storeu_ps( lanes.data(), accumulator );
 
-        result = CreateDescriptorPool();
-        if( result != StatusCode::Success )
+        for( const float lane : lanes )
         {
-            std::cerr << "Descriptor pool creation failed!" << std::endl;
-            return result;
+            result = CombineOnCpu( result, lane, reduction );
         }
+#elif defined( __ARM_NEON ) && defined( __aarch64__ )
+        constexpr uint32_t LaneCount = 4;
 
-        result = CreateDescriptorSets();
-        if( result != StatusCode::Success )
-        {
-            std::cerr << "Descriptor sets creation failed!" << std::endl;
-            return result;
-        }
+        float32x4_t accumulator = vdupq_n_f32( result );
 
-        result = CreateCommandBuffers();
-        if( result != StatusCode::Success )
+        for( ; i + LaneCount <= end; i += LaneCount )
         {
-            std::cerr << "Command buffers creation failed!" << std::endl;
-            return result;
-        }
+            const float32x4_t value = vld1q_f32( a + i );
 
-        result = RecordCommandBuffers();
-        if( result != StatusCode::Success )
-        {
-            std::cerr << "Command buffers recording failed!" << std::endl;
-            return result;
+            switch( reduction )
+            {
+                case ComputeReduction::Min:
+                    accumulator = vminq_f32( accumulator, value );
+                    break;
+
+                case ComputeReduction::Max:
+                    accumulator = vmaxq_f32( accumulator, value );
+                    break;
+
+                case ComputeReduction::Dot:
+                    accumulator = vfmaq_f32( accumulator, value, vld1q_f32( b + i ) );
+                    break;
+
+                default:
+                    accumulator = vaddq_f32( accumulator, value );
+                    break;
+            }
         }
 
-        return StatusCode::Success;
-    }
+        switch( reduction )
+        {
+            case ComputeReduction::Min:
+                result = vminvq_f32( accumulator );
+                break;
 
-    ////////////////////////////////////////////////////////////
-    /// Creates semaphores to perform gpu-gpu synchronization.
-    ////////////////////////////////////////////////////////////
-    StatusCode CreateSemaphores()
-    {
-        m_ImageAvailableSemaphores.resize( MaxFramesInFlight );
-        m_RenderFinishedSemaphores.resize( MaxFramesInFlight );
+            case ComputeReduction::Max:
+                result = vmaxvq_f32( accumulator );
+                break;
 
-        VkSemaphoreCreateInfo semaphoreInfo = {};
-        semaphoreInfo.sType                 = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+            default:
+                result = vaddvq_f32( accumulator );
+                break;
+        }
+#endif
 
-        for( uint32_t i = 0; i < MaxFramesInFlight; ++i )
+        // Scalar tail, or the whole range without simd.
+        for( ; i < end; ++i )
         {
-            if( vkCreateSemaphore( m_Device, &semaphoreInfo, nullptr, &m_ImageAvailableSemaphores[i] ) != VK_SUCCESS ||
-                vkCreateSemaphore( m_Device, &semaphoreInfo, nullptr, &m_RenderFinishedSemaphores[i] ) != VK_SUCCESS )
-            {
-                std::cerr << "Failed to create semaphores!" << std::endl;
-                return StatusCode::Fail;
-            }
+            result = CombineOnCpu( result, reduction == ComputeReduction::Dot ? a[i] * b[i] : a[i], reduction );
         }
 
-        return StatusCode::Success;
+        return result;
     }
 
     ////////////////////////////////////////////////////////////
-    /// Creates fences to perform cpu-gpu synchronization.
+    /// Reduces elements on worker threads, the cpu reference of the reduction kernel.
     ////////////////////////////////////////////////////////////
-    StatusCode CreateFences()
+    static float ReduceOnCpu( const float* a, const float* b, const uint32_t elementCount, const ComputeReduction reduction )
     {
-        m_InFlightFences.resize( MaxFramesInFlight );
-        m_ImagesInFlight.resize( m_SwapChainImages.size(), VK_NULL_HANDLE );
+        const uint32_t     rangeCount = GetCpuReferenceRangeCount( elementCount );
+        std::vector<float> rangeResults( rangeCount );
 
-        VkFenceCreateInfo fenceInfo = {};
-        fenceInfo.sType             = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-        fenceInfo.flags             = VK_FENCE_CREATE_SIGNALED_BIT;
+        ThreadPool::Get().ForEachRange( elementCount, rangeCount, [&]( const uint32_t r, const uint32_t begin, const uint32_t end ) {
+            rangeResults[r] = ReduceRangeOnCpu( a, b, begin, end, reduction );
+        } );
 
-        for( auto& inFlightFence : m_InFlightFences )
+        float result = rangeResults[0];
+
+        for( uint32_t r = 1; r < rangeCount; ++r )
         {
-            if( vkCreateFence( m_Device, &fenceInfo, nullptr, &inFlightFence ) != VK_SUCCESS )
-            {
-                std::cerr << "Failed to create fences!" << std::endl;
-                return StatusCode::Fail;
-            }
+            result = CombineOnCpu( result, rangeResults[r], reduction );
         }
 
-        return StatusCode::Success;
+        return result;
     }
 
     ////////////////////////////////////////////////////////////
-    /// Updates uniform buffer.
+    /// Computes prefix sums on worker threads, the cpu reference of the scan kernel.
+    /// Ranges are summed in parallel first, then each range is scanned from the sum of the ranges before it.
     ////////////////////////////////////////////////////////////
-    void UpdateUniformBuffer( const uint32_t currentImage )
+    static void ScanOnCpu( const float* values, float* sums, const uint32_t elementCount, const ComputeScan scan )
     {
-        static auto startTime = std::chrono::high_resolution_clock::now();
-
-        const auto  currentTime = std::chrono::high_resolution_clock::now();
-        const float time        = std::chrono::duration<float, std::chrono::seconds::period>( currentTime - startTime ).count();
-
-        UniformBufferObject ubo = {};
-
-        // Rotate only z-axis.
-        ubo.model = glm::rotate( glm::mat4( 1.0f ), time * glm::radians( 90.0f ), glm::vec3( 0.0f, 0.0f, 1.0f ) );
+        const uint32_t     rangeCount = GetCpuReferenceRangeCount( elementCount );
+        std::vector<float> rangePrefixes( rangeCount );
 
-        // Eye position, center position, up axis.
-        ubo.view = glm::lookAt( glm::vec3( 2.0f, 2.0f, 2.0f ), glm::vec3( 0.0f, 0.0f, 0.0f ), glm::vec3( 0.0f, 0.0f, -1.0f ) );
-
-        // Field of view, aspect ratio, near view plane, far view plane.
-        ubo.proj = glm::perspective( glm::radians( 45.0f ), m_SwapChainExtent.width / static_cast<float>( m_SwapChainExtent.height ), 0.1f, 10.0f );
+        ThreadPool::Get().ForEachRange( elementCount, rangeCount, [&]( const uint32_t r, const uint32_t begin, const uint32_t end ) {
+            rangePrefixes[r] = ReduceRangeOnCpu( values, nullptr, begin, end, ComputeReduction::Sum );
+        } );
 
-        // ubo.proj[1][1] *= -1;
+        float prefix = 0.0f;
 
-        // Copy data to buffer.
-        void* data                                         = nullptr;
-        auto [bufferGpuMemoryIndex, bufferGpuMemoryOffset] = m_UniformBuffersGpuMemoryOffsets[currentImage];
-        auto bufferGpuMemory                               = m_BufferGpuMemoryCpuVisible[bufferGpuMemoryIndex];
+        for( float& rangePrefix : rangePrefixes )
+        {
+            const float rangeSum = rangePrefix;
+            rangePrefix          = prefix;
+            prefix += rangeSum;
+        }
 
-        vkMapMemory( m_Device, bufferGpuMemory, bufferGpuMemoryOffset, sizeof( ubo ), 0, &data );
-        memcpy( data, &ubo, sizeof( ubo ) );
-        vkUnmapMemory( m_Device, bufferGpuMemory );
+        ThreadPool::Get().ForEachRange( elementCount, rangeCount, [&]( const uint32_t r, const uint32_t begin, const uint32_t end ) {
+            ScanRangeOnCpu( values, sums, begin, end, rangePrefixes[r], scan );
+        } );
     }
 
     ////////////////////////////////////////////////////////////
-    /// Draws a frame and multiplies vector.
+    /// Scans a range from the sum of the elements before it, eight lanes at a time with avx2 and four with neon.
+    /// Lanes are scanned in registers by shifted additions, then offset by the sum carried from the previous lanes.
     ////////////////////////////////////////////////////////////
-    StatusCode DrawFrameAndMultiplyVector()
+    static void ScanRangeOnCpu( const float* values, float* sums, const uint32_t begin, const uint32_t end, const float prefix, const ComputeScan scan )
     {
-        VkResult result = VK_SUCCESS;
-
-        // Wait for fences.
-        vkWaitForFences( m_Device, 1, &m_InFlightFences[m_CurrentFrame], VK_TRUE, UINT64_MAX );
+        const bool isExclusive = scan == ComputeScan::Exclusive;
+        float      sum         = prefix;
+        uint32_t   i           = begin;
 
-        // Acquire an image from the swap chain.
-        uint32_t imageIndex = 0;
-        result              = vkAcquireNextImageKHR( m_Device, m_SwapChain, UINT64_MAX, m_ImageAvailableSemaphores[m_CurrentFrame], VK_NULL_HANDLE, &imageIndex );
-
-        // Check swap chain status and recreate it if needed.
-        if( result == VK_ERROR_OUT_OF_DATE_KHR )
-        {
-            RecreateSwapChain();
-            return StatusCode::Success;
-        }
-        else if( result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR ) // Suboptimal swap chain is ok.
-        {
-            std::cerr << "Failed to acquire swap chain image!" << std::endl;
-            return StatusCode::Fail;
-        }
+#if defined( __AVX2__ )
+        constexpr uint32_t LaneCount = 8;
 
-        // Update uniform buffer.
-        UpdateUniformBuffer( imageIndex );
+        __m256 carry = _mm256_set1_ps( sum );
 
-        // Check if a previous frame is using this image (i.e. there is its fence to wait on).
-        if( m_ImagesInFlight[imageIndex] != VK_NULL_HANDLE )
+        for( ; i + LaneCount <= end; i += LaneCount )
         {
-            vkWaitForFences( m_Device, 1, &m_ImagesInFlight[imageIndex], VK_TRUE, UINT64_MAX );
-        }
-
-        // Mark the image as now being in use by this frame
-        m_ImagesInFlight[imageIndex] = m_InFlightFences[m_CurrentFrame];
+            const __m256 value = _mm256_loadu_ps( values + i );
 
-        // Submit the compute command buffer.
-        VkSubmitInfo submitInfo       = {};
-        submitInfo                    = {};
-        submitInfo.sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-        submitInfo.commandBufferCount = 1;
-        submitInfo.pCommandBuffers    = &m_ComputeCommandBuffer;
+            // Shifts stay within the 128-bit halves, so the sum of the low half is added to the high half after.
+            __m256 lanes = _mm256_add_ps( value, _mm256_castsi256_ps( _mm256_slli_si256( _mm256_castps_si256( value ), 4 ) ) );
+            lanes        = _mm256_add_ps( lanes, _mm256_castsi256_ps( _mm256_slli_si256( _mm256_castps_si256( lanes ), 8 ) ) );
 
-        if( vkQueueSubmit( m_ComputeQueue, 1, &submitInfo, VK_NULL_HANDLE ) != VK_SUCCESS )
-        {
-            std::cerr << "Failed to submit dispatch command buffer!" << std::endl;
-            return StatusCode::Fail;
-        }
+            const __m256 halfSums = _mm256_permute_ps( lanes, _MM_SHUFFLE( 3, 3, 3, 3 ) );
+            lanes                 = _mm256_add_ps( lanes, _mm256_permute2f128_ps( halfSums, halfSums, 0x08 ) );
 
-        // Submit the graphics command buffer.
-        VkPipelineStageFlags waitStages = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-        submitInfo.sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-        submitInfo.waitSemaphoreCount   = 1;
-        submitInfo.pWaitSemaphores      = &m_ImageAvailableSemaphores[m_CurrentFrame];
-        submitInfo.pWaitDstStageMask    = &waitStages;
-        submitInfo.commandBufferCount   = 1;
-        submitInfo.pCommandBuffers      = &m_GraphicsCommandBuffers[imageIndex];
-        submitInfo.signalSemaphoreCount = 1;
-        submitInfo.pSignalSemaphores    = &m_RenderFinishedSemaphores[m_CurrentFrame];
+            const __m256 inclusive = _mm256_add_ps( carry, lanes );
 
-        // Reset fences before using them.
-        vkResetFences( m_Device, 1, &m_InFlightFences[m_CurrentFrame] );
+            _mm256_storeu_ps( sums + i, isExclusive ? _mm256_sub_ps( inclusive, value ) : inclusive );
 
-        if( vkQueueSubmit( m_GraphicsQueue, 1, &submitInfo, m_InFlightFences[m_CurrentFrame] ) != VK_SUCCESS )
-        {
-            std::cerr << "Failed to submit draw command buffer!" << std::endl;
-            return StatusCode::Fail;
+            const __m256 lastLanes = _mm256_permute_ps( inclusive, _MM_SHUFFLE( 3, 3, 3, 3 ) );
+            carry                  = _mm256_permute2f128_ps( lastLanes, lastLanes, 0x11 );
         }
 
-        // Present the swap chain.
-        VkPresentInfoKHR presentInfo   = {};
-        presentInfo.sType              = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-        presentInfo.waitSemaphoreCount = 1;
-        presentInfo.pWaitSemaphores    = &m_RenderFinishedSemaphores[m_CurrentFrame];
-        presentInfo.swapchainCount     = 1;
-        presentInfo.pSwapchains        = &m_SwapChain;
-        presentInfo.pImageIndices      = &imageIndex;
-        presentInfo.pResults           = nullptr; // Optional.
+        sum = _mm256_cvtss_f32( carry );
+#elif defined( __ARM_NEON ) && defined( __aarch64__ )
+        constexpr uint32_t LaneCount = 4;
 
-        result = vkQueuePresentKHR( m_PresentQueue, &presentInfo );
+        const float32x4_t zero  = vdupq_n_f32( 0.0f );
+        float32x4_t       carry = vdupq_n_f32( sum );
 
-        // Get query data.
-        if( m_IsPipelineStatisticsQuerySupported )
+        for( ; i + LaneCount <= end; i += LaneCount )
         {
-            std::vector<uint64_t>    queryData( 7 );
-            const size_t             queryDataSize  = queryData.size() * sizeof( queryData[0] );
-            const VkQueryResultFlags queryDataFlags = VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT;
-            const uint32_t           queryPoolIndex = static_cast<uint32_t>( QueryType::PipelineStatistics );
+            const float32x4_t value = vld1q_f32( values + i );
 
-            VkResult queryResult = vkGetQueryPoolResults( m_Device, m_QueryPools[queryPoolIndex], imageIndex, 1, queryDataSize, queryData.data(), 0, queryDataFlags );
-            if( queryResult != VK_SUCCESS && queryData.back() != 0 )
-            {
-                std::cerr << "Failed to get query data!" << std::endl;
-                return StatusCode::Fail;
-            }
-        }
+            float32x4_t lanes = vaddq_f32( value, vextq_f32( zero, value, 3 ) );
+            lanes             = vaddq_f32( lanes, vextq_f32( zero, lanes, 2 ) );
 
-        vkQueueWaitIdle( m_ComputeQueue );
+            const float32x4_t inclusive = vaddq_f32( carry, lanes );
 
-        if( VerifyComputeWorkload() != StatusCode::Success )
-        {
-            std::cerr << "Failed to verify compute workload!" << std::endl;
-            return StatusCode::Fail;
-        }
+            vst1q_f32( sums + i, isExclusive ? vsubq_f32( inclusive, value ) : inclusive );
 
-        // Check swap chain status and recreate it if needed.
-        if( result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || m_IsFrameBufferResized )
-        {
-            m_IsFrameBufferResized = false;
-            RecreateSwapChain();
-        }
-        else if( result != VK_SUCCESS )
-        {
-            std::cerr << "Failed to present swap chain image!" << std::endl;
-            return StatusCode::Fail;
+            carry = vdupq_laneq_f32( inclusive, 3 );
         }
 
-        m_CurrentFrame = ( m_CurrentFrame + 1 ) % MaxFramesInFlight;
-
-        return StatusCode::Success;
-    }
-
-    ////////////////////////////////////////////////////////////
-    /// Verifies compute workload.
-    ////////////////////////////////////////////////////////////
-    StatusCode VerifyComputeWorkload()
-    {
-        void* data                  = nullptr;
-        auto  bufferGpuMemory       = m_BufferGpuMemoryCpuVisible[std::get<0>( m_ComputeBuffersGpuMemoryOffsets[2] )];
-        auto  bufferGpuMemoryOffset = std::get<1>( m_ComputeBuffersGpuMemoryOffsets[2] );
-
-        vkMapMemory( m_Device, bufferGpuMemory, bufferGpuMemoryOffset, m_VectorElementCount * sizeof( float ), 0, &data );
+        sum = vgetq_lane_f32( carry, 0 );
+#endif
 
-        for( uint32_t i = 0; i < m_VectorElementCount; ++i )
+        // Scalar tail, or the whole range without simd.
+        for( ; i < end; ++i )
         {
-            float* result = reinterpret_cast<float*>( data );
-
-            if( result[i] != m_Results[i] )
+            if( isExclusive )
             {
-                return StatusCode::Fail;
+                sums[i] = sum;
+                sum += values[i];
+            }
+            else
+            {
+                sum += values[i];
+                sums[i] = sum;
             }
         }
-
-        vkUnmapMemory( m_Device, bufferGpuMemory );
-
-        return StatusCode::Success;
     }
 
     ////////////////////////////////////////////////////////////
@@ -3679,7 +11192,7 @@ private:
         vkDestroyImageView( m_Device, m_DepthImageView, nullptr );
 
         // Destroy depth image.
-        vkDestroyImage( m_Device, m_DepthImage, nullptr );
+        DestroyImage( m_DepthImage, m_DepthImageGpuMemoryOffset );
 
         // Destroy frame buffers.
         for( auto& framebuffer : m_SwapChainFramebuffers )
@@ -3687,20 +11200,29 @@ private:
             vkDestroyFramebuffer( m_Device, framebuffer, nullptr );
         }
 
-        // Destroy uniform buffers.
-        for( auto& uniformBuffer : m_UniformBuffers )
+        // Destroy uniform ring buffer.
+        DestroyBuffer( m_UniformRingBuffer.m_Buffer, m_UniformRingBuffer.m_GpuMemoryOffsets );
+
+        // Destroy culling draw buffers.
+        for( size_t i = 0; i < m_CullingDrawBuffers.size(); ++i )
         {
-            vkDestroyBuffer( m_Device, uniformBuffer, nullptr );
+            DestroyBuffer( m_CullingDrawBuffers[i], m_CullingDrawBuffersGpuMemoryOffsets[i] );
         }
 
+        m_CullingDrawBuffers.clear();
+        m_CullingDrawBuffersGpuMemoryOffsets.clear();
+
+        // Culling descriptor sets are freed with the graphics descriptor pool.
+        m_CullingDescriptorSets.clear();
+
         // Free graphics descriptor sets.
         if( vkFreeDescriptorSets( m_Device, m_DescriptorPool, static_cast<uint32_t>( m_DescriptorSets.size() ), m_DescriptorSets.data() ) != VK_SUCCESS )
         {
             std::cerr << "Cannot free graphics descriptor sets!" << std::endl;
         }
 
-        // Free compute descriptor set.
-        if( vkFreeDescriptorSets( m_Device, m_ComputeDescriptorPool, 1, &m_ComputeDescriptorSet ) != VK_SUCCESS )
+        // Free compute descriptor sets.
+        if( vkFreeDescriptorSets( m_Device, m_ComputeDescriptorPool, static_cast<uint32_t>( m_ComputeDescriptorSets.size() ), m_ComputeDescriptorSets.data() ) != VK_SUCCESS )
         {
             std::cerr << "Cannot free compute descriptor sets!" << std::endl;
         }
@@ -3711,12 +11233,23 @@ private:
         // Destroy compute descriptor pool.
         vkDestroyDescriptorPool( m_Device, m_ComputeDescriptorPool, nullptr );
 
-        // Free compute command buffer.
-        vkFreeCommandBuffers( m_Device, m_CommandPoolCompute, 1, &m_ComputeCommandBuffer );
+        // Free compute command buffers.
+        vkFreeCommandBuffers( m_Device, m_CommandPoolCompute, static_cast<uint32_t>( m_ComputeCommandBuffers.size() ), m_ComputeCommandBuffers.data() );
 
         // Free graphics command buffers.
         vkFreeCommandBuffers( m_Device, m_CommandPoolGraphics, static_cast<uint32_t>( m_GraphicsCommandBuffers.size() ), m_GraphicsCommandBuffers.data() );
 
+        // Destroy query pools, they have a query or a profiler slot per command buffer.
+        for( auto& queryPool : m_QueryPools )
+        {
+            vkDestroyQueryPool( m_Device, queryPool, nullptr );
+        }
+
+        m_QueryPools.clear();
+
+        DestroyGpuProfiler( m_GraphicsProfiler );
+        DestroyGpuProfiler( m_ComputeProfiler );
+
         // Destroy graphics pipeline.
         vkDestroyPipeline( m_Device, m_GraphicsPipeline, nullptr );
 
@@ -3732,8 +11265,23 @@ private:
             vkDestroyImageView( m_Device, imageView, nullptr );
         }
 
-        // Destroy swap chain.
-        vkDestroySwapchainKHR( m_Device, m_SwapChain, nullptr );
+        // Destroy swap chain or offscreen images.
+        if( m_Settings.m_IsHeadless )
+        {
+            for( size_t i = 0; i < m_SwapChainImages.size(); ++i )
+            {
+                DestroyImage( m_SwapChainImages[i], m_OffscreenImagesGpuMemoryOffsets[i] );
+            }
+
+            for( size_t i = 0; i < m_CaptureBuffers.size(); ++i )
+            {
+                DestroyBuffer( m_CaptureBuffers[i], m_CaptureBuffersGpuMemoryOffsets[i] );
+            }
+        }
+        else
+        {
+            vkDestroySwapchainKHR( m_Device, m_SwapChain, nullptr );
+        }
     }
 
     ////////////////////////////////////////////////////////////
@@ -3741,20 +11289,49 @@ private:
     ////////////////////////////////////////////////////////////
     StatusCode CleanupVulkan()
     {
+        // Join asset loading in case initialization stopped early.
+        WaitForAsset( m_ModelLoading );
+        WaitForAsset( m_TextureLoading );
+        WaitForAsset( m_ShaderLoading );
+
+        if( m_LoadedTexture.m_Pixels != nullptr )
+        {
+            StbImage::unloadRbga( m_LoadedTexture.m_Pixels );
+        }
+
+        WaitForUpload( m_UploadTicket );
+        DestroyGpuMemoryMoves();
+
+        m_GpuMovableResources.clear();
+
         CleanupSwapChain();
 
-        // Destroy query pools.
-        for( auto& queryPool : m_QueryPools )
+        // Destroy compute jobs, the waiter threads must be done with the timelines.
+        StopComputeJobWaiter();
+        StopFrameLatencyWaiter();
+        ReleaseCompletedComputeJobs();
+
+        for( ComputeJobBuffer& jobBuffer : m_ComputeJobBuffers )
         {
-            vkDestroyQueryPool( m_Device, queryPool, nullptr );
+            DestroyBuffer( jobBuffer.m_Buffer, jobBuffer.m_GpuMemoryOffsets );
+        }
+
+        for( ComputeKernel& kernel : m_ComputeKernels )
+        {
+            DestroyComputeKernel( kernel );
         }
 
+        vkDestroyDescriptorPool( m_Device, m_ComputeJobDescriptorPool, nullptr );
+
         // Destroy compute pipeline.
         vkDestroyPipeline( m_Device, m_ComputePipeline, nullptr );
 
         // Destroy compute pipeline layout.
         vkDestroyPipelineLayout( m_Device, m_ComputePipelineLayout, nullptr );
 
+        // Destroy staging ring buffer.
+        DestroyBuffer( m_StagingRingBuffer.m_Buffer, m_StagingRingBuffer.m_GpuMemoryOffsets );
+
         // Destroy texture sampler.
         vkDestroySampler( m_Device, m_TextureSampler, nullptr );
 
@@ -3762,7 +11339,7 @@ private:
         vkDestroyImageView( m_Device, m_TextureImageView, nullptr );
 
         // Destroy texture image.
-        vkDestroyImage( m_Device, m_TextureImage, nullptr );
+        DestroyImage( m_TextureImage, m_TextureImageGpuMemoryOffset );
 
         // Destroy descriptor set layout.
         vkDestroyDescriptorSetLayout( m_Device, m_DescriptorSetLayout, nullptr );
@@ -3771,34 +11348,38 @@ private:
         vkDestroyDescriptorSetLayout( m_Device, m_ComputeDescriptorSetLayout, nullptr );
 
         // Destroy compute buffers.
-        for( auto& computeBuffer : m_ComputeBuffers )
+        for( size_t i = 0; i < m_ComputeBuffers.size(); ++i )
         {
-            vkDestroyBuffer( m_Device, computeBuffer, nullptr );
+            DestroyBuffer( m_ComputeBuffers[i], m_ComputeBuffersGpuMemoryOffsets[i] );
         }
 
-        // Destroy index buffer.
-        vkDestroyBuffer( m_Device, m_IndexBuffer, nullptr );
-
-        // Destroy vertex buffer.
-        vkDestroyBuffer( m_Device, m_VertexBuffer, nullptr );
+        // Destroy compute readback buffers, verification must not read them anymore.
+        FinishComputeVerification();
 
-        // Free gpu memory associated with local memory.
-        for( auto& bufferGpuMemoryLocal : m_BufferGpuMemoryLocal )
+        for( size_t i = 0; i < m_ComputeReadbackBuffers.size(); ++i )
         {
-            vkFreeMemory( m_Device, bufferGpuMemoryLocal, nullptr );
+            DestroyBuffer( m_ComputeReadbackBuffers[i], m_ComputeReadbackBuffersGpuMemoryOffsets[i] );
         }
 
-        // Free gpu memory associated with cpu visible memory.
-        for( auto& bufferGpuMemoryCpuVisible : m_BufferGpuMemoryCpuVisible )
-        {
-            vkFreeMemory( m_Device, bufferGpuMemoryCpuVisible, nullptr );
-        }
+        // Destroy index buffer.
+        DestroyBuffer( m_IndexBuffer, m_IndexBufferGpuMemoryOffset );
 
-        for( auto& inFlightFence : m_InFlightFences )
+        // Destroy culling cluster buffer.
+        DestroyBuffer( m_CullingClusterBuffer, m_CullingClusterBufferGpuMemoryOffset );
+
+        // Destroy vertex buffer.
+        DestroyBuffer( m_VertexBuffer, m_VertexBufferGpuMemoryOffset );
+
+        // Free gpu memory blocks.
+        for( auto& gpuMemoryBlock : m_GpuMemoryBlocks )
         {
-            vkDestroyFence( m_Device, inFlightFence, nullptr );
+            vkFreeMemory( m_Device, gpuMemoryBlock.m_Memory, nullptr );
         }
 
+        vkDestroySemaphore( m_Device, m_GraphicsTimeline.m_Semaphore, nullptr );
+        vkDestroySemaphore( m_Device, m_ComputeTimeline.m_Semaphore, nullptr );
+        vkDestroySemaphore( m_Device, m_CopyTimeline.m_Semaphore, nullptr );
+
         for( auto& renderFinishedSemaphore : m_RenderFinishedSemaphores )
         {
             vkDestroySemaphore( m_Device, renderFinishedSemaphore, nullptr );
@@ -3903,14 +11484,230 @@ private:
         (void) width;
         (void) height;
     }
+
+    ////////////////////////////////////////////////////////////
+    /// Key callback, F12 requests writing the trace.
+    ////////////////////////////////////////////////////////////
+    static void __stdcall KeyCallback(
+        GLFWwindow* window,
+        int32_t     key,
+        int32_t     scancode,
+        int32_t     action,
+        int32_t     mods )
+    {
+        auto app = reinterpret_cast<Application*>( glfwGetWindowUserPointer( window ) );
+
+        if( key == GLFW_KEY_F12 && action == GLFW_PRESS )
+        {
+            app->m_IsTraceRequested = true;
+        }
+
+        (void) scancode;
+        (void) mods;
+    }
 };
 
-int32_t main()
+////////////////////////////////////////////////////////////
+/// Parses command line arguments to application settings.
+////////////////////////////////////////////////////////////
+StatusCode ParseArguments( const int32_t argc, char** argv, ApplicationSettings& settings )
+{
+    bool isWarmupFrameCountSet = false;
+
+    for( int32_t i = 1; i < argc; ++i )
+    {
+        const std::string argument = argv[i];
+
+        if( argument == "--latency-mode=balanced" )
+        {
+            settings.m_LatencyMode = LatencyMode::Balanced;
+        }
+        else if( argument == "--latency-mode=low-latency" )
+        {
+            settings.m_LatencyMode = LatencyMode::LowLatency;
+        }
+        else if( argument == "--latency-mode=throughput" )
+        {
+            settings.m_LatencyMode = LatencyMode::Throughput;
+        }
+        else if( argument.starts_with( "--frames-in-flight=" ) )
+        {
+            settings.m_FramesInFlight = static_cast<uint32_t>( std::strtoul( argument.c_str() + argument.find( '=' ) + 1, nullptr, 10 ) );
+        }
+        else if( argument.starts_with( "--frames=" ) )
+        {
+            settings.m_FrameCount = static_cast<uint32_t>( std::strtoul( argument.c_str() + argument.find( '=' ) + 1, nullptr, 10 ) );
+        }
+        else if( argument == "--headless" )
+        {
+            settings.m_IsHeadless = true;
+        }
+        else if( argument.starts_with( "--capture=" ) )
+        {
+            settings.m_CaptureDirectory = argument.substr( argument.find( '=' ) + 1 );
+        }
+        else if( argument == "--benchmark" )
+        {
+            settings.m_IsBenchmark = true;
+        }
+        else if( argument.starts_with( "--benchmark-seconds=" ) )
+        {
+            settings.m_IsBenchmark      = true;
+            settings.m_BenchmarkSeconds = std::strtof( argument.c_str() + argument.find( '=' ) + 1, nullptr );
+        }
+        else if( argument.starts_with( "--warmup-frames=" ) )
+        {
+            settings.m_WarmupFrameCount = static_cast<uint32_t>( std::strtoul( argument.c_str() + argument.find( '=' ) + 1, nullptr, 10 ) );
+            isWarmupFrameCountSet       = true;
+        }
+        else if( argument == "--benchmark-format=json" )
+        {
+            settings.m_BenchmarkFormat = BenchmarkFormat::Json;
+        }
+        else if( argument == "--benchmark-format=csv" )
+        {
+            settings.m_BenchmarkFormat = BenchmarkFormat::Csv;
+        }
+        else if( argument.starts_with( "--benchmark-output=" ) )
+        {
+            settings.m_BenchmarkOutput = argument.substr( argument.find( '=' ) + 1 );
+        }
+        else if( argument == "--gpu-profile" )
+        {
+            settings.m_IsGpuProfileLogged = true;
+        }
+        else if( argument == "--pipeline-statistics=stdout" )
+        {
+            settings.m_PipelineStatisticsExport = PipelineStatisticsExport::Stdout;
+        }
+        else if( argument == "--pipeline-statistics=csv" )
+        {
+            settings.m_PipelineStatisticsExport = PipelineStatisticsExport::Csv;
+        }
+        else if( argument == "--pipeline-statistics=trace" )
+        {
+            settings.m_PipelineStatisticsExport = PipelineStatisticsExport::ChromeTrace;
+        }
+        else if( argument.starts_with( "--pipeline-statistics-output=" ) )
+        {
+            settings.m_PipelineStatisticsOutput = argument.substr( argument.find( '=' ) + 1 );
+        }
+        else if( argument.starts_with( "--trace=" ) )
+        {
+            settings.m_TraceOutput = argument.substr( argument.find( '=' ) + 1 );
+        }
+        else if( argument == "--compute-buffers=auto" )
+        {
+            settings.m_ComputeBufferMode = ComputeBufferMode::Auto;
+        }
+        else if( argument == "--compute-buffers=host-visible" )
+        {
+            settings.m_ComputeBufferMode = ComputeBufferMode::HostVisible;
+        }
+        else if( argument == "--compute-buffers=device-local" )
+        {
+            settings.m_ComputeBufferMode = ComputeBufferMode::DeviceLocal;
+        }
+        else if( argument.starts_with( "--compute-readback-interval=" ) )
+        {
+            settings.m_ComputeReadbackInterval = static_cast<uint32_t>( std::strtoul( argument.c_str() + argument.find( '=' ) + 1, nullptr, 10 ) );
+        }
+        else if( argument == "--compute-verify=exact" )
+        {
+            settings.m_ComputeVerificationMode = ComputeVerificationMode::Exact;
+        }
+        else if( argument == "--compute-verify=ulp" )
+        {
+            settings.m_ComputeVerificationMode = ComputeVerificationMode::Ulp;
+        }
+        else if( argument == "--compute-verify=relative" )
+        {
+            settings.m_ComputeVerificationMode = ComputeVerificationMode::Relative;
+        }
+        else if( argument.starts_with( "--compute-verify-tolerance=" ) )
+        {
+            settings.m_ComputeVerificationTolerance = std::strtof( argument.c_str() + argument.find( '=' ) + 1, nullptr );
+        }
+        else if( argument.starts_with( "--compute-verify-sampling=" ) )
+        {
+            settings.m_ComputeVerificationSampling = static_cast<uint32_t>( std::strtoul( argument.c_str() + argument.find( '=' ) + 1, nullptr, 10 ) );
+        }
+        else if( argument.starts_with( "--compute-verify-mismatches=" ) )
+        {
+            settings.m_ComputeMismatchReports = static_cast<uint32_t>( std::strtoul( argument.c_str() + argument.find( '=' ) + 1, nullptr, 10 ) );
+        }
+        else if( argument.starts_with( "--compute-stream=" ) )
+        {
+            settings.m_ComputeStreamChunkCount = static_cast<uint32_t>( std::strtoul( argument.c_str() + argument.find( '=' ) + 1, nullptr, 10 ) );
+        }
+        else if( argument.starts_with( "--compute-stream-buffers=" ) )
+        {
+            settings.m_ComputeStreamSlotCount = static_cast<uint32_t>( std::strtoul( argument.c_str() + argument.find( '=' ) + 1, nullptr, 10 ) );
+        }
+        else if( argument == "--async-compute=on" )
+        {
+            settings.m_IsComputeSerialized = false;
+        }
+        else if( argument == "--async-compute=off" )
+        {
+            settings.m_IsComputeSerialized = true;
+        }
+        else if( argument == "--gpu-culling=on" )
+        {
+            settings.m_IsGpuCullingDisabled = false;
+        }
+        else if( argument == "--gpu-culling=off" )
+        {
+            settings.m_IsGpuCullingDisabled = true;
+        }
+        else
+        {
+            std::cerr << "Unknown argument " << argument << "!" << std::endl;
+            std::cerr << "Usage: VulkanApplication [--latency-mode=balanced|low-latency|throughput] [--frames-in-flight=1-" << MaxFramesInFlight << "]"
+                      << " [--frames=N] [--headless [--capture=DIRECTORY]]"
+                      << " [--benchmark] [--benchmark-seconds=S] [--warmup-frames=N] [--benchmark-format=json|csv] [--benchmark-output=FILE]"
+                      << " [--gpu-profile] [--pipeline-statistics=stdout|csv|trace] [--pipeline-statistics-output=FILE] [--trace=FILE]"
+                      << " [--compute-buffers=auto|host-visible|device-local] [--compute-readback-interval=N]"
+                      << " [--compute-verify=exact|ulp|relative] [--compute-verify-tolerance=X] [--compute-verify-sampling=N] [--compute-verify-mismatches=N]"
+                      << " [--compute-stream=CHUNKS] [--compute-stream-buffers=2|3] [--async-compute=on|off] [--gpu-culling=on|off]" << std::endl;
+            return StatusCode::Fail;
+        }
+    }
+
+    if( settings.m_PipelineStatisticsOutput.empty() )
+    {
+        settings.m_PipelineStatisticsOutput =
+            settings.m_PipelineStatisticsExport == PipelineStatisticsExport::ChromeTrace ? "pipeline_statistics.json" : "pipeline_statistics.csv";
+    }
+
+    if( settings.m_IsBenchmark && !isWarmupFrameCountSet )
+    {
+        settings.m_WarmupFrameCount = BenchmarkWarmupFrameCount;
+    }
+
+    if( !settings.m_CaptureDirectory.empty() && !settings.m_IsHeadless )
+    {
+        std::cerr << "Frame capture is supported only in headless mode!" << std::endl;
+        return StatusCode::Fail;
+    }
+
+    return StatusCode::Success;
+}
+
+int32_t main( int32_t argc, char** argv )
 {
-    StatusCode result = StatusCode::Success;
+    StatusCode          result   = StatusCode::Success;
+    ApplicationSettings settings = {};
+
+    // Parse command line arguments.
+    result = ParseArguments( argc, argv, settings );
+    if( result != StatusCode::Success )
+    {
+        return static_cast<int32_t>( result );
+    }
 
     // Construct an application object with parameters.
-    Application application( 800, 600, "Vulkan Application" );
+    Application application( 800, 600, "Vulkan Application", settings );
 
     // Initialize the application.
     result = application.Initialize();